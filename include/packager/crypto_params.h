@@ -179,6 +179,11 @@ struct EncryptionParams {
   /// enabled, the key provider must support key rotation in this case.
   static constexpr double kNoKeyRotation = 0;
   double crypto_period_duration_in_seconds = kNoKeyRotation;
+  /// Number of crypto periods whose keys are fetched in the background ahead
+  /// of the current one when key rotation is enabled, so that the encryptors
+  /// do not wait for the key provider at crypto period boundaries. 0 disables
+  /// prefetching.
+  uint32_t crypto_period_key_lookahead = 2;
   /// Enable/disable subsample encryption for VP9.
   bool vp9_subsample_encryption = true;
 
@@ -7,6 +7,7 @@
 #ifndef PACKAGER_PUBLIC_FILE_H_
 #define PACKAGER_PUBLIC_FILE_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 
@@ -20,6 +21,7 @@ namespace shaka {
 extern const char* kCallbackFilePrefix;
 extern const char* kLocalFilePrefix;
 extern const char* kMemoryFilePrefix;
+extern const char* kOriginFilePrefix;
 extern const char* kUdpFilePrefix;
 extern const char* kHttpFilePrefix;
 const int64_t kWholeFile = -1;
@@ -69,6 +71,20 @@ class SHAKA_EXPORT File {
   /// @return Number of bytes written, or a value < 0 on error.
   virtual int64_t Write(const void* buffer, uint64_t length) = 0;
 
+  /// A block of data for WriteV().
+  struct IoVec {
+    const void* data;
+    uint64_t length;
+  };
+
+  /// Write blocks of data, in order, without gathering them in one buffer.
+  /// Unlike Write(), all the data is written unless there is an error. The
+  /// default implementation calls Write() for each block.
+  /// @param blocks points to @a num_blocks blocks of data.
+  /// @param num_blocks is the number of blocks to write.
+  /// @return Number of bytes written, or a value < 0 on error.
+  virtual int64_t WriteV(const IoVec* blocks, size_t num_blocks);
+
   /// Close the file for writing.  This signals that no more data will be
   /// written.  Future writes are invalid and their behavior is undefined!
   /// Data may still be read from the file after calling this method.
@@ -154,6 +170,12 @@ class SHAKA_EXPORT File {
   /// @return true if `file_name` is a local and regular file.
   static bool IsLocalRegularFile(const char* file_name);
 
+  /// @param file_name is the name of the file to be checked.
+  /// @return true if `file_name` is a local file which is either regular or
+  ///         does not exist yet, so that opening it for writing results in a
+  ///         local and regular file.
+  static bool IsLocalRegularOutputFile(const char* file_name);
+
   /// Generate callback file name.
   /// NOTE: THE GENERATED NAME IS ONLY VAID WHILE @a callback_params IS VALID.
   /// @param callback_params references BufferCallbackParams, which will be
@@ -61,6 +61,15 @@ struct HlsParams {
   /// be populated from segment duration specified in ChunkingParams if not
   /// specified.
   double target_segment_duration = 0;
+  /// Target duration of the LL-HLS partial segments, in seconds. Enables
+  /// Low-Latency HLS (EXT-X-PART, EXT-X-PRELOAD-HINT) if positive. Requires
+  /// the segments to be written as CMAF chunks, i.e. low latency mode.
+  double part_target_duration = 0;
+  /// Advertises blocking playlist reloads (CAN-BLOCK-RELOAD) in the LL-HLS
+  /// media playlists. The origin serving the playlists must support them. It
+  /// is set automatically if the playlists are served by the built-in HTTP
+  /// origin.
+  bool can_block_reload = false;
   /// Custom EXT-X-MEDIA-SEQUENCE value to allow continuous media playback
   /// across packager restarts. See #691 for details.
   uint32_t media_sequence_number = 0;
@@ -7,6 +7,8 @@
 #ifndef PACKAGER_PUBLIC_MP4_OUTPUT_PARAMS_H_
 #define PACKAGER_PUBLIC_MP4_OUTPUT_PARAMS_H_
 
+#include <cstdint>
+
 namespace shaka {
 
 /// MP4 (ISO-BMFF) output related parameters.
@@ -26,6 +28,15 @@ struct Mp4OutputParams {
   /// and mdat atom. Each chunk is uploaded immediately upon creation,
   /// decoupling latency from segment duration.
   bool low_latency_dash_mode = false;
+  /// Space, in bytes, to reserve at the start of single-segment (on-demand)
+  /// outputs for the 'ftyp', 'moov' and 'sidx' boxes. By default, media
+  /// fragments are written to a temporary file, which is copied to the output
+  /// after the boxes once they are complete. If this is non-zero, the
+  /// fragments are written directly to the output after the reserved space,
+  /// and the boxes are written into it at the end, followed by a 'free' box
+  /// filling the rest of the space. If the boxes do not fit, the media data is
+  /// moved in place to make room for them. The output must be a local file.
+  uint32_t reserved_header_size = 0;
 };
 
 }  // namespace shaka
@@ -0,0 +1,34 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_PUBLIC_ORIGIN_PARAMS_H_
+#define PACKAGER_PUBLIC_ORIGIN_PARAMS_H_
+
+#include <cstdint>
+#include <string>
+
+namespace shaka {
+
+/// Built-in HTTP origin related parameters. The origin serves the files
+/// written to "origin://" paths, e.g. a manifest written to
+/// "origin://live/manifest.mpd" is served as "/live/manifest.mpd". It is only
+/// available if the packager is built with ENABLE_HTTP_ORIGIN.
+struct OriginParams {
+  /// Address to listen on, e.g. "http://0.0.0.0:8080". The origin is
+  /// disabled if empty.
+  std::string listen_address;
+  /// Maximum number of bytes of the "origin://" files kept in memory. The
+  /// least recently completed files are dropped first. Files that are still
+  /// being written are never dropped.
+  uint64_t max_store_size = 512ULL << 20;
+  /// Maximum time a blocking playlist reload request (with the `_HLS_msn`
+  /// query parameter) is held, waiting for the requested segment or part.
+  double max_blocking_reload_in_seconds = 6;
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_PUBLIC_ORIGIN_PARAMS_H_
@@ -22,6 +22,9 @@
 #include <packager/hls_params.h>
 #include <packager/mp4_output_params.h>
 #include <packager/mpd_params.h>
+#include <packager/origin_params.h>
+#include <packager/packager_stats.h>
+#include <packager/stats_params.h>
 #include <packager/status.h>
 
 namespace shaka {
@@ -64,6 +67,24 @@ struct PackagingParams {
   /// Only use a single thread to generate output.  This is useful in tests to
   /// avoid non-deterministic outputs.
   bool single_threaded = false;
+  /// Number of worker threads shared by all the inputs to process their
+  /// outputs in parallel, e.g. to mux the renditions of a ladder on several
+  /// cores. With 0, every input is processed entirely on its own thread.
+  /// Ignored if `single_threaded` is set.
+  uint32_t num_worker_threads = 0;
+  /// Give every output of a stream its own thread, fed through a bounded
+  /// queue, e.g. to generate the trick play tracks and mux the main track in
+  /// parallel. Ignored if `single_threaded` is set.
+  bool parallel_outputs = false;
+  /// Number of segments of a stream which can be packaged in parallel on the
+  /// worker threads. The audio and video streams of local, non-fragmented MP4
+  /// inputs are then split into segments which are demuxed, chunked and
+  /// encrypted independently, and merged back in order, with the same output
+  /// as serial packaging. Other inputs, and options which need the whole
+  /// stream in order, e.g. ad cues or key rotation, use the serial path.
+  /// With 0, every input is demuxed on its own thread. Ignored without
+  /// `num_worker_threads`.
+  uint32_t max_parallel_segments = 0;
 
   /// DASH MPD related parameters.
   MpdParams mpd_params;
@@ -77,6 +98,12 @@ struct PackagingParams {
   /// Buffer callback params.
   BufferCallbackParams buffer_callback_params;
 
+  /// Packaging pipeline statistics parameters.
+  StatsParams stats_params;
+
+  /// Built-in HTTP origin parameters.
+  OriginParams origin_params;
+
   // Parameters for testing. Do not use in production.
   TestParams test_params;
 };
@@ -185,6 +212,12 @@ class SHAKA_EXPORT Packager {
   /// Cancel packaging. Note that it has to be called from another thread.
   void Cancel();
 
+  /// @return the statistics of the packaging pipeline, if
+  ///         `StatsParams::collect_stats` or `StatsParams::stats_output` is
+  ///         set, or empty statistics otherwise. It can be called from another
+  ///         thread while packaging.
+  PackagerStats GetStats() const;
+
   /// @return The version of the library.
   static std::string GetLibraryVersion();
 
@@ -0,0 +1,67 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_PUBLIC_PACKAGER_STATS_H_
+#define PACKAGER_PUBLIC_PACKAGER_STATS_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace shaka {
+
+/// Statistics of a handler of the packaging pipeline, e.g. a demuxer, an
+/// encryptor or a muxer.
+struct MediaHandlerStats {
+  /// Path of the handler in the pipeline, e.g.
+  /// "job0/Demuxer/ChunkingHandler[1]/EncryptionHandler/MP4Muxer", where the
+  /// index is the output of the upstream handler, if it has several.
+  std::string id;
+  /// Class of the handler, e.g. "EncryptionHandler".
+  std::string type;
+  /// Number of stream data received, of any type.
+  uint64_t num_stream_data = 0;
+  /// Number of media and text samples received.
+  uint64_t num_samples = 0;
+  /// Number of bytes of media samples received.
+  uint64_t num_bytes = 0;
+  /// Time spent in the handler, excluding the time spent in the downstream
+  /// handlers it calls on the same thread. For the handler at the head of a
+  /// pipeline, it is the time spent reading and parsing the input.
+  uint64_t processing_time_ns = 0;
+  /// Percentiles of the time spent per stream data or flush request, with a
+  /// precision of 25%. 0 for the handler at the head of a pipeline.
+  uint64_t p50_processing_time_ns = 0;
+  uint64_t p99_processing_time_ns = 0;
+  /// Number of stream data queued in front of the downstream handlers, and
+  /// its maximum, for handlers which queue, e.g. with `parallel_outputs`.
+  uint64_t queue_depth = 0;
+  uint64_t max_queue_depth = 0;
+};
+
+/// Statistics of the packaging pipeline.
+struct PackagerStats {
+  /// The handlers, in the order of the pipelines.
+  std::vector<MediaHandlerStats> handlers;
+  /// Number of buffers allocated for samples and stream data, in the whole
+  /// process.
+  uint64_t num_buffer_allocations = 0;
+  /// Number of those buffers which were not recycled and came from the heap.
+  uint64_t num_buffer_heap_allocations = 0;
+  /// Size of the recycled buffers kept for later allocations.
+  uint64_t cached_buffer_bytes = 0;
+  /// Number of crypto period keys requested by the encryptors when key
+  /// rotation is enabled and the keys are prefetched.
+  uint64_t num_crypto_period_key_requests = 0;
+  /// Number of those keys which were not prefetched in time.
+  uint64_t num_crypto_period_key_waits = 0;
+  /// Time the encryptors spent waiting for those keys.
+  uint64_t crypto_period_key_wait_time_ns = 0;
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_PUBLIC_PACKAGER_STATS_H_
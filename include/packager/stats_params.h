@@ -0,0 +1,38 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_PUBLIC_STATS_PARAMS_H_
+#define PACKAGER_PUBLIC_STATS_PARAMS_H_
+
+#include <string>
+
+namespace shaka {
+
+/// Format of the statistics written to `StatsParams::stats_output`.
+enum class StatsFormat {
+  kJson,
+  /// Prometheus text exposition format.
+  kPrometheus,
+};
+
+/// Packaging pipeline statistics related parameters.
+struct StatsParams {
+  /// Collect statistics of every handler of the packaging pipeline, which are
+  /// returned by Packager::GetStats(). It costs two clock reads per stream
+  /// data per handler.
+  bool collect_stats = false;
+  /// If not empty, the statistics are written to this file periodically
+  /// while packaging, and when packaging ends. Implies `collect_stats`.
+  std::string stats_output;
+  /// Format of `stats_output`.
+  StatsFormat stats_format = StatsFormat::kJson;
+  /// Interval between writes of `stats_output`.
+  double stats_output_interval_in_seconds = 10;
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_PUBLIC_STATS_PARAMS_H_
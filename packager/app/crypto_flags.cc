@@ -39,6 +39,12 @@ ABSL_FLAG(std::string,
           playready_extra_header_data,
           "",
           "Extra XML data to add to PlayReady headers.");
+ABSL_FLAG(int32_t,
+          crypto_period_key_lookahead,
+          2,
+          "Number of crypto periods whose keys are fetched in the background "
+          "ahead of the current one when key rotation is enabled. 0 to fetch "
+          "each key when it is needed.");
 
 bool ValueNotGreaterThanTen(const char* flagname, int32_t value) {
   if (value > 10) {
@@ -83,6 +89,12 @@ bool ValidateCryptoFlags() {
     success = false;
   }
 
+  if (absl::GetFlag(FLAGS_crypto_period_key_lookahead) < 0) {
+    fprintf(stderr, "ERROR: crypto_period_key_lookahead must be "
+                    "non-negative.\n");
+    success = false;
+  }
+
   return success;
 }
 }  // namespace shaka
@@ -46,6 +46,21 @@ ABSL_FLAG(std::optional<double>,
           "beginning of the playlist. A negative number indicates a "
           "negative time offset from the end of the last media segment "
           "in the playlist.");
+ABSL_FLAG(double,
+          hls_part_target_duration,
+          0,
+          "Floating-point number. Target duration of the Low-Latency HLS "
+          "partial segments, in seconds. If positive, the media playlists "
+          "list the CMAF chunks of the segments as EXT-X-PART and announce "
+          "the upcoming part with EXT-X-PRELOAD-HINT. Requires "
+          "--low_latency_dash_mode and a LIVE or EVENT playlist type.");
+ABSL_FLAG(bool,
+          hls_can_block_reload,
+          false,
+          "Advertise blocking playlist reloads (CAN-BLOCK-RELOAD) in the "
+          "Low-Latency HLS media playlists. Set it only if the origin "
+          "serving the playlists supports them. It is implied if the "
+          "playlists are served by the built-in HTTP origin.");
 ABSL_FLAG(bool,
           create_session_keys,
           false,
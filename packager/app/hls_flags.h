@@ -16,6 +16,8 @@ ABSL_DECLARE_FLAG(std::string, hls_key_uri);
 ABSL_DECLARE_FLAG(std::string, hls_playlist_type);
 ABSL_DECLARE_FLAG(int32_t, hls_media_sequence_number);
 ABSL_DECLARE_FLAG(std::optional<double>, hls_start_time_offset);
+ABSL_DECLARE_FLAG(double, hls_part_target_duration);
+ABSL_DECLARE_FLAG(bool, hls_can_block_reload);
 ABSL_DECLARE_FLAG(bool, create_session_keys);
 
 #endif  // PACKAGER_APP_HLS_FLAGS_H_
@@ -10,6 +10,7 @@
 
 #include <absl/log/check.h>
 
+#include <packager/media/base/work_stealing_thread_pool.h>
 #include <packager/media/chunking/sync_point_queue.h>
 #include <packager/media/origin/origin_handler.h>
 
@@ -40,8 +41,12 @@ void Job::Cancel() {
 }
 
 const Status& Job::Run() {
-  if (status_.ok())  // initialized correctly
+  if (status_.ok()) {  // initialized correctly
+    // The time spent in the origin handler itself, e.g. reading and parsing
+    // the input.
+    HandlerStats::ScopedTimer timer(work_->stats(), false);
     status_ = work_->Run();
+  }
 
   on_complete_(this);
 
@@ -55,8 +60,14 @@ void Job::Join() {
   }
 }
 
-JobManager::JobManager(std::unique_ptr<SyncPointQueue> sync_points)
-    : sync_points_(std::move(sync_points)) {}
+JobManager::JobManager(std::unique_ptr<SyncPointQueue> sync_points,
+                       size_t num_worker_threads)
+    : sync_points_(std::move(sync_points)) {
+  if (num_worker_threads > 0)
+    thread_pool_.reset(new WorkStealingThreadPool(num_worker_threads));
+}
+
+JobManager::~JobManager() = default;
 
 void JobManager::Add(const std::string& name,
                      std::shared_ptr<OriginHandler> handler) {
@@ -72,6 +83,19 @@ Status JobManager::InitializeJobs() {
   return status;
 }
 
+void JobManager::EnableStats() {
+  for (auto& job : jobs_)
+    job->work()->EnableStats();
+}
+
+void JobManager::GetStats(std::vector<MediaHandlerStats>* stats) const {
+  for (size_t i = 0; i < jobs_.size(); ++i) {
+    const OriginHandler* handler = jobs_[i]->work();
+    handler->GetStats("job" + std::to_string(i) + "/" + handler->GetTypeName(),
+                      stats);
+  }
+}
+
 Status JobManager::RunJobs() {
   std::set<Job*> active_jobs;
 
@@ -115,6 +139,10 @@ Status JobManager::RunJobs() {
   for (auto& job : active_jobs)
     job->Join();
 
+  // A failed or cancelled job may have left work queued on the pool.
+  if (thread_pool_)
+    thread_pool_->WaitForIdle();
+
   return status;
 }
 
@@ -15,6 +15,7 @@
 
 #include <absl/synchronization/mutex.h>
 
+#include <packager/packager_stats.h>
 #include <packager/status.h>
 
 namespace shaka {
@@ -22,6 +23,7 @@ namespace media {
 
 class OriginHandler;
 class SyncPointQueue;
+class WorkStealingThreadPool;
 
 // A job is a single line of work that is expected to run in parallel with
 // other jobs.
@@ -63,6 +65,9 @@ class Job {
   // The name given to this job in the constructor.
   const std::string& name() const { return name_; }
 
+  // The origin handler at the top of the chain.
+  OriginHandler* work() const { return work_.get(); }
+
  private:
   Job(const Job&) = delete;
   Job& operator=(const Job&) = delete;
@@ -82,9 +87,13 @@ class JobManager {
   // @param sync_points is an optional SyncPointQueue used to synchronize and
   //        align cue points. JobManager cancels @a sync_points when any job
   //        fails or is cancelled. It can be NULL.
-  explicit JobManager(std::unique_ptr<SyncPointQueue> sync_points);
+  // @param num_worker_threads is the size of the thread pool shared by the
+  //        jobs to run parts of their pipelines, see |thread_pool|. No pool
+  //        is created if it is 0.
+  explicit JobManager(std::unique_ptr<SyncPointQueue> sync_points,
+                      size_t num_worker_threads = 0);
 
-  virtual ~JobManager() = default;
+  virtual ~JobManager();
 
   // Create a new job entry by specifying the origin handler at the top of the
   // chain and a name for the thread. This will only register the job. To start
@@ -107,6 +116,19 @@ class JobManager {
 
   SyncPointQueue* sync_points() { return sync_points_.get(); }
 
+  // Collect statistics in the handlers of all registered jobs. Call before
+  // |RunJobs|.
+  void EnableStats();
+
+  // Append the statistics of the handlers of all registered jobs to |stats|,
+  // if they are collected. It can be called while the jobs run.
+  void GetStats(std::vector<MediaHandlerStats>* stats) const;
+
+  // A thread pool which the pipelines of the jobs can hand work to, e.g. the
+  // output branches after a Replicator, through an AsyncQueueHandler. It is
+  // idle when |RunJobs| returns. It can be NULL.
+  WorkStealingThreadPool* thread_pool() { return thread_pool_.get(); }
+
  protected:
   JobManager(const JobManager&) = delete;
   JobManager& operator=(const JobManager&) = delete;
@@ -119,6 +141,10 @@ class JobManager {
 
   std::vector<std::unique_ptr<Job>> jobs_;
 
+  // Declared after |jobs_| so the workers are joined before the handlers they
+  // may still be running are destroyed.
+  std::unique_ptr<WorkStealingThreadPool> thread_pool_;
+
   absl::Mutex mutex_;
   std::map<Job*, bool> complete_ ABSL_GUARDED_BY(mutex_);
   absl::CondVar any_job_complete_ ABSL_GUARDED_BY(mutex_);
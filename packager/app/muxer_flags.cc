@@ -54,6 +54,14 @@ ABSL_FLAG(bool,
           mp4_include_pssh_in_stream,
           true,
           "MP4 only: include pssh in the encrypted stream.");
+ABSL_FLAG(uint32_t,
+          mp4_reserved_header_size,
+          0,
+          "MP4 only, used only if single_segment=true: space, in bytes, to "
+          "reserve at the start of the output for the 'ftyp', 'moov' and "
+          "'sidx' boxes. If non-zero, media is written directly to the output "
+          "instead of to a temporary file which is then copied. The output "
+          "must be a local file. 64KB fits several thousand subsegments.");
 ABSL_FLAG(int32_t,
           transport_stream_timestamp_offset_ms,
           100,
@@ -57,6 +57,58 @@ ABSL_FLAG(bool,
           single_threaded,
           false,
           "If enabled, only use one thread when generating content.");
+ABSL_FLAG(uint32_t,
+          num_worker_threads,
+          0,
+          "Number of worker threads shared by all the inputs to package their "
+          "outputs in parallel. If 0, every input is packaged entirely on its "
+          "own thread. Ignored if --single_threaded is set.");
+ABSL_FLAG(bool,
+          parallel_outputs,
+          false,
+          "If enabled, every output of a stream is packaged on its own "
+          "thread. Ignored if --single_threaded is set.");
+ABSL_FLAG(uint32_t,
+          max_parallel_segments,
+          0,
+          "Number of segments of a stream which can be packaged in parallel "
+          "on the worker threads. Audio and video streams of local, "
+          "non-fragmented MP4 inputs are split into segments which are "
+          "demuxed, chunked and encrypted independently. If 0, every input is "
+          "demuxed on its own thread. Ignored without --num_worker_threads.");
+ABSL_FLAG(std::string,
+          stats_output,
+          "",
+          "If set, statistics of every handler of the packaging pipeline, "
+          "e.g. samples, bytes and time spent, are written to this file "
+          "periodically and when packaging ends.");
+ABSL_FLAG(std::string,
+          stats_format,
+          "json",
+          "Format of --stats_output: 'json' or 'prometheus' (text exposition "
+          "format).");
+ABSL_FLAG(double,
+          stats_output_interval,
+          10,
+          "Interval between writes of --stats_output, in seconds.");
+ABSL_FLAG(std::string,
+          http_origin_address,
+          "",
+          "If set, e.g. to 'http://0.0.0.0:8080', the files written to "
+          "'origin://' paths are served over HTTP on this address, e.g. "
+          "'origin://live/manifest.mpd' as '/live/manifest.mpd'. Segments are "
+          "delivered with chunked transfer encoding while they are written. "
+          "Requires a packager built with ENABLE_HTTP_ORIGIN.");
+ABSL_FLAG(uint64_t,
+          http_origin_max_store_size,
+          512ULL << 20,
+          "Maximum number of bytes of 'origin://' files kept in memory. The "
+          "least recently completed files are dropped first.");
+ABSL_FLAG(double,
+          http_origin_max_blocking_reload,
+          6,
+          "Maximum time an HLS blocking playlist reload request is held by "
+          "the HTTP origin, in seconds.");
 
 // From absl/log:
 ABSL_DECLARE_FLAG(int, stderrthreshold);
@@ -341,6 +393,32 @@ std::optional<PackagingParams> GetPackagingParams() {
 
   packaging_params.temp_dir = absl::GetFlag(FLAGS_temp_dir);
   packaging_params.single_threaded = absl::GetFlag(FLAGS_single_threaded);
+  packaging_params.num_worker_threads =
+      absl::GetFlag(FLAGS_num_worker_threads);
+  packaging_params.parallel_outputs = absl::GetFlag(FLAGS_parallel_outputs);
+  packaging_params.max_parallel_segments =
+      absl::GetFlag(FLAGS_max_parallel_segments);
+
+  StatsParams& stats_params = packaging_params.stats_params;
+  stats_params.stats_output = absl::GetFlag(FLAGS_stats_output);
+  stats_params.stats_output_interval_in_seconds =
+      absl::GetFlag(FLAGS_stats_output_interval);
+  const std::string stats_format = absl::GetFlag(FLAGS_stats_format);
+  if (stats_format == "json") {
+    stats_params.stats_format = StatsFormat::kJson;
+  } else if (stats_format == "prometheus") {
+    stats_params.stats_format = StatsFormat::kPrometheus;
+  } else {
+    LOG(ERROR) << "Unrecognized --stats_format " << stats_format;
+    return std::nullopt;
+  }
+
+  OriginParams& origin_params = packaging_params.origin_params;
+  origin_params.listen_address = absl::GetFlag(FLAGS_http_origin_address);
+  origin_params.max_store_size =
+      absl::GetFlag(FLAGS_http_origin_max_store_size);
+  origin_params.max_blocking_reload_in_seconds =
+      absl::GetFlag(FLAGS_http_origin_max_blocking_reload);
 
   AdCueGeneratorParams& ad_cue_generator_params =
       packaging_params.ad_cue_generator_params;
@@ -398,6 +476,8 @@ std::optional<PackagingParams> GetPackagingParams() {
 
     encryption_params.crypto_period_duration_in_seconds =
         absl::GetFlag(FLAGS_crypto_period_duration);
+    encryption_params.crypto_period_key_lookahead =
+        absl::GetFlag(FLAGS_crypto_period_key_lookahead);
     encryption_params.vp9_subsample_encryption =
         absl::GetFlag(FLAGS_vp9_subsample_encryption);
     encryption_params.stream_label_func = std::bind(
@@ -475,6 +555,8 @@ std::optional<PackagingParams> GetPackagingParams() {
   mp4_params.include_pssh_in_stream =
       absl::GetFlag(FLAGS_mp4_include_pssh_in_stream);
   mp4_params.low_latency_dash_mode = absl::GetFlag(FLAGS_low_latency_dash_mode);
+  mp4_params.reserved_header_size =
+      absl::GetFlag(FLAGS_mp4_reserved_header_size);
 
   packaging_params.transport_stream_timestamp_offset_ms =
       absl::GetFlag(FLAGS_transport_stream_timestamp_offset_ms);
@@ -543,6 +625,9 @@ std::optional<PackagingParams> GetPackagingParams() {
   hls_params.media_sequence_number =
       absl::GetFlag(FLAGS_hls_media_sequence_number);
   hls_params.start_time_offset = absl::GetFlag(FLAGS_hls_start_time_offset);
+  hls_params.part_target_duration =
+      absl::GetFlag(FLAGS_hls_part_target_duration);
+  hls_params.can_block_reload = absl::GetFlag(FLAGS_hls_can_block_reload);
   hls_params.create_session_keys = absl::GetFlag(FLAGS_create_session_keys);
 
   TestParams& test_params = packaging_params.test_params;
@@ -0,0 +1,214 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/app/stats_writer.h>
+
+#include <absl/log/log.h>
+#include <absl/strings/str_format.h>
+#include <absl/strings/str_replace.h>
+#include <absl/time/clock.h>
+#include <nlohmann/json.hpp>
+
+#include <packager/file.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+const double kNanosecondsPerSecond = 1e9;
+
+std::string EscapeLabelValue(const std::string& value) {
+  return absl::StrReplaceAll(value,
+                             {{"\\", "\\\\"}, {"\"", "\\\""}, {"\n", "\\n"}});
+}
+
+// Appends a metric with a value per handler.
+void AppendHandlerMetric(
+    const PackagerStats& stats,
+    const std::string& name,
+    const std::string& type,
+    const std::string& help,
+    const std::function<double(const MediaHandlerStats&)>& get_value,
+    std::string* output) {
+  absl::StrAppendFormat(output, "# HELP %s %s\n# TYPE %s %s\n", name, help,
+                        name, type);
+  for (const MediaHandlerStats& handler : stats.handlers) {
+    absl::StrAppendFormat(output, "%s{id=\"%s\",type=\"%s\"} %.9g\n", name,
+                          EscapeLabelValue(handler.id),
+                          EscapeLabelValue(handler.type), get_value(handler));
+  }
+}
+
+void AppendMetric(const std::string& name,
+                  const std::string& type,
+                  const std::string& help,
+                  uint64_t value,
+                  std::string* output) {
+  absl::StrAppendFormat(output, "# HELP %s %s\n# TYPE %s %s\n%s %d\n", name,
+                        help, name, type, name, value);
+}
+
+void AppendMetric(const std::string& name,
+                  const std::string& type,
+                  const std::string& help,
+                  double value,
+                  std::string* output) {
+  absl::StrAppendFormat(output, "# HELP %s %s\n# TYPE %s %s\n%s %.9g\n", name,
+                        help, name, type, name, value);
+}
+
+}  // namespace
+
+std::string FormatStatsAsJson(const PackagerStats& stats) {
+  nlohmann::json handlers = nlohmann::json::array();
+  for (const MediaHandlerStats& handler : stats.handlers) {
+    handlers.push_back({
+        {"id", handler.id},
+        {"type", handler.type},
+        {"num_stream_data", handler.num_stream_data},
+        {"num_samples", handler.num_samples},
+        {"num_bytes", handler.num_bytes},
+        {"processing_time_ns", handler.processing_time_ns},
+        {"p50_processing_time_ns", handler.p50_processing_time_ns},
+        {"p99_processing_time_ns", handler.p99_processing_time_ns},
+        {"queue_depth", handler.queue_depth},
+        {"max_queue_depth", handler.max_queue_depth},
+    });
+  }
+  nlohmann::json json = {
+      {"handlers", handlers},
+      {"num_buffer_allocations", stats.num_buffer_allocations},
+      {"num_buffer_heap_allocations", stats.num_buffer_heap_allocations},
+      {"cached_buffer_bytes", stats.cached_buffer_bytes},
+      {"num_crypto_period_key_requests", stats.num_crypto_period_key_requests},
+      {"num_crypto_period_key_waits", stats.num_crypto_period_key_waits},
+      {"crypto_period_key_wait_time_ns", stats.crypto_period_key_wait_time_ns},
+  };
+  return json.dump(2) + "\n";
+}
+
+std::string FormatStatsAsPrometheus(const PackagerStats& stats) {
+  std::string output;
+  AppendHandlerMetric(
+      stats, "shaka_packager_handler_stream_data_total", "counter",
+      "Stream data received by the handler.",
+      [](const MediaHandlerStats& s) { return s.num_stream_data; }, &output);
+  AppendHandlerMetric(
+      stats, "shaka_packager_handler_samples_total", "counter",
+      "Media and text samples received by the handler.",
+      [](const MediaHandlerStats& s) { return s.num_samples; }, &output);
+  AppendHandlerMetric(
+      stats, "shaka_packager_handler_bytes_total", "counter",
+      "Bytes of media samples received by the handler.",
+      [](const MediaHandlerStats& s) { return s.num_bytes; }, &output);
+  AppendHandlerMetric(
+      stats, "shaka_packager_handler_processing_seconds_total", "counter",
+      "Time spent in the handler, excluding the downstream handlers.",
+      [](const MediaHandlerStats& s) {
+        return s.processing_time_ns / kNanosecondsPerSecond;
+      },
+      &output);
+  AppendHandlerMetric(
+      stats, "shaka_packager_handler_processing_seconds_p50", "gauge",
+      "Median time spent in the handler per call.",
+      [](const MediaHandlerStats& s) {
+        return s.p50_processing_time_ns / kNanosecondsPerSecond;
+      },
+      &output);
+  AppendHandlerMetric(
+      stats, "shaka_packager_handler_processing_seconds_p99", "gauge",
+      "99th percentile of the time spent in the handler per call.",
+      [](const MediaHandlerStats& s) {
+        return s.p99_processing_time_ns / kNanosecondsPerSecond;
+      },
+      &output);
+  AppendHandlerMetric(
+      stats, "shaka_packager_handler_queue_depth", "gauge",
+      "Stream data queued by the handler.",
+      [](const MediaHandlerStats& s) { return s.queue_depth; }, &output);
+  AppendHandlerMetric(
+      stats, "shaka_packager_handler_max_queue_depth", "gauge",
+      "Maximum number of stream data queued by the handler.",
+      [](const MediaHandlerStats& s) { return s.max_queue_depth; }, &output);
+
+  AppendMetric("shaka_packager_buffer_allocations_total", "counter",
+               "Buffers allocated for samples and stream data.",
+               stats.num_buffer_allocations, &output);
+  AppendMetric("shaka_packager_buffer_heap_allocations_total", "counter",
+               "Buffers allocated from the heap instead of being recycled.",
+               stats.num_buffer_heap_allocations, &output);
+  AppendMetric("shaka_packager_cached_buffer_bytes", "gauge",
+               "Size of the buffers kept for recycling.",
+               stats.cached_buffer_bytes, &output);
+  AppendMetric("shaka_packager_crypto_period_key_requests_total", "counter",
+               "Crypto period keys requested by the encryptors.",
+               stats.num_crypto_period_key_requests, &output);
+  AppendMetric("shaka_packager_crypto_period_key_waits_total", "counter",
+               "Crypto period keys the encryptors waited for.",
+               stats.num_crypto_period_key_waits, &output);
+  AppendMetric("shaka_packager_crypto_period_key_wait_seconds_total",
+               "counter", "Time the encryptors spent waiting for keys.",
+               stats.crypto_period_key_wait_time_ns / kNanosecondsPerSecond,
+               &output);
+  return output;
+}
+
+StatsWriter::StatsWriter(const StatsParams& stats_params,
+                         std::function<PackagerStats()> get_stats)
+    : stats_params_(stats_params), get_stats_(std::move(get_stats)) {}
+
+StatsWriter::~StatsWriter() {
+  if (writer_thread_.joinable())
+    Stop();
+}
+
+void StatsWriter::Start() {
+  writer_thread_ = std::thread(&StatsWriter::WriteInBackground, this);
+}
+
+bool StatsWriter::Stop() {
+  if (writer_thread_.joinable()) {
+    {
+      absl::MutexLock lock(&mutex_);
+      stop_writer_ = true;
+    }
+    writer_thread_.join();
+  }
+  return Write();
+}
+
+bool StatsWriter::Write() {
+  const PackagerStats stats = get_stats_();
+  const std::string contents =
+      stats_params_.stats_format == StatsFormat::kPrometheus
+          ? FormatStatsAsPrometheus(stats)
+          : FormatStatsAsJson(stats);
+  if (!File::WriteFileAtomically(stats_params_.stats_output.c_str(),
+                                 contents)) {
+    LOG(ERROR) << "Failed to write stats to: " << stats_params_.stats_output;
+    return false;
+  }
+  return true;
+}
+
+void StatsWriter::WriteInBackground() {
+  const absl::Duration interval =
+      absl::Seconds(stats_params_.stats_output_interval_in_seconds);
+  while (true) {
+    {
+      absl::MutexLock lock(&mutex_);
+      const absl::Time deadline = absl::Now() + interval;
+      while (!stop_writer_ && absl::Now() < deadline)
+        mutex_.AwaitWithDeadline(absl::Condition(&stop_writer_), deadline);
+      if (stop_writer_)
+        return;
+    }
+    Write();
+  }
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,64 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_APP_STATS_WRITER_H_
+#define PACKAGER_APP_STATS_WRITER_H_
+
+#include <functional>
+#include <string>
+#include <thread>
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+
+#include <packager/packager_stats.h>
+#include <packager/stats_params.h>
+
+namespace shaka {
+namespace media {
+
+/// @return @a stats formatted as a JSON object.
+std::string FormatStatsAsJson(const PackagerStats& stats);
+
+/// @return @a stats formatted in the Prometheus text exposition format.
+std::string FormatStatsAsPrometheus(const PackagerStats& stats);
+
+/// Writes the statistics of the packager to StatsParams::stats_output
+/// periodically, on a background thread.
+class StatsWriter {
+ public:
+  /// @param get_stats returns the statistics to write. It is called on the
+  ///        background thread.
+  StatsWriter(const StatsParams& stats_params,
+              std::function<PackagerStats()> get_stats);
+  ~StatsWriter();
+
+  /// Starts writing periodically.
+  void Start();
+
+  /// Stops writing periodically, and writes the statistics one last time.
+  /// @return true if the last write succeeded.
+  bool Stop();
+
+ private:
+  StatsWriter(const StatsWriter&) = delete;
+  StatsWriter& operator=(const StatsWriter&) = delete;
+
+  bool Write();
+  void WriteInBackground();
+
+  const StatsParams stats_params_;
+  std::function<PackagerStats()> get_stats_;
+  std::thread writer_thread_;
+
+  absl::Mutex mutex_;
+  bool stop_writer_ ABSL_GUARDED_BY(mutex_) = false;
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_APP_STATS_WRITER_H_
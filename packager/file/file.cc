@@ -20,8 +20,10 @@
 #include <packager/file/callback_file.h>
 #include <packager/file/file_util.h>
 #include <packager/file/http_file.h>
+#include <packager/file/io_uring_file.h>
 #include <packager/file/local_file.h>
 #include <packager/file/memory_file.h>
+#include <packager/file/origin_file.h>
 #include <packager/file/threaded_io_file.h>
 #include <packager/file/udp_file.h>
 #include <packager/macros/compiler.h>
@@ -36,12 +38,26 @@ ABSL_FLAG(uint64_t,
           io_block_size,
           1ULL << 16,
           "Size of the block size used for threaded I/O, in bytes.");
+ABSL_FLAG(bool,
+          mmap_input_files,
+          false,
+          "Memory map local input files instead of reading them through "
+          "stdio. Threaded I/O is not used for the files which are mapped, "
+          "since reading from the mapping is already asynchronous.");
+ABSL_FLAG(bool,
+          io_uring_output_files,
+          false,
+          "Write local output files through a single io_uring for the whole "
+          "process, instead of a thread per file. Linux only. Threaded I/O "
+          "is used if io_uring is not available. Up to --io_cache_size bytes "
+          "are written asynchronously per file.");
 
 namespace shaka {
 
 const char* kCallbackFilePrefix = "callback://";
 const char* kLocalFilePrefix = "file://";
 const char* kMemoryFilePrefix = "memory://";
+const char* kOriginFilePrefix = "origin://";
 const char* kUdpFilePrefix = "udp://";
 const char* kHttpFilePrefix = "http://";
 const char* kHttpsFilePrefix = "https://";
@@ -136,6 +152,25 @@ bool DeleteMemoryFile(const char* file_name) {
   return true;
 }
 
+File* CreateOriginFile(const char* file_name, const char* mode) {
+  return new OriginFile(file_name, mode);
+}
+
+bool DeleteOriginFile(const char* file_name) {
+  return OriginFile::Delete(file_name);
+}
+
+bool WriteOriginFileAtomically(const char* file_name,
+                               const std::string& contents) {
+  // The previous version is served until the new one is closed.
+  std::unique_ptr<File, FileCloser> file(File::OpenWithNoBuffering(
+      (std::string(kOriginFilePrefix) + file_name).c_str(), "w"));
+  if (!file)
+    return false;
+  return file->Write(contents.data(), contents.size()) ==
+         static_cast<int64_t>(contents.size());
+}
+
 static const FileTypeInfo kFileTypeInfo[] = {
     {
         kLocalFilePrefix,
@@ -146,6 +181,8 @@ static const FileTypeInfo kFileTypeInfo[] = {
     {kUdpFilePrefix, &CreateUdpFile, nullptr, nullptr},
     {kMemoryFilePrefix, &CreateMemoryFile, &DeleteMemoryFile, nullptr},
     {kCallbackFilePrefix, &CreateCallbackFile, nullptr, nullptr},
+    {kOriginFilePrefix, &CreateOriginFile, &DeleteOriginFile,
+     &WriteOriginFileAtomically},
     {kHttpFilePrefix, &CreateHttpFile, &DeleteHttpFile, nullptr},
     {kHttpsFilePrefix, &CreateHttpsFile, &DeleteHttpsFile, nullptr},
 };
@@ -169,16 +206,44 @@ const FileTypeInfo* GetFileTypeInfo(std::string_view file_name,
   return &kFileTypeInfo[0];
 }
 
+// Returns true if the file may be memory mapped by LocalFile. Whether it is
+// only known once it is open.
+bool MayMapFile(std::string_view file_type_prefix, const char* mode) {
+  return absl::GetFlag(FLAGS_mmap_input_files) && !strcmp(mode, "r") &&
+         (file_type_prefix.empty() || file_type_prefix == kLocalFilePrefix);
+}
+
 }  // namespace
 
 File* File::Create(const char* file_name, const char* mode) {
+#if defined(__linux__)
+  if (absl::GetFlag(FLAGS_io_uring_output_files) &&
+      (!strcmp(mode, "w") || !strcmp(mode, "a")) &&
+      absl::GetFlag(FLAGS_io_cache_size) && IoUring::GetInstance()) {
+    std::string_view real_file_name;
+    const FileTypeInfo* file_type = GetFileTypeInfo(file_name, &real_file_name);
+    if (file_type->type == kLocalFilePrefix) {
+      return new IoUringFile(real_file_name.data(), mode,
+                             absl::GetFlag(FLAGS_io_cache_size));
+    }
+  }
+#endif  // defined(__linux__)
+
   std::unique_ptr<File, FileCloser> internal_file(
       CreateInternalFile(file_name, mode));
 
   std::string_view file_type_prefix = GetFileTypePrefix(file_name);
   if (file_type_prefix == kMemoryFilePrefix ||
-      file_type_prefix == kCallbackFilePrefix) {
-    // Disable caching for memory and callback files.
+      file_type_prefix == kCallbackFilePrefix ||
+      file_type_prefix == kOriginFilePrefix) {
+    // Disable caching for memory, callback and origin files. Origin files are
+    // served while they are written.
+    return internal_file.release();
+  }
+
+  if (MayMapFile(file_type_prefix, mode)) {
+    // Memory mapped files are read directly from the page cache. Open() adds
+    // threaded I/O if the file cannot be mapped.
     return internal_file.release();
   }
 
@@ -218,6 +283,18 @@ File* File::Open(const char* file_name, const char* mode) {
     delete file;
     return NULL;
   }
+
+  // Files which could not be mapped, e.g. pipes, are read with threaded I/O
+  // like other inputs.
+  if (MayMapFile(GetFileTypePrefix(file_name), mode) &&
+      absl::GetFlag(FLAGS_io_cache_size) &&
+      !static_cast<LocalFile*>(file)->is_mapped()) {
+    ThreadedIoFile* threaded_file = new ThreadedIoFile(
+        std::unique_ptr<File, FileCloser>(file), ThreadedIoFile::kInputMode,
+        absl::GetFlag(FLAGS_io_cache_size), absl::GetFlag(FLAGS_io_block_size));
+    threaded_file->Start();
+    return threaded_file;
+  }
   return file;
 }
 
@@ -251,6 +328,23 @@ bool File::Delete(const char* file_name) {
   }
 }
 
+int64_t File::WriteV(const IoVec* blocks, size_t num_blocks) {
+  int64_t total_size_written = 0;
+  for (size_t i = 0; i < num_blocks; ++i) {
+    const uint8_t* data = static_cast<const uint8_t*>(blocks[i].data);
+    uint64_t remaining_size = blocks[i].length;
+    while (remaining_size > 0) {
+      const int64_t size_written = Write(data, remaining_size);
+      if (size_written <= 0)
+        return -1;
+      data += size_written;
+      remaining_size -= size_written;
+      total_size_written += size_written;
+    }
+  }
+  return total_size_written;
+}
+
 int64_t File::GetFileSize(const char* file_name) {
   File* file = File::Open(file_name, "r");
   if (!file)
@@ -420,6 +514,22 @@ bool File::IsLocalRegularFile(const char* file_name) {
   return std::filesystem::is_regular_file(real_file_path, ec);
 }
 
+bool File::IsLocalRegularOutputFile(const char* file_name) {
+  std::string_view real_file_name;
+  const FileTypeInfo* file_type = GetFileTypeInfo(file_name, &real_file_name);
+  DCHECK(file_type);
+
+  if (file_type->type != kLocalFilePrefix)
+    return false;
+
+  std::error_code ec;
+  auto real_file_path = std::filesystem::u8path(real_file_name);
+  const std::filesystem::file_type type =
+      std::filesystem::status(real_file_path, ec).type();
+  return type == std::filesystem::file_type::regular ||
+         type == std::filesystem::file_type::not_found;
+}
+
 std::string File::MakeCallbackFileName(
     const BufferCallbackParams& callback_params,
     const std::string& name) {
@@ -14,10 +14,16 @@
 #include <gtest/gtest.h>
 
 #include <packager/file/file_test_util.h>
+#include <packager/file/io_uring.h>
+#include <packager/file/io_uring_file.h>
+#include <packager/file/local_file.h>
+#include <packager/file/threaded_io_file.h>
 #include <packager/flag_saver.h>
 
 ABSL_DECLARE_FLAG(uint64_t, io_cache_size);
 ABSL_DECLARE_FLAG(uint64_t, io_block_size);
+ABSL_DECLARE_FLAG(bool, mmap_input_files);
+ABSL_DECLARE_FLAG(bool, io_uring_output_files);
 
 namespace {
 const int kDataSize = 1024;
@@ -157,6 +163,35 @@ TEST_F(LocalFileTest, Write) {
   EXPECT_EQ(data_, read_data);
 }
 
+TEST_F(LocalFileTest, WriteV) {
+  const int kHeaderSize = 10;
+  const int kBlockSize = 1000;
+  File* file = File::Open(local_file_name_.c_str(), "w");
+  ASSERT_TRUE(file != NULL);
+  // Data written by Write() is buffered, and must come before the blocks.
+  EXPECT_EQ(kHeaderSize, file->Write(&data_[0], kHeaderSize));
+  const File::IoVec blocks[] = {
+      {&data_[kHeaderSize], kBlockSize},
+      {&data_[kHeaderSize + kBlockSize], 0},
+      {&data_[kHeaderSize + kBlockSize],
+       static_cast<uint64_t>(kDataSize - kHeaderSize - kBlockSize)},
+  };
+  EXPECT_EQ(kDataSize - kHeaderSize, file->WriteV(blocks, 3));
+  uint64_t position = 0;
+  ASSERT_TRUE(file->Tell(&position));
+  EXPECT_EQ(static_cast<uint64_t>(kDataSize), position);
+  EXPECT_EQ(kHeaderSize, file->Write(&data_[0], kHeaderSize));
+  ASSERT_TRUE(file->Tell(&position));
+  EXPECT_EQ(static_cast<uint64_t>(kDataSize + kHeaderSize), position);
+  EXPECT_TRUE(file->Close());
+
+  std::string read_data;
+  ASSERT_EQ(kDataSize + kHeaderSize,
+            ReadFile(local_file_name_no_prefix_, &read_data,
+                     kDataSize + kHeaderSize));
+  EXPECT_EQ(data_ + data_.substr(0, kHeaderSize), read_data);
+}
+
 TEST_F(LocalFileTest, Read_And_Eof) {
   WriteFile(local_file_name_no_prefix_, data_);
 
@@ -181,6 +216,136 @@ TEST_F(LocalFileTest, Read_And_Eof) {
   EXPECT_EQ(data_, read_data);
 }
 
+TEST_F(LocalFileTest, ReadMapped) {
+  WriteFile(local_file_name_no_prefix_, data_);
+
+  FlagSaver<bool> backup_mmap_input_files(&FLAGS_mmap_input_files);
+  absl::SetFlag(&FLAGS_mmap_input_files, true);
+  // Threaded I/O is bypassed for mapped files.
+  absl::SetFlag(&FLAGS_io_cache_size, 1000);
+  File* file = File::Open(local_file_name_.c_str(), "r");
+  ASSERT_TRUE(file != NULL);
+  LocalFile* local_file = dynamic_cast<LocalFile*>(file);
+  ASSERT_TRUE(local_file != NULL);
+#if !defined(OS_WIN)
+  ASSERT_TRUE(local_file->is_mapped());
+#endif  // !defined(OS_WIN)
+  EXPECT_EQ(kDataSize, file->Size());
+
+  // Read half of the file through a copy, and the rest without.
+  const int kFirstReadBytes = kDataSize / 2;
+  std::string read_data(kFirstReadBytes, 0);
+  EXPECT_EQ(kFirstReadBytes, file->Read(&read_data[0], kFirstReadBytes));
+  if (local_file->is_mapped()) {
+    const uint8_t* view = nullptr;
+    EXPECT_EQ(kDataSize - kFirstReadBytes,
+              local_file->ReadView(kDataSize, &view));
+    read_data.append(reinterpret_cast<const char*>(view),
+                     kDataSize - kFirstReadBytes);
+    EXPECT_EQ(0, local_file->ReadView(kDataSize, &view));
+  } else {
+    read_data.resize(kDataSize);
+    EXPECT_EQ(kDataSize - kFirstReadBytes,
+              file->Read(&read_data[kFirstReadBytes], kDataSize));
+  }
+  EXPECT_EQ(data_, read_data);
+
+  uint8_t single_byte;
+  EXPECT_EQ(0, file->Read(&single_byte, sizeof(single_byte)));
+  // Seeking back works like for any other file.
+  ASSERT_TRUE(file->Seek(kDataSize - 1));
+  uint64_t position = 0;
+  ASSERT_TRUE(file->Tell(&position));
+  EXPECT_EQ(kDataSize - 1u, position);
+  EXPECT_EQ(1, file->Read(&single_byte, sizeof(single_byte)));
+  EXPECT_EQ(data_.back(), static_cast<char>(single_byte));
+  EXPECT_TRUE(file->Close());
+}
+
+// Files which cannot be mapped, e.g. empty files, are read with threaded I/O.
+TEST_F(LocalFileTest, ReadUnmappedWithMmapInputFiles) {
+  WriteFile(local_file_name_no_prefix_, "");
+
+  FlagSaver<bool> backup_mmap_input_files(&FLAGS_mmap_input_files);
+  absl::SetFlag(&FLAGS_mmap_input_files, true);
+  absl::SetFlag(&FLAGS_io_cache_size, 1000);
+  File* file = File::Open(local_file_name_.c_str(), "r");
+  ASSERT_TRUE(file != NULL);
+  EXPECT_TRUE(dynamic_cast<ThreadedIoFile*>(file) != NULL);
+  EXPECT_EQ(0, file->Size());
+  uint8_t single_byte;
+  EXPECT_EQ(0, file->Read(&single_byte, sizeof(single_byte)));
+  EXPECT_TRUE(file->Close());
+}
+
+#if defined(__linux__)
+TEST_F(LocalFileTest, WriteThroughIoUring) {
+  if (!IoUring::GetInstance())
+    GTEST_SKIP() << "io_uring is not available.";
+
+  FlagSaver<bool> backup_io_uring_output_files(&FLAGS_io_uring_output_files);
+  absl::SetFlag(&FLAGS_io_uring_output_files, true);
+  // Less than a block is written asynchronously, so that writes wait.
+  absl::SetFlag(&FLAGS_io_cache_size, IoUring::kBlockSize / 2);
+
+  // Several blocks, in small and large writes, the last block being partial.
+  std::string expected;
+  for (int i = 0; i < 200; ++i)
+    expected += data_;
+  std::string large_data(3 * IoUring::kBlockSize + 100, 'x');
+  expected += large_data;
+
+  File* file = File::Open(local_file_name_.c_str(), "w");
+  ASSERT_TRUE(file != NULL);
+  ASSERT_TRUE(dynamic_cast<IoUringFile*>(file) != NULL);
+  for (int i = 0; i < 200; ++i)
+    ASSERT_EQ(kDataSize, file->Write(data_.data(), kDataSize));
+  ASSERT_EQ(static_cast<int64_t>(large_data.size()),
+            file->Write(large_data.data(), large_data.size()));
+  EXPECT_EQ(static_cast<int64_t>(expected.size()), file->Size());
+
+  // Rewrite the beginning, like a box size.
+  ASSERT_TRUE(file->Seek(10));
+  ASSERT_EQ(4, file->Write("abcd", 4));
+  expected.replace(10, 4, "abcd");
+  uint64_t position = 0;
+  ASSERT_TRUE(file->Tell(&position));
+  EXPECT_EQ(14u, position);
+  EXPECT_TRUE(file->Close());
+
+  // Append.
+  file = File::Open(local_file_name_.c_str(), "a");
+  ASSERT_TRUE(file != NULL);
+  EXPECT_EQ(static_cast<int64_t>(expected.size()), file->Size());
+  ASSERT_EQ(kDataSize, file->Write(data_.data(), kDataSize));
+  expected += data_;
+  EXPECT_TRUE(file->Close());
+
+  std::string read_data;
+  ASSERT_TRUE(File::ReadFileToString(local_file_name_.c_str(), &read_data));
+  EXPECT_EQ(expected, read_data);
+}
+
+TEST_F(LocalFileTest, IoUringWriteFailureFailsFile) {
+  if (!IoUring::GetInstance())
+    GTEST_SKIP() << "io_uring is not available.";
+
+  FlagSaver<bool> backup_io_uring_output_files(&FLAGS_io_uring_output_files);
+  absl::SetFlag(&FLAGS_io_uring_output_files, true);
+  absl::SetFlag(&FLAGS_io_cache_size, IoUring::kBlockSize);
+
+  // Every write to /dev/full fails with ENOSPC.
+  File* file = File::Open("/dev/full", "w");
+  ASSERT_TRUE(file != NULL);
+  ASSERT_TRUE(dynamic_cast<IoUringFile*>(file) != NULL);
+  ASSERT_EQ(kDataSize, file->Write(data_.data(), kDataSize));
+  EXPECT_FALSE(file->Flush());
+  // Later writes fail too.
+  EXPECT_EQ(-1, file->Write(data_.data(), kDataSize));
+  EXPECT_FALSE(file->Close());
+}
+#endif  // defined(__linux__)
+
 TEST_F(LocalFileTest, WriteRead) {
   // Write file using File API, using file name directly (without prefix).
   File* file = File::Open(local_file_name_no_prefix_.c_str(), "w");
@@ -248,6 +413,18 @@ TEST_F(LocalFileTest, IsLocalRegular) {
   ASSERT_TRUE(File::IsLocalRegularFile(local_file_name_.c_str()));
 }
 
+TEST_F(LocalFileTest, IsLocalRegularOutput) {
+  WriteFile(local_file_name_no_prefix_, data_);
+  EXPECT_TRUE(File::IsLocalRegularOutputFile(local_file_name_.c_str()));
+  // A file which does not exist yet is created as a regular file.
+  DeleteFile(local_file_name_no_prefix_);
+  EXPECT_TRUE(File::IsLocalRegularOutputFile(local_file_name_.c_str()));
+
+  EXPECT_FALSE(File::IsLocalRegularOutputFile(
+      std::filesystem::temp_directory_path().u8string().c_str()));
+  EXPECT_FALSE(File::IsLocalRegularOutputFile("memory://file"));
+}
+
 TEST_F(LocalFileTest, UnicodePath) {
   // Delete the temp file already created.
   DeleteFile(local_file_name_no_prefix_);
@@ -6,12 +6,16 @@
 
 #include <packager/file/http_file.h>
 
+#include <map>
+#include <vector>
+
 #include <absl/flags/declare.h>
 #include <absl/flags/flag.h>
 #include <absl/log/check.h>
 #include <absl/log/log.h>
 #include <absl/strings/escaping.h>
 #include <absl/strings/str_format.h>
+#include <absl/synchronization/mutex.h>
 #include <curl/curl.h>
 
 #include <packager/file/file_closer.h>
@@ -153,6 +157,119 @@ class LibCurlInitializer {
   LibCurlInitializer& operator=(const LibCurlInitializer&) = delete;
 };
 
+// Returns the scheme, host and port of |url|, e.g. "https://example.com:8080".
+std::string GetOrigin(const std::string& url) {
+  const size_t scheme_end = url.find("://");
+  if (scheme_end == std::string::npos)
+    return url;
+  const size_t origin_end = url.find_first_of("/?#", scheme_end + 3);
+  return url.substr(0, origin_end);
+}
+
+// Keeps the curl handles of completed requests so that later requests to the
+// same origin reuse their connections instead of paying for a new TCP and TLS
+// handshake every time. Live streams upload a segment and one or more
+// playlists every few seconds, so this saves a round trip or more per file.
+// The handles also share a DNS cache and TLS sessions, so that new connections
+// are cheaper too.
+class CurlHandlePool {
+ public:
+  static CurlHandlePool* GetInstance() {
+    static CurlHandlePool instance;
+    return &instance;
+  }
+
+  // Returns an idle handle for |origin| if there is one, or a new handle.
+  CURL* Acquire(const std::string& origin) {
+    {
+      absl::MutexLock lock(&mutex_);
+      auto iter = idle_handles_.find(origin);
+      if (iter != idle_handles_.end() && !iter->second.empty()) {
+        CURL* curl = iter->second.back();
+        iter->second.pop_back();
+        return curl;
+      }
+    }
+
+    CURL* curl = curl_easy_init();
+    if (curl && share_)
+      curl_easy_setopt(curl, CURLOPT_SHARE, share_);
+    return curl;
+  }
+
+  // Keeps |curl| for the next request to |origin|. The options are reset but
+  // the open connections are not.
+  void Release(const std::string& origin, CURL* curl) {
+    curl_easy_reset(curl);
+    if (share_)
+      curl_easy_setopt(curl, CURLOPT_SHARE, share_);
+
+    {
+      absl::MutexLock lock(&mutex_);
+      std::vector<CURL*>& idle_handles = idle_handles_[origin];
+      if (idle_handles.size() < kMaxIdleHandlesPerOrigin) {
+        idle_handles.push_back(curl);
+        return;
+      }
+    }
+    curl_easy_cleanup(curl);
+  }
+
+ private:
+  // Enough for the concurrent uploads of a few dozen live streams.
+  static constexpr size_t kMaxIdleHandlesPerOrigin = 32;
+
+  CurlHandlePool() : share_(curl_share_init()) {
+    if (!share_) {
+      LOG(WARNING) << "curl_share_init() failed. DNS and TLS sessions will not "
+                      "be shared between connections.";
+      return;
+    }
+    curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, &CurlHandlePool::LockShare);
+    curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC,
+                      &CurlHandlePool::UnlockShare);
+    curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+  }
+
+  ~CurlHandlePool() {
+    absl::MutexLock lock(&mutex_);
+    for (auto& entry : idle_handles_) {
+      for (CURL* curl : entry.second)
+        curl_easy_cleanup(curl);
+    }
+    if (share_)
+      curl_share_cleanup(share_);
+  }
+
+  CurlHandlePool(const CurlHandlePool&) = delete;
+  CurlHandlePool& operator=(const CurlHandlePool&) = delete;
+
+  // libcurl takes and releases the locks of the shared data in separate calls.
+  static void LockShare(CURL* /* handle */,
+                        curl_lock_data data,
+                        curl_lock_access /* access */,
+                        void* user) ABSL_NO_THREAD_SAFETY_ANALYSIS {
+    static_cast<CurlHandlePool*>(user)->share_mutexes_[data].Lock();
+  }
+
+  static void UnlockShare(CURL* /* handle */,
+                          curl_lock_data data,
+                          void* user) ABSL_NO_THREAD_SAFETY_ANALYSIS {
+    static_cast<CurlHandlePool*>(user)->share_mutexes_[data].Unlock();
+  }
+
+  // Must be initialized before any other use of libcurl, and cleaned up after.
+  LibCurlInitializer lib_curl_initializer_;
+  CURLSH* share_ = nullptr;
+  absl::Mutex share_mutexes_[CURL_LOCK_DATA_LAST];
+
+  absl::Mutex mutex_;
+  std::map<std::string, std::vector<CURL*>> idle_handles_
+      ABSL_GUARDED_BY(mutex_);
+};
+
 template <typename List>
 bool AppendHeader(const std::string& header, List* list) {
   auto* temp = curl_slist_append(list->get(), header.c_str());
@@ -177,13 +294,14 @@ HttpFile::HttpFile(HttpMethod method,
                    int32_t timeout_in_seconds)
     : File(url.c_str()),
       url_(url),
+      origin_(GetOrigin(url)),
       upload_content_type_(upload_content_type),
       timeout_in_seconds_(timeout_in_seconds),
       method_(method),
       isUpload_(method == HttpMethod::kPut || method == HttpMethod::kPost),
       download_cache_(absl::GetFlag(FLAGS_io_cache_size)),
       upload_cache_(absl::GetFlag(FLAGS_io_cache_size)),
-      curl_(curl_easy_init()),
+      curl_(CurlHandlePool::GetInstance()->Acquire(origin_)),
       status_(Status::OK),
       user_agent_(absl::GetFlag(FLAGS_user_agent)),
       ca_file_(absl::GetFlag(FLAGS_ca_file)),
@@ -192,7 +310,6 @@ HttpFile::HttpFile(HttpMethod method,
           absl::GetFlag(FLAGS_client_cert_private_key_file)),
       client_cert_private_key_password_(
           absl::GetFlag(FLAGS_client_cert_private_key_password)) {
-  static LibCurlInitializer lib_curl_initializer;
   if (user_agent_.empty()) {
     user_agent_ += "ShakaPackager/" + GetPackagerVersion();
   }
@@ -261,6 +378,10 @@ Status HttpFile::CloseWithStatus() {
 
   const Status result = status_;
   LOG_IF(ERROR, !result.ok()) << "HttpFile request failed: " << result;
+  // Keep the connection for later requests, unless the request failed and
+  // left it in an unknown state.
+  if (result.ok() && curl_)
+    CurlHandlePool::GetInstance()->Release(origin_, curl_.release());
   delete this;
   return absl::GetFlag(FLAGS_ignore_http_output_failures) ? Status::OK : result;
 }
@@ -339,6 +460,8 @@ void HttpFile::SetupRequest() {
   curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeout_in_seconds_);
   curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
   curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+  // Detect connections dropped by the network while idle in the pool.
+  curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
   curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &CurlWriteCallback);
   curl_easy_setopt(curl, CURLOPT_WRITEDATA, &download_cache_);
   if (isUpload_) {
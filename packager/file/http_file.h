@@ -78,6 +78,9 @@ class HttpFile : public File {
   void ThreadMain();
 
   const std::string url_;
+  // The scheme, host and port of |url_|, which identify the connections that
+  // can be reused for the request.
+  const std::string origin_;
   const std::string upload_content_type_;
   const int32_t timeout_in_seconds_;
   const HttpMethod method_;
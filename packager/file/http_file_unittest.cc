@@ -328,4 +328,31 @@ TEST_F(HttpFileTest, TimeoutNotTriggered) {
   ASSERT_TRUE(file.release()->Close());
 }
 
+// Uploads to the same server should reuse the connection of the previous
+// upload instead of paying for a new handshake.
+TEST_F(HttpFileTest, ReusesConnection) {
+  std::string connections[2];
+  for (std::string& connection : connections) {
+    FilePtr file(new HttpFile(HttpMethod::kPut, server_.ReflectUrl(),
+                              kBinaryContentType, kNoHeaders,
+                              kDefaultTestTimeout));
+    ASSERT_TRUE(file);
+    ASSERT_TRUE(file->Open());
+
+    const std::string data = "abcd";
+    ASSERT_EQ(file->Write(data.data(), data.size()),
+              static_cast<int64_t>(data.size()));
+    file->CloseForWriting();
+
+    auto json = HandleResponse(file);
+    ASSERT_TRUE(json.is_object());
+    ASSERT_TRUE(file.release()->Close());
+    ASSERT_JSON_STRING(json, "body", data);
+
+    connection = GetJsonString(json, "connection");
+    ASSERT_FALSE(connection.empty()) << "JSON is " << json;
+  }
+  EXPECT_EQ(connections[0], connections[1]);
+}
+
 }  // namespace shaka
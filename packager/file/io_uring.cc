@@ -0,0 +1,395 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/file/io_uring.h>
+
+#if defined(__linux__)
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <absl/log/check.h>
+#include <absl/log/log.h>
+
+#include <packager/macros/logging.h>
+
+namespace shaka {
+namespace {
+
+// Number of entries of the submission queue. The completion queue is at
+// least as large.
+const uint32_t kQueueDepth = 128;
+// Number of blocks registered with the ring, 4 MiB in total.
+const uint32_t kNumRegisteredBlocks = 64;
+
+int IoUringSetup(uint32_t entries, io_uring_params* params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringEnter(int ring_fd,
+                 uint32_t to_submit,
+                 uint32_t min_complete,
+                 uint32_t flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit,
+                                  min_complete, flags, nullptr, 0));
+}
+
+int IoUringRegister(int ring_fd,
+                    uint32_t opcode,
+                    const void* arg,
+                    uint32_t num_args) {
+  return static_cast<int>(
+      syscall(__NR_io_uring_register, ring_fd, opcode, arg, num_args));
+}
+
+template <typename T>
+T* RingField(void* ring, uint32_t offset) {
+  return reinterpret_cast<T*>(static_cast<uint8_t*>(ring) + offset);
+}
+
+}  // namespace
+
+struct IoUring::Request {
+  Write write;
+  size_t bytes_written = 0;
+  // The buffer of an unregistered block.
+  struct iovec iovec = {};
+  // The errno with which the request failed before being submitted, or 0.
+  int error = 0;
+};
+
+// The queues shared with the kernel.
+struct IoUring::Rings {
+  ~Rings() {
+    if (sqes != MAP_FAILED)
+      munmap(sqes, sqes_size);
+    if (cq_ring != MAP_FAILED && cq_ring != sq_ring)
+      munmap(cq_ring, cq_ring_size);
+    if (sq_ring != MAP_FAILED)
+      munmap(sq_ring, sq_ring_size);
+  }
+
+  bool Map(int ring_fd, const io_uring_params& params) {
+    sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    cq_ring_size =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    // Both queues are in a single mapping on Linux 5.4 and later.
+    const bool single_mapping = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mapping)
+      sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+
+    sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    if (sq_ring == MAP_FAILED)
+      return false;
+    cq_ring = single_mapping ? sq_ring
+                             : mmap(nullptr, cq_ring_size,
+                                    PROT_READ | PROT_WRITE,
+                                    MAP_SHARED | MAP_POPULATE, ring_fd,
+                                    IORING_OFF_CQ_RING);
+    if (cq_ring == MAP_FAILED)
+      return false;
+    sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes_mapping =
+        mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    if (sqes_mapping == MAP_FAILED)
+      return false;
+    sqes = static_cast<io_uring_sqe*>(sqes_mapping);
+
+    sq_tail = RingField<uint32_t>(sq_ring, params.sq_off.tail);
+    sq_mask = *RingField<uint32_t>(sq_ring, params.sq_off.ring_mask);
+    sq_array = RingField<uint32_t>(sq_ring, params.sq_off.array);
+    cq_head = RingField<uint32_t>(cq_ring, params.cq_off.head);
+    cq_tail = RingField<uint32_t>(cq_ring, params.cq_off.tail);
+    cq_mask = *RingField<uint32_t>(cq_ring, params.cq_off.ring_mask);
+    cqes = RingField<io_uring_cqe>(cq_ring, params.cq_off.cqes);
+    return true;
+  }
+
+  void* sq_ring = MAP_FAILED;
+  size_t sq_ring_size = 0;
+  void* cq_ring = MAP_FAILED;
+  size_t cq_ring_size = 0;
+  void* sqes = MAP_FAILED;
+  size_t sqes_size = 0;
+
+  // Written by us and read by the kernel, and the other way around for the
+  // completion queue.
+  uint32_t* sq_tail = nullptr;
+  uint32_t sq_mask = 0;
+  uint32_t* sq_array = nullptr;
+  uint32_t* cq_head = nullptr;
+  uint32_t* cq_tail = nullptr;
+  uint32_t cq_mask = 0;
+  io_uring_cqe* cqes = nullptr;
+};
+
+IoUring* IoUring::GetInstance() {
+  static IoUring* const instance = []() -> IoUring* {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    const int ring_fd = IoUringSetup(kQueueDepth, &params);
+    if (ring_fd < 0) {
+      LOG(WARNING) << "io_uring is not available: " << strerror(errno);
+      return nullptr;
+    }
+    // The completions must not be dropped when there are more of them than
+    // the completion queue fits, which is guaranteed on Linux 5.5 and later.
+    // Since there are never more requests in flight than the submission
+    // queue fits, the completion queue only needs to be as large.
+    CHECK_GE(params.cq_entries, params.sq_entries);
+
+    std::unique_ptr<Rings> rings(new Rings);
+    if (!rings->Map(ring_fd, params)) {
+      LOG(WARNING) << "Failed to map io_uring queues: " << strerror(errno);
+      rings.reset();
+      close(ring_fd);
+      return nullptr;
+    }
+    return new IoUring(ring_fd, std::move(rings));
+  }();
+  return instance;
+}
+
+IoUring::IoUring(int ring_fd, std::unique_ptr<Rings> rings)
+    : ring_fd_(ring_fd), rings_(std::move(rings)) {
+  RegisterBlocks();
+  completion_thread_ = std::thread(&IoUring::CompletionLoop, this);
+}
+
+IoUring::Block* IoUring::AcquireBlock() {
+  {
+    absl::MutexLock lock(&blocks_mutex_);
+    if (!free_blocks_.empty()) {
+      Block* block = free_blocks_.back();
+      free_blocks_.pop_back();
+      return block;
+    }
+  }
+  // All the pooled blocks are being written.
+  Block* block = new Block;
+  block->data.reset(new uint8_t[kBlockSize]);
+  return block;
+}
+
+void IoUring::ReleaseBlock(Block* block) {
+  if (!block->pooled) {
+    delete block;
+    return;
+  }
+  absl::MutexLock lock(&blocks_mutex_);
+  free_blocks_.push_back(block);
+}
+
+void IoUring::Submit(std::vector<Write> writes) {
+  std::vector<Request*> failed_requests;
+  {
+    absl::MutexLock lock(&mutex_);
+    for (Write& write : writes) {
+      DCHECK_LE(write.size, kBlockSize);
+      if (ring_error_ == 0 && !HasRoomForRequest()) {
+        SubmitQueuedRequests(&failed_requests);
+        mutex_.Await(absl::Condition(this, &IoUring::HasRoomForRequest));
+      }
+      Request* request = new Request;
+      request->write = std::move(write);
+      if (ring_error_ != 0) {
+        request->error = ring_error_;
+        failed_requests.push_back(request);
+        continue;
+      }
+      requests_.insert(request);
+      QueueRequest(request);
+    }
+    SubmitQueuedRequests(&failed_requests);
+  }
+
+  for (Request* request : failed_requests)
+    CompleteRequest(request, -request->error);
+}
+
+void IoUring::QueueRequest(Request* request) {
+  const uint32_t tail = *rings_->sq_tail;
+  const uint32_t index = tail & rings_->sq_mask;
+  io_uring_sqe* sqe = &static_cast<io_uring_sqe*>(rings_->sqes)[index];
+  memset(sqe, 0, sizeof(*sqe));
+
+  const Write& write = request->write;
+  uint8_t* data = write.block->data.get() + request->bytes_written;
+  const size_t size = write.size - request->bytes_written;
+  if (write.block->index >= 0) {
+    sqe->opcode = IORING_OP_WRITE_FIXED;
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = static_cast<uint32_t>(size);
+    sqe->buf_index = static_cast<uint16_t>(write.block->index);
+  } else {
+    // IORING_OP_WRITEV is supported since the first io_uring, unlike
+    // IORING_OP_WRITE.
+    request->iovec.iov_base = data;
+    request->iovec.iov_len = size;
+    sqe->opcode = IORING_OP_WRITEV;
+    sqe->addr = reinterpret_cast<uint64_t>(&request->iovec);
+    sqe->len = 1;
+  }
+  sqe->fd = write.fd;
+  sqe->off = write.offset + request->bytes_written;
+  sqe->user_data = reinterpret_cast<uint64_t>(request);
+
+  rings_->sq_array[index] = index;
+  // Publishes the entry to the kernel.
+  __atomic_store_n(rings_->sq_tail, tail + 1, __ATOMIC_RELEASE);
+  ++requests_queued_;
+}
+
+void IoUring::SubmitQueuedRequests(std::vector<Request*>* failed_requests) {
+  while (requests_queued_ > 0) {
+    const int result = IoUringEnter(ring_fd_, requests_queued_, 0, 0);
+    if (result >= 0) {
+      requests_queued_ -= result;
+      requests_in_flight_ += result;
+      continue;
+    }
+    const int error = errno;
+    if (error == EINTR || error == EAGAIN || error == EBUSY)
+      continue;
+
+    LOG(ERROR) << "Failed to submit to io_uring: " << strerror(error);
+    // The kernel did not consume the queued entries, so they are taken back
+    // from the end of the submission queue.
+    const uint32_t tail = *rings_->sq_tail - requests_queued_;
+    const io_uring_sqe* sqes = static_cast<io_uring_sqe*>(rings_->sqes);
+    for (uint32_t i = tail; i != *rings_->sq_tail; ++i) {
+      const io_uring_sqe& sqe = sqes[rings_->sq_array[i & rings_->sq_mask]];
+      Request* request = reinterpret_cast<Request*>(sqe.user_data);
+      request->error = error;
+      requests_.erase(request);
+      failed_requests->push_back(request);
+    }
+    __atomic_store_n(rings_->sq_tail, tail, __ATOMIC_RELEASE);
+    requests_queued_ = 0;
+  }
+}
+
+bool IoUring::HasRoomForRequest() const {
+  return requests_in_flight_ + requests_queued_ < kQueueDepth;
+}
+
+void IoUring::CompletionLoop() {
+  uint32_t* const cq_head = rings_->cq_head;
+  while (true) {
+    uint32_t head = *cq_head;
+    const uint32_t tail = __atomic_load_n(rings_->cq_tail, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+      if (IoUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 &&
+          errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        OnRingFailure(errno);
+        return;
+      }
+      continue;
+    }
+    for (; head != tail; ++head) {
+      const io_uring_cqe& cqe = rings_->cqes[head & rings_->cq_mask];
+      Request* request = reinterpret_cast<Request*>(cqe.user_data);
+      const int result = cqe.res;
+      // Frees the entry for the kernel.
+      __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+      OnCompletion(request, result);
+    }
+  }
+}
+
+void IoUring::OnCompletion(Request* request, int result) {
+  Write& write = request->write;
+  if (result > 0)
+    request->bytes_written += result;
+  const bool retry = result == -EINTR || result == -EAGAIN ||
+                     (result > 0 && request->bytes_written < write.size);
+  if (retry) {
+    std::vector<Request*> failed_requests;
+    {
+      absl::MutexLock lock(&mutex_);
+      // Takes the room of the completed request.
+      --requests_in_flight_;
+      QueueRequest(request);
+      SubmitQueuedRequests(&failed_requests);
+    }
+    for (Request* failed_request : failed_requests)
+      CompleteRequest(failed_request, -failed_request->error);
+    return;
+  }
+
+  {
+    absl::MutexLock lock(&mutex_);
+    --requests_in_flight_;
+    requests_.erase(request);
+  }
+  if (result > 0) {
+    CompleteRequest(request, request->bytes_written);
+  } else {
+    // Nothing written without an error is unexpected for a local file.
+    CompleteRequest(request, result < 0 ? result : -EIO);
+  }
+}
+
+void IoUring::CompleteRequest(Request* request, int64_t result) {
+  request->write.done(result);
+  ReleaseBlock(request->write.block);
+  delete request;
+}
+
+void IoUring::OnRingFailure(int error) {
+  LOG(ERROR) << "Failed to wait for io_uring: " << strerror(error);
+  std::unordered_set<Request*> requests;
+  {
+    absl::MutexLock lock(&mutex_);
+    ring_error_ = error;
+    requests.swap(requests_);
+    requests_in_flight_ = 0;
+  }
+  // The kernel may still use the blocks of the requests in flight, so they
+  // are not released.
+  for (Request* request : requests) {
+    request->write.done(-error);
+    delete request;
+  }
+}
+
+void IoUring::RegisterBlocks() {
+  std::vector<struct iovec> iovecs;
+  for (uint32_t i = 0; i < kNumRegisteredBlocks; ++i) {
+    std::unique_ptr<Block> block(new Block);
+    block->data.reset(new uint8_t[kBlockSize]);
+    block->index = static_cast<int>(i);
+    block->pooled = true;
+    iovecs.push_back({block->data.get(), kBlockSize});
+    registered_blocks_.push_back(std::move(block));
+  }
+
+  if (IoUringRegister(ring_fd_, IORING_REGISTER_BUFFERS, iovecs.data(),
+                      kNumRegisteredBlocks) < 0) {
+    // Registered buffers count towards RLIMIT_MEMLOCK, which may be low. The
+    // blocks are still pooled.
+    VLOG(1) << "Failed to register io_uring buffers: " << strerror(errno);
+    for (const auto& block : registered_blocks_)
+      block->index = -1;
+  }
+
+  absl::MutexLock lock(&blocks_mutex_);
+  for (const auto& block : registered_blocks_)
+    free_blocks_.push_back(block.get());
+}
+
+}  // namespace shaka
+
+#endif  // defined(__linux__)
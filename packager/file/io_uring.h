@@ -0,0 +1,124 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_FILE_IO_URING_H_
+#define PACKAGER_FILE_IO_URING_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <absl/synchronization/mutex.h>
+
+#include <packager/macros/classes.h>
+
+namespace shaka {
+
+/// A process-wide io_uring, through which IoUringFile writes the data of all
+/// the files, with a single thread reaping the completions. It is never
+/// destroyed. Linux only.
+///
+/// Errors of the ring itself are reported as errors of the affected writes.
+/// If the completions can no longer be reaped, all the writes fail from then
+/// on.
+class IoUring {
+ public:
+  /// Size of the blocks written.
+  static constexpr size_t kBlockSize = 1 << 16;
+
+  /// A block of memory to write from. Some blocks are registered with the
+  /// ring, which saves the kernel from mapping them for every write.
+  struct Block {
+    std::unique_ptr<uint8_t[]> data;
+    // The index of the block in the registered buffers, or -1.
+    int index = -1;
+    // Whether the block is kept by the ring when released.
+    bool pooled = false;
+  };
+
+  /// A write of the first bytes of a block.
+  struct Write {
+    int fd = -1;
+    uint64_t offset = 0;
+    Block* block = nullptr;
+    size_t size = 0;
+    /// Called on the completion thread, with the number of bytes written, or
+    /// a negative errno.
+    std::function<void(int64_t result)> done;
+  };
+
+  /// @return the process-wide ring, or nullptr if io_uring is not supported.
+  static IoUring* GetInstance();
+
+  /// @return a block to write from. The block is released when it has been
+  ///         written, or by ReleaseBlock() if it is not written.
+  Block* AcquireBlock();
+
+  /// Releases a block which was not written.
+  void ReleaseBlock(Block* block);
+
+  /// Submits writes, together as far as the ring allows. Partial writes are
+  /// resubmitted until all the data is written or an error occurs. The
+  /// blocks are released when they have been written. The writes which cannot
+  /// be submitted are completed with the error, possibly before this returns.
+  void Submit(std::vector<Write> writes);
+
+ private:
+  struct Request;
+  struct Rings;
+
+  IoUring(int ring_fd, std::unique_ptr<Rings> rings);
+
+  // Adds |request| to the submission queue.
+  void QueueRequest(Request* request) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Submits the queued requests to the kernel. If the kernel rejects them,
+  // they are removed from the queue and appended to |failed_requests|, to be
+  // completed once |mutex_| is released.
+  void SubmitQueuedRequests(std::vector<Request*>* failed_requests)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  bool HasRoomForRequest() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Reaps the completions, forever.
+  void CompletionLoop();
+  // Resubmits the rest of |request| if it was not all written, or completes
+  // it.
+  void OnCompletion(Request* request, int result);
+  // Calls the done callback of |request| and frees it and its block.
+  void CompleteRequest(Request* request, int64_t result);
+  // Fails the requests in flight and all the later writes, after the
+  // completions could not be reaped.
+  void OnRingFailure(int error);
+  void RegisterBlocks();
+
+  const int ring_fd_;
+  std::unique_ptr<Rings> rings_;
+
+  absl::Mutex mutex_;
+  // Requests submitted and not completed yet, which must fit in the
+  // completion queue.
+  uint32_t requests_in_flight_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Requests queued and not submitted yet.
+  uint32_t requests_queued_ ABSL_GUARDED_BY(mutex_) = 0;
+  // All the requests, queued or in flight.
+  std::unordered_set<Request*> requests_ ABSL_GUARDED_BY(mutex_);
+  // The errno with which the ring failed, or 0.
+  int ring_error_ ABSL_GUARDED_BY(mutex_) = 0;
+
+  absl::Mutex blocks_mutex_;
+  std::vector<std::unique_ptr<Block>> registered_blocks_;
+  std::vector<Block*> free_blocks_ ABSL_GUARDED_BY(blocks_mutex_);
+
+  std::thread completion_thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(IoUring);
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_FILE_IO_URING_H_
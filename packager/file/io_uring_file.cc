@@ -0,0 +1,213 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/file/io_uring_file.h>
+
+#if defined(__linux__)
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+
+#include <absl/log/check.h>
+#include <absl/log/log.h>
+
+#include <packager/macros/compiler.h>
+#include <packager/macros/logging.h>
+
+namespace shaka {
+
+IoUringFile::IoUringFile(const char* file_name,
+                         const char* mode,
+                         uint64_t max_bytes_in_flight)
+    : File(file_name),
+      file_mode_(mode),
+      max_bytes_in_flight_(max_bytes_in_flight),
+      io_uring_(IoUring::GetInstance()) {
+  DCHECK(io_uring_);
+  DCHECK(file_mode_ == "w" || file_mode_ == "a");
+}
+
+IoUringFile::~IoUringFile() {
+  // Only left open if Open() failed half way.
+  if (fd_ >= 0)
+    close(fd_);
+}
+
+bool IoUringFile::Close() {
+  bool result = Flush();
+  if (block_)
+    io_uring_->ReleaseBlock(block_);
+  if (fd_ >= 0 && close(fd_) != 0) {
+    LOG(ERROR) << "Failed to close '" << file_name()
+               << "', error: " << strerror(errno);
+    result = false;
+  }
+  fd_ = -1;
+  delete this;
+  return result;
+}
+
+int64_t IoUringFile::Read(void* buffer, uint64_t length) {
+  UNUSED(buffer);
+  UNUSED(length);
+  LOG(ERROR) << "IoUringFile is write only.";
+  return -1;
+}
+
+int64_t IoUringFile::Write(const void* buffer, uint64_t length) {
+  if (HasFailed())
+    return -1;
+
+  const uint8_t* data = static_cast<const uint8_t*>(buffer);
+  uint64_t bytes_left = length;
+  while (bytes_left > 0) {
+    if (!block_)
+      block_ = io_uring_->AcquireBlock();
+    if (block_size_ == 0)
+      block_offset_ = position_;
+    const size_t size =
+        std::min<uint64_t>(bytes_left, IoUring::kBlockSize - block_size_);
+    memcpy(block_->data.get() + block_size_, data, size);
+    block_size_ += size;
+    position_ += size;
+    data += size;
+    bytes_left -= size;
+    if (block_size_ == IoUring::kBlockSize)
+      QueueBlock();
+  }
+  size_ = std::max(size_, position_);
+  // The full blocks of a large write are submitted together.
+  SubmitPendingWrites();
+  return length;
+}
+
+void IoUringFile::CloseForWriting() {}
+
+int64_t IoUringFile::Size() {
+  return size_;
+}
+
+bool IoUringFile::Flush() {
+  if (block_size_ > 0)
+    QueueBlock();
+  SubmitPendingWrites();
+  WaitForWrites(0);
+  return !HasFailed();
+}
+
+bool IoUringFile::Seek(uint64_t position) {
+  if (position == position_)
+    return true;
+  // The writes in flight may complete in any order, so they must not overlap
+  // the writes after the seek.
+  if (!Flush())
+    return false;
+  position_ = position;
+  return true;
+}
+
+bool IoUringFile::Tell(uint64_t* position) {
+  DCHECK(position);
+  *position = position_;
+  return true;
+}
+
+bool IoUringFile::Open() {
+  auto file_path = std::filesystem::u8path(file_name());
+
+  // Create upper level directories for write mode, like LocalFile.
+  if (file_mode_ == "w") {
+    auto parent_path = file_path.parent_path();
+    std::error_code ec;
+    if (parent_path != "" && !std::filesystem::is_directory(parent_path, ec)) {
+      if (!std::filesystem::create_directories(parent_path, ec))
+        return false;
+    }
+  }
+
+  // Appending is done with explicit offsets, since the writes are not
+  // submitted in order.
+  const int flags = O_WRONLY | O_CREAT | O_CLOEXEC |
+                    (file_mode_ == "w" ? O_TRUNC : 0);
+  fd_ = open(file_path.u8string().c_str(), flags, 0666);
+  if (fd_ < 0)
+    return false;
+
+  if (file_mode_ == "a") {
+    const off_t end = lseek(fd_, 0, SEEK_END);
+    if (end < 0)
+      return false;
+    position_ = size_ = static_cast<uint64_t>(end);
+  }
+  return true;
+}
+
+void IoUringFile::QueueBlock() {
+  IoUring::Write write;
+  write.fd = fd_;
+  write.offset = block_offset_;
+  write.block = block_;
+  write.size = block_size_;
+  const size_t size = block_size_;
+  write.done = [this, size](int64_t result) { OnWriteDone(size, result); };
+  pending_writes_.push_back(std::move(write));
+
+  block_ = nullptr;
+  block_size_ = 0;
+}
+
+void IoUringFile::SubmitPendingWrites() {
+  if (pending_writes_.empty())
+    return;
+
+  uint64_t bytes = 0;
+  for (const IoUring::Write& write : pending_writes_)
+    bytes += write.size;
+  {
+    absl::MutexLock lock(&mutex_);
+    bytes_in_flight_ += bytes;
+  }
+  io_uring_->Submit(std::move(pending_writes_));
+  pending_writes_.clear();
+
+  WaitForWrites(max_bytes_in_flight_);
+}
+
+void IoUringFile::WaitForWrites(uint64_t max_bytes) {
+  auto done = [this, max_bytes]() {
+    return bytes_in_flight_ <= max_bytes;
+  };
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(&done));
+}
+
+void IoUringFile::OnWriteDone(size_t size, int64_t result) {
+  absl::MutexLock lock(&mutex_);
+  if (result < 0) {
+    LOG(ERROR) << "Failed to write '" << file_name()
+               << "', error: " << strerror(-result);
+    failed_ = true;
+  } else if (static_cast<uint64_t>(result) != size) {
+    LOG(ERROR) << "Failed to write '" << file_name() << "', " << result
+               << " bytes written out of " << size << ".";
+    failed_ = true;
+  }
+  bytes_in_flight_ -= size;
+}
+
+bool IoUringFile::HasFailed() {
+  absl::MutexLock lock(&mutex_);
+  return failed_;
+}
+
+}  // namespace shaka
+
+#endif  // defined(__linux__)
@@ -0,0 +1,88 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_FILE_IO_URING_FILE_H_
+#define PACKAGER_FILE_IO_URING_FILE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <absl/synchronization/mutex.h>
+
+#include <packager/file.h>
+#include <packager/file/io_uring.h>
+#include <packager/macros/classes.h>
+
+namespace shaka {
+
+/// A local file written through the process-wide IoUring, instead of a
+/// thread of its own like ThreadedIoFile. Write() copies the data into blocks,
+/// which are written asynchronously once full. Errors are reported by the
+/// following Write(), Flush() or Close(). Linux only, write and append modes
+/// only.
+class IoUringFile : public File {
+ public:
+  /// @param file_name is the path of the file, without any prefix.
+  /// @param mode is "w" or "a".
+  /// @param max_bytes_in_flight is the number of bytes which may be written
+  ///        asynchronously before Write() blocks.
+  IoUringFile(const char* file_name,
+              const char* mode,
+              uint64_t max_bytes_in_flight);
+
+  /// @name File implementation overrides.
+  /// @{
+  bool Close() override;
+  int64_t Read(void* buffer, uint64_t length) override;
+  int64_t Write(const void* buffer, uint64_t length) override;
+  void CloseForWriting() override;
+  int64_t Size() override;
+  bool Flush() override;
+  bool Seek(uint64_t position) override;
+  bool Tell(uint64_t* position) override;
+  /// @}
+
+ protected:
+  ~IoUringFile() override;
+
+  bool Open() override;
+
+ private:
+  // Moves the current block to |pending_writes_|.
+  void QueueBlock();
+  // Submits |pending_writes_|, then waits until no more than
+  // |max_bytes_in_flight_| bytes are being written.
+  void SubmitPendingWrites();
+  // Waits until no more than |max_bytes| bytes are being written.
+  void WaitForWrites(uint64_t max_bytes);
+  // Called on the completion thread of the ring.
+  void OnWriteDone(size_t size, int64_t result);
+  bool HasFailed();
+
+  const std::string file_mode_;
+  const uint64_t max_bytes_in_flight_;
+  IoUring* const io_uring_;
+  int fd_ = -1;
+
+  // The block being filled, which starts at |block_offset_| in the file.
+  IoUring::Block* block_ = nullptr;
+  size_t block_size_ = 0;
+  uint64_t block_offset_ = 0;
+  std::vector<IoUring::Write> pending_writes_;
+  uint64_t position_ = 0;
+  uint64_t size_ = 0;
+
+  absl::Mutex mutex_;
+  uint64_t bytes_in_flight_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool failed_ ABSL_GUARDED_BY(mutex_) = false;
+
+  DISALLOW_COPY_AND_ASSIGN(IoUringFile);
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_FILE_IO_URING_FILE_H_
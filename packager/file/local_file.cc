@@ -9,17 +9,29 @@
 #if defined(OS_WIN)
 #include <windows.h>
 #else
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
 #endif  // defined(OS_WIN)
 
+#include <algorithm>
+#include <cerrno>
+#include <climits>
 #include <cstdio>
+#include <cstring>
 #include <filesystem>
+#include <vector>
 
+#include <absl/flags/declare.h>
+#include <absl/flags/flag.h>
 #include <absl/log/check.h>
 #include <absl/log/log.h>
 
 #include <packager/macros/logging.h>
 
+ABSL_DECLARE_FLAG(bool, mmap_input_files);
+
 namespace shaka {
 
 // Always open files in binary mode.
@@ -33,6 +45,12 @@ LocalFile::LocalFile(const char* file_name, const char* mode)
 
 bool LocalFile::Close() {
   bool result = true;
+#if !defined(OS_WIN)
+  if (mapped_data_) {
+    munmap(const_cast<uint8_t*>(mapped_data_), mapped_size_);
+    mapped_data_ = nullptr;
+  }
+#endif  // !defined(OS_WIN)
   if (internal_file_) {
     result = fclose(internal_file_) == 0;
     internal_file_ = NULL;
@@ -44,6 +62,12 @@ bool LocalFile::Close() {
 int64_t LocalFile::Read(void* buffer, uint64_t length) {
   DCHECK(buffer != NULL);
   DCHECK(internal_file_ != NULL);
+  if (mapped_data_) {
+    const uint8_t* data = nullptr;
+    const int64_t bytes_read = ReadView(length, &data);
+    memcpy(buffer, data, bytes_read);
+    return bytes_read;
+  }
   size_t bytes_read = fread(buffer, sizeof(char), length, internal_file_);
   VLOG(2) << "Read " << length << " return " << bytes_read << " error "
           << ferror(internal_file_);
@@ -65,10 +89,85 @@ int64_t LocalFile::Write(const void* buffer, uint64_t length) {
   return bytes_written;
 }
 
+int64_t LocalFile::WriteV(const IoVec* blocks, size_t num_blocks) {
+#if defined(OS_WIN)
+  return File::WriteV(blocks, num_blocks);
+#else
+  DCHECK(internal_file_ != NULL);
+  // The data buffered by Write() goes first.
+  if (fflush(internal_file_) != 0)
+    return -1;
+  const int fd = fileno(internal_file_);
+
+  std::vector<struct iovec> iovecs(num_blocks);
+  for (size_t i = 0; i < num_blocks; ++i) {
+    iovecs[i].iov_base = const_cast<void*>(blocks[i].data);
+    iovecs[i].iov_len = blocks[i].length;
+  }
+
+  int64_t total_size_written = 0;
+  size_t index = 0;
+  while (index < iovecs.size()) {
+    if (iovecs[index].iov_len == 0) {
+      ++index;
+      continue;
+    }
+    const int count =
+        static_cast<int>(std::min<size_t>(iovecs.size() - index, IOV_MAX));
+    const ssize_t size_written = writev(fd, &iovecs[index], count);
+    VLOG(2) << "WriteV " << count << " blocks return " << size_written;
+    if (size_written < 0 && errno == EINTR)
+      continue;
+    if (size_written <= 0) {
+      LOG(ERROR) << "Failed to write to " << file_name() << ": "
+                 << strerror(errno);
+      return -1;
+    }
+    total_size_written += size_written;
+
+    // Skip the blocks written, which may end in the middle of a block.
+    size_t remaining_size = static_cast<size_t>(size_written);
+    while (remaining_size > 0) {
+      struct iovec& block = iovecs[index];
+      if (remaining_size < block.iov_len) {
+        block.iov_base = static_cast<uint8_t*>(block.iov_base) + remaining_size;
+        block.iov_len -= remaining_size;
+        break;
+      }
+      remaining_size -= block.iov_len;
+      ++index;
+    }
+  }
+
+  // writev() moved the file offset behind the back of stdio, so resync the
+  // position cached by the stream for Tell(), Seek() and further writes.
+  const off_t offset = lseek(fd, 0, SEEK_CUR);
+  if (offset < 0 || fseeko(internal_file_, offset, SEEK_SET) != 0) {
+    LOG(ERROR) << "Failed to sync the position of " << file_name() << ": "
+               << strerror(errno);
+    return -1;
+  }
+  return total_size_written;
+#endif  // defined(OS_WIN)
+}
+
+int64_t LocalFile::ReadView(uint64_t length, const uint8_t** data) {
+  DCHECK(data);
+  if (!mapped_data_)
+    return -1;
+  const uint64_t bytes_read =
+      std::min(length, mapped_size_ - std::min(mapped_position_, mapped_size_));
+  *data = mapped_data_ + mapped_position_;
+  mapped_position_ += bytes_read;
+  return bytes_read;
+}
+
 void LocalFile::CloseForWriting() {}
 
 int64_t LocalFile::Size() {
   DCHECK(internal_file_ != NULL);
+  if (mapped_data_)
+    return mapped_size_;
 
   // Flush any buffered data, so we get the true file size.
   if (!Flush()) {
@@ -92,6 +191,10 @@ bool LocalFile::Flush() {
 }
 
 bool LocalFile::Seek(uint64_t position) {
+  if (mapped_data_) {
+    mapped_position_ = position;
+    return true;
+  }
 #if defined(OS_WIN)
   return _fseeki64(internal_file_, static_cast<__int64>(position), SEEK_SET) ==
          0;
@@ -101,6 +204,10 @@ bool LocalFile::Seek(uint64_t position) {
 }
 
 bool LocalFile::Tell(uint64_t* position) {
+  if (mapped_data_) {
+    *position = mapped_position_;
+    return true;
+  }
 #if defined(OS_WIN)
   __int64 offset = _ftelli64(internal_file_);
 #else
@@ -132,7 +239,42 @@ bool LocalFile::Open() {
   }
 
   internal_file_ = fopen(file_path.u8string().c_str(), file_mode_.c_str());
-  return (internal_file_ != NULL);
+  if (!internal_file_)
+    return false;
+
+  if (file_mode_ == "rb" && absl::GetFlag(FLAGS_mmap_input_files))
+    MapFile();
+  return true;
+}
+
+void LocalFile::MapFile() {
+#if defined(OS_WIN)
+  VLOG(1) << "Memory mapped input files are not supported on Windows.";
+#else
+  const int fd = fileno(internal_file_);
+  struct stat file_stat;
+  // Pipes and other special files are read through stdio. So are empty files,
+  // which cannot be mapped.
+  if (fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode) ||
+      file_stat.st_size == 0) {
+    return;
+  }
+
+  void* data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    LOG(WARNING) << "Cannot memory map file '" << file_name()
+                 << "', error: " << strerror(errno);
+    return;
+  }
+  // Inputs are mostly read from start to end, so let the kernel read ahead
+  // aggressively and drop the pages behind.
+  if (madvise(data, file_stat.st_size, MADV_SEQUENTIAL) != 0)
+    VLOG(1) << "madvise failed, error: " << strerror(errno);
+
+  mapped_data_ = static_cast<const uint8_t*>(data);
+  mapped_size_ = file_stat.st_size;
+  mapped_position_ = 0;
+#endif  // defined(OS_WIN)
 }
 
 bool LocalFile::Delete(const char* file_name) {
@@ -16,6 +16,10 @@
 namespace shaka {
 
 /// Implement LocalFile which deals with local storage.
+///
+/// With --mmap_input_files, files opened for reading are memory mapped, if
+/// the platform and the file allow it. Read() then copies from the mapping,
+/// and ReadView() gives access to the mapped data without any copy.
 class LocalFile : public File {
  public:
   /// @param file_name C string containing the name of the file to be accessed.
@@ -28,6 +32,7 @@ class LocalFile : public File {
   bool Close() override;
   int64_t Read(void* buffer, uint64_t length) override;
   int64_t Write(const void* buffer, uint64_t length) override;
+  int64_t WriteV(const IoVec* blocks, size_t num_blocks) override;
   void CloseForWriting() override;
   int64_t Size() override;
   bool Flush() override;
@@ -35,6 +40,17 @@ class LocalFile : public File {
   bool Tell(uint64_t* position) override;
   /// @}
 
+  /// Read data without copying it, if the file is memory mapped.
+  /// @param length indicates the maximum number of bytes to be read.
+  /// @param[out] data points to the data read, which stays valid until the
+  ///             file is closed.
+  /// @return Number of bytes read, zero on end-of-file, or a value < 0 if the
+  ///         file is not memory mapped.
+  int64_t ReadView(uint64_t length, const uint8_t** data);
+
+  /// @return true if the file is memory mapped.
+  bool is_mapped() const { return mapped_data_ != nullptr; }
+
   /// Delete a local file.
   /// @param file_name is the path of the file to be deleted.
   /// @return true if successful, or false otherwise.
@@ -46,9 +62,18 @@ class LocalFile : public File {
   bool Open() override;
 
  private:
+  // Maps |internal_file_| to memory. The file is read through stdio if it
+  // fails.
+  void MapFile();
+
   std::string file_mode_;
   FILE* internal_file_;
 
+  // The mapping of the file, and the read position in it.
+  const uint8_t* mapped_data_ = nullptr;
+  uint64_t mapped_size_ = 0;
+  uint64_t mapped_position_ = 0;
+
   DISALLOW_COPY_AND_ASSIGN(LocalFile);
 };
 
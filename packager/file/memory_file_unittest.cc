@@ -82,6 +82,20 @@ TEST_F(MemoryFileTest, EndOfFile) {
   EXPECT_EQ(0, file->Read(read_buffer, kWriteBufferSize));
 }
 
+TEST_F(MemoryFileTest, WriteV) {
+  std::unique_ptr<File, FileCloser> file(File::Open("memory://file1", "w"));
+  ASSERT_TRUE(file);
+
+  const File::IoVec blocks[] = {
+      {kWriteBuffer, 3}, {kWriteBuffer + 3, 0}, {kWriteBuffer + 3, 5}};
+  ASSERT_EQ(kWriteBufferSize, file->WriteV(blocks, 3));
+  ASSERT_TRUE(file->Seek(0));
+
+  uint8_t read_buffer[kWriteBufferSize];
+  EXPECT_EQ(kWriteBufferSize, file->Read(read_buffer, kWriteBufferSize));
+  EXPECT_EQ(0, memcmp(read_buffer, kWriteBuffer, kWriteBufferSize));
+}
+
 TEST_F(MemoryFileTest, ExtendsSize) {
   std::unique_ptr<File, FileCloser> file(File::Open("memory://file1", "w"));
   ASSERT_TRUE(file);
@@ -0,0 +1,95 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/file/origin_file.h>
+
+#include <absl/log/check.h>
+#include <absl/log/log.h>
+
+#include <packager/macros/logging.h>
+
+namespace shaka {
+
+OriginFile::OriginFile(const std::string& file_name, const std::string& mode)
+    : File(file_name), mode_(mode) {}
+
+OriginFile::~OriginFile() {}
+
+bool OriginFile::Close() {
+  CloseForWriting();
+  delete this;
+  return true;
+}
+
+int64_t OriginFile::Read(void* buffer, uint64_t length) {
+  if (writing_)
+    return -1;
+  const uint64_t bytes_read = SegmentStore::GetInstance()->Read(
+      *entry_, position_, buffer, length, nullptr);
+  position_ += bytes_read;
+  return bytes_read;
+}
+
+int64_t OriginFile::Write(const void* buffer, uint64_t length) {
+  if (!writing_ || !entry_)
+    return -1;
+  SegmentStore::GetInstance()->Append(entry_.get(), buffer, length);
+  position_ += length;
+  return length;
+}
+
+void OriginFile::CloseForWriting() {
+  if (!writing_ || !entry_)
+    return;
+  SegmentStore::GetInstance()->FinishWriting(file_name(), entry_);
+  entry_.reset();
+}
+
+int64_t OriginFile::Size() {
+  if (!entry_)
+    return -1;
+  return SegmentStore::GetInstance()->Size(*entry_);
+}
+
+bool OriginFile::Flush() {
+  return true;
+}
+
+bool OriginFile::Seek(uint64_t position) {
+  // Files are only ever appended to.
+  if (writing_ || Size() < static_cast<int64_t>(position))
+    return false;
+  position_ = position;
+  return true;
+}
+
+bool OriginFile::Tell(uint64_t* position) {
+  *position = position_;
+  return true;
+}
+
+bool OriginFile::Delete(const std::string& file_name) {
+  return SegmentStore::GetInstance()->Delete(file_name);
+}
+
+bool OriginFile::Open() {
+  SegmentStore* store = SegmentStore::GetInstance();
+  if (mode_ == "r") {
+    entry_ = store->Find(file_name());
+    return entry_ != nullptr;
+  }
+  if (mode_ != "w" && mode_ != "a") {
+    NOTIMPLEMENTED() << "File mode '" << mode_
+                     << "' not supported by OriginFile";
+    return false;
+  }
+  writing_ = true;
+  entry_ = store->StartWriting(file_name(), mode_ == "a");
+  position_ = store->Size(*entry_);
+  return true;
+}
+
+}  // namespace shaka
@@ -0,0 +1,59 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_FILE_ORIGIN_FILE_H_
+#define PACKAGER_FILE_ORIGIN_FILE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <packager/file.h>
+#include <packager/file/segment_store.h>
+
+namespace shaka {
+
+/// Implements a File stored in the SegmentStore, which is served by the
+/// built-in HTTP origin. What is written is visible to the readers right
+/// away; the file is complete when it is closed.
+class OriginFile : public File {
+ public:
+  /// @param file_name is the path in the store, without the prefix.
+  /// @param mode is "r", "w" or "a".
+  OriginFile(const std::string& file_name, const std::string& mode);
+
+  /// @name File implementation overrides.
+  /// @{
+  bool Close() override;
+  int64_t Read(void* buffer, uint64_t length) override;
+  int64_t Write(const void* buffer, uint64_t length) override;
+  void CloseForWriting() override;
+  int64_t Size() override;
+  bool Flush() override;
+  bool Seek(uint64_t position) override;
+  bool Tell(uint64_t* position) override;
+  /// @}
+
+  /// Deletes the file with the given file_name from the store.
+  static bool Delete(const std::string& file_name);
+
+ protected:
+  ~OriginFile() override;
+  bool Open() override;
+
+ private:
+  OriginFile(const OriginFile&) = delete;
+  OriginFile& operator=(const OriginFile&) = delete;
+
+  std::string mode_;
+  std::shared_ptr<SegmentStore::Entry> entry_;
+  uint64_t position_ = 0;
+  bool writing_ = false;
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_FILE_ORIGIN_FILE_H_
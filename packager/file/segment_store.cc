@@ -0,0 +1,200 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/file/segment_store.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <absl/log/check.h>
+#include <absl/log/log.h>
+
+namespace shaka {
+namespace {
+
+const uint64_t kDefaultMaxSize = 512ULL << 20;
+
+}  // namespace
+
+class SegmentStore::Entry {
+ public:
+  std::string data;
+  bool complete = false;
+  // Whether |data| is counted in the size of the store, i.e. whether the
+  // entry is still one of the versions of its file.
+  bool stored = true;
+};
+
+SegmentStore::SegmentStore() : max_size_(kDefaultMaxSize) {}
+
+SegmentStore::~SegmentStore() {}
+
+// static
+SegmentStore* SegmentStore::GetInstance() {
+  static SegmentStore instance;
+  return &instance;
+}
+
+void SegmentStore::SetMaxSize(uint64_t max_size) {
+  absl::MutexLock lock(&mutex_);
+  max_size_ = max_size;
+}
+
+std::shared_ptr<SegmentStore::Entry> SegmentStore::StartWriting(
+    const std::string& path,
+    bool append) {
+  std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+
+  absl::MutexLock lock(&mutex_);
+  Versions& versions = files_[path];
+  if (versions.writing) {
+    LOG(WARNING) << "Replacing '" << path << "' which is still being written.";
+    size_ -= versions.writing->data.size();
+    versions.writing->stored = false;
+  }
+  if (append) {
+    const Entry* latest =
+        versions.writing ? versions.writing.get() : versions.complete.get();
+    if (latest) {
+      entry->data = latest->data;
+      size_ += entry->data.size();
+    }
+  }
+  versions.writing = entry;
+  return entry;
+}
+
+void SegmentStore::Append(Entry* entry, const void* data, uint64_t length) {
+  DCHECK(entry);
+  absl::MutexLock lock(&mutex_);
+  DCHECK(!entry->complete);
+  entry->data.append(static_cast<const char*>(data), length);
+  if (entry->stored)
+    size_ += length;
+}
+
+void SegmentStore::FinishWriting(const std::string& path,
+                                 const std::shared_ptr<Entry>& entry) {
+  DCHECK(entry);
+  absl::MutexLock lock(&mutex_);
+  entry->complete = true;
+
+  auto iter = files_.find(path);
+  if (iter == files_.end() || iter->second.writing != entry) {
+    // Replaced or deleted while being written.
+    return;
+  }
+  Versions& versions = iter->second;
+  if (versions.complete)
+    DropCompleteVersion(&versions);
+  versions.complete = std::move(versions.writing);
+  versions.completion_position =
+      completion_order_.insert(completion_order_.end(), path);
+  Evict();
+}
+
+std::shared_ptr<SegmentStore::Entry> SegmentStore::Find(
+    const std::string& path) const {
+  absl::MutexLock lock(&mutex_);
+  auto iter = files_.find(path);
+  if (iter == files_.end())
+    return nullptr;
+  return iter->second.complete ? iter->second.complete : iter->second.writing;
+}
+
+uint64_t SegmentStore::Read(const Entry& entry,
+                            uint64_t offset,
+                            void* buffer,
+                            uint64_t length,
+                            bool* complete) const {
+  absl::MutexLock lock(&mutex_);
+  if (complete)
+    *complete = entry.complete;
+  if (offset >= entry.data.size())
+    return 0;
+  const uint64_t bytes_to_read = std::min(length, entry.data.size() - offset);
+  memcpy(buffer, entry.data.data() + offset, bytes_to_read);
+  return bytes_to_read;
+}
+
+uint64_t SegmentStore::Size(const Entry& entry) const {
+  absl::MutexLock lock(&mutex_);
+  return entry.data.size();
+}
+
+bool SegmentStore::IsComplete(const Entry& entry) const {
+  absl::MutexLock lock(&mutex_);
+  return entry.complete;
+}
+
+bool SegmentStore::ReadToString(const std::string& path,
+                                std::string* contents,
+                                bool* complete) const {
+  DCHECK(contents);
+  std::shared_ptr<Entry> entry = Find(path);
+  if (!entry)
+    return false;
+  absl::MutexLock lock(&mutex_);
+  *contents = entry->data;
+  if (complete)
+    *complete = entry->complete;
+  return true;
+}
+
+bool SegmentStore::Delete(const std::string& path) {
+  absl::MutexLock lock(&mutex_);
+  auto iter = files_.find(path);
+  if (iter == files_.end())
+    return false;
+  Versions& versions = iter->second;
+  if (versions.complete)
+    DropCompleteVersion(&versions);
+  if (versions.writing) {
+    size_ -= versions.writing->data.size();
+    versions.writing->stored = false;
+  }
+  files_.erase(iter);
+  return true;
+}
+
+void SegmentStore::DeleteAll() {
+  absl::MutexLock lock(&mutex_);
+  for (auto& pair : files_) {
+    if (pair.second.complete)
+      pair.second.complete->stored = false;
+    if (pair.second.writing)
+      pair.second.writing->stored = false;
+  }
+  files_.clear();
+  completion_order_.clear();
+  size_ = 0;
+}
+
+uint64_t SegmentStore::size() const {
+  absl::MutexLock lock(&mutex_);
+  return size_;
+}
+
+void SegmentStore::DropCompleteVersion(Versions* versions) {
+  DCHECK(versions->complete);
+  size_ -= versions->complete->data.size();
+  versions->complete->stored = false;
+  versions->complete.reset();
+  completion_order_.erase(versions->completion_position);
+}
+
+void SegmentStore::Evict() {
+  while (size_ > max_size_ && completion_order_.size() > 1) {
+    auto iter = files_.find(completion_order_.front());
+    DCHECK(iter != files_.end());
+    VLOG(1) << "Dropping '" << iter->first << "' from the segment store.";
+    DropCompleteVersion(&iter->second);
+    if (!iter->second.writing)
+      files_.erase(iter);
+  }
+}
+
+}  // namespace shaka
@@ -0,0 +1,115 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_FILE_SEGMENT_STORE_H_
+#define PACKAGER_FILE_SEGMENT_STORE_H_
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <absl/synchronization/mutex.h>
+
+namespace shaka {
+
+/// A bounded in-memory store of the files written by the muxers and the
+/// manifest generators, which are served by the built-in HTTP origin.
+///
+/// Every path has at most one complete version, which is what readers get,
+/// and one version being written. A file that has never been completed is
+/// served while it is being written, so that low latency segments can be
+/// delivered chunk by chunk, but a rewritten manifest only replaces the
+/// previous one once it is complete.
+///
+/// When the store is full, the least recently completed files are dropped.
+/// Files being written are never dropped.
+class SegmentStore {
+ public:
+  /// The contents of a version of a file. Only accessed through the store.
+  class Entry;
+
+  /// @return The process-wide store.
+  static SegmentStore* GetInstance();
+
+  /// Sets the maximum number of bytes stored. Files may be dropped on the
+  /// next call to FinishWriting().
+  void SetMaxSize(uint64_t max_size);
+
+  /// Starts a new version of |path|, which replaces any version of it being
+  /// written.
+  /// @param append true to start with the contents of the latest version.
+  /// @return The new version, to be passed to Append() and FinishWriting().
+  std::shared_ptr<Entry> StartWriting(const std::string& path, bool append);
+  /// Appends |length| bytes to a version being written.
+  void Append(Entry* entry, const void* data, uint64_t length);
+  /// Completes a version started with StartWriting(). It becomes the version
+  /// served for |path|, unless it was replaced or deleted in the meantime.
+  void FinishWriting(const std::string& path,
+                     const std::shared_ptr<Entry>& entry);
+
+  /// @return The version served for |path|, or nullptr if there is none.
+  std::shared_ptr<Entry> Find(const std::string& path) const;
+  /// Copies up to |length| bytes of |entry| from |offset|.
+  /// @param complete is set to whether |entry| is complete, i.e. whether a
+  ///        short read is the end of the file. Can be nullptr.
+  /// @return The number of bytes copied.
+  uint64_t Read(const Entry& entry,
+                uint64_t offset,
+                void* buffer,
+                uint64_t length,
+                bool* complete) const;
+  /// @return The current size of |entry|.
+  uint64_t Size(const Entry& entry) const;
+  /// @return Whether |entry| is complete, i.e. whether its size is final.
+  bool IsComplete(const Entry& entry) const;
+  /// Reads the whole version served for |path|.
+  /// @return false if there is no such file.
+  bool ReadToString(const std::string& path,
+                    std::string* contents,
+                    bool* complete) const;
+
+  /// Deletes all versions of |path|. Readers holding one of them can still
+  /// read it.
+  /// @return false if there was no such file.
+  bool Delete(const std::string& path);
+  /// Deletes all the files.
+  void DeleteAll();
+
+  /// @return The number of bytes stored.
+  uint64_t size() const;
+
+ private:
+  struct Versions {
+    std::shared_ptr<Entry> complete;
+    std::shared_ptr<Entry> writing;
+    // Position in |completion_order_|, if |complete| is set.
+    std::list<std::string>::iterator completion_position;
+  };
+
+  SegmentStore();
+  ~SegmentStore();
+  SegmentStore(const SegmentStore&) = delete;
+  SegmentStore& operator=(const SegmentStore&) = delete;
+
+  void DropCompleteVersion(Versions* versions)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Drops the least recently completed files, except the most recent one,
+  // until the store fits in |max_size_|.
+  void Evict() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  mutable absl::Mutex mutex_;
+  uint64_t max_size_ ABSL_GUARDED_BY(mutex_);
+  uint64_t size_ ABSL_GUARDED_BY(mutex_) = 0;
+  std::map<std::string, Versions> files_ ABSL_GUARDED_BY(mutex_);
+  // Paths of the complete versions, least recently completed first.
+  std::list<std::string> completion_order_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_FILE_SEGMENT_STORE_H_
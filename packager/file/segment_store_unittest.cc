@@ -0,0 +1,160 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/file/segment_store.h>
+
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <packager/file.h>
+#include <packager/file/file_closer.h>
+
+namespace shaka {
+namespace {
+
+const uint64_t kDefaultMaxSize = 512ULL << 20;
+
+}  // namespace
+
+class SegmentStoreTest : public testing::Test {
+ protected:
+  void SetUp() override { store_ = SegmentStore::GetInstance(); }
+
+  void TearDown() override {
+    store_->DeleteAll();
+    store_->SetMaxSize(kDefaultMaxSize);
+  }
+
+  void WriteFile(const std::string& path, const std::string& contents) {
+    std::shared_ptr<SegmentStore::Entry> entry =
+        store_->StartWriting(path, false);
+    store_->Append(entry.get(), contents.data(), contents.size());
+    store_->FinishWriting(path, entry);
+  }
+
+  std::string ReadFile(const std::string& path, bool* complete = nullptr) {
+    std::string contents;
+    EXPECT_TRUE(store_->ReadToString(path, &contents, complete));
+    return contents;
+  }
+
+  SegmentStore* store_ = nullptr;
+};
+
+TEST_F(SegmentStoreTest, ServesFileBeingWritten) {
+  std::shared_ptr<SegmentStore::Entry> entry =
+      store_->StartWriting("seg-1.m4s", false);
+  store_->Append(entry.get(), "abc", 3);
+
+  bool complete = true;
+  EXPECT_EQ("abc", ReadFile("seg-1.m4s", &complete));
+  EXPECT_FALSE(complete);
+
+  store_->Append(entry.get(), "def", 3);
+  char buffer[8];
+  EXPECT_EQ(3u, store_->Read(*entry, 3, buffer, sizeof(buffer), &complete));
+  EXPECT_EQ("def", std::string(buffer, 3));
+  EXPECT_FALSE(complete);
+
+  store_->FinishWriting("seg-1.m4s", entry);
+  EXPECT_EQ("abcdef", ReadFile("seg-1.m4s", &complete));
+  EXPECT_TRUE(complete);
+}
+
+TEST_F(SegmentStoreTest, ServesPreviousVersionUntilComplete) {
+  WriteFile("manifest.mpd", "old");
+
+  std::shared_ptr<SegmentStore::Entry> entry =
+      store_->StartWriting("manifest.mpd", false);
+  store_->Append(entry.get(), "new", 3);
+  EXPECT_EQ("old", ReadFile("manifest.mpd"));
+
+  store_->FinishWriting("manifest.mpd", entry);
+  EXPECT_EQ("new", ReadFile("manifest.mpd"));
+  EXPECT_EQ(3u, store_->size());
+}
+
+TEST_F(SegmentStoreTest, Append) {
+  WriteFile("seg.m4s", "abc");
+
+  std::shared_ptr<SegmentStore::Entry> entry =
+      store_->StartWriting("seg.m4s", true);
+  store_->Append(entry.get(), "def", 3);
+  store_->FinishWriting("seg.m4s", entry);
+  EXPECT_EQ("abcdef", ReadFile("seg.m4s"));
+  EXPECT_EQ(6u, store_->size());
+}
+
+TEST_F(SegmentStoreTest, DropsLeastRecentlyCompletedFiles) {
+  store_->SetMaxSize(10);
+  WriteFile("seg-1.m4s", "1234");
+  WriteFile("seg-2.m4s", "1234");
+
+  std::shared_ptr<SegmentStore::Entry> entry =
+      store_->StartWriting("seg-4.m4s", false);
+  store_->Append(entry.get(), "12345678", 8);
+  WriteFile("seg-3.m4s", "1234");
+
+  // Files being written and the most recently completed file are kept.
+  EXPECT_FALSE(store_->Find("seg-1.m4s"));
+  EXPECT_FALSE(store_->Find("seg-2.m4s"));
+  EXPECT_TRUE(store_->Find("seg-3.m4s"));
+  EXPECT_TRUE(store_->Find("seg-4.m4s"));
+  EXPECT_EQ(12u, store_->size());
+
+  store_->FinishWriting("seg-4.m4s", entry);
+  EXPECT_FALSE(store_->Find("seg-3.m4s"));
+  EXPECT_EQ(8u, store_->size());
+}
+
+TEST_F(SegmentStoreTest, Delete) {
+  std::shared_ptr<SegmentStore::Entry> entry =
+      store_->StartWriting("seg.m4s", false);
+  store_->Append(entry.get(), "abc", 3);
+  EXPECT_TRUE(store_->Delete("seg.m4s"));
+  EXPECT_FALSE(store_->Delete("seg.m4s"));
+  EXPECT_FALSE(store_->Find("seg.m4s"));
+
+  // Finishing a deleted file does not bring it back.
+  store_->Append(entry.get(), "def", 3);
+  store_->FinishWriting("seg.m4s", entry);
+  EXPECT_FALSE(store_->Find("seg.m4s"));
+  EXPECT_EQ(0u, store_->size());
+}
+
+TEST_F(SegmentStoreTest, OriginFile) {
+  std::unique_ptr<File, FileCloser> writer(
+      File::Open("origin://live/seg-1.m4s", "w"));
+  ASSERT_TRUE(writer);
+  ASSERT_EQ(3, writer->Write("abc", 3));
+
+  // Written data is visible before the file is closed.
+  std::string contents;
+  ASSERT_TRUE(File::ReadFileToString("origin://live/seg-1.m4s", &contents));
+  EXPECT_EQ("abc", contents);
+  writer.reset();
+
+  std::unique_ptr<File, FileCloser> appender(
+      File::Open("origin://live/seg-1.m4s", "a"));
+  ASSERT_TRUE(appender);
+  ASSERT_EQ(3, appender->Write("def", 3));
+  appender.reset();
+  contents.clear();
+  ASSERT_TRUE(File::ReadFileToString("origin://live/seg-1.m4s", &contents));
+  EXPECT_EQ("abcdef", contents);
+
+  ASSERT_TRUE(File::WriteFileAtomically("origin://live/manifest.mpd", "mpd"));
+  contents.clear();
+  ASSERT_TRUE(File::ReadFileToString("origin://live/manifest.mpd", &contents));
+  EXPECT_EQ("mpd", contents);
+
+  EXPECT_TRUE(File::Delete("origin://live/seg-1.m4s"));
+  EXPECT_FALSE(File::Open("origin://live/seg-1.m4s", "r"));
+}
+
+}  // namespace shaka
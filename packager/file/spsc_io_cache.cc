@@ -0,0 +1,224 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/file/spsc_io_cache.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <absl/log/check.h>
+#include <absl/log/log.h>
+
+#include <packager/macros/logging.h>
+
+namespace shaka {
+namespace {
+
+// The number of times to check whether the other side is done before going
+// to sleep. Sleeping and waking up take system calls, which are not worth it
+// when the other side is about to be done, e.g. when it is copying a block.
+const int kSpinCount = 512;
+
+void CpuRelax() {
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+  asm volatile("yield");
+#endif
+}
+
+}  // namespace
+
+SpscIoCache::SpscIoCache(uint64_t cache_size)
+    : cache_size_(cache_size),
+      circular_buffer_(new uint8_t[cache_size]),
+      writer_wake_up_size_(std::max<uint64_t>(cache_size / 4, 1)) {
+  DCHECK_GT(cache_size, 0u);
+}
+
+SpscIoCache::~SpscIoCache() {
+  Close();
+}
+
+uint64_t SpscIoCache::Read(void* buffer, uint64_t size) {
+  DCHECK(buffer);
+
+  uint8_t* dest = static_cast<uint8_t*>(buffer);
+  uint64_t bytes_read = 0;
+  // The data may wrap around the end of the buffer, in which case it is read
+  // in two regions. Only the first one is waited for.
+  do {
+    const uint8_t* data = nullptr;
+    const uint64_t region_size =
+        std::min(size - bytes_read, GetReadRegion(&data));
+    if (region_size == 0)
+      break;
+    memcpy(dest + bytes_read, data, region_size);
+    CommitRead(region_size);
+    bytes_read += region_size;
+  } while (bytes_read < size &&
+           reader_write_position_ !=
+               read_position_.load(std::memory_order_relaxed));
+  return bytes_read;
+}
+
+uint64_t SpscIoCache::Write(const void* buffer, uint64_t size) {
+  DCHECK(buffer);
+
+  const uint8_t* source = static_cast<const uint8_t*>(buffer);
+  uint64_t bytes_written = 0;
+  while (bytes_written < size) {
+    uint8_t* data = nullptr;
+    const uint64_t region_size =
+        std::min(size - bytes_written, GetWriteRegion(&data));
+    if (region_size == 0)
+      return 0;
+    memcpy(data, source + bytes_written, region_size);
+    CommitWrite(region_size);
+    bytes_written += region_size;
+  }
+  return size;
+}
+
+uint64_t SpscIoCache::GetReadRegion(const uint8_t** data) {
+  DCHECK(data);
+
+  const uint64_t read_position = read_position_.load(std::memory_order_relaxed);
+  if (reader_write_position_ == read_position) {
+    reader_write_position_ = write_position_.load(std::memory_order_acquire);
+    if (reader_write_position_ == read_position) {
+      Wait(&reader_waiting_, [this, read_position]() {
+        return closed() || write_position_.load(std::memory_order_acquire) !=
+                               read_position;
+      });
+      // Everything written before the cache was closed is still read.
+      reader_write_position_ = write_position_.load(std::memory_order_acquire);
+      if (reader_write_position_ == read_position)
+        return 0;
+    }
+  }
+
+  const uint64_t offset = read_position % cache_size_;
+  *data = circular_buffer_.get() + offset;
+  return std::min(reader_write_position_ - read_position, cache_size_ - offset);
+}
+
+void SpscIoCache::CommitRead(uint64_t size) {
+  const uint64_t read_position =
+      read_position_.load(std::memory_order_relaxed) + size;
+  DCHECK_LE(read_position, reader_write_position_);
+  read_position_.store(read_position, std::memory_order_release);
+
+  // |reader_write_position_| may be behind, in which case the writer may be
+  // woken up a little early.
+  if (cache_size_ - (reader_write_position_ - read_position) >=
+      writer_wake_up_size_) {
+    WakeUp(&writer_waiting_);
+  }
+}
+
+uint64_t SpscIoCache::GetWriteRegion(uint8_t** data) {
+  DCHECK(data);
+
+  const uint64_t write_position =
+      write_position_.load(std::memory_order_relaxed);
+  if (write_position - writer_read_position_ == cache_size_) {
+    writer_read_position_ = read_position_.load(std::memory_order_acquire);
+    if (write_position - writer_read_position_ == cache_size_ && !closed()) {
+      VLOG(1) << "Circular buffer is full, which can happen if data arrives "
+                 "faster than being consumed by packager. Ignore if it is not "
+                 "live packaging. Otherwise, try increasing --io_cache_size.";
+      Wait(&writer_waiting_, [this, write_position]() {
+        return closed() ||
+               write_position - read_position_.load(
+                                    std::memory_order_acquire) <
+                   cache_size_;
+      });
+      writer_read_position_ = read_position_.load(std::memory_order_acquire);
+    }
+  }
+  if (closed())
+    return 0;
+
+  const uint64_t offset = write_position % cache_size_;
+  *data = circular_buffer_.get() + offset;
+  return std::min(cache_size_ - (write_position - writer_read_position_),
+                  cache_size_ - offset);
+}
+
+void SpscIoCache::CommitWrite(uint64_t size) {
+  const uint64_t write_position =
+      write_position_.load(std::memory_order_relaxed) + size;
+  DCHECK_LE(write_position - writer_read_position_, cache_size_);
+  write_position_.store(write_position, std::memory_order_release);
+  WakeUp(&reader_waiting_);
+}
+
+void SpscIoCache::Clear() {
+  // The data is dropped by reading it, so that the positions keep growing.
+  reader_write_position_ = write_position_.load(std::memory_order_acquire);
+  read_position_.store(reader_write_position_, std::memory_order_release);
+  // Let any writers know that there is room in the cache.
+  WakeUp(&writer_waiting_);
+}
+
+void SpscIoCache::Close() {
+  closed_.store(true, std::memory_order_release);
+  // Unlocking the mutex lets any waiter check the cache again.
+  absl::MutexLock lock(&mutex_);
+}
+
+void SpscIoCache::Reopen() {
+  CHECK(closed());
+  Clear();
+  closed_.store(false, std::memory_order_release);
+}
+
+uint64_t SpscIoCache::BytesCached() {
+  // The read position is loaded first so that it is not past the write
+  // position.
+  const uint64_t read_position = read_position_.load(std::memory_order_acquire);
+  return write_position_.load(std::memory_order_acquire) - read_position;
+}
+
+uint64_t SpscIoCache::BytesFree() {
+  return cache_size_ - BytesCached();
+}
+
+void SpscIoCache::WaitUntilEmptyOrClosed() {
+  Wait(&writer_waiting_, [this]() {
+    return closed() || read_position_.load(std::memory_order_acquire) ==
+                           write_position_.load(std::memory_order_acquire);
+  });
+}
+
+template <typename ReadyFunction>
+void SpscIoCache::Wait(std::atomic<bool>* waiting, ReadyFunction ready) {
+  for (int i = 0; i < kSpinCount; ++i) {
+    if (ready())
+      return;
+    CpuRelax();
+  }
+
+  waiting->store(true, std::memory_order_relaxed);
+  // Pairs with the fence in WakeUp(), so that either |ready| sees the other
+  // side done, or the other side sees |*waiting| and wakes this one up.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  mutex_.LockWhen(absl::Condition(&ready));
+  mutex_.Unlock();
+  waiting->store(false, std::memory_order_relaxed);
+}
+
+void SpscIoCache::WakeUp(std::atomic<bool>* waiting) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiting->load(std::memory_order_relaxed)) {
+    // The condition of the waiter is checked again when the mutex is unlocked.
+    absl::MutexLock lock(&mutex_);
+  }
+}
+
+}  // namespace shaka
@@ -0,0 +1,143 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_FILE_SPSC_IO_CACHE_H_
+#define PACKAGER_FILE_SPSC_IO_CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include <absl/synchronization/mutex.h>
+
+#include <packager/macros/classes.h>
+
+namespace shaka {
+
+/// A circular buffer like IoCache, for exactly one reader thread and one
+/// writer thread. The reader and the writer only share atomic positions, and
+/// only take a lock to sleep, after spinning for a while, or to wake the other
+/// one up if it sleeps.
+///
+/// Besides Read() and Write(), which copy the data, the reader and the writer
+/// can get contiguous regions of the buffer to read or write in place.
+class SpscIoCache {
+ public:
+  explicit SpscIoCache(uint64_t cache_size);
+  ~SpscIoCache();
+
+  /// Read data from the cache. This function may block until there is data in
+  /// the cache.
+  /// @param buffer is a buffer into which to read the data from the cache.
+  /// @param size is the size of @a buffer.
+  /// @return the number of bytes read into @a buffer, or 0 if the call
+  ///         unblocked because the cache has been closed and is empty.
+  uint64_t Read(void* buffer, uint64_t size);
+
+  /// Write data to the cache. This function may block until there is enough
+  /// room in the cache.
+  /// @param buffer is a buffer containing the data to be written to the cache.
+  /// @param size is the size of the data to be written to the cache.
+  /// @return the amount of data written to the buffer (which will equal
+  ///         @a data), or 0 if the call unblocked because the cache has been
+  ///         closed.
+  uint64_t Write(const void* buffer, uint64_t size);
+
+  /// Get the oldest data in the cache which is contiguous in the buffer. This
+  /// function may block until there is data in the cache. The data stays in
+  /// the cache until it is released with CommitRead().
+  /// @param data receives a pointer to the data.
+  /// @return the number of bytes at @a data, or 0 if the call unblocked
+  ///         because the cache has been closed and is empty.
+  uint64_t GetReadRegion(const uint8_t** data);
+
+  /// Release data from the cache, after it was read from GetReadRegion().
+  /// @param size is the number of bytes to release, up to the size of the
+  ///        region.
+  void CommitRead(uint64_t size);
+
+  /// Get free room in the cache which is contiguous in the buffer. This
+  /// function may block until there is room in the cache. The data written
+  /// to the region is added to the cache with CommitWrite().
+  /// @param data receives a pointer to the room.
+  /// @return the number of bytes at @a data, or 0 if the call unblocked
+  ///         because the cache has been closed.
+  uint64_t GetWriteRegion(uint8_t** data);
+
+  /// Add data to the cache, after it was written to GetWriteRegion().
+  /// @param size is the number of bytes to add, up to the size of the region.
+  void CommitWrite(uint64_t size);
+
+  /// Empties the cache. Only the reader may empty the cache.
+  void Clear();
+
+  /// Close the cache. This will call any blocking calls to unblock, and the
+  /// cache won't be usable until Reopened.
+  void Close();
+
+  /// @return true if the cache is closed, false otherwise.
+  bool closed() { return closed_.load(std::memory_order_acquire); }
+
+  /// Reopens the cache. Any data still in the cache will be lost. Only the
+  /// reader may reopen the cache.
+  void Reopen();
+
+  /// Returns the number of bytes in the cache.
+  /// @return the number of bytes in the cache.
+  uint64_t BytesCached();
+
+  /// Returns the number of free bytes in the cache.
+  /// @return the number of free bytes in the cache.
+  uint64_t BytesFree();
+
+  /// Waits until the cache is empty or has been closed. Only the writer may
+  /// wait.
+  void WaitUntilEmptyOrClosed();
+
+ private:
+  // Keeps the positions written by the reader and the writer on separate cache
+  // lines, so that they do not invalidate each other's caches.
+  static constexpr size_t kCacheLineSize = 64;
+
+  // Spins and then sleeps until |ready| returns true, with |*waiting| set
+  // while sleeping.
+  template <typename ReadyFunction>
+  void Wait(std::atomic<bool>* waiting, ReadyFunction ready);
+
+  // Wakes up the other side if it sleeps, which it checks in |*waiting|.
+  void WakeUp(std::atomic<bool>* waiting);
+
+  const uint64_t cache_size_;
+  // Not initialized, so that large caches are cheap to create when only a
+  // part of them is used.
+  std::unique_ptr<uint8_t[]> circular_buffer_;
+  // A sleeping writer is only woken up once it can write this many bytes, so
+  // that it does not wake up for every read.
+  const uint64_t writer_wake_up_size_;
+
+  // Positions only grow, the offset in |circular_buffer_| being their
+  // remainder of |cache_size_|. Written by the reader.
+  alignas(kCacheLineSize) std::atomic<uint64_t> read_position_{0};
+  std::atomic<bool> reader_waiting_{false};
+  // The last |write_position_| seen by the reader.
+  uint64_t reader_write_position_ = 0;
+
+  // Written by the writer.
+  alignas(kCacheLineSize) std::atomic<uint64_t> write_position_{0};
+  std::atomic<bool> writer_waiting_{false};
+  // The last |read_position_| seen by the writer.
+  uint64_t writer_read_position_ = 0;
+
+  alignas(kCacheLineSize) std::atomic<bool> closed_{false};
+  // Only held to sleep and to wake up.
+  absl::Mutex mutex_;
+
+  DISALLOW_COPY_AND_ASSIGN(SpscIoCache);
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_FILE_SPSC_IO_CACHE_H_
@@ -0,0 +1,314 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/file/spsc_io_cache.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace {
+const uint64_t kBlockSize = 256;
+const uint64_t kCacheSize = 16 * kBlockSize;
+}  // namespace
+
+namespace shaka {
+
+class SpscIoCacheTest : public testing::Test {
+ public:
+  void WriteToCache(const std::vector<uint8_t>& test_buffer,
+                    uint64_t num_writes,
+                    int sleep_between_writes_ms,
+                    bool close_when_done) {
+    for (uint64_t write_idx = 0; write_idx < num_writes; ++write_idx) {
+      uint64_t write_result =
+          cache_->Write(test_buffer.data(), test_buffer.size());
+      if (!write_result) {
+        // Cache was closed.
+        cache_closed_ = true;
+        break;
+      }
+      EXPECT_EQ(test_buffer.size(), write_result);
+      if (sleep_between_writes_ms) {
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(sleep_between_writes_ms));
+      }
+    }
+    if (close_when_done)
+      cache_->Close();
+  }
+
+ protected:
+  void SetUp() override {
+    cache_.reset(new SpscIoCache(kCacheSize));
+    cache_closed_ = false;
+  }
+
+  void TearDown() override { WaitForWriterThread(); }
+
+  // Generates a buffer which does not repeat every block, to catch data read
+  // out of order.
+  void GenerateTestBuffer(uint64_t size, std::vector<uint8_t>* test_buffer) {
+    test_buffer->resize(size);
+    for (uint64_t idx = 0; idx < size; ++idx)
+      (*test_buffer)[idx] = static_cast<uint8_t>(idx * 7 + idx / 251);
+  }
+
+  void WriteToCacheThreaded(const std::vector<uint8_t>& test_buffer,
+                            uint64_t num_writes,
+                            int sleep_between_writes_ms,
+                            bool close_when_done) {
+    writer_thread_.reset(new std::thread(
+        std::bind(&SpscIoCacheTest::WriteToCache, this, test_buffer,
+                  num_writes, sleep_between_writes_ms, close_when_done)));
+  }
+
+  void WaitForWriterThread() {
+    if (writer_thread_) {
+      writer_thread_->join();
+      writer_thread_.reset();
+    }
+  }
+
+  std::unique_ptr<SpscIoCache> cache_;
+  std::unique_ptr<std::thread> writer_thread_;
+  bool cache_closed_;
+};
+
+TEST_F(SpscIoCacheTest, VerySmallWrite) {
+  const uint64_t kTestBytes(5);
+
+  std::vector<uint8_t> write_buffer;
+  GenerateTestBuffer(kTestBytes, &write_buffer);
+  WriteToCacheThreaded(write_buffer, 1, 0, false);
+
+  std::vector<uint8_t> read_buffer(kTestBytes);
+  EXPECT_EQ(kTestBytes, cache_->Read(read_buffer.data(), kTestBytes));
+  EXPECT_EQ(write_buffer, read_buffer);
+}
+
+TEST_F(SpscIoCacheTest, LotsOfUnalignedBlocks) {
+  const uint64_t kNumWrites(kCacheSize * 1000 / kBlockSize);
+  const uint64_t kUnalignBlockSize(55);
+
+  std::vector<uint8_t> write_buffer;
+  GenerateTestBuffer(kUnalignBlockSize, &write_buffer);
+  WriteToCacheThreaded(write_buffer, kNumWrites, 0, true);
+
+  std::vector<uint8_t> verify_buffer;
+  for (uint64_t idx = 0; idx < kNumWrites; ++idx) {
+    verify_buffer.insert(verify_buffer.end(), write_buffer.begin(),
+                         write_buffer.end());
+  }
+  std::vector<uint8_t> read_buffer;
+  while (true) {
+    uint8_t block[kBlockSize];
+    uint64_t bytes_read = cache_->Read(block, kBlockSize);
+    if (bytes_read == 0)
+      break;
+    read_buffer.insert(read_buffer.end(), block, block + bytes_read);
+  }
+  EXPECT_EQ(verify_buffer, read_buffer);
+}
+
+TEST_F(SpscIoCacheTest, SlowRead) {
+  const int kReadDelayMs(10);
+  const uint64_t kNumWrites(kCacheSize * 5 / kBlockSize);
+
+  std::vector<uint8_t> write_buffer;
+  GenerateTestBuffer(kBlockSize, &write_buffer);
+  WriteToCacheThreaded(write_buffer, kNumWrites, 0, false);
+  for (uint64_t num_reads = 0; num_reads < kNumWrites; ++num_reads) {
+    std::vector<uint8_t> read_buffer(kBlockSize);
+    EXPECT_EQ(kBlockSize, cache_->Read(read_buffer.data(), kBlockSize));
+    EXPECT_EQ(write_buffer, read_buffer);
+    std::this_thread::sleep_for(std::chrono::milliseconds(kReadDelayMs));
+  }
+}
+
+TEST_F(SpscIoCacheTest, CloseByReader) {
+  const uint64_t kNumWrites(kCacheSize * 1000 / kBlockSize);
+
+  std::vector<uint8_t> write_buffer;
+  GenerateTestBuffer(kBlockSize, &write_buffer);
+  WriteToCacheThreaded(write_buffer, kNumWrites, 0, false);
+  while (cache_->BytesCached() < kCacheSize) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(0u, cache_->BytesFree());
+  cache_->Close();
+  WaitForWriterThread();
+  EXPECT_TRUE(cache_closed_);
+}
+
+TEST_F(SpscIoCacheTest, CloseByWriter) {
+  uint8_t test_buffer[kBlockSize];
+  std::vector<uint8_t> write_buffer;
+  WriteToCacheThreaded(write_buffer, 0, 0, true);
+  EXPECT_EQ(0U, cache_->Read(test_buffer, kBlockSize));
+  WaitForWriterThread();
+}
+
+TEST_F(SpscIoCacheTest, ReadsDataWrittenBeforeClose) {
+  const uint64_t kTestBytes(kBlockSize + 1);
+
+  std::vector<uint8_t> write_buffer;
+  GenerateTestBuffer(kTestBytes, &write_buffer);
+  WriteToCache(write_buffer, 1, 0, true);
+
+  std::vector<uint8_t> read_buffer(kCacheSize);
+  EXPECT_EQ(kTestBytes, cache_->Read(read_buffer.data(), kCacheSize));
+  read_buffer.resize(kTestBytes);
+  EXPECT_EQ(write_buffer, read_buffer);
+  EXPECT_EQ(0u, cache_->Read(read_buffer.data(), kCacheSize));
+}
+
+TEST_F(SpscIoCacheTest, Reopen) {
+  const uint64_t kTestBytes1(5);
+  const uint64_t kTestBytes2(10);
+
+  std::vector<uint8_t> write_buffer;
+  GenerateTestBuffer(kTestBytes1, &write_buffer);
+  WriteToCache(write_buffer, 2, 0, true);
+
+  std::vector<uint8_t> read_buffer(kTestBytes1);
+  EXPECT_EQ(kTestBytes1, cache_->Read(read_buffer.data(), kTestBytes1));
+  EXPECT_EQ(write_buffer, read_buffer);
+
+  ASSERT_TRUE(cache_->closed());
+  cache_->Reopen();
+  ASSERT_FALSE(cache_->closed());
+  // The data left is dropped.
+  EXPECT_EQ(0u, cache_->BytesCached());
+
+  GenerateTestBuffer(kTestBytes2, &write_buffer);
+  WriteToCacheThreaded(write_buffer, 1, 0, false);
+  read_buffer.resize(kTestBytes2);
+  EXPECT_EQ(kTestBytes2, cache_->Read(read_buffer.data(), kTestBytes2));
+  EXPECT_EQ(write_buffer, read_buffer);
+}
+
+TEST_F(SpscIoCacheTest, SingleLargeWrite) {
+  const uint64_t kTestBytes(kCacheSize * 10);
+
+  std::vector<uint8_t> write_buffer;
+  GenerateTestBuffer(kTestBytes, &write_buffer);
+  WriteToCacheThreaded(write_buffer, 1, 0, false);
+  uint64_t bytes_read(0);
+  std::vector<uint8_t> read_buffer(kTestBytes);
+  while (bytes_read < kTestBytes) {
+    EXPECT_EQ(kBlockSize, cache_->Read(&read_buffer[bytes_read], kBlockSize));
+    bytes_read += kBlockSize;
+  }
+  EXPECT_EQ(write_buffer, read_buffer);
+}
+
+TEST_F(SpscIoCacheTest, LargeReadWrapsAround) {
+  const uint64_t kOffset(kBlockSize / 2);
+
+  // Move the positions off the start of the buffer.
+  std::vector<uint8_t> write_buffer;
+  GenerateTestBuffer(kOffset, &write_buffer);
+  WriteToCache(write_buffer, 1, 0, false);
+  std::vector<uint8_t> read_buffer(kOffset);
+  EXPECT_EQ(kOffset, cache_->Read(read_buffer.data(), kOffset));
+
+  GenerateTestBuffer(kCacheSize, &write_buffer);
+  WriteToCache(write_buffer, 1, 0, false);
+  read_buffer.resize(kCacheSize);
+  EXPECT_EQ(kCacheSize, cache_->Read(read_buffer.data(), kCacheSize));
+  EXPECT_EQ(write_buffer, read_buffer);
+}
+
+TEST_F(SpscIoCacheTest, Regions) {
+  const uint64_t kOffset(kBlockSize / 2);
+
+  uint8_t* write_region = nullptr;
+  ASSERT_EQ(kCacheSize, cache_->GetWriteRegion(&write_region));
+  memset(write_region, 1, kOffset);
+  cache_->CommitWrite(kOffset);
+  EXPECT_EQ(kOffset, cache_->BytesCached());
+
+  const uint8_t* read_region = nullptr;
+  ASSERT_EQ(kOffset, cache_->GetReadRegion(&read_region));
+  EXPECT_EQ(write_region, read_region);
+  EXPECT_EQ(1, read_region[kOffset - 1]);
+  // Only a part of the region is released.
+  cache_->CommitRead(kOffset - 1);
+  ASSERT_EQ(1u, cache_->GetReadRegion(&read_region));
+  cache_->CommitRead(1);
+
+  // The room left is split at the end of the buffer.
+  const uint8_t* buffer_start = write_region;
+  ASSERT_EQ(kCacheSize - kOffset, cache_->GetWriteRegion(&write_region));
+  EXPECT_EQ(buffer_start + kOffset, write_region);
+  memset(write_region, 2, kCacheSize - kOffset);
+  cache_->CommitWrite(kCacheSize - kOffset);
+  ASSERT_EQ(kOffset, cache_->GetWriteRegion(&write_region));
+  EXPECT_EQ(buffer_start, write_region);
+  memset(write_region, 3, kOffset);
+  cache_->CommitWrite(kOffset);
+  EXPECT_EQ(0u, cache_->BytesFree());
+
+  ASSERT_EQ(kCacheSize - kOffset, cache_->GetReadRegion(&read_region));
+  EXPECT_EQ(2, read_region[0]);
+  cache_->CommitRead(kCacheSize - kOffset);
+  ASSERT_EQ(kOffset, cache_->GetReadRegion(&read_region));
+  EXPECT_EQ(3, read_region[0]);
+  cache_->CommitRead(kOffset);
+  EXPECT_EQ(0u, cache_->BytesCached());
+}
+
+TEST_F(SpscIoCacheTest, ThreadedRegions) {
+  const uint64_t kTestBytes(kCacheSize * 100 + 3);
+
+  std::vector<uint8_t> write_buffer;
+  GenerateTestBuffer(kTestBytes, &write_buffer);
+  writer_thread_.reset(new std::thread([this, &write_buffer]() {
+    uint64_t bytes_written = 0;
+    while (bytes_written < write_buffer.size()) {
+      uint8_t* region = nullptr;
+      // Writes less than the region, in odd sizes.
+      uint64_t size =
+          std::min<uint64_t>({cache_->GetWriteRegion(&region), 100,
+                              write_buffer.size() - bytes_written});
+      memcpy(region, &write_buffer[bytes_written], size);
+      cache_->CommitWrite(size);
+      bytes_written += size;
+    }
+    cache_->WaitUntilEmptyOrClosed();
+    cache_->Close();
+  }));
+
+  std::vector<uint8_t> read_buffer;
+  while (true) {
+    const uint8_t* region = nullptr;
+    uint64_t size = cache_->GetReadRegion(&region);
+    if (size == 0)
+      break;
+    read_buffer.insert(read_buffer.end(), region, region + size);
+    cache_->CommitRead(size);
+  }
+  EXPECT_EQ(write_buffer, read_buffer);
+}
+
+TEST_F(SpscIoCacheTest, WriteRegionUnblocksOnClose) {
+  std::vector<uint8_t> write_buffer;
+  GenerateTestBuffer(kCacheSize, &write_buffer);
+  WriteToCache(write_buffer, 1, 0, false);
+
+  writer_thread_.reset(new std::thread([this]() {
+    uint8_t* region = nullptr;
+    EXPECT_EQ(0u, cache_->GetWriteRegion(&region));
+  }));
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  cache_->Close();
+}
+
+}  // namespace shaka
@@ -6,6 +6,8 @@
 
 #include <packager/file/threaded_io_file.h>
 
+#include <algorithm>
+
 #include <absl/log/check.h>
 
 #include <packager/file/thread_pool.h>
@@ -20,7 +22,7 @@ ThreadedIoFile::ThreadedIoFile(std::unique_ptr<File, FileCloser> internal_file,
       internal_file_(std::move(internal_file)),
       mode_(mode),
       cache_(io_cache_size),
-      io_buffer_(io_block_size),
+      io_block_size_(io_block_size),
       position_(0),
       size_(0),
       eof_(false),
@@ -39,11 +41,15 @@ bool ThreadedIoFile::Open() {
   if (!internal_file_->Open())
     return false;
 
+  Start();
+  return true;
+}
+
+void ThreadedIoFile::Start() {
   position_ = 0;
   size_ = internal_file_->Size();
 
   ThreadPool::instance.PostTask(std::bind(&ThreadedIoFile::TaskHandler, this));
-  return true;
 }
 
 bool ThreadedIoFile::Close() {
@@ -180,15 +186,26 @@ void ThreadedIoFile::RunInInputMode() {
   DCHECK_EQ(kInputMode, mode_);
 
   while (true) {
+    uint8_t* region = nullptr;
+    const uint64_t region_size = cache_.GetWriteRegion(&region);
+    if (region_size == 0)
+      return;
+
+    const bool read_in_place = region_size >= io_block_size_;
+    if (!read_in_place && io_buffer_.empty())
+      io_buffer_.resize(io_block_size_);
     int64_t read_result =
-        internal_file_->Read(&io_buffer_[0], io_buffer_.size());
+        internal_file_->Read(read_in_place ? region : io_buffer_.data(),
+                             io_block_size_);
     if (read_result <= 0) {
       eof_.store(read_result == 0, std::memory_order_relaxed);
       internal_file_error_.store(read_result, std::memory_order_relaxed);
       cache_.Close();
       return;
     }
-    if (cache_.Write(&io_buffer_[0], read_result) == 0) {
+    if (read_in_place) {
+      cache_.CommitWrite(read_result);
+    } else if (cache_.Write(io_buffer_.data(), read_result) == 0) {
       return;
     }
   }
@@ -199,7 +216,9 @@ void ThreadedIoFile::RunInOutputMode() {
   DCHECK_EQ(kOutputMode, mode_);
 
   while (true) {
-    uint64_t write_bytes = cache_.Read(&io_buffer_[0], io_buffer_.size());
+    const uint8_t* region = nullptr;
+    const uint64_t write_bytes =
+        std::min(cache_.GetReadRegion(&region), io_block_size_);
     if (write_bytes == 0) {
       absl::MutexLock lock(&flush_mutex_);
       if (flushing_) {
@@ -213,7 +232,7 @@ void ThreadedIoFile::RunInOutputMode() {
       uint64_t bytes_written(0);
       while (bytes_written < write_bytes) {
         int64_t write_result = internal_file_->Write(
-            &io_buffer_[bytes_written], write_bytes - bytes_written);
+            region + bytes_written, write_bytes - bytes_written);
         if (write_result < 0) {
           internal_file_error_.store(write_result, std::memory_order_relaxed);
           cache_.Close();
@@ -227,6 +246,7 @@ void ThreadedIoFile::RunInOutputMode() {
         }
         bytes_written += write_result;
       }
+      cache_.CommitRead(write_bytes);
     }
   }
 }
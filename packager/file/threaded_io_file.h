@@ -14,7 +14,7 @@
 
 #include <packager/file.h>
 #include <packager/file/file_closer.h>
-#include <packager/file/io_cache.h>
+#include <packager/file/spsc_io_cache.h>
 #include <packager/macros/classes.h>
 
 namespace shaka {
@@ -41,6 +41,10 @@ class ThreadedIoFile : public File {
   bool Tell(uint64_t* position) override;
   /// @}
 
+  /// Starts the I/O task on an internal file which is already open, instead
+  /// of opening it with Open().
+  void Start();
+
  protected:
   ~ThreadedIoFile() override;
 
@@ -56,7 +60,13 @@ class ThreadedIoFile : public File {
 
   std::unique_ptr<File, FileCloser> internal_file_;
   const Mode mode_;
-  IoCache cache_;
+  // Only the caller and the task handler use the cache.
+  SpscIoCache cache_;
+  // The internal file is read and written in place in |cache_|, in blocks of
+  // up to |io_block_size_| bytes. Reads use |io_buffer_| instead when the
+  // room left at the end of |cache_| is smaller than a block, since some
+  // files, e.g. UDP, drop what does not fit in a read.
+  const uint64_t io_block_size_;
   std::vector<uint8_t> io_buffer_;
   uint64_t position_;
   uint64_t size_;
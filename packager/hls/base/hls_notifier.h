@@ -65,6 +65,21 @@ class HlsNotifier {
                                 uint64_t start_byte_offset,
                                 uint64_t size) = 0;
 
+  /// Called for every LL-HLS partial segment of the segment being written,
+  /// before NotifyNewSegment() is called for the whole segment.
+  /// @param stream_id is the value set by NotifyNewStream().
+  /// @param segment_name is the name of the segment containing the part.
+  /// @param duration is in terms of timescale passed in @a media_info.
+  /// @param start_byte_offset is the offset of the part in the segment.
+  /// @param size is the size in bytes.
+  /// @param is_independent is true if the part starts with a key frame.
+  virtual bool NotifyNewPart(uint32_t stream_id,
+                             const std::string& segment_name,
+                             int64_t duration,
+                             uint64_t start_byte_offset,
+                             uint64_t size,
+                             bool is_independent) = 0;
+
   /// Called on every key frame. For Video only.
   /// @param stream_id is the value set by NotifyNewStream().
   /// @param timestamp is the timesamp of the key frame in timescale units
@@ -564,6 +564,28 @@ bool MasterPlaylist::WriteMasterPlaylist(
     const std::string& base_url,
     const std::string& output_dir,
     const std::list<MediaPlaylist*>& playlists) {
+  return WriteRenderedMasterPlaylist(output_dir,
+                                     RenderMasterPlaylist(base_url, playlists));
+}
+
+bool MasterPlaylist::WriteRenderedMasterPlaylist(const std::string& output_dir,
+                                                 const std::string& content) {
+  // Skip if the playlist is already written.
+  if (content == written_playlist_)
+    return true;
+
+  auto file_path = std::filesystem::u8path(output_dir) / file_name_;
+  if (!File::WriteFileAtomically(file_path.string().c_str(), content)) {
+    LOG(ERROR) << "Failed to write master playlist to: " << file_path.string();
+    return false;
+  }
+  written_playlist_ = content;
+  return true;
+}
+
+std::string MasterPlaylist::RenderMasterPlaylist(
+    const std::string& base_url,
+    const std::list<MediaPlaylist*>& playlists) {
   std::string content = "#EXTM3U\n";
   AppendVersionString(&content);
 
@@ -589,18 +611,7 @@ bool MasterPlaylist::WriteMasterPlaylist(
 
   AppendPlaylists(default_audio_language_, default_text_language_, base_url,
                   playlists, &content);
-
-  // Skip if the playlist is already written.
-  if (content == written_playlist_)
-    return true;
-
-  auto file_path = std::filesystem::u8path(output_dir) / file_name_;
-  if (!File::WriteFileAtomically(file_path.string().c_str(), content)) {
-    LOG(ERROR) << "Failed to write master playlist to: " << file_path.string();
-    return false;
-  }
-  written_playlist_ = content;
-  return true;
+  return content;
 }
 
 }  // namespace hls
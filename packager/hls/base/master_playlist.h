@@ -45,6 +45,23 @@ class MasterPlaylist {
                                    const std::string& output_dir,
                                    const std::list<MediaPlaylist*>& playlists);
 
+  /// Write |content|, as returned by RenderMasterPlaylist(), to the Master
+  /// Playlist file in |output_dir|, for callers which render and write the
+  /// playlist at different times. It shares the last written content with
+  /// WriteMasterPlaylist().
+  /// @return true if the playlist is updated successfully or there is no
+  ///         difference since the last write, false otherwise.
+  bool WriteRenderedMasterPlaylist(const std::string& output_dir,
+                                   const std::string& content);
+
+  /// Generate the content of the Master Playlist, as written by
+  /// WriteMasterPlaylist().
+  /// @param base_url is the prefix for the Media Playlist files.
+  /// @return the playlist.
+  virtual std::string RenderMasterPlaylist(
+      const std::string& base_url,
+      const std::list<MediaPlaylist*>& playlists);
+
  private:
   MasterPlaylist(const MasterPlaylist&) = delete;
   MasterPlaylist& operator=(const MasterPlaylist&) = delete;
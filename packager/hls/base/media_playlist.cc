@@ -28,6 +28,11 @@ namespace shaka {
 namespace hls {
 
 namespace {
+// LL-HLS parts are kept in the playlist for this many target durations from
+// the end of the playlist; this is also the PART-HOLD-BACK in part target
+// durations. See RFC 8216bis sections 4.4.4.9 and 4.4.3.8.
+const int kPartHoldBackTargetDurations = 3;
+
 int32_t GetTimeScale(const MediaInfo& media_info) {
   if (media_info.has_reference_time_scale())
     return media_info.reference_time_scale();
@@ -111,7 +116,9 @@ std::string CreatePlaylistHeader(
     MediaPlaylist::MediaPlaylistStreamType stream_type,
     uint32_t media_sequence_number,
     int discontinuity_sequence_number,
-    std::optional<double> start_time_offset) {
+    std::optional<double> start_time_offset,
+    double part_target_duration,
+    bool can_block_reload) {
   const std::string version = GetPackagerVersion();
   std::string version_line;
   if (!version.empty()) {
@@ -157,6 +164,14 @@ std::string CreatePlaylistHeader(
     absl::StrAppendFormat(&header, "#EXT-X-START:TIME-OFFSET=%f\n",
                           start_time_offset.value());
   }
+  if (part_target_duration > 0) {
+    absl::StrAppendFormat(
+        &header, "#EXT-X-SERVER-CONTROL:%sPART-HOLD-BACK=%.3f\n",
+        can_block_reload ? "CAN-BLOCK-RELOAD=YES," : "",
+        kPartHoldBackTargetDurations * part_target_duration);
+    absl::StrAppendFormat(&header, "#EXT-X-PART-INF:PART-TARGET=%.3f\n",
+                          part_target_duration);
+  }
 
   // Put EXT-X-MAP at the end since the rest of the playlist is about the
   // segment and key info.
@@ -165,6 +180,21 @@ std::string CreatePlaylistHeader(
   return header;
 }
 
+std::string CreatePartTag(const std::string& file_name,
+                          double duration_seconds,
+                          uint64_t start_byte_offset,
+                          uint64_t size,
+                          bool is_independent) {
+  std::string part;
+  Tag tag("#EXT-X-PART", &part);
+  tag.AddFloat("DURATION", duration_seconds);
+  tag.AddQuotedString("URI", file_name);
+  tag.AddQuotedNumberPair("BYTERANGE", size, '@', start_byte_offset);
+  if (is_independent)
+    tag.AddString("INDEPENDENT", "YES");
+  part += "\n";
+  return part;
+}
 
 }  // namespace
 
@@ -193,6 +223,9 @@ class SegmentInfoEntry : public HlsEntry {
   void set_duration_seconds(double duration_seconds) {
     duration_seconds_ = duration_seconds;
   }
+  // |parts| are the EXT-X-PART tags of the segment, listed before EXTINF.
+  void set_parts(std::string parts) { parts_ = std::move(parts); }
+  void clear_parts() { parts_.clear(); }
 
  private:
   SegmentInfoEntry(const SegmentInfoEntry&) = delete;
@@ -205,6 +238,7 @@ class SegmentInfoEntry : public HlsEntry {
   const uint64_t start_byte_offset_;
   const uint64_t segment_file_size_;
   const uint64_t previous_segment_end_offset_;
+  std::string parts_;
 };
 
 SegmentInfoEntry::SegmentInfoEntry(const std::string& file_name,
@@ -224,7 +258,8 @@ SegmentInfoEntry::SegmentInfoEntry(const std::string& file_name,
       previous_segment_end_offset_(previous_segment_end_offset) {}
 
 std::string SegmentInfoEntry::ToString() {
-  std::string result = absl::StrFormat("#EXTINF:%.3f,", duration_seconds_);
+  std::string result = parts_;
+  absl::StrAppendFormat(&result, "#EXTINF:%.3f,", duration_seconds_);
 
   if (use_byte_range_) {
     absl::StrAppendFormat(&result, "\n#EXT-X-BYTERANGE:%" PRIu64,
@@ -451,6 +486,26 @@ void MediaPlaylist::AddSegment(const std::string& file_name,
                              size);
 }
 
+void MediaPlaylist::AddPart(const std::string& file_name,
+                            int64_t duration,
+                            uint64_t start_byte_offset,
+                            uint64_t size,
+                            bool is_independent) {
+  if (hls_params_.part_target_duration <= 0 || time_scale_ == 0 ||
+      stream_type_ == MediaPlaylistStreamType::kVideoIFramesOnly) {
+    return;
+  }
+  if (file_name != open_segment_file_name_) {
+    // The parts of a segment which was never added are dropped.
+    open_segment_file_name_ = file_name;
+    open_segment_parts_.clear();
+  }
+  open_segment_parts_ +=
+      CreatePartTag(file_name, static_cast<double>(duration) / time_scale_,
+                    start_byte_offset, size, is_independent);
+  next_part_start_byte_offset_ = start_byte_offset + size;
+}
+
 void MediaPlaylist::AddKeyFrame(int64_t timestamp,
                                 uint64_t start_byte_offset,
                                 uint64_t size) {
@@ -488,6 +543,15 @@ void MediaPlaylist::AddPlacementOpportunity() {
 }
 
 bool MediaPlaylist::WriteToFile(const std::filesystem::path& file_path) {
+  const std::string content = RenderPlaylist();
+  if (!File::WriteFileAtomically(file_path.string().c_str(), content)) {
+    LOG(ERROR) << "Failed to write playlist to: " << file_path.string();
+    return false;
+  }
+  return true;
+}
+
+std::string MediaPlaylist::RenderPlaylist() {
   if (!target_duration_set_) {
     SetTargetDuration(ceil(GetLongestSegmentDuration()));
   }
@@ -495,20 +559,31 @@ bool MediaPlaylist::WriteToFile(const std::filesystem::path& file_path) {
   std::string content = CreatePlaylistHeader(
       media_info_, target_duration_, hls_params_.playlist_type, stream_type_,
       media_sequence_number_, discontinuity_sequence_number_,
-      hls_params_.start_time_offset);
-
-  for (const auto& entry : entries_)
-    absl::StrAppendFormat(&content, "%s\n", entry->ToString().c_str());
+      hls_params_.start_time_offset, hls_params_.part_target_duration,
+      hls_params_.can_block_reload);
+
+  DCHECK_LE(num_rendered_entries_, entries_.size());
+  for (auto iter = std::prev(entries_.end(),
+                             entries_.size() - num_rendered_entries_);
+       iter != entries_.end(); ++iter) {
+    absl::StrAppendFormat(&rendered_entries_, "%s\n", (*iter)->ToString());
+  }
+  num_rendered_entries_ = entries_.size();
+  content += rendered_entries_;
+
+  if (!open_segment_file_name_.empty()) {
+    content += open_segment_parts_;
+    Tag tag("#EXT-X-PRELOAD-HINT", &content);
+    tag.AddString("TYPE", "PART");
+    tag.AddQuotedString("URI", open_segment_file_name_);
+    tag.AddNumber("BYTERANGE-START", next_part_start_byte_offset_);
+    content += "\n";
+  }
 
   if (hls_params_.playlist_type == HlsPlaylistType::kVod) {
     content += "#EXT-X-ENDLIST\n";
   }
-
-  if (!File::WriteFileAtomically(file_path.string().c_str(), content)) {
-    LOG(ERROR) << "Failed to write playlist to: " << file_path.string();
-    return false;
-  }
-  return true;
+  return content;
 }
 
 uint64_t MediaPlaylist::MaxBitrate() const {
@@ -652,10 +727,21 @@ void MediaPlaylist::AddSegmentInfoEntry(const std::string& segment_file_name,
     }
   }
 
-  entries_.emplace_back(new SegmentInfoEntry(
+  std::unique_ptr<SegmentInfoEntry> entry(new SegmentInfoEntry(
       segment_file_name, start_time, segment_duration_seconds, use_byte_range_,
       start_byte_offset, size, previous_segment_end_offset_));
   previous_segment_end_offset_ = start_byte_offset + size - 1;
+
+  if (!open_segment_file_name_.empty()) {
+    if (open_segment_file_name_ == segment_file_name) {
+      entry->set_parts(std::move(open_segment_parts_));
+      segments_with_parts_.push_back(entry.get());
+    }
+    open_segment_file_name_.clear();
+    open_segment_parts_.clear();
+  }
+  entries_.push_back(std::move(entry));
+  RemoveOldParts();
 }
 
 void MediaPlaylist::AdjustLastSegmentInfoEntryDuration(int64_t next_timestamp) {
@@ -674,8 +760,10 @@ void MediaPlaylist::AdjustLastSegmentInfoEntryDuration(int64_t next_timestamp) {
           next_timestamp_seconds -
           static_cast<double>(segment_info->start_time()) / time_scale_;
       // It could be negative if timestamp messed up.
-      if (segment_duration_seconds > 0)
+      if (segment_duration_seconds > 0) {
         segment_info->set_duration_seconds(segment_duration_seconds);
+        InvalidateRenderedEntries();
+      }
       longest_segment_duration_seconds_ =
           std::max(longest_segment_duration_seconds_, segment_duration_seconds);
       break;
@@ -737,10 +825,17 @@ void MediaPlaylist::SlideWindow() {
         break;
       current_buffer_depth_ -= segment_info.duration_seconds();
       RemoveOldSegment(segment_info.start_time());
+      if (!segments_with_parts_.empty() &&
+          segments_with_parts_.front() == &segment_info) {
+        segments_with_parts_.pop_front();
+      }
       media_sequence_number_++;
     }
     prev_entry_type = entry_type;
   }
+  if (last == entries_.begin())
+    return;
+  InvalidateRenderedEntries();
   entries_.erase(entries_.begin(), last);
   // Add key entries back.
   entries_.insert(entries_.begin(), std::make_move_iterator(ext_x_keys.begin()),
@@ -768,5 +863,30 @@ void MediaPlaylist::RemoveOldSegment(int64_t start_time) {
   }
 }
 
+void MediaPlaylist::RemoveOldParts() {
+  const double max_distance_seconds =
+      kPartHoldBackTargetDurations *
+      std::max(static_cast<double>(target_duration_),
+               longest_segment_duration_seconds_);
+  // Distance of the end of the oldest segment to the end of the playlist.
+  double distance_seconds = 0;
+  for (const SegmentInfoEntry* segment_info : segments_with_parts_)
+    distance_seconds += segment_info->duration_seconds();
+  while (!segments_with_parts_.empty()) {
+    SegmentInfoEntry* oldest = segments_with_parts_.front();
+    distance_seconds -= oldest->duration_seconds();
+    if (distance_seconds <= max_distance_seconds)
+      break;
+    oldest->clear_parts();
+    segments_with_parts_.pop_front();
+    InvalidateRenderedEntries();
+  }
+}
+
+void MediaPlaylist::InvalidateRenderedEntries() {
+  rendered_entries_.clear();
+  num_rendered_entries_ = 0;
+}
+
 }  // namespace hls
 }  // namespace shaka
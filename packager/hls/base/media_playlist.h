@@ -7,6 +7,7 @@
 #ifndef PACKAGER_HLS_BASE_MEDIA_PLAYLIST_H_
 #define PACKAGER_HLS_BASE_MEDIA_PLAYLIST_H_
 
+#include <deque>
 #include <filesystem>
 #include <list>
 #include <memory>
@@ -25,6 +26,8 @@ class File;
 
 namespace hls {
 
+class SegmentInfoEntry;
+
 class HlsEntry {
  public:
   enum class EntryType {
@@ -137,6 +140,21 @@ class MediaPlaylist {
                           uint64_t start_byte_offset,
                           uint64_t size);
 
+  /// Adds an LL-HLS partial segment (EXT-X-PART) of the segment being written.
+  /// Parts must be added in order, before the segment containing them is
+  /// added with AddSegment(). Ignored unless part_target_duration is set in
+  /// HlsParams.
+  /// @param file_name is the file name of the segment containing the part.
+  /// @param duration is in terms of the timescale of the media.
+  /// @param start_byte_offset is the offset of the part in the segment.
+  /// @param size is size in bytes.
+  /// @param is_independent is true if the part starts with a key frame.
+  virtual void AddPart(const std::string& file_name,
+                       int64_t duration,
+                       uint64_t start_byte_offset,
+                       uint64_t size,
+                       bool is_independent);
+
   /// Keyframes must be added in order. It is also called before the containing
   /// segment being called.
   /// @param timestamp is the timestamp of the key frame in timescale of the
@@ -181,6 +199,11 @@ class MediaPlaylist {
   /// @return true on success, false otherwise.
   virtual bool WriteToFile(const std::filesystem::path& file_path);
 
+  /// Generate the content of the playlist, as written by WriteToFile(). The
+  /// same note on the target duration applies.
+  /// @return the playlist.
+  virtual std::string RenderPlaylist();
+
   /// If bitrate is specified in MediaInfo then it will use that value.
   /// Otherwise, returns the max bitrate.
   /// @return the max bitrate (in bits per second) of this MediaPlaylist.
@@ -268,6 +291,11 @@ class MediaPlaylist {
   // happen at a later time depending on the value of
   // |preserved_segment_outside_live_window| in |hls_params_|.
   void RemoveOldSegment(int64_t start_time);
+  // Remove the parts of the segments which are more than three target
+  // durations from the end of the playlist.
+  void RemoveOldParts();
+  // Discard the rendered |entries_|, after changing existing entries.
+  void InvalidateRenderedEntries();
 
   const HlsParams& hls_params_;
   // Mainly for MasterPlaylist to use these values.
@@ -309,6 +337,20 @@ class MediaPlaylist {
   // Once a file is actually removed, it is removed from the list.
   std::list<std::string> segments_to_be_removed_;
 
+  // |entries_| rendered by RenderPlaylist(). Entries added since are appended
+  // on the next call, so that adding a part or a segment does not render the
+  // whole playlist again.
+  std::string rendered_entries_;
+  size_t num_rendered_entries_ = 0;
+
+  // LL-HLS parts of the segment being written, which is not in |entries_|
+  // yet, rendered as EXT-X-PART tags.
+  std::string open_segment_file_name_;
+  std::string open_segment_parts_;
+  uint64_t next_part_start_byte_offset_ = 0;
+  // The segments in |entries_| which still list their parts, oldest first.
+  std::deque<SegmentInfoEntry*> segments_with_parts_;
+
   // Used by kVideoIFrameOnly playlists to track the i-frames (key frames).
   struct KeyFrameInfo {
     int64_t timestamp;
@@ -0,0 +1,73 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// Benchmark for rendering media playlists with many segments.
+
+#include <string>
+
+#include <absl/strings/str_format.h>
+#include <benchmark/benchmark.h>
+
+#include <packager/hls/base/media_playlist.h>
+
+namespace shaka {
+namespace hls {
+namespace {
+
+const int32_t kTimeScale = 90000;
+const int64_t kSegmentDuration = 6 * kTimeScale;
+const uint64_t kSegmentSize = 1500000;
+
+MediaInfo GetVideoMediaInfo() {
+  MediaInfo media_info;
+  media_info.set_reference_time_scale(kTimeScale);
+  media_info.set_segment_template_url("video-$Number$.ts");
+  MediaInfo::VideoInfo* video_info = media_info.mutable_video_info();
+  video_info->set_codec("avc1.64001f");
+  video_info->set_time_scale(kTimeScale);
+  video_info->set_frame_duration(3000);
+  video_info->set_width(1280);
+  video_info->set_height(720);
+  video_info->set_pixel_width(1);
+  video_info->set_pixel_height(1);
+  return media_info;
+}
+
+// The argument is the number of segments.
+void BM_RenderMediaPlaylist(benchmark::State& state) {
+  HlsParams hls_params;
+  hls_params.playlist_type = HlsPlaylistType::kVod;
+  hls_params.is_independent_segments = false;
+  hls_params.create_session_keys = false;
+  MediaPlaylist playlist(hls_params, "video.m3u8", "video", "group");
+  if (!playlist.SetMediaInfo(GetVideoMediaInfo())) {
+    state.SkipWithError("Failed to set the MediaInfo.");
+    return;
+  }
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    // Alternate the durations slightly, as encoders do.
+    const int64_t duration = kSegmentDuration + (i % 2 ? 3000 : -3000);
+    playlist.AddSegment(absl::StrFormat("video-%d.ts", i + 1),
+                        i * kSegmentDuration, duration, 0,
+                        kSegmentSize + i % 1000);
+  }
+
+  size_t playlist_size = 0;
+  for (auto _ : state) {
+    const std::string content = playlist.RenderPlaylist();
+    playlist_size = content.size();
+    benchmark::DoNotOptimize(content.data());
+  }
+  state.SetBytesProcessed(state.iterations() * playlist_size);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// About 1.5 hours, 17 hours and a week of content.
+BENCHMARK(BM_RenderMediaPlaylist)->Arg(1000)->Arg(10000)->Arg(100000);
+
+}  // namespace
+}  // namespace hls
+}  // namespace shaka
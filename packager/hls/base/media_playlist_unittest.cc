@@ -908,6 +908,157 @@ TEST_F(LiveMediaPlaylistTest, TimeShiftedWithEncryptionInfoShifted) {
   ASSERT_FILE_STREQ(kMemoryFilePath, kExpectedOutput);
 }
 
+class LowLatencyMediaPlaylistTest : public LiveMediaPlaylistTest {
+ protected:
+  void SetUp() override {
+    LiveMediaPlaylistTest::SetUp();
+    mutable_hls_params()->part_target_duration = 0.5;
+    ASSERT_TRUE(media_playlist_->SetMediaInfo(valid_video_media_info_));
+  }
+
+  // Adds |num_parts| parts of 0.5 seconds and |kPartSize| bytes, the first
+  // one independent, then the segment itself if |complete|.
+  void AddSegmentWithParts(const std::string& file_name,
+                           int64_t start_time,
+                           int num_parts,
+                           bool complete) {
+    for (int i = 0; i < num_parts; ++i) {
+      media_playlist_->AddPart(file_name, kTimeScale / 2, i * kPartSize,
+                               kPartSize, i == 0);
+    }
+    if (complete) {
+      media_playlist_->AddSegment(file_name, start_time,
+                                  num_parts * kTimeScale / 2, kZeroByteOffset,
+                                  num_parts * kPartSize);
+    }
+  }
+
+  const uint64_t kPartSize = 1000;
+};
+
+TEST_F(LowLatencyMediaPlaylistTest, PartsAndPreloadHint) {
+  AddSegmentWithParts("file1.m4s", 0, 4, true);
+  AddSegmentWithParts("file2.m4s", 2 * kTimeScale, 2, false);
+
+  const char kExpectedOutput[] =
+      "#EXTM3U\n"
+      "#EXT-X-VERSION:6\n"
+      "## Generated with https://github.com/shaka-project/shaka-packager "
+      "version test\n"
+      "#EXT-X-TARGETDURATION:2\n"
+      "#EXT-X-SERVER-CONTROL:PART-HOLD-BACK=1.500\n"
+      "#EXT-X-PART-INF:PART-TARGET=0.500\n"
+      "#EXT-X-PART:DURATION=0.500,URI=\"file1.m4s\",BYTERANGE=\"1000@0\","
+      "INDEPENDENT=YES\n"
+      "#EXT-X-PART:DURATION=0.500,URI=\"file1.m4s\",BYTERANGE=\"1000@1000\"\n"
+      "#EXT-X-PART:DURATION=0.500,URI=\"file1.m4s\",BYTERANGE=\"1000@2000\"\n"
+      "#EXT-X-PART:DURATION=0.500,URI=\"file1.m4s\",BYTERANGE=\"1000@3000\"\n"
+      "#EXTINF:2.000,\n"
+      "file1.m4s\n"
+      "#EXT-X-PART:DURATION=0.500,URI=\"file2.m4s\",BYTERANGE=\"1000@0\","
+      "INDEPENDENT=YES\n"
+      "#EXT-X-PART:DURATION=0.500,URI=\"file2.m4s\",BYTERANGE=\"1000@1000\"\n"
+      "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"file2.m4s\",BYTERANGE-START=2000\n";
+
+  ASSERT_EQ(kExpectedOutput, media_playlist_->RenderPlaylist());
+}
+
+// Verify that blocking playlist reloads are advertised only if the origin
+// supports them.
+TEST_F(LowLatencyMediaPlaylistTest, CanBlockReload) {
+  mutable_hls_params()->can_block_reload = true;
+  media_playlist_->SetTargetDuration(1);
+  AddSegmentWithParts("file1.m4s", 0, 1, false);
+
+  const char kExpectedOutput[] =
+      "#EXTM3U\n"
+      "#EXT-X-VERSION:6\n"
+      "## Generated with https://github.com/shaka-project/shaka-packager "
+      "version test\n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=1.500\n"
+      "#EXT-X-PART-INF:PART-TARGET=0.500\n"
+      "#EXT-X-PART:DURATION=0.500,URI=\"file1.m4s\",BYTERANGE=\"1000@0\","
+      "INDEPENDENT=YES\n"
+      "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"file1.m4s\",BYTERANGE-START=1000\n";
+
+  ASSERT_EQ(kExpectedOutput, media_playlist_->RenderPlaylist());
+}
+
+// Verify that the playlist is the same whether it is rendered after every
+// update, i.e. incrementally, or only at the end.
+TEST_F(LowLatencyMediaPlaylistTest, IncrementalRendering) {
+  MediaPlaylist reference_playlist(hls_params_, default_file_name_,
+                                   default_name_, default_group_id_);
+  ASSERT_TRUE(reference_playlist.SetMediaInfo(valid_video_media_info_));
+  // As SimpleHlsNotifier does, so that the first rendering does not fix it.
+  media_playlist_->SetTargetDuration(2);
+  reference_playlist.SetTargetDuration(2);
+
+  for (int segment = 0; segment < 6; ++segment) {
+    const std::string file_name = absl::StrFormat("file%d.m4s", segment);
+    for (int i = 0; i < 4; ++i) {
+      media_playlist_->AddPart(file_name, kTimeScale / 2, i * kPartSize,
+                               kPartSize, i == 0);
+      reference_playlist.AddPart(file_name, kTimeScale / 2, i * kPartSize,
+                                 kPartSize, i == 0);
+      media_playlist_->RenderPlaylist();
+    }
+    media_playlist_->AddSegment(file_name, segment * 2 * kTimeScale,
+                                2 * kTimeScale, kZeroByteOffset,
+                                4 * kPartSize);
+    reference_playlist.AddSegment(file_name, segment * 2 * kTimeScale,
+                                  2 * kTimeScale, kZeroByteOffset,
+                                  4 * kPartSize);
+    media_playlist_->RenderPlaylist();
+  }
+  EXPECT_EQ(reference_playlist.RenderPlaylist(),
+            media_playlist_->RenderPlaylist());
+}
+
+// Verify that the parts are removed once they are more than three target
+// durations from the end of the playlist.
+TEST_F(LowLatencyMediaPlaylistTest, OldPartsRemoved) {
+  media_playlist_->SetTargetDuration(1);
+  for (int segment = 0; segment < 5; ++segment) {
+    AddSegmentWithParts(absl::StrFormat("file%d.m4s", segment),
+                        segment * kTimeScale, 2, true);
+  }
+
+  const char kExpectedOutput[] =
+      "#EXTM3U\n"
+      "#EXT-X-VERSION:6\n"
+      "## Generated with https://github.com/shaka-project/shaka-packager "
+      "version test\n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXT-X-SERVER-CONTROL:PART-HOLD-BACK=1.500\n"
+      "#EXT-X-PART-INF:PART-TARGET=0.500\n"
+      "#EXTINF:1.000,\n"
+      "file0.m4s\n"
+      "#EXT-X-PART:DURATION=0.500,URI=\"file1.m4s\",BYTERANGE=\"1000@0\","
+      "INDEPENDENT=YES\n"
+      "#EXT-X-PART:DURATION=0.500,URI=\"file1.m4s\",BYTERANGE=\"1000@1000\"\n"
+      "#EXTINF:1.000,\n"
+      "file1.m4s\n"
+      "#EXT-X-PART:DURATION=0.500,URI=\"file2.m4s\",BYTERANGE=\"1000@0\","
+      "INDEPENDENT=YES\n"
+      "#EXT-X-PART:DURATION=0.500,URI=\"file2.m4s\",BYTERANGE=\"1000@1000\"\n"
+      "#EXTINF:1.000,\n"
+      "file2.m4s\n"
+      "#EXT-X-PART:DURATION=0.500,URI=\"file3.m4s\",BYTERANGE=\"1000@0\","
+      "INDEPENDENT=YES\n"
+      "#EXT-X-PART:DURATION=0.500,URI=\"file3.m4s\",BYTERANGE=\"1000@1000\"\n"
+      "#EXTINF:1.000,\n"
+      "file3.m4s\n"
+      "#EXT-X-PART:DURATION=0.500,URI=\"file4.m4s\",BYTERANGE=\"1000@0\","
+      "INDEPENDENT=YES\n"
+      "#EXT-X-PART:DURATION=0.500,URI=\"file4.m4s\",BYTERANGE=\"1000@1000\"\n"
+      "#EXTINF:1.000,\n"
+      "file4.m4s\n";
+
+  ASSERT_EQ(kExpectedOutput, media_playlist_->RenderPlaylist());
+}
+
 class EventMediaPlaylistTest : public MediaPlaylistMultiSegmentTest {
  protected:
   EventMediaPlaylistTest()
@@ -30,6 +30,12 @@ class MockMediaPlaylist : public MediaPlaylist {
                     int64_t duration,
                     uint64_t start_byte_offset,
                     uint64_t size));
+  MOCK_METHOD5(AddPart,
+               void(const std::string& file_name,
+                    int64_t duration,
+                    uint64_t start_byte_offset,
+                    uint64_t size,
+                    bool is_independent));
   MOCK_METHOD3(AddKeyFrame,
                void(int64_t timestamp,
                     uint64_t start_byte_offset,
@@ -43,6 +49,7 @@ class MockMediaPlaylist : public MediaPlaylist {
                     const std::string& key_format_versions));
   MOCK_METHOD0(AddPlacementOpportunity, void());
   MOCK_METHOD1(WriteToFile, bool(const std::filesystem::path& file_path));
+  MOCK_METHOD0(RenderPlaylist, std::string());
   MOCK_CONST_METHOD0(MaxBitrate, uint64_t());
   MOCK_CONST_METHOD0(AvgBitrate, uint64_t());
   MOCK_CONST_METHOD0(GetLongestSegmentDuration, double());
@@ -9,6 +9,7 @@
 #include <cmath>
 #include <filesystem>
 #include <optional>
+#include <utility>
 
 #include <absl/flags/flag.h>
 #include <absl/log/check.h>
@@ -16,6 +17,7 @@
 #include <absl/strings/escaping.h>
 #include <absl/strings/numbers.h>
 
+#include <packager/file.h>
 #include <packager/file/file_util.h>
 #include <packager/media/base/protection_system_ids.h>
 #include <packager/media/base/protection_system_specific_info.h>
@@ -286,9 +288,23 @@ SimpleHlsNotifier::SimpleHlsNotifier(const HlsParams& hls_params)
       master_playlist_path.filename(), default_audio_langauge,
       default_text_language, hls_params.is_independent_segments,
       hls_params.create_session_keys));
+
+  if (hls_params.playlist_type == HlsPlaylistType::kLive ||
+      hls_params.playlist_type == HlsPlaylistType::kEvent) {
+    writer_thread_ =
+        std::thread(&SimpleHlsNotifier::WritePlaylistsInBackground, this);
+  }
 }
 
-SimpleHlsNotifier::~SimpleHlsNotifier() {}
+SimpleHlsNotifier::~SimpleHlsNotifier() {
+  if (writer_thread_.joinable()) {
+    {
+      absl::MutexLock lock(&lock_);
+      stop_writer_ = true;
+    }
+    writer_thread_.join();
+  }
+}
 
 bool SimpleHlsNotifier::Init() {
   return true;
@@ -379,25 +395,52 @@ bool SimpleHlsNotifier::NotifyNewSegment(uint32_t stream_id,
     target_duration_updated = true;
   }
 
-  // Update the playlists when there is new segments in live mode.
+  // Update the playlists when there is new segments in live mode. They are
+  // written by the writer thread.
   if (hls_params().playlist_type == HlsPlaylistType::kLive ||
       hls_params().playlist_type == HlsPlaylistType::kEvent) {
     // Update all playlists if target duration is updated.
     if (target_duration_updated) {
       for (MediaPlaylist* playlist : media_playlists_) {
         playlist->SetTargetDuration(target_duration_);
-        if (!WriteMediaPlaylist(master_playlist_dir_, playlist))
-          return false;
+        playlists_to_write_.insert(playlist);
       }
     } else {
-      if (!WriteMediaPlaylist(master_playlist_dir_, media_playlist.get()))
-        return false;
-    }
-    if (!master_playlist_->WriteMasterPlaylist(
-            hls_params().base_url, master_playlist_dir_, media_playlists_)) {
-      LOG(ERROR) << "Failed to write master playlist.";
-      return false;
+      playlists_to_write_.insert(media_playlist.get());
     }
+    // The bitrates may have changed.
+    master_playlist_to_write_ = true;
+    // Report the failure of a previous write.
+    return !playlist_write_failed_;
+  }
+  return true;
+}
+
+bool SimpleHlsNotifier::NotifyNewPart(uint32_t stream_id,
+                                      const std::string& segment_name,
+                                      int64_t duration,
+                                      uint64_t start_byte_offset,
+                                      uint64_t size,
+                                      bool is_independent) {
+  absl::MutexLock lock(&lock_);
+  auto stream_iterator = stream_map_.find(stream_id);
+  if (stream_iterator == stream_map_.end()) {
+    LOG(ERROR) << "Cannot find stream with ID: " << stream_id;
+    return false;
+  }
+  auto& media_playlist = stream_iterator->second->media_playlist;
+  const std::string& segment_url =
+      GenerateSegmentUrl(segment_name, hls_params().base_url,
+                         master_playlist_dir_, media_playlist->file_name());
+  media_playlist->AddPart(segment_url, duration, start_byte_offset, size,
+                          is_independent);
+
+  // Parts are only listed in live mode. Unlike for segments, only this
+  // playlist is updated; the target duration and the bitrates do not change.
+  if (hls_params().playlist_type == HlsPlaylistType::kLive ||
+      hls_params().playlist_type == HlsPlaylistType::kEvent) {
+    playlists_to_write_.insert(media_playlist.get());
+    return !playlist_write_failed_;
   }
   return true;
 }
@@ -509,6 +552,12 @@ bool SimpleHlsNotifier::NotifyEncryptionUpdate(
 
 bool SimpleHlsNotifier::Flush() {
   absl::MutexLock lock(&lock_);
+  // All the playlists are written below. Wait for an ongoing background write
+  // to complete so it does not overwrite them with older content.
+  playlists_to_write_.clear();
+  master_playlist_to_write_ = false;
+  lock_.Await(absl::Condition(this, &SimpleHlsNotifier::IsWriterIdle));
+
   for (MediaPlaylist* playlist : media_playlists_) {
     playlist->SetTargetDuration(target_duration_);
     if (!WriteMediaPlaylist(master_playlist_dir_, playlist))
@@ -519,7 +568,69 @@ bool SimpleHlsNotifier::Flush() {
     LOG(ERROR) << "Failed to write master playlist.";
     return false;
   }
-  return true;
+  // Report the failure of a background write.
+  return !playlist_write_failed_;
+}
+
+void SimpleHlsNotifier::WritePlaylistsInBackground() {
+  while (true) {
+    std::vector<std::pair<MediaPlaylist*, std::string>> playlists;
+    std::optional<std::string> master_playlist;
+    {
+      absl::MutexLock lock(
+          &lock_, absl::Condition(this, &SimpleHlsNotifier::HasPendingWrites));
+      if (playlists_to_write_.empty() && !master_playlist_to_write_)
+        return;  // Stopped.
+
+      // Rendering reads the playlists, so it is done under the lock, once
+      // for all the updates made since the previous write.
+      for (MediaPlaylist* playlist : media_playlists_) {
+        if (playlists_to_write_.count(playlist) > 0)
+          playlists.emplace_back(playlist, playlist->RenderPlaylist());
+      }
+      playlists_to_write_.clear();
+      if (master_playlist_to_write_) {
+        master_playlist = master_playlist_->RenderMasterPlaylist(
+            hls_params().base_url, media_playlists_);
+        master_playlist_to_write_ = false;
+      }
+      writing_playlists_ = true;
+    }
+
+    bool success = true;
+    for (const auto& playlist : playlists) {
+      const auto file_path = std::filesystem::u8path(master_playlist_dir_) /
+                             playlist.first->file_name();
+      if (!File::WriteFileAtomically(file_path.string().c_str(),
+                                     playlist.second)) {
+        LOG(ERROR) << "Failed to write playlist " << file_path.string();
+        success = false;
+      }
+    }
+    // The media playlists are written first, so the master playlist never
+    // refers to a missing media playlist.
+    // It is only written if it changed since the last write, here or in
+    // Flush().
+    if (master_playlist && !master_playlist_->WriteRenderedMasterPlaylist(
+                               master_playlist_dir_, *master_playlist)) {
+      success = false;
+    }
+
+    absl::MutexLock lock(&lock_);
+    writing_playlists_ = false;
+    if (!success)
+      playlist_write_failed_ = true;
+  }
+}
+
+bool SimpleHlsNotifier::HasPendingWrites() const {
+  return stop_writer_ || !playlists_to_write_.empty() ||
+         master_playlist_to_write_;
+}
+
+bool SimpleHlsNotifier::IsWriterIdle() const {
+  return !writing_playlists_ && playlists_to_write_.empty() &&
+         !master_playlist_to_write_;
 }
 
 }  // namespace hls
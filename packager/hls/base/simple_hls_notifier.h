@@ -10,9 +10,12 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include <absl/base/thread_annotations.h>
 #include <absl/synchronization/mutex.h>
 
 #include <packager/hls/base/hls_notifier.h>
@@ -36,6 +39,9 @@ class MediaPlaylistFactory {
 };
 
 /// This is thread safe.
+/// In live and event modes, the playlists are written by a background thread.
+/// Updates made while a write is in progress are coalesced into the next one,
+/// and the master playlist is only written when its content changes.
 class SimpleHlsNotifier : public HlsNotifier {
  public:
   /// @param hls_params contains parameters for setting up the notifier.
@@ -58,6 +64,12 @@ class SimpleHlsNotifier : public HlsNotifier {
                         int64_t duration,
                         uint64_t start_byte_offset,
                         uint64_t size) override;
+  bool NotifyNewPart(uint32_t stream_id,
+                     const std::string& segment_name,
+                     int64_t duration,
+                     uint64_t start_byte_offset,
+                     uint64_t size,
+                     bool is_independent) override;
   bool NotifyKeyFrame(uint32_t stream_id,
                       int64_t timestamp,
                       uint64_t start_byte_offset,
@@ -80,6 +92,12 @@ class SimpleHlsNotifier : public HlsNotifier {
     MediaPlaylist::EncryptionMethod encryption_method;
   };
 
+  // Runs on |writer_thread_|. Renders the playlists marked for writing and
+  // writes them without holding |lock_|, until the notifier is destroyed.
+  void WritePlaylistsInBackground();
+  bool HasPendingWrites() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  bool IsWriterIdle() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   std::string master_playlist_dir_;
   int32_t target_duration_ = 0;
 
@@ -94,6 +112,17 @@ class SimpleHlsNotifier : public HlsNotifier {
 
   absl::Mutex lock_;
 
+  // Playlists to be written by |writer_thread_|.
+  std::set<MediaPlaylist*> playlists_to_write_ ABSL_GUARDED_BY(lock_);
+  bool master_playlist_to_write_ ABSL_GUARDED_BY(lock_) = false;
+  bool writing_playlists_ ABSL_GUARDED_BY(lock_) = false;
+  bool playlist_write_failed_ ABSL_GUARDED_BY(lock_) = false;
+  bool stop_writer_ ABSL_GUARDED_BY(lock_) = false;
+  // Writes the rendered playlists without holding |lock_|, while
+  // |writing_playlists_| is set. That includes |master_playlist_|, which keeps
+  // the last written master playlist for both the writer and Flush().
+  std::thread writer_thread_;
+
   DISALLOW_COPY_AND_ASSIGN(SimpleHlsNotifier);
 };
 
@@ -15,6 +15,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <packager/file.h>
+#include <packager/file/file_util.h>
 #include <packager/flag_saver.h>
 #include <packager/hls/base/mock_media_playlist.h>
 #include <packager/media/base/protection_system_ids.h>
@@ -27,6 +29,7 @@ namespace shaka {
 namespace hls {
 
 using ::testing::_;
+using ::testing::AnyNumber;
 using ::testing::DoAll;
 using ::testing::ElementsAre;
 using ::testing::Eq;
@@ -60,6 +63,9 @@ class MockMasterPlaylist : public MasterPlaylist {
                bool(const std::string& prefix,
                     const std::string& output_dir,
                     const std::list<MediaPlaylist*>& playlists));
+  MOCK_METHOD2(RenderMasterPlaylist,
+               std::string(const std::string& base_url,
+                           const std::list<MediaPlaylist*>& playlists));
 };
 
 class MockMediaPlaylistFactory : public MediaPlaylistFactory {
@@ -82,6 +88,7 @@ class MockMediaPlaylistFactory : public MediaPlaylistFactory {
 const double kTestTimeShiftBufferDepth = 1800.0;
 const char kTestPrefix[] = "http://testprefix.com/";
 const char kAnyOutputDir[] = "anything";
+const char kLiveOutputDir[] = "memory://live";
 
 const int64_t kAnyStartTime = 10;
 const int64_t kAnyDuration = 1000;
@@ -125,6 +132,25 @@ class SimpleHlsNotifierTest : public ::testing::Test {
     return notifier.stream_map_.size();
   }
 
+  // Waits for the background writer to write the pending playlists.
+  void WaitForPlaylistWrites(SimpleHlsNotifier* notifier) {
+    absl::MutexLock lock(&notifier->lock_);
+    notifier->lock_.Await(
+        absl::Condition(notifier, &SimpleHlsNotifier::IsWriterIdle));
+  }
+
+  bool PlaylistWriteFailed(SimpleHlsNotifier* notifier) {
+    absl::MutexLock lock(&notifier->lock_);
+    return notifier->playlist_write_failed_;
+  }
+
+  std::string ReadLivePlaylist(const std::string& file_name) {
+    std::string content;
+    File::ReadFileToString(
+        (std::string(kLiveOutputDir) + "/" + file_name).c_str(), &content);
+    return content;
+  }
+
   uint32_t SetupStream(const std::string& protection_scheme,
                        MockMediaPlaylist* mock_media_playlist,
                        SimpleHlsNotifier* notifier) {
@@ -272,6 +298,25 @@ TEST_F(SimpleHlsNotifierTest, NotifyKeyFrame) {
       notifier.NotifyKeyFrame(stream_id, kTimestamp, kStartByteOffset, kSize));
 }
 
+TEST_F(SimpleHlsNotifierTest, NotifyNewPart) {
+  // Pointer released by SimpleHlsNotifier.
+  MockMediaPlaylist* mock_media_playlist =
+      new MockMediaPlaylist("playlist.m3u8", "", "");
+  SimpleHlsNotifier notifier(hls_params_);
+  const uint32_t stream_id =
+      SetupStream(kCencProtectionScheme, mock_media_playlist, &notifier);
+
+  const int64_t kDuration = 45000;
+  const uint64_t kStartByteOffset = 888;
+  const uint64_t kSize = 555;
+  const std::string segment_name = "segmentname";
+  EXPECT_CALL(*mock_media_playlist,
+              AddPart(StrEq(kTestPrefix + segment_name), kDuration,
+                      kStartByteOffset, kSize, true));
+  EXPECT_TRUE(notifier.NotifyNewPart(stream_id, segment_name, kDuration,
+                                     kStartByteOffset, kSize, true));
+}
+
 TEST_F(SimpleHlsNotifierTest, NotifyNewSegmentWithoutStreamsRegistered) {
   SimpleHlsNotifier notifier(hls_params_);
   EXPECT_TRUE(notifier.Init());
@@ -521,6 +566,9 @@ class LiveOrEventSimpleHlsNotifierTest
  protected:
   LiveOrEventSimpleHlsNotifierTest() : SimpleHlsNotifierTest(GetParam()) {
     expected_playlist_type_ = GetParam();
+    hls_params_.playlist_type = GetParam();
+    hls_params_.master_playlist_output =
+        std::string(kLiveOutputDir) + "/" + kMasterPlaylistName;
   }
 
   HlsPlaylistType expected_playlist_type_;
@@ -553,17 +601,14 @@ TEST_P(LiveOrEventSimpleHlsNotifierTest, NotifyNewSegment) {
   EXPECT_CALL(*mock_media_playlist, GetLongestSegmentDuration())
       .WillOnce(Return(kLongestSegmentDuration));
 
-  EXPECT_CALL(*mock_master_playlist,
-              WriteMasterPlaylist(StrEq(kTestPrefix), StrEq(kAnyOutputDir), _))
-      .WillOnce(Return(true));
   EXPECT_CALL(*mock_media_playlist, SetTargetDuration(kTargetDuration))
       .Times(1);
-  EXPECT_CALL(*mock_media_playlist,
-              WriteToFile(Eq(
-                  (std::filesystem::u8path(kAnyOutputDir) / "playlist.m3u8"))))
-      .WillOnce(Return(true));
+  EXPECT_CALL(*mock_media_playlist, RenderPlaylist())
+      .WillOnce(Return("media playlist"));
+  EXPECT_CALL(*mock_master_playlist,
+              RenderMasterPlaylist(StrEq(kTestPrefix), _))
+      .WillOnce(Return("master playlist"));
 
-  hls_params_.playlist_type = GetParam();
   SimpleHlsNotifier notifier(hls_params_);
   InjectMasterPlaylist(std::move(mock_master_playlist), &notifier);
   InjectMediaPlaylistFactory(std::move(factory), &notifier);
@@ -575,6 +620,9 @@ TEST_P(LiveOrEventSimpleHlsNotifierTest, NotifyNewSegment) {
 
   EXPECT_TRUE(notifier.NotifyNewSegment(stream_id, segment_name, kStartTime,
                                         kDuration, 0, kSize));
+  WaitForPlaylistWrites(&notifier);
+  EXPECT_EQ("media playlist", ReadLivePlaylist("playlist.m3u8"));
+  EXPECT_EQ("master playlist", ReadLivePlaylist(kMasterPlaylistName));
 }
 
 TEST_P(LiveOrEventSimpleHlsNotifierTest, NotifyNewSegmentsWithMultipleStreams) {
@@ -602,7 +650,6 @@ TEST_P(LiveOrEventSimpleHlsNotifierTest, NotifyNewSegmentsWithMultipleStreams) {
       .WillOnce(Return(mock_media_playlist2));
   EXPECT_CALL(*mock_media_playlist2, SetMediaInfo(_)).WillOnce(Return(true));
 
-  hls_params_.playlist_type = GetParam();
   SimpleHlsNotifier notifier(hls_params_);
   MockMasterPlaylist* mock_master_playlist_ptr = mock_master_playlist.get();
   InjectMasterPlaylist(std::move(mock_master_playlist), &notifier);
@@ -626,36 +673,97 @@ TEST_P(LiveOrEventSimpleHlsNotifierTest, NotifyNewSegmentsWithMultipleStreams) {
   // SetTargetDuration and update all playlists as target duration is updated.
   EXPECT_CALL(*mock_media_playlist1, SetTargetDuration(kTargetDuration))
       .Times(1);
-  EXPECT_CALL(*mock_media_playlist1,
-              WriteToFile(Eq(
-                  (std::filesystem::u8path(kAnyOutputDir) / "playlist1.m3u8"))))
-      .WillOnce(Return(true));
   EXPECT_CALL(*mock_media_playlist2, SetTargetDuration(kTargetDuration))
       .Times(1);
-  EXPECT_CALL(*mock_media_playlist2,
-              WriteToFile(Eq(
-                  (std::filesystem::u8path(kAnyOutputDir) / "playlist2.m3u8"))))
-      .WillOnce(Return(true));
+  EXPECT_CALL(*mock_media_playlist1, RenderPlaylist())
+      .WillOnce(Return("playlist1 v1"));
+  EXPECT_CALL(*mock_media_playlist2, RenderPlaylist())
+      .WillOnce(Return("playlist2 v1"));
   EXPECT_CALL(
       *mock_master_playlist_ptr,
-      WriteMasterPlaylist(
-          _, _, ElementsAre(mock_media_playlist1, mock_media_playlist2)))
-      .WillOnce(Return(true));
+      RenderMasterPlaylist(
+          _, ElementsAre(mock_media_playlist1, mock_media_playlist2)))
+      .WillOnce(Return("master playlist"));
   EXPECT_TRUE(notifier.NotifyNewSegment(stream_id1, "segment_name", kStartTime,
                                         kDuration, 0, kSize));
+  WaitForPlaylistWrites(&notifier);
+  EXPECT_EQ("playlist1 v1", ReadLivePlaylist("playlist1.m3u8"));
+  EXPECT_EQ("playlist2 v1", ReadLivePlaylist("playlist2.m3u8"));
+  EXPECT_EQ("master playlist", ReadLivePlaylist(kMasterPlaylistName));
+
+  const std::string master_playlist_path =
+      std::string(kLiveOutputDir) + "/" + kMasterPlaylistName;
+  ASSERT_TRUE(File::Delete(master_playlist_path.c_str()));
 
   EXPECT_CALL(*mock_media_playlist2, AddSegment(_, _, _, _, _)).Times(1);
   EXPECT_CALL(*mock_media_playlist2, GetLongestSegmentDuration())
       .WillOnce(Return(kLongestSegmentDuration));
   // Not updating other playlists as target duration does not change.
-  EXPECT_CALL(*mock_media_playlist2,
-              WriteToFile(Eq(
-                  (std::filesystem::u8path(kAnyOutputDir) / "playlist2.m3u8"))))
-      .WillOnce(Return(true));
-  EXPECT_CALL(*mock_master_playlist_ptr, WriteMasterPlaylist(_, _, _))
-      .WillOnce(Return(true));
+  EXPECT_CALL(*mock_media_playlist2, RenderPlaylist())
+      .WillOnce(Return("playlist2 v2"));
+  EXPECT_CALL(*mock_master_playlist_ptr, RenderMasterPlaylist(_, _))
+      .WillOnce(Return("master playlist"));
   EXPECT_TRUE(notifier.NotifyNewSegment(stream_id2, "segment_name", kStartTime,
                                         kDuration, 0, kSize));
+  WaitForPlaylistWrites(&notifier);
+  EXPECT_EQ("playlist2 v2", ReadLivePlaylist("playlist2.m3u8"));
+  // The master playlist is not written again as it has not changed.
+  EXPECT_EQ("", ReadLivePlaylist(kMasterPlaylistName));
+}
+
+TEST_P(LiveOrEventSimpleHlsNotifierTest, FailedBackgroundWrite) {
+  // The playlists cannot be written to a directory which is a file.
+  std::string file_name;
+  ASSERT_TRUE(TempFilePath("", &file_name));
+  ASSERT_TRUE(File::WriteStringToFile(file_name.c_str(), ""));
+  hls_params_.master_playlist_output = file_name + "/" + kMasterPlaylistName;
+
+  std::unique_ptr<MockMasterPlaylist> mock_master_playlist(
+      new MockMasterPlaylist());
+  MockMasterPlaylist* mock_master_playlist_ptr = mock_master_playlist.get();
+  std::unique_ptr<MockMediaPlaylistFactory> factory(
+      new MockMediaPlaylistFactory());
+
+  // Pointer released by SimpleHlsNotifier.
+  MockMediaPlaylist* mock_media_playlist =
+      new MockMediaPlaylist("playlist.m3u8", "", "");
+
+  EXPECT_CALL(*mock_media_playlist, SetMediaInfo(_)).WillOnce(Return(true));
+  EXPECT_CALL(*factory, CreateMock(_, _, _, _))
+      .WillOnce(Return(mock_media_playlist));
+  EXPECT_CALL(*mock_media_playlist, AddSegment(_, _, _, _, _)).Times(2);
+  EXPECT_CALL(*mock_media_playlist, GetLongestSegmentDuration())
+      .WillRepeatedly(Return(11.3));
+  EXPECT_CALL(*mock_media_playlist, SetTargetDuration(_)).Times(AnyNumber());
+  EXPECT_CALL(*mock_media_playlist, RenderPlaylist())
+      .WillRepeatedly(Return("media playlist"));
+  EXPECT_CALL(*mock_master_playlist_ptr, RenderMasterPlaylist(_, _))
+      .WillRepeatedly(Return("master playlist"));
+
+  SimpleHlsNotifier notifier(hls_params_);
+  InjectMasterPlaylist(std::move(mock_master_playlist), &notifier);
+  InjectMediaPlaylistFactory(std::move(factory), &notifier);
+  EXPECT_TRUE(notifier.Init());
+  MediaInfo media_info;
+  uint32_t stream_id;
+  EXPECT_TRUE(notifier.NotifyNewStream(media_info, "playlist.m3u8", "name",
+                                       "groupid", &stream_id));
+
+  EXPECT_TRUE(notifier.NotifyNewSegment(stream_id, "segment1", kAnyStartTime,
+                                        kAnyDuration, 0, kAnySize));
+  WaitForPlaylistWrites(&notifier);
+  EXPECT_TRUE(PlaylistWriteFailed(&notifier));
+
+  // The failure is reported by the next calls.
+  EXPECT_FALSE(notifier.NotifyNewSegment(stream_id, "segment2",
+                                         kAnyStartTime + kAnyDuration,
+                                         kAnyDuration, 0, kAnySize));
+  EXPECT_CALL(*mock_media_playlist, WriteToFile(_)).WillOnce(Return(true));
+  EXPECT_CALL(*mock_master_playlist_ptr, WriteMasterPlaylist(_, _, _))
+      .WillOnce(Return(true));
+  EXPECT_FALSE(notifier.Flush());
+
+  File::Delete(file_name.c_str());
 }
 
 INSTANTIATE_TEST_CASE_P(PlaylistTypes,
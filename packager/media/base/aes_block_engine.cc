@@ -0,0 +1,307 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/base/aes_block_engine.h>
+
+#include <cstring>
+
+#include <absl/log/check.h>
+#include <absl/log/log.h>
+
+#include <packager/macros/crypto.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define AES_ENGINE_USE_X86_INTRINSICS 1
+#include <immintrin.h>
+#endif
+
+namespace shaka {
+namespace media {
+namespace {
+
+// Number of blocks kept in flight by the AES-NI path. AESENC has a latency of
+// several cycles but a throughput of one or two per cycle, so independent
+// blocks have to be interleaved to keep the pipeline busy.
+const size_t kAesNiLanes = 8;
+
+const uint8_t kSbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b,
+    0xfe, 0xd7, 0xab, 0x76, 0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0,
+    0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0, 0xb7, 0xfd, 0x93, 0x26,
+    0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2,
+    0xeb, 0x27, 0xb2, 0x75, 0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0,
+    0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84, 0x53, 0xd1, 0x00, 0xed,
+    0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f,
+    0x50, 0x3c, 0x9f, 0xa8, 0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5,
+    0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2, 0xcd, 0x0c, 0x13, 0xec,
+    0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14,
+    0xde, 0x5e, 0x0b, 0xdb, 0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c,
+    0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79, 0xe7, 0xc8, 0x37, 0x6d,
+    0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f,
+    0x4b, 0xbd, 0x8b, 0x8a, 0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e,
+    0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e, 0xe1, 0xf8, 0x98, 0x11,
+    0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f,
+    0xb0, 0x54, 0xbb, 0x16};
+
+// Expand |key| into |num_rounds| + 1 round keys as described in FIPS-197
+// section 5.2. The round keys are stored as consecutive bytes, which is the
+// layout AESENC expects when loaded as a 128-bit little-endian value.
+void ExpandEncryptionKey(const std::vector<uint8_t>& key,
+                         int num_rounds,
+                         uint8_t* round_keys) {
+  const size_t key_words = key.size() / 4;
+  const size_t total_words = 4 * (num_rounds + 1);
+  memcpy(round_keys, key.data(), key.size());
+
+  uint8_t rcon = 0x01;
+  for (size_t i = key_words; i < total_words; ++i) {
+    uint8_t temp[4];
+    memcpy(temp, round_keys + 4 * (i - 1), 4);
+    if (i % key_words == 0) {
+      // RotWord, SubWord and Rcon.
+      const uint8_t first = temp[0];
+      temp[0] = kSbox[temp[1]] ^ rcon;
+      temp[1] = kSbox[temp[2]];
+      temp[2] = kSbox[temp[3]];
+      temp[3] = kSbox[first];
+      rcon = static_cast<uint8_t>((rcon << 1) ^ ((rcon & 0x80) ? 0x1b : 0));
+    } else if (key_words > 6 && i % key_words == 4) {
+      for (uint8_t& byte : temp)
+        byte = kSbox[byte];
+    }
+    for (size_t j = 0; j < 4; ++j)
+      round_keys[4 * i + j] = round_keys[4 * (i - key_words) + j] ^ temp[j];
+  }
+}
+
+// Written out byte by byte so that compilers recognize the pattern and emit a
+// single byte-swapping load/store.
+uint64_t LoadBigEndian64(const uint8_t* data) {
+  return (static_cast<uint64_t>(data[0]) << 56) |
+         (static_cast<uint64_t>(data[1]) << 48) |
+         (static_cast<uint64_t>(data[2]) << 40) |
+         (static_cast<uint64_t>(data[3]) << 32) |
+         (static_cast<uint64_t>(data[4]) << 24) |
+         (static_cast<uint64_t>(data[5]) << 16) |
+         (static_cast<uint64_t>(data[6]) << 8) | static_cast<uint64_t>(data[7]);
+}
+
+void StoreBigEndian64(uint64_t value, uint8_t* data) {
+  data[0] = static_cast<uint8_t>(value >> 56);
+  data[1] = static_cast<uint8_t>(value >> 48);
+  data[2] = static_cast<uint8_t>(value >> 40);
+  data[3] = static_cast<uint8_t>(value >> 32);
+  data[4] = static_cast<uint8_t>(value >> 24);
+  data[5] = static_cast<uint8_t>(value >> 16);
+  data[6] = static_cast<uint8_t>(value >> 8);
+  data[7] = static_cast<uint8_t>(value);
+}
+
+#if defined(AES_ENGINE_USE_X86_INTRINSICS)
+
+bool CpuSupportsAesNi() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("aes") && __builtin_cpu_supports("sse4.1");
+}
+
+bool CpuSupportsVaes() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("vaes") && __builtin_cpu_supports("avx2");
+}
+
+__attribute__((target("aes,sse4.1"))) void AesNiEncryptBlocks(
+    const uint8_t* round_keys,
+    int num_rounds,
+    const uint8_t* input,
+    uint8_t* output,
+    size_t num_blocks) {
+  __m128i keys[15];
+  for (int r = 0; r <= num_rounds; ++r) {
+    keys[r] = _mm_load_si128(
+        reinterpret_cast<const __m128i*>(round_keys + r * AES_BLOCK_SIZE));
+  }
+
+  size_t i = 0;
+  for (; i + kAesNiLanes <= num_blocks; i += kAesNiLanes) {
+    const __m128i* in =
+        reinterpret_cast<const __m128i*>(input + i * AES_BLOCK_SIZE);
+    __m128i* out = reinterpret_cast<__m128i*>(output + i * AES_BLOCK_SIZE);
+    __m128i blocks[kAesNiLanes];
+    for (size_t j = 0; j < kAesNiLanes; ++j)
+      blocks[j] = _mm_xor_si128(_mm_loadu_si128(in + j), keys[0]);
+    for (int r = 1; r < num_rounds; ++r) {
+      for (size_t j = 0; j < kAesNiLanes; ++j)
+        blocks[j] = _mm_aesenc_si128(blocks[j], keys[r]);
+    }
+    for (size_t j = 0; j < kAesNiLanes; ++j) {
+      _mm_storeu_si128(out + j,
+                       _mm_aesenclast_si128(blocks[j], keys[num_rounds]));
+    }
+  }
+  for (; i < num_blocks; ++i) {
+    const __m128i* in =
+        reinterpret_cast<const __m128i*>(input + i * AES_BLOCK_SIZE);
+    __m128i* out = reinterpret_cast<__m128i*>(output + i * AES_BLOCK_SIZE);
+    __m128i block = _mm_xor_si128(_mm_loadu_si128(in), keys[0]);
+    for (int r = 1; r < num_rounds; ++r)
+      block = _mm_aesenc_si128(block, keys[r]);
+    _mm_storeu_si128(out, _mm_aesenclast_si128(block, keys[num_rounds]));
+  }
+}
+
+// Same as AesNiEncryptBlocks, but with 256-bit VAES instructions, which
+// process two blocks per instruction.
+__attribute__((target("aes,sse4.1,avx2,vaes"))) void VaesEncryptBlocks(
+    const uint8_t* round_keys,
+    int num_rounds,
+    const uint8_t* input,
+    uint8_t* output,
+    size_t num_blocks) {
+  const size_t kBlocksPerVector = 2;
+  const size_t kBlocksPerBatch = kAesNiLanes * kBlocksPerVector;
+
+  __m256i keys[15];
+  for (int r = 0; r <= num_rounds; ++r) {
+    keys[r] = _mm256_broadcastsi128_si256(_mm_load_si128(
+        reinterpret_cast<const __m128i*>(round_keys + r * AES_BLOCK_SIZE)));
+  }
+
+  size_t i = 0;
+  for (; i + kBlocksPerBatch <= num_blocks; i += kBlocksPerBatch) {
+    const __m256i* in =
+        reinterpret_cast<const __m256i*>(input + i * AES_BLOCK_SIZE);
+    __m256i* out = reinterpret_cast<__m256i*>(output + i * AES_BLOCK_SIZE);
+    __m256i blocks[kAesNiLanes];
+    for (size_t j = 0; j < kAesNiLanes; ++j)
+      blocks[j] = _mm256_xor_si256(_mm256_loadu_si256(in + j), keys[0]);
+    for (int r = 1; r < num_rounds; ++r) {
+      for (size_t j = 0; j < kAesNiLanes; ++j)
+        blocks[j] = _mm256_aesenc_epi128(blocks[j], keys[r]);
+    }
+    for (size_t j = 0; j < kAesNiLanes; ++j) {
+      _mm256_storeu_si256(
+          out + j, _mm256_aesenclast_epi128(blocks[j], keys[num_rounds]));
+    }
+  }
+  _mm256_zeroupper();
+
+  if (i < num_blocks) {
+    AesNiEncryptBlocks(round_keys, num_rounds, input + i * AES_BLOCK_SIZE,
+                       output + i * AES_BLOCK_SIZE, num_blocks - i);
+  }
+}
+
+#endif  // defined(AES_ENGINE_USE_X86_INTRINSICS)
+
+}  // namespace
+
+AesBlockEngine::AesBlockEngine() {
+  mbedtls_aes_init(&aes_ctx_);
+}
+
+AesBlockEngine::~AesBlockEngine() {
+  mbedtls_aes_free(&aes_ctx_);
+}
+
+bool AesBlockEngine::SetKey(const std::vector<uint8_t>& key) {
+  // AES defines three key sizes: 128, 192 and 256 bits, with 10, 12 and 14
+  // rounds respectively.
+  if (key.size() != 16 && key.size() != 24 && key.size() != 32) {
+    LOG(ERROR) << "Invalid AES key size: " << key.size();
+    return false;
+  }
+  num_rounds_ = static_cast<int>(key.size() / 4 + 6);
+
+#if defined(AES_ENGINE_USE_X86_INTRINSICS)
+  static const bool kCpuSupportsAesNi = CpuSupportsAesNi();
+  static const bool kCpuSupportsVaes = kCpuSupportsAesNi && CpuSupportsVaes();
+  use_aes_ni_ = kCpuSupportsAesNi;
+  use_vaes_ = kCpuSupportsVaes;
+#endif
+
+  if (use_aes_ni_) {
+    ExpandEncryptionKey(key, num_rounds_, round_keys_);
+    return true;
+  }
+
+  if (mbedtls_aes_setkey_enc(&aes_ctx_, key.data(),
+                             static_cast<unsigned int>(8 * key.size())) != 0) {
+    LOG(ERROR) << "Failed to set AES encryption key";
+    return false;
+  }
+  return true;
+}
+
+void AesBlockEngine::EncryptBlocks(const uint8_t* input,
+                                   uint8_t* output,
+                                   size_t num_blocks) const {
+  DCHECK_GT(num_rounds_, 0) << "SetKey() must be called first.";
+
+#if defined(AES_ENGINE_USE_X86_INTRINSICS)
+  if (use_vaes_) {
+    VaesEncryptBlocks(round_keys_, num_rounds_, input, output, num_blocks);
+    return;
+  }
+  if (use_aes_ni_) {
+    AesNiEncryptBlocks(round_keys_, num_rounds_, input, output, num_blocks);
+    return;
+  }
+#endif
+
+  // mbedtls_aes_crypt_ecb() is not const-correct, but does not modify the
+  // context when encrypting.
+  mbedtls_aes_context* aes_ctx = const_cast<mbedtls_aes_context*>(&aes_ctx_);
+  for (size_t i = 0; i < num_blocks; ++i) {
+    CHECK_EQ(mbedtls_aes_crypt_ecb(aes_ctx, MBEDTLS_AES_ENCRYPT,
+                                   input + i * AES_BLOCK_SIZE,
+                                   output + i * AES_BLOCK_SIZE),
+             0);
+  }
+}
+
+void AesBlockEngine::GenerateCtrKeystream(uint8_t* counter,
+                                          uint8_t* keystream,
+                                          size_t num_blocks) const {
+  // The upper 8 bytes of the counter block never change; the lower 8 bytes
+  // are a 64-bit big-endian integer which wraps around on overflow.
+  uint64_t low_counter = LoadBigEndian64(counter + 8);
+  for (size_t i = 0; i < num_blocks; ++i) {
+    uint8_t* block = keystream + i * AES_BLOCK_SIZE;
+    memcpy(block, counter, 8);
+    StoreBigEndian64(low_counter++, block + 8);
+  }
+  StoreBigEndian64(low_counter, counter + 8);
+
+  EncryptBlocks(keystream, keystream, num_blocks);
+}
+
+void XorBytes(const uint8_t* a,
+              const uint8_t* b,
+              uint8_t* output,
+              size_t size) {
+  size_t i = 0;
+  // memcpy() keeps the word accesses free of alignment and aliasing issues;
+  // compilers turn these into plain (and usually vectorized) loads/stores.
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t x;
+    uint64_t y;
+    memcpy(&x, a + i, sizeof(x));
+    memcpy(&y, b + i, sizeof(y));
+    x ^= y;
+    memcpy(output + i, &x, sizeof(x));
+  }
+  for (; i < size; ++i)
+    output[i] = a[i] ^ b[i];
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,80 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// Multi-block AES engine used by the AES cryptors.
+
+#ifndef PACKAGER_MEDIA_BASE_AES_BLOCK_ENGINE_H_
+#define PACKAGER_MEDIA_BASE_AES_BLOCK_ENGINE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <mbedtls/aes.h>
+
+#include <packager/macros/classes.h>
+
+namespace shaka {
+namespace media {
+
+/// Encrypts many independent AES blocks per call. On x86 CPUs with AES-NI the
+/// blocks are processed in interleaved lanes (two blocks per instruction with
+/// VAES), otherwise it falls back to mbedtls one block at a time.
+class AesBlockEngine {
+ public:
+  /// Maximum number of blocks processed in one interleaved batch. Callers
+  /// that generate their input on the stack can size buffers with this.
+  static constexpr size_t kMaxBatchBlocks = 64;
+
+  AesBlockEngine();
+  ~AesBlockEngine();
+
+  /// Set up the encryption key schedule.
+  /// @param key is a 16, 24 or 32-byte AES key.
+  /// @return true on success, false if the key size is invalid.
+  bool SetKey(const std::vector<uint8_t>& key);
+
+  /// Encrypt @a num_blocks independent 16-byte blocks (AES-ECB).
+  /// @a input and @a output may point to the same address.
+  void EncryptBlocks(const uint8_t* input,
+                     uint8_t* output,
+                     size_t num_blocks) const;
+
+  /// Generate AES-CTR keystream for @a num_blocks blocks.
+  /// @param counter points to the 16-byte counter block. As required by
+  ///        ISO/IEC 23001-7 (CENC), only the least significant 8 bytes are
+  ///        incremented, once per block. It is updated to the counter of the
+  ///        block following the last generated one.
+  /// @param keystream receives @a num_blocks * 16 bytes of keystream.
+  void GenerateCtrKeystream(uint8_t* counter,
+                            uint8_t* keystream,
+                            size_t num_blocks) const;
+
+  /// @return true if the blocks are encrypted with AES instructions directly,
+  ///         false if the generic mbedtls implementation is used.
+  bool hardware_accelerated() const { return use_aes_ni_; }
+
+ private:
+  // Expanded encryption round keys, laid out as consecutive 16-byte blocks
+  // in the byte order expected by the AES instructions.
+  alignas(16) uint8_t round_keys_[15 * 16];
+  int num_rounds_ = 0;
+  bool use_aes_ni_ = false;
+  bool use_vaes_ = false;
+  // Used when AES instructions are not available.
+  mbedtls_aes_context aes_ctx_;
+
+  DISALLOW_COPY_AND_ASSIGN(AesBlockEngine);
+};
+
+/// XOR @a size bytes of @a a and @a b into @a output, a word at a time.
+/// @a output may alias either input.
+void XorBytes(const uint8_t* a, const uint8_t* b, uint8_t* output, size_t size);
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_BASE_AES_BLOCK_ENGINE_H_
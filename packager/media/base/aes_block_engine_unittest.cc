@@ -0,0 +1,120 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/base/aes_block_engine.h>
+
+#include <absl/strings/escaping.h>
+#include <gtest/gtest.h>
+
+#include <packager/macros/crypto.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+// Number of blocks which covers full wide batches, full narrow batches and a
+// remainder in the interleaved implementations.
+const size_t kNumBlocks = 16 + 8 + 5;
+
+std::vector<uint8_t> HexToBytes(const std::string& hex) {
+  const std::string bytes = absl::HexStringToBytes(hex);
+  return std::vector<uint8_t>(bytes.begin(), bytes.end());
+}
+
+struct BlockTestCase {
+  const char* key_hex;
+  const char* ciphertext_hex;
+};
+
+// From FIPS-197 Appendix C. The plaintext is the same for all key sizes.
+const char kFipsPlaintextHex[] = "00112233445566778899aabbccddeeff";
+const BlockTestCase kBlockTestCases[] = {
+    {"000102030405060708090a0b0c0d0e0f", "69c4e0d86a7b0430d8cdb78070b4c55a"},
+    {"000102030405060708090a0b0c0d0e0f1011121314151617",
+     "dda97ca4864cdfe06eaf70a0ec0d7191"},
+    {"000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f",
+     "8ea2b7ca516745bfeafc49904b496089"},
+};
+
+}  // namespace
+
+class AesBlockEngineTest : public ::testing::TestWithParam<BlockTestCase> {};
+
+TEST_P(AesBlockEngineTest, EncryptBlocks) {
+  AesBlockEngine engine;
+  ASSERT_TRUE(engine.SetKey(HexToBytes(GetParam().key_hex)));
+
+  const std::vector<uint8_t> plaintext_block = HexToBytes(kFipsPlaintextHex);
+  const std::vector<uint8_t> ciphertext_block =
+      HexToBytes(GetParam().ciphertext_hex);
+  std::vector<uint8_t> text;
+  std::vector<uint8_t> expected;
+  for (size_t i = 0; i < kNumBlocks; ++i) {
+    text.insert(text.end(), plaintext_block.begin(), plaintext_block.end());
+    expected.insert(expected.end(), ciphertext_block.begin(),
+                    ciphertext_block.end());
+  }
+
+  // In place.
+  engine.EncryptBlocks(text.data(), text.data(), kNumBlocks);
+  EXPECT_EQ(expected, text);
+}
+
+INSTANTIATE_TEST_SUITE_P(FipsTestCases,
+                         AesBlockEngineTest,
+                         ::testing::ValuesIn(kBlockTestCases));
+
+TEST(AesBlockEngineCtrTest, CounterWrapsAroundLower64Bits) {
+  AesBlockEngine engine;
+  ASSERT_TRUE(engine.SetKey(std::vector<uint8_t>(16, 0x42)));
+
+  const std::vector<uint8_t> initial_counter =
+      HexToBytes("0102030405060708fffffffffffffffe");
+  std::vector<uint8_t> counter = initial_counter;
+  std::vector<uint8_t> keystream(kNumBlocks * AES_BLOCK_SIZE);
+  engine.GenerateCtrKeystream(counter.data(), keystream.data(), kNumBlocks);
+  EXPECT_EQ(HexToBytes("0102030405060708000000000000001b"), counter);
+
+  // Generating the keystream one block at a time gives the same result.
+  counter = initial_counter;
+  std::vector<uint8_t> single_block_keystream(kNumBlocks * AES_BLOCK_SIZE);
+  for (size_t i = 0; i < kNumBlocks; ++i) {
+    engine.GenerateCtrKeystream(
+        counter.data(), &single_block_keystream[i * AES_BLOCK_SIZE], 1);
+  }
+  EXPECT_EQ(keystream, single_block_keystream);
+
+  // The third block encrypts a counter with the lower 64 bits wrapped to 0.
+  std::vector<uint8_t> wrapped_block =
+      HexToBytes("01020304050607080000000000000000");
+  engine.EncryptBlocks(wrapped_block.data(), wrapped_block.data(), 1);
+  EXPECT_EQ(wrapped_block,
+            std::vector<uint8_t>(keystream.begin() + 2 * AES_BLOCK_SIZE,
+                                 keystream.begin() + 3 * AES_BLOCK_SIZE));
+}
+
+TEST(AesBlockEngineCtrTest, InvalidKeySize) {
+  AesBlockEngine engine;
+  EXPECT_FALSE(engine.SetKey(std::vector<uint8_t>(13, 0x42)));
+}
+
+TEST(XorBytesTest, UnalignedSizes) {
+  std::vector<uint8_t> a(37);
+  std::vector<uint8_t> b(37);
+  for (size_t i = 0; i < a.size(); ++i) {
+    a[i] = static_cast<uint8_t>(i * 7);
+    b[i] = static_cast<uint8_t>(0xA5 ^ i);
+  }
+  for (size_t size = 0; size <= a.size() - 1; ++size) {
+    std::vector<uint8_t> output(size);
+    XorBytes(a.data() + 1, b.data(), output.data(), size);
+    for (size_t i = 0; i < size; ++i)
+      EXPECT_EQ(a[i + 1] ^ b[i], output[i]);
+  }
+}
+
+}  // namespace media
+}  // namespace shaka
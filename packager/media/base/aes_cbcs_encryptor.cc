@@ -0,0 +1,178 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/base/aes_cbcs_encryptor.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <absl/log/check.h>
+#include <absl/log/log.h>
+
+#include <packager/macros/crypto.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+// Number of chunks encrypted side by side. Matches the widest batch of the
+// AES block engine.
+const size_t kNumLanes = 16;
+
+}  // namespace
+
+// State of the encryption of one chunk of text.
+struct AesCbcsEncryptor::Lane {
+  const uint8_t* text = nullptr;
+  uint8_t* crypt_text = nullptr;
+  // Bytes left in the chunk.
+  size_t remaining_size = 0;
+  // Blocks left to encrypt in the current crypt run of the pattern.
+  size_t remaining_crypt_blocks = 0;
+  // Clear bytes following the current crypt run of the pattern.
+  size_t clear_bytes_after_run = 0;
+  // The previous cipher block, or the iv for the first block.
+  uint8_t chain[AES_BLOCK_SIZE];
+};
+
+AesCbcsEncryptor::AesCbcsEncryptor(
+    uint8_t crypt_byte_block,
+    uint8_t skip_byte_block,
+    AesPatternCryptor::PatternEncryptionMode encryption_mode)
+    : AesCryptor(kUseConstantIv),
+      crypt_byte_block_(crypt_byte_block),
+      skip_byte_block_(skip_byte_block),
+      encryption_mode_(encryption_mode) {
+  // Treat pattern 0:0 as 1:0.
+  if (crypt_byte_block_ == 0 && skip_byte_block_ == 0)
+    crypt_byte_block_ = 1;
+}
+
+AesCbcsEncryptor::~AesCbcsEncryptor() {}
+
+bool AesCbcsEncryptor::InitializeWithIv(const std::vector<uint8_t>& key,
+                                        const std::vector<uint8_t>& iv) {
+  if (!block_engine_.SetKey(key)) {
+    LOG(ERROR) << "Failed to set CBC encryption key";
+    return false;
+  }
+  return SetIv(iv);
+}
+
+bool AesCbcsEncryptor::CryptRanges(const std::vector<CryptRange>& ranges) {
+  Lane lanes[kNumLanes];
+  size_t num_lanes = 0;
+  size_t next_range = 0;
+  alignas(16) uint8_t blocks[kNumLanes * AES_BLOCK_SIZE];
+
+  while (true) {
+    // Start the chunks which are still waiting on the free lanes.
+    while (num_lanes < kNumLanes && next_range < ranges.size()) {
+      const CryptRange& range = ranges[next_range++];
+      Lane& lane = lanes[num_lanes];
+      lane.text = range.text;
+      lane.crypt_text = range.crypt_text;
+      lane.remaining_size = range.text_size;
+      lane.remaining_crypt_blocks = 0;
+      lane.clear_bytes_after_run = 0;
+      memcpy(lane.chain, internal_iv_.data(), AES_BLOCK_SIZE);
+      if (AdvanceToNextCryptBlock(&lane))
+        ++num_lanes;
+    }
+    if (num_lanes == 0)
+      return true;
+
+    // Encrypt the next block of every lane in one batch.
+    for (size_t i = 0; i < num_lanes; ++i) {
+      XorBytes(lanes[i].text, lanes[i].chain, &blocks[i * AES_BLOCK_SIZE],
+               AES_BLOCK_SIZE);
+    }
+    block_engine_.EncryptBlocks(blocks, blocks, num_lanes);
+
+    for (size_t i = 0; i < num_lanes; ++i) {
+      Lane& lane = lanes[i];
+      const uint8_t* cipher_block = &blocks[i * AES_BLOCK_SIZE];
+      memcpy(lane.crypt_text, cipher_block, AES_BLOCK_SIZE);
+      memcpy(lane.chain, cipher_block, AES_BLOCK_SIZE);
+      lane.text += AES_BLOCK_SIZE;
+      lane.crypt_text += AES_BLOCK_SIZE;
+      lane.remaining_size -= AES_BLOCK_SIZE;
+      --lane.remaining_crypt_blocks;
+    }
+
+    // Retire the finished lanes, moving the last active lane into their slot.
+    for (size_t i = 0; i < num_lanes;) {
+      if (AdvanceToNextCryptBlock(&lanes[i])) {
+        ++i;
+      } else {
+        lanes[i] = lanes[--num_lanes];
+      }
+    }
+  }
+}
+
+bool AesCbcsEncryptor::CryptInternal(const uint8_t* text,
+                                     size_t text_size,
+                                     uint8_t* crypt_text,
+                                     size_t* crypt_text_size) {
+  // |crypt_text_size| is always the same as |text_size| for pattern encryption.
+  if (*crypt_text_size < text_size) {
+    LOG(ERROR) << "Expecting output size of at least " << text_size
+               << " bytes.";
+    return false;
+  }
+  *crypt_text_size = text_size;
+  return CryptRanges({{text, text_size, crypt_text}});
+}
+
+void AesCbcsEncryptor::SetIvInternal() {
+  internal_iv_ = iv();
+  internal_iv_.resize(AES_BLOCK_SIZE, 0);
+}
+
+bool AesCbcsEncryptor::AdvanceToNextCryptBlock(Lane* lane) const {
+  if (lane->remaining_crypt_blocks > 0)
+    return true;
+
+  // The current crypt run is done. Leave the following skipped blocks in the
+  // clear, then start the next run of the pattern.
+  while (true) {
+    if (lane->clear_bytes_after_run > 0) {
+      if (lane->text != lane->crypt_text)
+        memcpy(lane->crypt_text, lane->text, lane->clear_bytes_after_run);
+      lane->text += lane->clear_bytes_after_run;
+      lane->crypt_text += lane->clear_bytes_after_run;
+      lane->remaining_size -= lane->clear_bytes_after_run;
+      lane->clear_bytes_after_run = 0;
+    }
+    if (lane->remaining_size == 0)
+      return false;
+
+    const size_t crypt_byte_size = crypt_byte_block_ * AES_BLOCK_SIZE;
+    if (lane->remaining_size <= crypt_byte_size) {
+      // The partial pattern SHALL be followed with the partial 16-byte block
+      // remains unencrypted.
+      const bool need_encrypt =
+          encryption_mode_ !=
+              AesPatternCryptor::kSkipIfCryptByteBlockRemaining &&
+          lane->remaining_size >= AES_BLOCK_SIZE;
+      lane->remaining_crypt_blocks =
+          need_encrypt ? lane->remaining_size / AES_BLOCK_SIZE : 0;
+      lane->clear_bytes_after_run =
+          lane->remaining_size - lane->remaining_crypt_blocks * AES_BLOCK_SIZE;
+    } else {
+      lane->remaining_crypt_blocks = crypt_byte_block_;
+      lane->clear_bytes_after_run =
+          std::min(static_cast<size_t>(skip_byte_block_ * AES_BLOCK_SIZE),
+                   lane->remaining_size - crypt_byte_size);
+    }
+    if (lane->remaining_crypt_blocks > 0)
+      return true;
+  }
+}
+
+}  // namespace media
+}  // namespace shaka
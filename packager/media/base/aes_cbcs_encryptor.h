@@ -0,0 +1,72 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_BASE_AES_CBCS_ENCRYPTOR_H_
+#define PACKAGER_MEDIA_BASE_AES_CBCS_ENCRYPTOR_H_
+
+#include <vector>
+
+#include <packager/macros/classes.h>
+#include <packager/media/base/aes_block_engine.h>
+#include <packager/media/base/aes_cryptor.h>
+#include <packager/media/base/aes_pattern_cryptor.h>
+
+namespace shaka {
+namespace media {
+
+/// Implements pattern-based AES-CBC encryption with a constant iv, i.e.
+/// 'cbcs' and SAMPLE-AES. It produces the same output as AesPatternCryptor
+/// wrapping an AesCbcEncryptor, but since every chunk of text restarts the
+/// cipher block chain from the constant iv, independent chunks passed to
+/// CryptRanges() are encrypted in interleaved lanes: one block of each chunk
+/// per AES batch.
+class AesCbcsEncryptor : public AesCryptor {
+ public:
+  /// @param crypt_byte_block indicates number of encrypted blocks (16-byte) in
+  ///        pattern based encryption.
+  /// @param skip_byte_block indicates number of unencrypted blocks (16-byte)
+  ///        in pattern based encryption.
+  /// @param encryption_mode is used to determine the behavior for the last
+  ///        block.
+  AesCbcsEncryptor(uint8_t crypt_byte_block,
+                   uint8_t skip_byte_block,
+                   AesPatternCryptor::PatternEncryptionMode encryption_mode);
+  ~AesCbcsEncryptor() override;
+
+  /// @name AesCryptor implementation overrides.
+  /// @{
+  bool InitializeWithIv(const std::vector<uint8_t>& key,
+                        const std::vector<uint8_t>& iv) override;
+  bool CryptRanges(const std::vector<CryptRange>& ranges) override;
+  /// @}
+
+ private:
+  struct Lane;
+
+  bool CryptInternal(const uint8_t* text,
+                     size_t text_size,
+                     uint8_t* crypt_text,
+                     size_t* crypt_text_size) override;
+  void SetIvInternal() override;
+
+  // Moves |lane| to its next block to be encrypted, copying the clear bytes
+  // on the way. Returns false if there is nothing left to encrypt.
+  bool AdvanceToNextCryptBlock(Lane* lane) const;
+
+  uint8_t crypt_byte_block_;
+  const uint8_t skip_byte_block_;
+  const AesPatternCryptor::PatternEncryptionMode encryption_mode_;
+  AesBlockEngine block_engine_;
+  // 16-byte constant iv.
+  std::vector<uint8_t> internal_iv_;
+
+  DISALLOW_COPY_AND_ASSIGN(AesCbcsEncryptor);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_BASE_AES_CBCS_ENCRYPTOR_H_
@@ -0,0 +1,137 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/base/aes_cbcs_encryptor.h>
+
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include <packager/media/base/aes_encryptor.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+const uint8_t kKey[] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+                        0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+const uint8_t kIv[] = {0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+                       0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff};
+
+// Chunk sizes covering empty chunks, partial blocks, partial patterns and
+// more chunks than there are lanes.
+const size_t kChunkSizes[] = {0,   15,  16,  17,  31,   32,   159, 160,
+                              161, 175, 176, 500, 1000, 1601, 4103, 16,
+                              48,  64,  3,   333, 2048, 12345};
+
+struct CbcsTestCase {
+  uint8_t crypt_byte_block;
+  uint8_t skip_byte_block;
+  AesPatternCryptor::PatternEncryptionMode encryption_mode;
+};
+
+const CbcsTestCase kCbcsTestCases[] = {
+    {1, 9, AesPatternCryptor::kEncryptIfCryptByteBlockRemaining},
+    {1, 9, AesPatternCryptor::kSkipIfCryptByteBlockRemaining},
+    {5, 5, AesPatternCryptor::kEncryptIfCryptByteBlockRemaining},
+    {5, 5, AesPatternCryptor::kSkipIfCryptByteBlockRemaining},
+    {0, 0, AesPatternCryptor::kEncryptIfCryptByteBlockRemaining},
+    {1, 0, AesPatternCryptor::kSkipIfCryptByteBlockRemaining},
+    {2, 0, AesPatternCryptor::kEncryptIfCryptByteBlockRemaining},
+    {0, 3, AesPatternCryptor::kEncryptIfCryptByteBlockRemaining},
+};
+
+}  // namespace
+
+class AesCbcsEncryptorTest : public ::testing::TestWithParam<CbcsTestCase> {
+ public:
+  void SetUp() override {
+    key_.assign(std::begin(kKey), std::end(kKey));
+    iv_.assign(std::begin(kIv), std::end(kIv));
+
+    // The reference implementation.
+    reference_encryptor_.reset(new AesPatternCryptor(
+        GetParam().crypt_byte_block, GetParam().skip_byte_block,
+        GetParam().encryption_mode, AesCryptor::kUseConstantIv,
+        std::unique_ptr<AesCryptor>(new AesCbcEncryptor(kNoPadding))));
+    ASSERT_TRUE(reference_encryptor_->InitializeWithIv(key_, iv_));
+
+    encryptor_.reset(new AesCbcsEncryptor(GetParam().crypt_byte_block,
+                                          GetParam().skip_byte_block,
+                                          GetParam().encryption_mode));
+    ASSERT_TRUE(encryptor_->InitializeWithIv(key_, iv_));
+
+    for (size_t chunk_size : kChunkSizes) {
+      std::vector<uint8_t> chunk(chunk_size);
+      for (size_t i = 0; i < chunk_size; ++i)
+        chunk[i] = static_cast<uint8_t>(i * 31 + chunk_size);
+      chunks_.push_back(chunk);
+
+      std::vector<uint8_t> expected_chunk;
+      ASSERT_TRUE(reference_encryptor_->Crypt(chunk, &expected_chunk));
+      expected_chunks_.push_back(expected_chunk);
+    }
+  }
+
+ protected:
+  std::vector<uint8_t> key_;
+  std::vector<uint8_t> iv_;
+  std::unique_ptr<AesCryptor> reference_encryptor_;
+  std::unique_ptr<AesCryptor> encryptor_;
+  std::vector<std::vector<uint8_t>> chunks_;
+  std::vector<std::vector<uint8_t>> expected_chunks_;
+};
+
+TEST_P(AesCbcsEncryptorTest, Crypt) {
+  for (size_t i = 0; i < chunks_.size(); ++i) {
+    std::vector<uint8_t> encrypted;
+    ASSERT_TRUE(encryptor_->Crypt(chunks_[i], &encrypted));
+    EXPECT_EQ(expected_chunks_[i], encrypted) << "chunk " << i;
+  }
+}
+
+TEST_P(AesCbcsEncryptorTest, CryptRanges) {
+  std::vector<std::vector<uint8_t>> encrypted_chunks;
+  std::vector<AesCryptor::CryptRange> ranges;
+  for (const std::vector<uint8_t>& chunk : chunks_) {
+    encrypted_chunks.emplace_back(chunk.size());
+    ranges.push_back(
+        {chunk.data(), chunk.size(), encrypted_chunks.back().data()});
+  }
+  ASSERT_TRUE(encryptor_->CryptRanges(ranges));
+  EXPECT_EQ(expected_chunks_, encrypted_chunks);
+
+  // The same through the generic implementation.
+  std::vector<std::vector<uint8_t>> reference_chunks(encrypted_chunks.size());
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    reference_chunks[i].resize(chunks_[i].size());
+    ranges[i].crypt_text = reference_chunks[i].data();
+  }
+  ASSERT_TRUE(reference_encryptor_->CryptRanges(ranges));
+  EXPECT_EQ(expected_chunks_, reference_chunks);
+}
+
+TEST_P(AesCbcsEncryptorTest, CryptRangesInPlace) {
+  std::vector<AesCryptor::CryptRange> ranges;
+  for (std::vector<uint8_t>& chunk : chunks_)
+    ranges.push_back({chunk.data(), chunk.size(), chunk.data()});
+  ASSERT_TRUE(encryptor_->CryptRanges(ranges));
+  EXPECT_EQ(expected_chunks_, chunks_);
+}
+
+INSTANTIATE_TEST_SUITE_P(CbcsTestCases,
+                         AesCbcsEncryptorTest,
+                         ::testing::ValuesIn(kCbcsTestCases));
+
+TEST(AesCbcsEncryptorKeyTest, UnsupportedKeySize) {
+  AesCbcsEncryptor encryptor(
+      1, 9, AesPatternCryptor::kEncryptIfCryptByteBlockRemaining);
+  EXPECT_FALSE(encryptor.InitializeWithIv(std::vector<uint8_t>(13, 0),
+                                          std::vector<uint8_t>(16, 0)));
+}
+
+}  // namespace media
+}  // namespace shaka
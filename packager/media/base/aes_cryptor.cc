@@ -67,6 +67,14 @@ bool AesCryptor::Crypt(const std::string& text, std::string* crypt_text) {
   return true;
 }
 
+bool AesCryptor::CryptRanges(const std::vector<CryptRange>& ranges) {
+  for (const CryptRange& range : ranges) {
+    if (!Crypt(range.text, range.text_size, range.crypt_text))
+      return false;
+  }
+  return true;
+}
+
 bool AesCryptor::SetIv(const std::vector<uint8_t>& iv) {
   if (!IsIvSizeValid(iv.size())) {
     LOG(ERROR) << "Invalid IV size: " << iv.size();
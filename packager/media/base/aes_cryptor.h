@@ -71,6 +71,20 @@ class AesCryptor {
   }
   /// @}
 
+  /// A chunk of text passed to CryptRanges().
+  struct CryptRange {
+    const uint8_t* text;
+    size_t text_size;
+    /// Should have at least @a text_size bytes.
+    uint8_t* crypt_text;
+  };
+
+  /// Crypt several chunks of text. This is equivalent to calling Crypt() on
+  /// each of the chunks in order, but cryptors using a constant iv, where the
+  /// chunks are independent of each other, may process them in parallel.
+  /// @return true on success, false otherwise.
+  virtual bool CryptRanges(const std::vector<CryptRange>& ranges);
+
   /// Set IV. SetIv() implementation guarantees that the iv passed to SetIv()
   /// is set to iv() and then calls SetIvInternal().
   /// @return true if successful, false if the input is invalid.
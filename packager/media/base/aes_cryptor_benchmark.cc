@@ -0,0 +1,81 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// Benchmarks for sample encryption with 'cenc' (AES-CTR), 'cens' (AES-CTR with
+// a 1:9 pattern) and 'cbcs' (AES-CBC with a 1:9 pattern) at typical sample
+// sizes.
+
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <packager/media/base/aes_cbcs_encryptor.h>
+#include <packager/media/base/aes_encryptor.h>
+#include <packager/media/base/aes_pattern_cryptor.h>
+#include <packager/media/base/fourccs.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+const uint8_t kCryptByteBlock = 1;
+const uint8_t kSkipByteBlock = 9;
+
+std::unique_ptr<AesCryptor> CreateEncryptor(FourCC protection_scheme) {
+  if (protection_scheme == FOURCC_cbcs) {
+    return std::unique_ptr<AesCryptor>(new AesCbcsEncryptor(
+        kCryptByteBlock, kSkipByteBlock,
+        AesPatternCryptor::kEncryptIfCryptByteBlockRemaining));
+  }
+  if (protection_scheme == FOURCC_cens) {
+    return std::unique_ptr<AesCryptor>(new AesPatternCryptor(
+        kCryptByteBlock, kSkipByteBlock,
+        AesPatternCryptor::kEncryptIfCryptByteBlockRemaining,
+        AesCryptor::kDontUseConstantIv,
+        std::unique_ptr<AesCryptor>(new AesCtrEncryptor)));
+  }
+  return std::unique_ptr<AesCryptor>(new AesCtrEncryptor);
+}
+
+// The argument is the sample size.
+void BM_Encrypt(benchmark::State& state, FourCC protection_scheme) {
+  std::unique_ptr<AesCryptor> encryptor = CreateEncryptor(protection_scheme);
+  const std::vector<uint8_t> key(16, 0x42);
+  const std::vector<uint8_t> iv(8, 0x24);
+  if (!encryptor->InitializeWithIv(key, iv)) {
+    state.SkipWithError("Failed to initialize the encryptor.");
+    return;
+  }
+
+  std::vector<uint8_t> sample(state.range(0));
+  for (size_t i = 0; i < sample.size(); ++i)
+    sample[i] = static_cast<uint8_t>(i);
+  std::vector<uint8_t> encrypted(sample.size());
+
+  for (auto _ : state) {
+    if (!encryptor->Crypt(sample.data(), sample.size(), encrypted.data())) {
+      state.SkipWithError("Encryption failed.");
+      return;
+    }
+    encryptor->UpdateIv();
+    benchmark::DoNotOptimize(encrypted.data());
+  }
+  state.SetBytesProcessed(state.iterations() * sample.size());
+}
+
+// An AAC frame, a small video frame, an HD frame and a 4K key frame.
+#define SAMPLE_SIZES Arg(384)->Arg(4 << 10)->Arg(64 << 10)->Arg(1 << 20)
+
+BENCHMARK_CAPTURE(BM_Encrypt, cenc, FOURCC_cenc)->SAMPLE_SIZES;
+BENCHMARK_CAPTURE(BM_Encrypt, cens, FOURCC_cens)->SAMPLE_SIZES;
+BENCHMARK_CAPTURE(BM_Encrypt, cbcs, FOURCC_cbcs)->SAMPLE_SIZES;
+
+#undef SAMPLE_SIZES
+
+}  // namespace
+}  // namespace media
+}  // namespace shaka
@@ -7,6 +7,7 @@
 #include <packager/media/base/aes_decryptor.h>
 #include <packager/media/base/aes_encryptor.h>
 
+#include <algorithm>
 #include <iterator>
 #include <memory>
 
@@ -269,6 +270,30 @@ INSTANTIATE_TEST_CASE_P(SubsampleTestCases,
                         AesCtrEncryptorSubsampleTest,
                         ::testing::ValuesIn(kSubsampleTestCases));
 
+TEST_F(AesCtrEncryptorTest, BatchedAndIncrementalEncryptionMatch) {
+  // Spans several keystream batches and ends with a partial block.
+  std::vector<uint8_t> plaintext(4099);
+  for (size_t i = 0; i < plaintext.size(); ++i)
+    plaintext[i] = static_cast<uint8_t>(i);
+
+  std::vector<uint8_t> encrypted;
+  ASSERT_TRUE(encryptor_.Crypt(plaintext, &encrypted));
+
+  // Counter mode is symmetric, so the decryptor can be used to encrypt the same
+  // data in chunks which do not line up with the block boundaries.
+  const size_t kChunkSizes[] = {1, 15, 17, 1024, 3, 16, 2000};
+  std::vector<uint8_t> incremental(plaintext.size());
+  for (size_t i = 0, offset = 0; offset < plaintext.size(); ++i) {
+    const size_t len = std::min(kChunkSizes[i % std::size(kChunkSizes)],
+                                plaintext.size() - offset);
+    ASSERT_TRUE(
+        decryptor_.Crypt(&plaintext[offset], len, &incremental[offset]));
+    offset += len;
+    EXPECT_EQ(offset % kAesBlockSize, decryptor_.block_offset());
+  }
+  EXPECT_EQ(encrypted, incremental);
+}
+
 struct IvTestCase {
   const uint8_t* iv_test;
   size_t iv_size;
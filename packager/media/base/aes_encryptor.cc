@@ -6,25 +6,13 @@
 
 #include <packager/media/base/aes_encryptor.h>
 
+#include <algorithm>
+
 #include <absl/log/check.h>
 #include <absl/log/log.h>
 
 #include <packager/macros/crypto.h>
 
-namespace {
-
-// Increment an 8-byte counter by 1. Return true if overflowed.
-bool Increment64(uint8_t* counter) {
-  DCHECK(counter);
-  for (int i = 7; i >= 0; --i) {
-    if (++counter[i] != 0)
-      return false;
-  }
-  return true;
-}
-
-}  // namespace
-
 namespace shaka {
 namespace media {
 
@@ -39,13 +27,7 @@ AesCtrEncryptor::~AesCtrEncryptor() {}
 
 bool AesCtrEncryptor::InitializeWithIv(const std::vector<uint8_t>& key,
                                        const std::vector<uint8_t>& iv) {
-  if (!SetupCipher(key.size(), kCtrMode)) {
-    return false;
-  }
-
-  if (mbedtls_cipher_setkey(&cipher_ctx_, key.data(),
-                            static_cast<int>(8 * key.size()),
-                            MBEDTLS_ENCRYPT) != 0) {
+  if (!block_engine_.SetKey(key)) {
     LOG(ERROR) << "Failed to set CTR encryption key";
     return false;
   }
@@ -68,24 +50,42 @@ bool AesCtrEncryptor::CryptInternal(const uint8_t* plaintext,
   }
   *ciphertext_size = plaintext_size;
 
-  for (size_t i = 0; i < plaintext_size; ++i) {
-    if (block_offset_ == 0) {
-      size_t ignored_output_size;
-      CHECK_EQ(
-          mbedtls_cipher_crypt(&cipher_ctx_, /* iv= */ NULL, /* iv_len= */ 0,
-                               &counter_[0], AES_BLOCK_SIZE,
-                               &encrypted_counter_[0], &ignored_output_size),
-          0);
-
-      // As mentioned in ISO/IEC 23001-7:2016 CENC spec, of the 16 byte counter
-      // block, bytes 8 to 15 (i.e. the least significant bytes) are used as a
-      // simple 64 bit unsigned integer that is incremented by one for each
-      // subsequent block of sample data processed and is kept in network byte
-      // order.
-      Increment64(&counter_[8]);
-    }
-    ciphertext[i] = plaintext[i] ^ encrypted_counter_[block_offset_];
-    block_offset_ = (block_offset_ + 1) % AES_BLOCK_SIZE;
+  // Use up the keystream left over from a partial block in the previous call.
+  size_t offset = 0;
+  if (block_offset_ != 0) {
+    const size_t size =
+        std::min(plaintext_size, AES_BLOCK_SIZE - size_t{block_offset_});
+    XorBytes(plaintext, &encrypted_counter_[block_offset_], ciphertext, size);
+    block_offset_ =
+        static_cast<uint32_t>((block_offset_ + size) % AES_BLOCK_SIZE);
+    offset = size;
+  }
+
+  // As mentioned in ISO/IEC 23001-7:2016 CENC spec, of the 16 byte counter
+  // block, bytes 8 to 15 (i.e. the least significant bytes) are used as a
+  // simple 64 bit unsigned integer that is incremented by one for each
+  // subsequent block of sample data processed and is kept in network byte
+  // order. The keystream for full blocks is generated in batches so the AES
+  // implementation can work on many counter blocks at once.
+  uint8_t keystream[AesBlockEngine::kMaxBatchBlocks * AES_BLOCK_SIZE];
+  while (plaintext_size - offset >= AES_BLOCK_SIZE) {
+    const size_t num_blocks =
+        std::min((plaintext_size - offset) / AES_BLOCK_SIZE,
+                 AesBlockEngine::kMaxBatchBlocks);
+    const size_t size = num_blocks * AES_BLOCK_SIZE;
+    block_engine_.GenerateCtrKeystream(counter_.data(), keystream, num_blocks);
+    XorBytes(plaintext + offset, keystream, ciphertext + offset, size);
+    offset += size;
+  }
+
+  // Encrypt the trailing partial block, keeping the rest of its keystream for
+  // the next call.
+  if (offset < plaintext_size) {
+    block_engine_.GenerateCtrKeystream(counter_.data(),
+                                       encrypted_counter_.data(), 1);
+    block_offset_ = static_cast<uint32_t>(plaintext_size - offset);
+    XorBytes(plaintext + offset, encrypted_counter_.data(), ciphertext + offset,
+             block_offset_);
   }
   return true;
 }
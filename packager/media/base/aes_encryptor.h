@@ -13,6 +13,7 @@
 #include <vector>
 
 #include <packager/macros/classes.h>
+#include <packager/media/base/aes_block_engine.h>
 #include <packager/media/base/aes_cryptor.h>
 
 namespace shaka {
@@ -38,11 +39,14 @@ class AesCtrEncryptor : public AesCryptor {
                      size_t* ciphertext_size) override;
   void SetIvInternal() override;
 
+  // Generates the keystream for many counter blocks at once.
+  AesBlockEngine block_engine_;
   // Current block offset.
   uint32_t block_offset_;
   // Current AES-CTR counter.
   std::vector<uint8_t> counter_;
-  // Encrypted counter.
+  // Encrypted counter. Holds the keystream of a partially consumed block when
+  // |block_offset_| is not 0.
   std::vector<uint8_t> encrypted_counter_;
 
   DISALLOW_COPY_AND_ASSIGN(AesCtrEncryptor);
@@ -4,6 +4,9 @@
 // license that can be found in the LICENSE file or at
 // https://developers.google.com/open-source/licenses/bsd
 
+#ifndef PACKAGER_MEDIA_BASE_AES_PATTERN_CRYPTOR_H_
+#define PACKAGER_MEDIA_BASE_AES_PATTERN_CRYPTOR_H_
+
 #include <memory>
 
 #include <packager/macros/classes.h>
@@ -77,3 +80,5 @@ class AesPatternCryptor : public AesCryptor {
 
 }  // namespace media
 }  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_BASE_AES_PATTERN_CRYPTOR_H_
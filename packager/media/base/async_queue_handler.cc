@@ -0,0 +1,127 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/base/async_queue_handler.h>
+
+#include <absl/log/check.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+// Number of stream data dispatched by a task before it yields the worker.
+const size_t kMaxStreamDataPerTask = 16;
+
+}  // namespace
+
+AsyncQueueHandler::AsyncQueueHandler(WorkStealingThreadPool* thread_pool,
+                                     size_t max_queue_size)
+    : thread_pool_(thread_pool), max_queue_size_(max_queue_size) {
+  DCHECK(thread_pool_);
+  DCHECK_GT(max_queue_size_, 0u);
+}
+
+AsyncQueueHandler::~AsyncQueueHandler() {
+  absl::MutexLock lock(&mutex_);
+  DCHECK(!drain_scheduled_) << "The thread pool is still draining the queue.";
+}
+
+Status AsyncQueueHandler::InitializeInternal() {
+  if (num_input_streams() != 1 || next_output_stream_index() != 1) {
+    return Status(error::INVALID_ARGUMENT,
+                  "Expects exactly one input and one output.");
+  }
+  return Status::OK;
+}
+
+Status AsyncQueueHandler::Process(std::unique_ptr<StreamData> stream_data) {
+  DCHECK(!thread_pool_->IsWorkerThread());
+
+  absl::MutexLock lock(&mutex_);
+  while (status_.ok() && queue_.size() >= max_queue_size_)
+    queue_not_full_.Wait(&mutex_);
+  if (!status_.ok())
+    return status_;
+
+  queue_.push_back(std::move(stream_data));
+  if (stats())
+    stats()->SetQueueDepth(queue_.size());
+  ScheduleDrain();
+  return Status::OK;
+}
+
+Status AsyncQueueHandler::OnFlushRequest(size_t input_stream_index) {
+  DCHECK_EQ(input_stream_index, 0u);
+  DCHECK(!thread_pool_->IsWorkerThread());
+
+  absl::MutexLock lock(&mutex_);
+  // A flush request does not count against the queue size, so it never
+  // blocks behind a full queue.
+  queue_.push_back(nullptr);
+  ++num_pending_flushes_;
+  ScheduleDrain();
+  while (num_pending_flushes_ > 0)
+    flushed_.Wait(&mutex_);
+  return status_;
+}
+
+void AsyncQueueHandler::ScheduleDrain() {
+  if (drain_scheduled_)
+    return;
+  drain_scheduled_ = true;
+  thread_pool_->PostTask([this]() { DrainQueue(); });
+}
+
+void AsyncQueueHandler::DrainQueue() {
+  for (size_t i = 0; i < kMaxStreamDataPerTask; ++i) {
+    std::unique_ptr<StreamData> stream_data;
+    {
+      absl::MutexLock lock(&mutex_);
+      if (queue_.empty()) {
+        drain_scheduled_ = false;
+        return;
+      }
+      stream_data = std::move(queue_.front());
+      queue_.pop_front();
+      queue_not_full_.Signal();
+      if (stats())
+        stats()->SetQueueDepth(queue_.size());
+
+      // Drop the stream data after an error, but still complete flushes so
+      // OnFlushRequest() returns.
+      if (!status_.ok()) {
+        if (!stream_data) {
+          --num_pending_flushes_;
+          flushed_.SignalAll();
+        }
+        continue;
+      }
+    }
+
+    const bool is_flush = !stream_data;
+    Status status =
+        is_flush ? FlushDownstream(0) : Dispatch(std::move(stream_data));
+
+    absl::MutexLock lock(&mutex_);
+    status_.Update(std::move(status));
+    if (!status_.ok())
+      queue_not_full_.Signal();
+    if (is_flush) {
+      --num_pending_flushes_;
+      flushed_.SignalAll();
+    }
+  }
+
+  absl::MutexLock lock(&mutex_);
+  if (queue_.empty()) {
+    drain_scheduled_ = false;
+    return;
+  }
+  thread_pool_->PostTask([this]() { DrainQueue(); });
+}
+
+}  // namespace media
+}  // namespace shaka
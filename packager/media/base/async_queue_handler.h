@@ -0,0 +1,82 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_BASE_ASYNC_QUEUE_HANDLER_H_
+#define PACKAGER_MEDIA_BASE_ASYNC_QUEUE_HANDLER_H_
+
+#include <deque>
+#include <memory>
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+
+#include <packager/media/base/media_handler.h>
+#include <packager/media/base/work_stealing_thread_pool.h>
+#include <packager/status.h>
+
+namespace shaka {
+namespace media {
+
+/// A single input single output pass-through handler which moves its
+/// downstream handlers onto a thread pool. Process() only queues the stream
+/// data; a task on the pool dispatches it downstream. At most one task drains
+/// the queue at a time, so the downstream handlers see the stream data in
+/// order.
+///
+/// Process() blocks while the queue is full, which applies backpressure to
+/// the upstream handlers, and OnFlushRequest() blocks until everything queued
+/// has been processed and the downstream handlers are flushed. An error from
+/// the downstream handlers is returned by the following Process() or
+/// OnFlushRequest() call.
+///
+/// The downstream handlers must not contain another AsyncQueueHandler on the
+/// same pool, as a worker blocked on a full queue could starve the pool.
+class AsyncQueueHandler : public MediaHandler {
+ public:
+  /// @param thread_pool runs the downstream handlers. It must outlive this
+  ///        handler, and be idle when this handler is destroyed.
+  /// @param max_queue_size is the number of stream data queued before
+  ///        Process() blocks.
+  AsyncQueueHandler(WorkStealingThreadPool* thread_pool, size_t max_queue_size);
+  ~AsyncQueueHandler() override;
+
+ protected:
+  /// @name MediaHandler implementation overrides.
+  /// @{
+  Status InitializeInternal() override;
+  Status Process(std::unique_ptr<StreamData> stream_data) override;
+  Status OnFlushRequest(size_t input_stream_index) override;
+  /// @}
+
+ private:
+  AsyncQueueHandler(const AsyncQueueHandler&) = delete;
+  AsyncQueueHandler& operator=(const AsyncQueueHandler&) = delete;
+
+  // Posts a task draining the queue unless one is already pending or running.
+  void ScheduleDrain() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Dispatches a batch of queued stream data downstream, then reschedules
+  // itself if the queue is not empty, letting the other queues of the pool
+  // have a turn.
+  void DrainQueue();
+
+  WorkStealingThreadPool* const thread_pool_;
+  const size_t max_queue_size_;
+
+  absl::Mutex mutex_;
+  absl::CondVar queue_not_full_ ABSL_GUARDED_BY(mutex_);
+  absl::CondVar flushed_ ABSL_GUARDED_BY(mutex_);
+  // A null entry is a flush request.
+  std::deque<std::unique_ptr<StreamData>> queue_ ABSL_GUARDED_BY(mutex_);
+  bool drain_scheduled_ ABSL_GUARDED_BY(mutex_) = false;
+  size_t num_pending_flushes_ ABSL_GUARDED_BY(mutex_) = 0;
+  // The first error returned by the downstream handlers.
+  Status status_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_BASE_ASYNC_QUEUE_HANDLER_H_
@@ -0,0 +1,164 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/base/async_queue_handler.h>
+
+#include <atomic>
+#include <thread>
+
+#include <absl/synchronization/notification.h>
+#include <absl/time/clock.h>
+#include <absl/time/time.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <packager/macros/compiler.h>
+#include <packager/media/base/media_handler_test_base.h>
+#include <packager/status/status_test_util.h>
+
+using ::testing::_;
+using ::testing::InSequence;
+
+namespace shaka {
+namespace media {
+namespace {
+
+const size_t kNumThreads = 2;
+const size_t kMaxQueueSize = 4;
+const size_t kStreamIndex = 0;
+const int32_t kTimeScale = 1000;
+const int64_t kDuration = 100;
+const bool kKeyFrame = true;
+const bool kEncrypted = true;
+const size_t kNumSamples = 100;
+
+// A downstream handler which blocks every stream data until released, then
+// returns |status|.
+class GatedMediaHandler : public MediaHandler {
+ public:
+  explicit GatedMediaHandler(Status status) : status_(std::move(status)) {}
+
+  void Release() { release_.Notify(); }
+  size_t num_processed() const { return num_processed_; }
+
+ private:
+  Status InitializeInternal() override { return Status::OK; }
+
+  Status Process(std::unique_ptr<StreamData> stream_data) override {
+    UNUSED(stream_data);
+    release_.WaitForNotification();
+    ++num_processed_;
+    return status_;
+  }
+
+  Status OnFlushRequest(size_t input_stream_index) override {
+    UNUSED(input_stream_index);
+    return status_;
+  }
+
+  const Status status_;
+  absl::Notification release_;
+  std::atomic<size_t> num_processed_{0};
+};
+
+}  // namespace
+
+class AsyncQueueHandlerTest : public MediaHandlerTestBase {
+ protected:
+  AsyncQueueHandlerTest() : thread_pool_(kNumThreads) {}
+
+  void TearDown() override { thread_pool_.WaitForIdle(); }
+
+  // Connects an input, an AsyncQueueHandler and |output|.
+  void SetUpGatedGraph(std::shared_ptr<MediaHandler> output) {
+    input_ = std::make_shared<FakeInputMediaHandler>();
+    auto handler =
+        std::make_shared<AsyncQueueHandler>(&thread_pool_, kMaxQueueSize);
+    ASSERT_OK(MediaHandler::Chain({input_, handler, output}));
+    ASSERT_OK(input_->Initialize());
+  }
+
+  Status DispatchSample(FakeInputMediaHandler* input, int64_t timestamp) {
+    return input->Dispatch(StreamData::FromMediaSample(
+        kStreamIndex, GetMediaSample(timestamp, kDuration, kKeyFrame)));
+  }
+
+  WorkStealingThreadPool thread_pool_;
+  std::shared_ptr<FakeInputMediaHandler> input_;
+};
+
+TEST_F(AsyncQueueHandlerTest, DispatchesInOrderAndFlushes) {
+  ASSERT_OK(SetUpAndInitializeGraph(
+      std::make_shared<AsyncQueueHandler>(&thread_pool_, kMaxQueueSize), 1,
+      1));
+
+  {
+    InSequence s;
+    EXPECT_CALL(*Output(0),
+                OnProcess(IsStreamInfo(kStreamIndex, kTimeScale, !kEncrypted,
+                                       _)));
+    for (size_t i = 0; i < kNumSamples; ++i) {
+      EXPECT_CALL(*Output(0),
+                  OnProcess(IsMediaSample(kStreamIndex, i * kDuration,
+                                          kDuration, !kEncrypted, kKeyFrame)));
+    }
+    EXPECT_CALL(*Output(0), OnFlush(kStreamIndex));
+  }
+
+  ASSERT_OK(Input(0)->Dispatch(StreamData::FromStreamInfo(
+      kStreamIndex, GetVideoStreamInfo(kTimeScale))));
+  for (size_t i = 0; i < kNumSamples; ++i)
+    ASSERT_OK(DispatchSample(Input(0), i * kDuration));
+  // Returns only after the downstream handler is flushed.
+  ASSERT_OK(Input(0)->FlushAllDownstreams());
+  testing::Mock::VerifyAndClearExpectations(Output(0));
+}
+
+TEST_F(AsyncQueueHandlerTest, BlocksWhenQueueIsFull) {
+  auto output = std::make_shared<GatedMediaHandler>(Status::OK);
+  SetUpGatedGraph(output);
+
+  // One stream data is held by the blocked downstream handler, then the queue
+  // fills up.
+  const size_t kMaxInFlight = kMaxQueueSize + 1;
+  std::atomic<size_t> num_dispatched(0);
+  std::thread producer([this, &num_dispatched]() {
+    for (size_t i = 0; i < kMaxInFlight + 1; ++i) {
+      ASSERT_OK(DispatchSample(input_.get(), i * kDuration));
+      ++num_dispatched;
+    }
+  });
+
+  const absl::Time deadline = absl::Now() + absl::Seconds(10);
+  while (num_dispatched < kMaxInFlight && absl::Now() < deadline)
+    absl::SleepFor(absl::Milliseconds(1));
+  absl::SleepFor(absl::Milliseconds(50));
+  EXPECT_EQ(kMaxInFlight, num_dispatched);
+
+  output->Release();
+  producer.join();
+  EXPECT_EQ(kMaxInFlight + 1, num_dispatched);
+  ASSERT_OK(input_->FlushAllDownstreams());
+  EXPECT_EQ(kMaxInFlight + 1, output->num_processed());
+}
+
+TEST_F(AsyncQueueHandlerTest, ReturnsDownstreamError) {
+  auto output = std::make_shared<GatedMediaHandler>(
+      Status(error::MUXER_FAILURE, "muxer failure"));
+  SetUpGatedGraph(output);
+  output->Release();
+
+  // The error is only known once the queued sample is processed.
+  ASSERT_OK(DispatchSample(input_.get(), 0));
+  EXPECT_EQ(error::MUXER_FAILURE,
+            input_->FlushAllDownstreams().error_code());
+  EXPECT_EQ(error::MUXER_FAILURE,
+            DispatchSample(input_.get(), kDuration).error_code());
+  EXPECT_EQ(1u, output->num_processed());
+}
+
+}  // namespace media
+}  // namespace shaka
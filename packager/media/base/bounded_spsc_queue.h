@@ -0,0 +1,116 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_BASE_BOUNDED_SPSC_QUEUE_H_
+#define PACKAGER_MEDIA_BASE_BOUNDED_SPSC_QUEUE_H_
+
+#include <atomic>
+#include <vector>
+
+#include <absl/log/check.h>
+#include <absl/synchronization/mutex.h>
+
+#include <packager/macros/classes.h>
+
+namespace shaka {
+namespace media {
+
+/// A blocking, bounded, single producer single consumer queue. Elements are
+/// passed through a ring of slots with atomic head and tail positions, so
+/// neither side takes a lock unless the queue is full or empty and it has to
+/// sleep.
+template <class T>
+class BoundedSpscQueue {
+ public:
+  /// @param capacity is the maximum number of elements in the queue.
+  explicit BoundedSpscQueue(size_t capacity) : slots_(capacity) {
+    DCHECK_GT(capacity, 0u);
+  }
+
+  /// Push an element to the back of the queue, blocking while the queue is
+  /// full. Must only be called from the producer thread.
+  /// @return false if the queue is stopped; @a element is dropped.
+  bool Push(T element) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == slots_.size()) {
+      absl::MutexLock lock(&mutex_);
+      producer_waiting_.store(true);
+      while (tail - head_.load() == slots_.size() && !stopped_.load())
+        not_full_.Wait(&mutex_);
+      producer_waiting_.store(false);
+    }
+    if (stopped_.load(std::memory_order_acquire))
+      return false;
+
+    slots_[tail % slots_.size()] = std::move(element);
+    tail_.store(tail + 1);
+    if (consumer_waiting_.load()) {
+      absl::MutexLock lock(&mutex_);
+      not_empty_.Signal();
+    }
+    return true;
+  }
+
+  /// Pop an element from the front of the queue, blocking while the queue is
+  /// empty. Must only be called from the consumer thread. Elements pushed
+  /// before Stop() can still be popped.
+  /// @return false if the queue is stopped and empty.
+  bool Pop(T* element) {
+    DCHECK(element);
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (tail_.load(std::memory_order_acquire) == head) {
+      absl::MutexLock lock(&mutex_);
+      consumer_waiting_.store(true);
+      while (tail_.load() == head && !stopped_.load())
+        not_empty_.Wait(&mutex_);
+      consumer_waiting_.store(false);
+      if (tail_.load() == head)
+        return false;
+    }
+
+    *element = std::move(slots_[head % slots_.size()]);
+    head_.store(head + 1);
+    if (producer_waiting_.load()) {
+      absl::MutexLock lock(&mutex_);
+      not_full_.Signal();
+    }
+    return true;
+  }
+
+  /// Fail the pending and future Push() calls, and wake up the consumer once
+  /// the queue is drained. Can be called from any thread.
+  void Stop() {
+    absl::MutexLock lock(&mutex_);
+    stopped_.store(true);
+    not_full_.SignalAll();
+    not_empty_.SignalAll();
+  }
+
+ private:
+  // The waiting flags and positions use sequentially consistent operations:
+  // either the side publishing a position sees the flag of the side about to
+  // sleep and signals it under |mutex_|, or the sleeping side sees the new
+  // position before it waits.
+  std::vector<T> slots_;
+  // Position of the next element to pop. Only written by the consumer.
+  alignas(64) std::atomic<size_t> head_{0};
+  // Position of the next element to push. Only written by the producer.
+  alignas(64) std::atomic<size_t> tail_{0};
+  std::atomic<bool> stopped_{false};
+  std::atomic<bool> producer_waiting_{false};
+  std::atomic<bool> consumer_waiting_{false};
+
+  absl::Mutex mutex_;
+  absl::CondVar not_full_;
+  absl::CondVar not_empty_;
+
+  DISALLOW_COPY_AND_ASSIGN(BoundedSpscQueue);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_BASE_BOUNDED_SPSC_QUEUE_H_
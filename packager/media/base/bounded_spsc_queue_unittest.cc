@@ -0,0 +1,82 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/base/bounded_spsc_queue.h>
+
+#include <memory>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+const size_t kCapacity = 8;
+const size_t kNumElements = 100000;
+
+}  // namespace
+
+TEST(BoundedSpscQueueTest, PushPop) {
+  BoundedSpscQueue<std::unique_ptr<size_t>> queue(kCapacity);
+  for (size_t i = 0; i < kCapacity; ++i)
+    ASSERT_TRUE(queue.Push(std::unique_ptr<size_t>(new size_t(i))));
+  for (size_t i = 0; i < kCapacity; ++i) {
+    std::unique_ptr<size_t> element;
+    ASSERT_TRUE(queue.Pop(&element));
+    ASSERT_TRUE(element);
+    EXPECT_EQ(i, *element);
+  }
+}
+
+TEST(BoundedSpscQueueTest, ProducerConsumer) {
+  BoundedSpscQueue<size_t> queue(kCapacity);
+  std::thread producer([&queue]() {
+    for (size_t i = 0; i < kNumElements; ++i)
+      ASSERT_TRUE(queue.Push(i));
+    queue.Stop();
+  });
+
+  size_t num_popped = 0;
+  size_t element;
+  while (queue.Pop(&element)) {
+    ASSERT_EQ(num_popped, element);
+    ++num_popped;
+  }
+  producer.join();
+  EXPECT_EQ(kNumElements, num_popped);
+}
+
+TEST(BoundedSpscQueueTest, StopUnblocksFullQueue) {
+  BoundedSpscQueue<size_t> queue(kCapacity);
+  for (size_t i = 0; i < kCapacity; ++i)
+    ASSERT_TRUE(queue.Push(i));
+
+  std::thread producer([&queue]() { EXPECT_FALSE(queue.Push(kCapacity)); });
+  queue.Stop();
+  producer.join();
+
+  // The elements pushed before Stop() can still be popped.
+  size_t element;
+  for (size_t i = 0; i < kCapacity; ++i) {
+    ASSERT_TRUE(queue.Pop(&element));
+    EXPECT_EQ(i, element);
+  }
+  EXPECT_FALSE(queue.Pop(&element));
+}
+
+TEST(BoundedSpscQueueTest, StopUnblocksEmptyQueue) {
+  BoundedSpscQueue<size_t> queue(kCapacity);
+  std::thread consumer([&queue]() {
+    size_t element;
+    EXPECT_FALSE(queue.Pop(&element));
+  });
+  queue.Stop();
+  consumer.join();
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,85 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/base/buffer_chain.h>
+
+#include <absl/log/check.h>
+
+#include <packager/file.h>
+#include <packager/media/base/buffer_writer.h>
+
+namespace shaka {
+namespace media {
+
+BufferChain::BufferChain() {}
+BufferChain::~BufferChain() {}
+
+void BufferChain::AppendArray(const uint8_t* buf, size_t size) {
+  if (size == 0)
+    return;
+  if (blocks_.empty() || blocks_.back().shared_data)
+    blocks_.emplace_back();
+  std::vector<uint8_t>& copied_data = blocks_.back().copied_data;
+  copied_data.insert(copied_data.end(), buf, buf + size);
+  size_ += size;
+}
+
+void BufferChain::AppendBuffer(const BufferWriter& buffer) {
+  AppendArray(buffer.Buffer(), buffer.Size());
+}
+
+void BufferChain::AppendSharedData(std::shared_ptr<const uint8_t> data,
+                                   size_t size) {
+  if (size == 0)
+    return;
+  DCHECK(data);
+  blocks_.emplace_back();
+  blocks_.back().shared_data = std::move(data);
+  blocks_.back().shared_size = size;
+  size_ += size;
+}
+
+void BufferChain::AppendChain(const BufferChain& chain) {
+  for (const Block& block : chain.blocks_) {
+    if (block.shared_data)
+      AppendSharedData(block.shared_data, block.shared_size);
+    else
+      AppendArray(block.copied_data.data(), block.copied_data.size());
+  }
+}
+
+void BufferChain::Clear() {
+  blocks_.clear();
+  size_ = 0;
+}
+
+void BufferChain::CopyTo(std::vector<uint8_t>* output) const {
+  DCHECK(output);
+  output->clear();
+  output->reserve(size_);
+  for (const Block& block : blocks_)
+    output->insert(output->end(), block.data(), block.data() + block.size());
+}
+
+Status BufferChain::WriteToFile(File* file) {
+  DCHECK(file);
+
+  std::vector<File::IoVec> io_vecs;
+  io_vecs.reserve(blocks_.size());
+  for (const Block& block : blocks_)
+    io_vecs.push_back({block.data(), block.size()});
+
+  const int64_t size_written = file->WriteV(io_vecs.data(), io_vecs.size());
+  if (size_written < 0 || static_cast<size_t>(size_written) != size_) {
+    return Status(error::FILE_FAILURE,
+                  "Fail to write to file in BufferChain");
+  }
+  Clear();
+  return Status::OK;
+}
+
+}  // namespace media
+}  // namespace shaka
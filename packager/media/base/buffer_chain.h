@@ -0,0 +1,81 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_BASE_BUFFER_CHAIN_H_
+#define PACKAGER_MEDIA_BASE_BUFFER_CHAIN_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <packager/macros/classes.h>
+#include <packager/status.h>
+
+namespace shaka {
+
+class File;
+
+namespace media {
+
+class BufferWriter;
+
+/// A buffer made of a chain of blocks. Small data, e.g. box headers, is
+/// copied into the chain, while large data, e.g. the data of media samples,
+/// is referenced without copying. The chain is written to a file with a single
+/// vectored write, without gathering the blocks in one buffer.
+class BufferChain {
+ public:
+  BufferChain();
+  ~BufferChain();
+
+  /// Append a copy of @a size bytes from @a buf. Consecutive copies are
+  /// gathered in one block.
+  void AppendArray(const uint8_t* buf, size_t size);
+  /// Append a copy of the data in @a buffer.
+  void AppendBuffer(const BufferWriter& buffer);
+  /// Append @a size bytes of @a data without copying them. The chain keeps a
+  /// reference to @a data, which must not be modified until the chain is
+  /// cleared.
+  void AppendSharedData(std::shared_ptr<const uint8_t> data, size_t size);
+  /// Append the blocks of @a chain. The referenced data is shared, not copied.
+  void AppendChain(const BufferChain& chain);
+
+  void Clear();
+  size_t Size() const { return size_; }
+
+  /// Copy the data of the chain to @a output, replacing its contents.
+  void CopyTo(std::vector<uint8_t>* output) const;
+
+  /// Write the chain to file. The chain will be cleared after writing.
+  /// @param file should not be NULL.
+  /// @return OK on success.
+  Status WriteToFile(File* file);
+
+ private:
+  struct Block {
+    // Null for the blocks copied in |copied_data|.
+    std::shared_ptr<const uint8_t> shared_data;
+    size_t shared_size = 0;
+    std::vector<uint8_t> copied_data;
+
+    const uint8_t* data() const {
+      return shared_data ? shared_data.get() : copied_data.data();
+    }
+    size_t size() const {
+      return shared_data ? shared_size : copied_data.size();
+    }
+  };
+
+  std::vector<Block> blocks_;
+  size_t size_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(BufferChain);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_BASE_BUFFER_CHAIN_H_
@@ -0,0 +1,90 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/base/buffer_chain.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <packager/file.h>
+#include <packager/file/file_closer.h>
+#include <packager/file/file_test_util.h>
+#include <packager/media/base/buffer_writer.h>
+#include <packager/status/status_test_util.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+const uint8_t kHeader[] = {1, 2, 3};
+const uint8_t kData[] = {10, 11, 12, 13, 14};
+
+std::shared_ptr<const uint8_t> SharedData() {
+  std::shared_ptr<uint8_t> data(new uint8_t[sizeof(kData)],
+                                std::default_delete<uint8_t[]>());
+  memcpy(data.get(), kData, sizeof(kData));
+  return data;
+}
+
+}  // namespace
+
+TEST(BufferChainTest, AppendAndCopy) {
+  std::shared_ptr<const uint8_t> data = SharedData();
+
+  BufferWriter writer;
+  writer.AppendArray(kHeader, sizeof(kHeader));
+  BufferChain chain;
+  chain.AppendBuffer(writer);
+  chain.AppendArray(kHeader, sizeof(kHeader));
+  chain.AppendSharedData(data, sizeof(kData));
+  chain.AppendSharedData(data, 0);
+  chain.AppendArray(kHeader, 1);
+  ASSERT_EQ(2 * sizeof(kHeader) + sizeof(kData) + 1, chain.Size());
+  // The data is referenced, not copied.
+  EXPECT_EQ(2, data.use_count());
+
+  std::vector<uint8_t> output;
+  chain.CopyTo(&output);
+  EXPECT_EQ(std::vector<uint8_t>({1, 2, 3, 1, 2, 3, 10, 11, 12, 13, 14, 1}),
+            output);
+
+  BufferChain other_chain;
+  other_chain.AppendChain(chain);
+  EXPECT_EQ(3, data.use_count());
+  other_chain.CopyTo(&output);
+  EXPECT_EQ(std::vector<uint8_t>({1, 2, 3, 1, 2, 3, 10, 11, 12, 13, 14, 1}),
+            output);
+
+  chain.Clear();
+  EXPECT_EQ(0u, chain.Size());
+  EXPECT_EQ(2, data.use_count());
+}
+
+TEST(BufferChainTest, WriteToFile) {
+  TempFile temp_file;
+
+  BufferChain chain;
+  chain.AppendArray(kHeader, sizeof(kHeader));
+  chain.AppendSharedData(SharedData(), sizeof(kData));
+  chain.AppendArray(kHeader, sizeof(kHeader));
+
+  std::unique_ptr<File, FileCloser> file(
+      File::Open(temp_file.path().c_str(), "w"));
+  ASSERT_TRUE(file);
+  ASSERT_OK(chain.WriteToFile(file.get()));
+  EXPECT_EQ(0u, chain.Size());
+  ASSERT_TRUE(file.release()->Close());
+
+  std::string contents;
+  ASSERT_TRUE(File::ReadFileToString(temp_file.path().c_str(), &contents));
+  EXPECT_EQ(std::string({1, 2, 3, 10, 11, 12, 13, 14, 1, 2, 3}), contents);
+}
+
+}  // namespace media
+}  // namespace shaka
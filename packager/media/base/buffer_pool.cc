@@ -0,0 +1,137 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/base/buffer_pool.h>
+
+#include <algorithm>
+#include <new>
+
+namespace shaka {
+namespace media {
+namespace {
+
+// Size classes go from 64 bytes, which fits a StreamData or a shared_ptr
+// control block, to 16 MiB, which fits the largest video frames.
+const size_t kMinBlockSizeLog2 = 6;
+const size_t kMaxBlockSizeLog2 = 24;
+const size_t kNumSizeClasses = kMaxBlockSizeLog2 - kMinBlockSizeLog2 + 1;
+// Limits the memory held by the free list of every size class.
+const size_t kMaxCachedBytesPerSizeClass = 8 << 20;
+
+size_t GetBlockSize(size_t size_class) {
+  return size_t{1} << (size_class + kMinBlockSizeLog2);
+}
+
+// Returns kNumSizeClasses if |size| is too large to be pooled.
+size_t GetSizeClass(size_t size) {
+  size_t size_class = 0;
+  while (size_class < kNumSizeClasses && GetBlockSize(size_class) < size)
+    ++size_class;
+  return size_class;
+}
+
+size_t GetMaxCachedBlocks(size_t size_class) {
+  return std::max<size_t>(
+      1, kMaxCachedBytesPerSizeClass / GetBlockSize(size_class));
+}
+
+// Returns a buffer to its pool when the last reference is dropped.
+class PooledBufferDeleter {
+ public:
+  PooledBufferDeleter(BufferPool* pool, size_t size)
+      : pool_(pool), size_(size) {}
+
+  void operator()(uint8_t* buffer) const { pool_->Release(buffer, size_); }
+
+ private:
+  BufferPool* pool_;
+  size_t size_;
+};
+
+}  // namespace
+
+// static
+BufferPool* BufferPool::GetInstance() {
+  static BufferPool* const instance = new BufferPool;
+  return instance;
+}
+
+BufferPool::BufferPool() {
+  for (size_t i = 0; i < kNumSizeClasses; ++i)
+    size_classes_.emplace_back(new SizeClass);
+}
+
+BufferPool::~BufferPool() {
+  for (auto& size_class : size_classes_) {
+    absl::MutexLock lock(&size_class->mutex);
+    for (void* block : size_class->free_blocks)
+      ::operator delete(block);
+  }
+}
+
+std::shared_ptr<uint8_t> BufferPool::Allocate(size_t size) {
+  return std::shared_ptr<uint8_t>(static_cast<uint8_t*>(AllocateRaw(size)),
+                                  PooledBufferDeleter(this, size),
+                                  BufferPoolAllocator<uint8_t>(this));
+}
+
+void* BufferPool::AllocateRaw(size_t size) {
+  ++num_allocations_;
+
+  const size_t size_class = GetSizeClass(size);
+  if (size_class == kNumSizeClasses) {
+    ++num_heap_allocations_;
+    return ::operator new(size);
+  }
+
+  SizeClass& pooled_blocks = *size_classes_[size_class];
+  {
+    absl::MutexLock lock(&pooled_blocks.mutex);
+    if (!pooled_blocks.free_blocks.empty()) {
+      void* block = pooled_blocks.free_blocks.back();
+      pooled_blocks.free_blocks.pop_back();
+      ++num_reused_;
+      --num_cached_buffers_;
+      cached_bytes_ -= GetBlockSize(size_class);
+      return block;
+    }
+  }
+  ++num_heap_allocations_;
+  return ::operator new(GetBlockSize(size_class));
+}
+
+void BufferPool::Release(void* block, size_t size) {
+  if (!block)
+    return;
+
+  const size_t size_class = GetSizeClass(size);
+  if (size_class < kNumSizeClasses) {
+    SizeClass& pooled_blocks = *size_classes_[size_class];
+    absl::MutexLock lock(&pooled_blocks.mutex);
+    if (pooled_blocks.free_blocks.size() < GetMaxCachedBlocks(size_class)) {
+      pooled_blocks.free_blocks.push_back(block);
+      ++num_cached_buffers_;
+      cached_bytes_ += GetBlockSize(size_class);
+      return;
+    }
+  }
+  ++num_heap_frees_;
+  ::operator delete(block);
+}
+
+BufferPoolStats BufferPool::GetStats() const {
+  BufferPoolStats stats;
+  stats.num_allocations = num_allocations_;
+  stats.num_reused = num_reused_;
+  stats.num_heap_allocations = num_heap_allocations_;
+  stats.num_heap_frees = num_heap_frees_;
+  stats.num_cached_buffers = num_cached_buffers_;
+  stats.cached_bytes = cached_bytes_;
+  return stats;
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,123 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_BASE_BUFFER_POOL_H_
+#define PACKAGER_MEDIA_BASE_BUFFER_POOL_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+
+#include <packager/macros/classes.h>
+
+namespace shaka {
+namespace media {
+
+/// Allocation counters of a BufferPool.
+struct BufferPoolStats {
+  /// Number of buffers handed out.
+  uint64_t num_allocations = 0;
+  /// Number of buffers handed out from the free lists, without touching the
+  /// heap.
+  uint64_t num_reused = 0;
+  /// Number of buffers allocated from the heap, either because the free list
+  /// of their size class was empty or because they are too large to pool.
+  uint64_t num_heap_allocations = 0;
+  /// Number of buffers returned to the heap because their free list was full
+  /// or they are too large to pool.
+  uint64_t num_heap_frees = 0;
+  /// Number of buffers currently in the free lists.
+  uint64_t num_cached_buffers = 0;
+  /// Total size of the buffers currently in the free lists.
+  uint64_t cached_bytes = 0;
+};
+
+/// A thread-safe pool of recycled buffers. Buffers are grouped in power of
+/// two size classes; a released buffer goes to the free list of its class,
+/// up to a limit per class, and the next allocation of that class takes it
+/// back instead of going to the heap. Buffers larger than the largest class
+/// are allocated from the heap directly.
+class BufferPool {
+ public:
+  /// @return the process-wide pool. It is never destroyed, so buffers can be
+  ///         released at any time, including during static destruction.
+  static BufferPool* GetInstance();
+
+  BufferPool();
+  ~BufferPool();
+
+  /// Allocate a buffer of at least @a size bytes, which goes back to the pool
+  /// when the last reference is dropped. The shared_ptr control block comes
+  /// from the pool too.
+  std::shared_ptr<uint8_t> Allocate(size_t size);
+
+  /// Allocate a raw block of at least @a size bytes, suitably aligned for any
+  /// object. It must be released with Release() and the same @a size.
+  void* AllocateRaw(size_t size);
+  void Release(void* block, size_t size);
+
+  BufferPoolStats GetStats() const;
+
+ private:
+  struct SizeClass {
+    absl::Mutex mutex;
+    std::vector<void*> free_blocks ABSL_GUARDED_BY(mutex);
+  };
+
+  std::vector<std::unique_ptr<SizeClass>> size_classes_;
+
+  std::atomic<uint64_t> num_allocations_{0};
+  std::atomic<uint64_t> num_reused_{0};
+  std::atomic<uint64_t> num_heap_allocations_{0};
+  std::atomic<uint64_t> num_heap_frees_{0};
+  std::atomic<uint64_t> num_cached_buffers_{0};
+  std::atomic<uint64_t> cached_bytes_{0};
+
+  DISALLOW_COPY_AND_ASSIGN(BufferPool);
+};
+
+/// A standard allocator backed by a BufferPool, e.g. for shared_ptr control
+/// blocks.
+template <class T>
+class BufferPoolAllocator {
+ public:
+  typedef T value_type;
+
+  /// @param pool is the pool to allocate from, the process-wide pool if NULL.
+  explicit BufferPoolAllocator(BufferPool* pool = nullptr)
+      : pool_(pool ? pool : BufferPool::GetInstance()) {}
+  template <class U>
+  BufferPoolAllocator(const BufferPoolAllocator<U>& other)
+      : pool_(other.pool()) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(pool_->AllocateRaw(n * sizeof(T)));
+  }
+  void deallocate(T* p, size_t n) { pool_->Release(p, n * sizeof(T)); }
+
+  BufferPool* pool() const { return pool_; }
+
+  template <class U>
+  bool operator==(const BufferPoolAllocator<U>& other) const {
+    return pool_ == other.pool();
+  }
+  template <class U>
+  bool operator!=(const BufferPoolAllocator<U>& other) const {
+    return pool_ != other.pool();
+  }
+
+ private:
+  BufferPool* pool_;
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_BASE_BUFFER_POOL_H_
@@ -0,0 +1,109 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/base/buffer_pool.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+const size_t kBufferSize = 1000;
+// Larger than the largest size class.
+const size_t kOversizedBufferSize = 32 << 20;
+const size_t kNumThreads = 4;
+const size_t kNumIterations = 1000;
+
+}  // namespace
+
+TEST(BufferPoolTest, ReusesReleasedBuffers) {
+  BufferPool pool;
+  std::shared_ptr<uint8_t> buffer = pool.Allocate(kBufferSize);
+  ASSERT_TRUE(buffer);
+  memset(buffer.get(), 0xAB, kBufferSize);
+  uint8_t* const address = buffer.get();
+  buffer.reset();
+
+  // The buffer and the shared_ptr control block are both cached.
+  BufferPoolStats stats = pool.GetStats();
+  EXPECT_EQ(2u, stats.num_allocations);
+  EXPECT_EQ(2u, stats.num_cached_buffers);
+  EXPECT_EQ(0u, stats.num_heap_frees);
+
+  // A buffer of the same size class reuses the released one.
+  buffer = pool.Allocate(kBufferSize - 1);
+  EXPECT_EQ(address, buffer.get());
+  stats = pool.GetStats();
+  EXPECT_EQ(2u, stats.num_reused);
+  EXPECT_EQ(0u, stats.num_cached_buffers);
+}
+
+TEST(BufferPoolTest, DoesNotMixSizeClasses) {
+  BufferPool pool;
+  void* small_block = pool.AllocateRaw(100);
+  pool.Release(small_block, 100);
+
+  void* large_block = pool.AllocateRaw(kBufferSize);
+  EXPECT_NE(small_block, large_block);
+  EXPECT_EQ(0u, pool.GetStats().num_reused);
+  pool.Release(large_block, kBufferSize);
+  EXPECT_EQ(2u, pool.GetStats().num_cached_buffers);
+}
+
+TEST(BufferPoolTest, DoesNotCacheOversizedBuffers) {
+  BufferPool pool;
+  pool.Allocate(kOversizedBufferSize).reset();
+
+  // Only the control block is cached.
+  const BufferPoolStats stats = pool.GetStats();
+  EXPECT_EQ(1u, stats.num_heap_frees);
+  EXPECT_EQ(1u, stats.num_cached_buffers);
+}
+
+TEST(BufferPoolTest, AllocatorWorksWithStandardContainers) {
+  BufferPool pool;
+  {
+    std::vector<int, BufferPoolAllocator<int>> values(
+        (BufferPoolAllocator<int>(&pool)));
+    for (int i = 0; i < 100; ++i)
+      values.push_back(i);
+    EXPECT_EQ(99, values.back());
+  }
+  const BufferPoolStats stats = pool.GetStats();
+  EXPECT_GT(stats.num_allocations, 0u);
+  EXPECT_EQ(stats.num_allocations,
+            stats.num_cached_buffers + stats.num_reused + stats.num_heap_frees);
+}
+
+TEST(BufferPoolTest, IsThreadSafe) {
+  BufferPool pool;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&pool, i]() {
+      for (size_t j = 0; j < kNumIterations; ++j) {
+        const size_t size = (i + 1) * (j % 64 + 1);
+        std::shared_ptr<uint8_t> buffer = pool.Allocate(size);
+        memset(buffer.get(), static_cast<int>(i), size);
+      }
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+
+  const BufferPoolStats stats = pool.GetStats();
+  // Every buffer and control block has been released.
+  EXPECT_EQ(2 * kNumThreads * kNumIterations, stats.num_allocations);
+  EXPECT_EQ(stats.num_heap_allocations,
+            stats.num_cached_buffers + stats.num_heap_frees);
+}
+
+}  // namespace media
+}  // namespace shaka
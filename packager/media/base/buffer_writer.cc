@@ -69,6 +69,12 @@ void BufferWriter::AppendBuffer(const BufferWriter& buffer) {
   buf_.insert(buf_.end(), buffer.buf_.begin(), buffer.buf_.end());
 }
 
+uint8_t* BufferWriter::Grow(size_t size) {
+  const size_t old_size = buf_.size();
+  buf_.resize(old_size + size);
+  return buf_.data() + old_size;
+}
+
 Status BufferWriter::WriteToFile(File* file) {
   DCHECK(file);
   DCHECK(!buf_.empty());
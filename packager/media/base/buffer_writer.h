@@ -53,6 +53,11 @@ class BufferWriter {
   void AppendArray(const uint8_t* buf, size_t size);
   void AppendBuffer(const BufferWriter& buffer);
 
+  /// Grow the buffer by @a size bytes, for the caller to fill in place.
+  /// @return A pointer to the new bytes. It is invalidated by the next change
+  ///         to the buffer.
+  uint8_t* Grow(size_t size);
+
   void Swap(BufferWriter* buffer) { buf_.swap(buffer->buf_); }
   void SwapBuffer(std::vector<uint8_t>* buffer) { buf_.swap(*buffer); }
 
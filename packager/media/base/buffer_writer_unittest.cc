@@ -6,6 +6,7 @@
 
 #include <packager/media/base/buffer_writer.h>
 
+#include <cstring>
 #include <filesystem>
 #include <limits>
 #include <memory>
@@ -152,6 +153,21 @@ TEST_F(BufferWriterTest, AppendBufferWriter) {
   ASSERT_NO_FATAL_FAILURE(ReadAndExpect(kuint32));
 }
 
+TEST_F(BufferWriterTest, Grow) {
+  writer_->AppendInt(kuint16);
+  uint8_t* data = writer_->Grow(sizeof(kuint8Array));
+  memcpy(data, kuint8Array, sizeof(kuint8Array));
+  ASSERT_EQ(sizeof(kuint16) + sizeof(kuint8Array), writer_->Size());
+
+  CreateReader();
+  ASSERT_NO_FATAL_FAILURE(ReadAndExpect(kuint16));
+  std::vector<uint8_t> data_read;
+  ASSERT_TRUE(reader_->ReadToVector(&data_read, sizeof(kuint8Array)));
+  EXPECT_EQ(std::vector<uint8_t>(std::begin(kuint8Array),
+                                 std::end(kuint8Array)),
+            data_read);
+}
+
 TEST_F(BufferWriterTest, Swap) {
   BufferWriter local_writer;
   local_writer.AppendInt(kuint16);
@@ -4,9 +4,15 @@
 
 #include <packager/media/base/byte_queue.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
 #include <absl/log/check.h>
 #include <absl/log/log.h>
 
+#include <packager/media/base/buffer_pool.h>
+
 namespace shaka {
 namespace media {
 
@@ -14,11 +20,11 @@ namespace media {
 enum { kDefaultQueueSize = 1024 };
 
 ByteQueue::ByteQueue()
-    : buffer_(new uint8_t[kDefaultQueueSize]),
+    : buffer_(BufferPool::GetInstance()->Allocate(kDefaultQueueSize)),
       size_(kDefaultQueueSize),
       offset_(0),
-      used_(0) {
-}
+      used_(0),
+      shared_end_(0) {}
 
 ByteQueue::~ByteQueue() {}
 
@@ -32,25 +38,30 @@ void ByteQueue::Push(const uint8_t* data, int size) {
 
   size_t size_needed = used_ + size;
 
-  // Check to see if we need a bigger buffer.
-  if (size_needed > size_) {
-    size_t new_size = 2 * size_;
-    while (size_needed > new_size && new_size > size_)
+  // Check to see if we need a bigger buffer, or new storage because the data
+  // would have to be moved within a shared buffer.
+  const size_t tail = offset_ + used_;
+  const bool can_append_in_place = tail + size <= size_ && CanWriteFrom(tail);
+  if (size_needed > size_ || (!can_append_in_place && !CanWriteFrom(0))) {
+    size_t new_size = size_;
+    while (size_needed > new_size) {
       new_size *= 2;
+      // Sanity check to make sure we didn't overflow.
+      CHECK_GT(new_size, size_);
+    }
 
-    // Sanity check to make sure we didn't overflow.
-    CHECK_GT(new_size, size_);
-
-    std::unique_ptr<uint8_t[]> new_buffer(new uint8_t[new_size]);
+    std::shared_ptr<uint8_t> new_buffer =
+        BufferPool::GetInstance()->Allocate(new_size);
 
     // Copy the data from the old buffer to the start of the new one.
     if (used_ > 0)
       memcpy(new_buffer.get(), front(), used_);
 
-    buffer_.reset(new_buffer.release());
+    buffer_ = std::move(new_buffer);
     size_ = new_size;
     offset_ = 0;
-  } else if ((offset_ + used_ + size) > size_) {
+    shared_end_ = 0;
+  } else if (!can_append_in_place) {
     // The buffer is big enough, but we need to move the data in the queue.
     memmove(buffer_.get(), front(), used_);
     offset_ = 0;
@@ -80,6 +91,37 @@ void ByteQueue::Pop(int count) {
   }
 }
 
+std::shared_ptr<uint8_t> ByteQueue::Share(const uint8_t* data, int size) {
+  DCHECK_GE(data, front());
+  DCHECK_LE(data + size, front() + used_);
+  const size_t begin = static_cast<size_t>(data - buffer_.get());
+  if (!CanWriteFrom(begin)) {
+    // The slice may overlap with a slice shared before, which its holder is
+    // allowed to modify. Give it its own copy instead.
+    std::shared_ptr<uint8_t> copy = BufferPool::GetInstance()->Allocate(size);
+    memcpy(copy.get(), data, size);
+    return copy;
+  }
+  shared_end_ = begin + size;
+  // Each slice has its own owner, so that its holder can tell whether it holds
+  // the only reference to it. The owner keeps the whole storage alive.
+  std::shared_ptr<uint8_t> storage = buffer_;
+  return std::shared_ptr<uint8_t>(const_cast<uint8_t*>(data),
+                                  [storage](uint8_t*) {});
+}
+
+bool ByteQueue::CanWriteFrom(size_t offset) {
+  if (offset >= shared_end_)
+    return true;
+  if (buffer_.use_count() > 1)
+    return false;
+  // All the shared slices have been released, possibly on other threads.
+  // Make sure their last accesses happen before the storage is reused.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  shared_end_ = 0;
+  return true;
+}
+
 uint8_t* ByteQueue::front() const {
   return buffer_.get() + offset_;
 }
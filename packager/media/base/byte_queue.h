@@ -18,6 +18,12 @@ namespace media {
 /// The contents of the queue can be observed via the Peek() method. This class
 /// manages the underlying storage of the queue and tries to minimize the
 /// number of buffer copies when data is appended and removed.
+///
+/// Slices of the queue can be shared with Share(), e.g. so that samples can
+/// reference the input data instead of copying it. The queue never modifies
+/// the bytes of its storage while they are shared; it moves on to new storage
+/// instead. Slices never overlap, so the holder of the only reference to a
+/// slice may modify it, e.g. to encrypt a sample in place.
 class ByteQueue {
  public:
   ByteQueue();
@@ -37,11 +43,24 @@ class ByteQueue {
   /// @param count specifies number of bytes to be popped.
   void Pop(int count);
 
+  /// Share a slice of the queue.
+  /// @param data points to the first byte of the slice. It must have been
+  ///        returned by Peek() since the last Push() or Pop() call.
+  /// @param size is the size of the slice, which must be in the queue.
+  /// @return A reference to @a data which keeps the slice alive and unchanged
+  ///         by the queue for as long as it is held. Its holder may modify
+  ///         the slice, so its bytes must not be read from the queue again.
+  ///         A slice which overlaps with one shared before is copied.
+  std::shared_ptr<uint8_t> Share(const uint8_t* data, int size);
+
  private:
   // Returns a pointer to the front of the queue.
   uint8_t* front() const;
 
-  std::unique_ptr<uint8_t[]> buffer_;
+  // Returns true if the bytes of |buffer_| from |offset| may be modified.
+  bool CanWriteFrom(size_t offset);
+
+  std::shared_ptr<uint8_t> buffer_;
 
   // Size of |buffer_|.
   size_t size_;
@@ -52,6 +71,9 @@ class ByteQueue {
   // Number of bytes stored in the queue.
   int used_;
 
+  // End offset of the slices of |buffer_| handed out by Share().
+  size_t shared_end_;
+
   DISALLOW_COPY_AND_ASSIGN(ByteQueue);
 };
 
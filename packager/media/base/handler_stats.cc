@@ -0,0 +1,133 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/base/handler_stats.h>
+
+#include <algorithm>
+
+#include <absl/log/check.h>
+#include <absl/numeric/bits.h>
+
+#include <packager/media/base/media_handler.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+// The time measured by the timers nested in the innermost timer of the
+// thread.
+thread_local int64_t g_nested_time_ns = 0;
+
+// Buckets 0 to 3 hold 0 to 3 ns. Above, bucket 4 * e + i holds the times
+// from (4 + i) * 2^(e - 2) to (5 + i) * 2^(e - 2) ns, where e is the exponent
+// of the time.
+int GetLatencyBucket(uint64_t time_ns) {
+  if (time_ns < 4)
+    return static_cast<int>(time_ns);
+  const int exponent = absl::bit_width(time_ns) - 1;
+  return exponent * 4 + static_cast<int>((time_ns >> (exponent - 2)) & 3);
+}
+
+uint64_t GetLatencyBucketLowerBound(int bucket) {
+  const int exponent = bucket / 4;
+  if (exponent < 2)
+    return bucket;
+  return static_cast<uint64_t>(4 + bucket % 4) << (exponent - 2);
+}
+
+}  // namespace
+
+HandlerStats::ScopedTimer::ScopedTimer(HandlerStats* stats,
+                                       bool record_latency)
+    : stats_(stats), record_latency_(record_latency) {
+  if (!stats_)
+    return;
+  enclosing_nested_time_ns_ = g_nested_time_ns;
+  g_nested_time_ns = 0;
+  start_ = std::chrono::steady_clock::now();
+}
+
+HandlerStats::ScopedTimer::~ScopedTimer() {
+  if (!stats_)
+    return;
+  const int64_t time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - start_)
+                              .count();
+  // The nested timers were all in scope, so their time is included.
+  stats_->AddProcessingTime(time_ns - g_nested_time_ns, record_latency_);
+  g_nested_time_ns = enclosing_nested_time_ns_ + time_ns;
+}
+
+void HandlerStats::OnStreamData(const StreamData& stream_data) {
+  num_stream_data_.fetch_add(1, std::memory_order_relaxed);
+  switch (stream_data.stream_data_type) {
+    case StreamDataType::kMediaSample:
+      num_samples_.fetch_add(1, std::memory_order_relaxed);
+      num_bytes_.fetch_add(stream_data.media_sample->data_size(),
+                           std::memory_order_relaxed);
+      break;
+    case StreamDataType::kTextSample:
+      num_samples_.fetch_add(1, std::memory_order_relaxed);
+      break;
+    default:
+      break;
+  }
+}
+
+void HandlerStats::SetQueueDepth(uint64_t queue_depth) {
+  queue_depth_.store(queue_depth, std::memory_order_relaxed);
+  uint64_t max_queue_depth = max_queue_depth_.load(std::memory_order_relaxed);
+  while (queue_depth > max_queue_depth &&
+         !max_queue_depth_.compare_exchange_weak(max_queue_depth, queue_depth,
+                                                 std::memory_order_relaxed)) {
+  }
+}
+
+void HandlerStats::GetStats(MediaHandlerStats* stats) const {
+  stats->num_stream_data = num_stream_data_.load(std::memory_order_relaxed);
+  stats->num_samples = num_samples_.load(std::memory_order_relaxed);
+  stats->num_bytes = num_bytes_.load(std::memory_order_relaxed);
+  stats->processing_time_ns =
+      processing_time_ns_.load(std::memory_order_relaxed);
+  stats->p50_processing_time_ns = GetLatencyPercentile(0.5);
+  stats->p99_processing_time_ns = GetLatencyPercentile(0.99);
+  stats->queue_depth = queue_depth_.load(std::memory_order_relaxed);
+  stats->max_queue_depth = max_queue_depth_.load(std::memory_order_relaxed);
+}
+
+void HandlerStats::AddProcessingTime(int64_t time_ns, bool record_latency) {
+  DCHECK_GE(time_ns, 0);
+  processing_time_ns_.fetch_add(time_ns, std::memory_order_relaxed);
+  if (record_latency) {
+    latency_buckets_[GetLatencyBucket(time_ns)].fetch_add(
+        1, std::memory_order_relaxed);
+  }
+}
+
+uint64_t HandlerStats::GetLatencyPercentile(double percentile) const {
+  uint64_t counts[kNumLatencyBuckets];
+  uint64_t total_count = 0;
+  for (int i = 0; i < kNumLatencyBuckets; ++i) {
+    counts[i] = latency_buckets_[i].load(std::memory_order_relaxed);
+    total_count += counts[i];
+  }
+  if (total_count == 0)
+    return 0;
+
+  // The rank of the percentile, from 1 to |total_count|.
+  const uint64_t rank = std::max<uint64_t>(
+      1, static_cast<uint64_t>(percentile * total_count + 0.5));
+  uint64_t count = 0;
+  for (int i = 0; i < kNumLatencyBuckets; ++i) {
+    count += counts[i];
+    if (count >= rank)
+      return GetLatencyBucketLowerBound(i);
+  }
+  return GetLatencyBucketLowerBound(kNumLatencyBuckets - 1);
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,79 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_BASE_HANDLER_STATS_H_
+#define PACKAGER_MEDIA_BASE_HANDLER_STATS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include <packager/macros/classes.h>
+#include <packager/packager_stats.h>
+
+namespace shaka {
+namespace media {
+
+struct StreamData;
+
+/// Statistics of a MediaHandler, updated by MediaHandler as stream data go
+/// through it, and read at any time from another thread.
+class HandlerStats {
+ public:
+  /// Measures the time spent by a handler while in scope, excluding the time
+  /// measured by the timers created in its scope on the same thread, i.e. the
+  /// time spent in the downstream handlers it calls.
+  class ScopedTimer {
+   public:
+    /// @param stats receives the time. Nothing is measured if it is null.
+    /// @param record_latency is true if the scope is a single call, whose
+    ///        time goes to the percentiles too.
+    ScopedTimer(HandlerStats* stats, bool record_latency);
+    ~ScopedTimer();
+
+   private:
+    HandlerStats* const stats_;
+    const bool record_latency_;
+    std::chrono::steady_clock::time_point start_;
+    // The time measured by the enclosing timer's nested timers so far.
+    int64_t enclosing_nested_time_ns_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedTimer);
+  };
+
+  HandlerStats() = default;
+
+  /// Counts @a stream_data, received by the handler.
+  void OnStreamData(const StreamData& stream_data);
+
+  /// Updates the number of stream data queued by the handler.
+  void SetQueueDepth(uint64_t queue_depth);
+
+  /// Fills the counters of @a stats.
+  void GetStats(MediaHandlerStats* stats) const;
+
+ private:
+  // Four buckets per power of two, up to 2^63 ns.
+  static constexpr int kNumLatencyBuckets = 64 * 4;
+
+  void AddProcessingTime(int64_t time_ns, bool record_latency);
+  uint64_t GetLatencyPercentile(double percentile) const;
+
+  std::atomic<uint64_t> num_stream_data_{0};
+  std::atomic<uint64_t> num_samples_{0};
+  std::atomic<uint64_t> num_bytes_{0};
+  std::atomic<uint64_t> processing_time_ns_{0};
+  std::atomic<uint64_t> queue_depth_{0};
+  std::atomic<uint64_t> max_queue_depth_{0};
+  std::atomic<uint64_t> latency_buckets_[kNumLatencyBuckets] = {};
+
+  DISALLOW_COPY_AND_ASSIGN(HandlerStats);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_BASE_HANDLER_STATS_H_
@@ -0,0 +1,117 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/base/handler_stats.h>
+
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <packager/media/base/media_handler.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+const uint8_t kData[] = {1, 2, 3, 4, 5};
+const auto kSleepTime = std::chrono::milliseconds(20);
+const uint64_t kSleepTimeNs = 20000000;
+
+}  // namespace
+
+TEST(HandlerStatsTest, CountsStreamData) {
+  HandlerStats stats;
+  stats.OnStreamData(*StreamData::FromMediaSample(
+      0, MediaSample::CopyFrom(kData, sizeof(kData), true)));
+  stats.OnStreamData(*StreamData::FromSegmentInfo(
+      0, std::make_shared<SegmentInfo>()));
+
+  MediaHandlerStats handler_stats;
+  stats.GetStats(&handler_stats);
+  EXPECT_EQ(2u, handler_stats.num_stream_data);
+  EXPECT_EQ(1u, handler_stats.num_samples);
+  EXPECT_EQ(sizeof(kData), handler_stats.num_bytes);
+  EXPECT_EQ(0u, handler_stats.processing_time_ns);
+  EXPECT_EQ(0u, handler_stats.p50_processing_time_ns);
+}
+
+TEST(HandlerStatsTest, ExcludesNestedTime) {
+  HandlerStats upstream_stats;
+  HandlerStats downstream_stats;
+  {
+    HandlerStats::ScopedTimer upstream_timer(&upstream_stats, true);
+    HandlerStats::ScopedTimer downstream_timer(&downstream_stats, true);
+    std::this_thread::sleep_for(kSleepTime);
+  }
+
+  MediaHandlerStats upstream;
+  upstream_stats.GetStats(&upstream);
+  MediaHandlerStats downstream;
+  downstream_stats.GetStats(&downstream);
+  EXPECT_GE(downstream.processing_time_ns, kSleepTimeNs);
+  EXPECT_LT(upstream.processing_time_ns, kSleepTimeNs / 2);
+  // With a single call, the percentiles are the lower bound of its bucket.
+  EXPECT_LE(downstream.p50_processing_time_ns,
+            downstream.processing_time_ns);
+  EXPECT_GT(downstream.p50_processing_time_ns,
+            downstream.processing_time_ns * 3 / 4);
+  EXPECT_EQ(downstream.p50_processing_time_ns,
+            downstream.p99_processing_time_ns);
+}
+
+TEST(HandlerStatsTest, Percentiles) {
+  HandlerStats stats;
+  // 99 fast calls and a slow one.
+  for (int i = 0; i < 99; ++i)
+    HandlerStats::ScopedTimer timer(&stats, true);
+  {
+    HandlerStats::ScopedTimer timer(&stats, true);
+    std::this_thread::sleep_for(kSleepTime);
+  }
+
+  MediaHandlerStats handler_stats;
+  stats.GetStats(&handler_stats);
+  EXPECT_LT(handler_stats.p50_processing_time_ns, kSleepTimeNs / 2);
+  EXPECT_LT(handler_stats.p99_processing_time_ns, kSleepTimeNs / 2);
+
+  // One more slow call moves the 99th percentile.
+  {
+    HandlerStats::ScopedTimer timer(&stats, true);
+    std::this_thread::sleep_for(kSleepTime);
+  }
+  stats.GetStats(&handler_stats);
+  EXPECT_LT(handler_stats.p50_processing_time_ns, kSleepTimeNs / 2);
+  EXPECT_GT(handler_stats.p99_processing_time_ns, kSleepTimeNs * 3 / 4);
+}
+
+TEST(HandlerStatsTest, RunTimeNotInPercentiles) {
+  HandlerStats stats;
+  {
+    HandlerStats::ScopedTimer timer(&stats, false);
+    std::this_thread::sleep_for(kSleepTime);
+  }
+
+  MediaHandlerStats handler_stats;
+  stats.GetStats(&handler_stats);
+  EXPECT_GE(handler_stats.processing_time_ns, kSleepTimeNs);
+  EXPECT_EQ(0u, handler_stats.p99_processing_time_ns);
+}
+
+TEST(HandlerStatsTest, QueueDepth) {
+  HandlerStats stats;
+  stats.SetQueueDepth(3);
+  stats.SetQueueDepth(5);
+  stats.SetQueueDepth(2);
+
+  MediaHandlerStats handler_stats;
+  stats.GetStats(&handler_stats);
+  EXPECT_EQ(2u, handler_stats.queue_depth);
+  EXPECT_EQ(5u, handler_stats.max_queue_depth);
+}
+
+}  // namespace media
+}  // namespace shaka
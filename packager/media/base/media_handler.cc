@@ -6,11 +6,29 @@
 
 #include <packager/media/base/media_handler.h>
 
+#include <cstdlib>
+#include <typeinfo>
+
+#if defined(__GNUC__)
+#include <cxxabi.h>
+#endif
+
 #include <packager/macros/status.h>
+#include <packager/media/base/buffer_pool.h>
 
 namespace shaka {
 namespace media {
 
+// static
+void* StreamData::operator new(size_t size) {
+  return BufferPool::GetInstance()->AllocateRaw(size);
+}
+
+// static
+void StreamData::operator delete(void* ptr, size_t size) {
+  BufferPool::GetInstance()->Release(ptr, size);
+}
+
 std::string StreamDataTypeToString(StreamDataType type) {
   switch (type) {
     case StreamDataType::kStreamInfo:
@@ -80,6 +98,51 @@ Status MediaHandler::Chain(
   return Status::OK;
 }
 
+void MediaHandler::EnableStats() {
+  if (stats_)
+    return;
+  stats_.reset(new HandlerStats);
+  for (auto& pair : output_handlers_)
+    pair.second.first->EnableStats();
+}
+
+void MediaHandler::GetStats(const std::string& id,
+                            std::vector<MediaHandlerStats>* stats) const {
+  if (!stats_)
+    return;
+  MediaHandlerStats handler_stats;
+  handler_stats.id = id;
+  handler_stats.type = GetTypeName();
+  stats_->GetStats(&handler_stats);
+  stats->push_back(std::move(handler_stats));
+
+  for (const auto& pair : output_handlers_) {
+    const MediaHandler& handler = *pair.second.first;
+    std::string handler_id = id + "/" + handler.GetTypeName();
+    if (output_handlers_.size() > 1)
+      handler_id += "[" + std::to_string(pair.first) + "]";
+    handler.GetStats(handler_id, stats);
+  }
+}
+
+std::string MediaHandler::GetTypeName() const {
+  const char* name = typeid(*this).name();
+  std::string type_name;
+#if defined(__GNUC__)
+  int status = 0;
+  char* demangled_name = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+  if (status == 0 && demangled_name)
+    type_name = demangled_name;
+  free(demangled_name);
+#endif
+  // Without demangling, the name is already readable, e.g. with MSVC.
+  if (type_name.empty())
+    type_name = name;
+  // Drop the namespaces, and the "class " prefix of MSVC.
+  const size_t pos = type_name.find_last_of(": ");
+  return pos == std::string::npos ? type_name : type_name.substr(pos + 1);
+}
+
 Status MediaHandler::OnFlushRequest(size_t input_stream_index) {
   // The default implementation treats the output stream index to be identical
   // to the input stream index, which is true for most handlers.
@@ -99,7 +162,11 @@ Status MediaHandler::Dispatch(std::unique_ptr<StreamData> stream_data) const {
                   "No output handler exist at the specified index.");
   }
   stream_data->stream_index = handler_it->second.second;
-  return handler_it->second.first->Process(std::move(stream_data));
+  MediaHandler* handler = handler_it->second.first.get();
+  if (handler->stats_)
+    handler->stats_->OnStreamData(*stream_data);
+  HandlerStats::ScopedTimer timer(handler->stats_.get(), true);
+  return handler->Process(std::move(stream_data));
 }
 
 Status MediaHandler::FlushDownstream(size_t output_stream_index) {
@@ -108,12 +175,16 @@ Status MediaHandler::FlushDownstream(size_t output_stream_index) {
     return Status(error::NOT_FOUND,
                   "No output handler exist at the specified index.");
   }
-  return handler_it->second.first->OnFlushRequest(handler_it->second.second);
+  MediaHandler* handler = handler_it->second.first.get();
+  HandlerStats::ScopedTimer timer(handler->stats_.get(), true);
+  return handler->OnFlushRequest(handler_it->second.second);
 }
 
 Status MediaHandler::FlushAllDownstreams() {
   for (const auto& pair : output_handlers_) {
-    Status status = pair.second.first->OnFlushRequest(pair.second.second);
+    MediaHandler* handler = pair.second.first.get();
+    HandlerStats::ScopedTimer timer(handler->stats_.get(), true);
+    Status status = handler->OnFlushRequest(pair.second.second);
     if (!status.ok()) {
       return status;
     }
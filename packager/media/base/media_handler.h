@@ -9,8 +9,11 @@
 
 #include <map>
 #include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
+#include <packager/media/base/handler_stats.h>
 #include <packager/media/base/media_sample.h>
 #include <packager/media/base/stream_info.h>
 #include <packager/media/base/text_sample.h>
@@ -78,6 +81,11 @@ struct StreamData {
   std::shared_ptr<const Scte35Event> scte35_event;
   std::shared_ptr<const CueEvent> cue_event;
 
+  // StreamData objects are created for every sample on every branch, so they
+  // are recycled through the BufferPool.
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr, size_t size);
+
   static std::unique_ptr<StreamData> FromStreamInfo(
       size_t stream_index,
       std::shared_ptr<const StreamInfo> stream_info) {
@@ -177,6 +185,24 @@ class MediaHandler {
 
   static Status Chain(const std::vector<std::shared_ptr<MediaHandler>>& list);
 
+  /// Collect statistics in the handler and the downstream handlers. It should
+  /// be called before running the graph.
+  void EnableStats();
+
+  /// Append the statistics of the handler and of the downstream handlers to
+  /// @a stats, if they are collected. It can be called from any thread.
+  /// @param id is the id of the handler, which prefixes the ids of the
+  ///        downstream handlers.
+  void GetStats(const std::string& id,
+                std::vector<MediaHandlerStats>* stats) const;
+
+  /// @return the statistics of the handler, or nullptr if they are not
+  ///         collected.
+  HandlerStats* stats() const { return stats_.get(); }
+
+  /// @return the name of the class of the handler, e.g. "EncryptionHandler".
+  std::string GetTypeName() const;
+
  protected:
   /// Internal implementation of initialize. Note that it should only initialize
   /// the MediaHandler itself. Downstream handlers are handled in Initialize().
@@ -273,6 +299,7 @@ class MediaHandler {
   // map.
   std::map<size_t, std::pair<std::shared_ptr<MediaHandler>, size_t>>
       output_handlers_;
+  std::unique_ptr<HandlerStats> stats_;
 };
 
 }  // namespace media
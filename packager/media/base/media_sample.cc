@@ -12,8 +12,21 @@
 #include <absl/log/log.h>
 #include <absl/strings/str_format.h>
 
+#include <packager/media/base/buffer_pool.h>
+
 namespace shaka {
 namespace media {
+namespace {
+
+// Takes ownership of |sample|, with a shared_ptr control block from the
+// BufferPool.
+std::shared_ptr<MediaSample> MakeShared(MediaSample* sample) {
+  return std::shared_ptr<MediaSample>(sample,
+                                      std::default_delete<MediaSample>(),
+                                      BufferPoolAllocator<MediaSample>());
+}
+
+}  // namespace
 
 MediaSample::MediaSample(const uint8_t* data,
                          size_t data_size,
@@ -27,8 +40,8 @@ MediaSample::MediaSample(const uint8_t* data,
 
   SetData(data, data_size);
   if (side_data) {
-    std::shared_ptr<uint8_t> shared_side_data(new uint8_t[side_data_size],
-                                              std::default_delete<uint8_t[]>());
+    std::shared_ptr<uint8_t> shared_side_data =
+        BufferPool::GetInstance()->Allocate(side_data_size);
     memcpy(shared_side_data.get(), side_data, side_data_size);
     side_data_ = std::move(shared_side_data);
     side_data_size_ = side_data_size;
@@ -39,13 +52,23 @@ MediaSample::MediaSample() {}
 
 MediaSample::~MediaSample() {}
 
+// static
+void* MediaSample::operator new(size_t size) {
+  return BufferPool::GetInstance()->AllocateRaw(size);
+}
+
+// static
+void MediaSample::operator delete(void* ptr, size_t size) {
+  BufferPool::GetInstance()->Release(ptr, size);
+}
+
 // static
 std::shared_ptr<MediaSample> MediaSample::CopyFrom(const uint8_t* data,
                                                    size_t data_size,
                                                    bool is_key_frame) {
   // If you hit this CHECK you likely have a bug in a demuxer. Go fix it.
   CHECK(data);
-  return std::shared_ptr<MediaSample>(
+  return MakeShared(
       new MediaSample(data, data_size, nullptr, 0u, is_key_frame));
 }
 
@@ -57,30 +80,29 @@ std::shared_ptr<MediaSample> MediaSample::CopyFrom(const uint8_t* data,
                                                    bool is_key_frame) {
   // If you hit this CHECK you likely have a bug in a demuxer. Go fix it.
   CHECK(data);
-  return std::shared_ptr<MediaSample>(new MediaSample(
-      data, data_size, side_data, side_data_size, is_key_frame));
+  return MakeShared(new MediaSample(data, data_size, side_data,
+                                    side_data_size, is_key_frame));
 }
 
 // static
 std::shared_ptr<MediaSample> MediaSample::FromMetadata(const uint8_t* metadata,
                                                        size_t metadata_size) {
-  return std::shared_ptr<MediaSample>(
+  return MakeShared(
       new MediaSample(nullptr, 0, metadata, metadata_size, false));
 }
 
 // static
 std::shared_ptr<MediaSample> MediaSample::CreateEmptyMediaSample() {
-  return std::shared_ptr<MediaSample>(new MediaSample);
+  return MakeShared(new MediaSample);
 }
 
 // static
 std::shared_ptr<MediaSample> MediaSample::CreateEOSBuffer() {
-  return std::shared_ptr<MediaSample>(
-      new MediaSample(nullptr, 0, nullptr, 0, false));
+  return MakeShared(new MediaSample(nullptr, 0, nullptr, 0, false));
 }
 
 std::shared_ptr<MediaSample> MediaSample::Clone() const {
-  std::shared_ptr<MediaSample> new_media_sample(new MediaSample);
+  std::shared_ptr<MediaSample> new_media_sample = MakeShared(new MediaSample);
   new_media_sample->dts_ = dts_;
   new_media_sample->pts_ = pts_;
   new_media_sample->duration_ = duration_;
@@ -108,8 +130,8 @@ void MediaSample::TransferData(std::shared_ptr<uint8_t> data,
 }
 
 void MediaSample::SetData(const uint8_t* data, size_t data_size) {
-  std::shared_ptr<uint8_t> shared_data(new uint8_t[data_size],
-                                       std::default_delete<uint8_t[]>());
+  std::shared_ptr<uint8_t> shared_data =
+      BufferPool::GetInstance()->Allocate(data_size);
   memcpy(shared_data.get(), data, data_size);
   TransferData(std::move(shared_data), data_size);
 }
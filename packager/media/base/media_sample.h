@@ -67,6 +67,10 @@ class MediaSample {
 
   virtual ~MediaSample();
 
+  /// MediaSample objects are recycled through the BufferPool.
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr, size_t size);
+
   /// Clone the object and return a new MediaSample.
   std::shared_ptr<MediaSample> Clone() const;
 
@@ -76,7 +80,7 @@ class MediaSample {
   void TransferData(std::shared_ptr<uint8_t> data, size_t data_size);
 
   /// Set the data in this media sample. Note that this method involves data
-  /// copying.
+  /// copying, into a buffer from the BufferPool.
   /// @param data points to the data to be copied.
   /// @param data_size is the size of the data to be copied.
   void SetData(const uint8_t* data, size_t data_size);
@@ -127,6 +131,28 @@ class MediaSample {
     return data_size_;
   }
 
+  /// @return a reference to the sample data, to keep it without copying it.
+  ///         The sample does not have exclusive data while it is held.
+  std::shared_ptr<const uint8_t> shared_data() const {
+    DCHECK(!end_of_stream());
+    return data_;
+  }
+
+  /// @return a writable pointer to the sample data. It can only be used when
+  ///         the data is not shared with other samples, see
+  ///         has_exclusive_data().
+  uint8_t* writable_data() {
+    DCHECK(!end_of_stream());
+    DCHECK(has_exclusive_data());
+    // The data is always allocated as non-const, by SetData() or by the owner
+    // of TransferData(), so it is fine to write to it.
+    return const_cast<uint8_t*>(data_.get());
+  }
+
+  /// @return true if this sample is the only owner of its data, i.e. the data
+  ///         is not shared with clones of this sample.
+  bool has_exclusive_data() const { return data_.use_count() == 1; }
+
   const uint8_t* side_data() const { return side_data_.get(); }
 
   size_t side_data_size() const { return side_data_size_; }
@@ -50,6 +50,11 @@ void OffsetByteQueue::PeekAt(int64_t offset, const uint8_t** buf, int* size) {
   *size = tail() - offset;
 }
 
+std::shared_ptr<uint8_t> OffsetByteQueue::Share(const uint8_t* buf,
+                                                int size) {
+  return queue_.Share(buf, size);
+}
+
 bool OffsetByteQueue::Trim(int64_t max_offset) {
   if (max_offset < head_) return true;
   if (max_offset > tail()) {
@@ -6,6 +6,7 @@
 #define PACKAGER_MEDIA_BASE_OFFSET_BYTE_QUEUE_H_
 
 #include <cstdint>
+#include <memory>
 
 #include <packager/macros/classes.h>
 #include <packager/media/base/byte_queue.h>
@@ -38,6 +39,10 @@ class OffsetByteQueue {
   /// a null @a buf and a @a size of zero.
   void PeekAt(int64_t offset, const uint8_t** buf, int* size);
 
+  /// Works like ByteQueue::Share(). @a buf must have been returned by Peek()
+  /// or PeekAt() since the last Push(), Pop() or Trim() call.
+  std::shared_ptr<uint8_t> Share(const uint8_t* buf, int size);
+
   /// Mark the bytes up to (but not including) @a max_offset as ready for
   /// deletion. This is relatively inexpensive, but will not necessarily reduce
   /// the resident buffer size right away (or ever).
@@ -7,6 +7,7 @@
 #include <cstdint>
 #include <cstring>
 #include <memory>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -91,5 +92,80 @@ TEST_F(OffsetByteQueueTest, Trim) {
   EXPECT_TRUE(queue_->Trim(512));
 }
 
+TEST_F(OffsetByteQueueTest, ShareAppendsInPlace) {
+  const uint8_t* head;
+  int size;
+  queue_->Peek(&head, &size);
+  std::shared_ptr<uint8_t> slice = queue_->Share(head, size);
+  EXPECT_EQ(head, slice.get());
+
+  const uint8_t kData[16] = {};
+  queue_->Push(kData, sizeof(kData));
+
+  // There is room after the tail, so the data has not been moved.
+  const uint8_t* buf;
+  queue_->PeekAt(384, &buf, &size);
+  EXPECT_EQ(head, buf);
+  EXPECT_EQ(128 + 16, size);
+}
+
+TEST_F(OffsetByteQueueTest, ShareKeepsSliceUnchanged) {
+  const uint8_t* buf;
+  int size;
+  queue_->PeekAt(400, &buf, &size);
+  std::shared_ptr<uint8_t> slice = queue_->Share(buf, 16);
+
+  // Pushing more data than there is room for after the tail would move the
+  // data, and overwrite the shared slice.
+  EXPECT_TRUE(queue_->Trim(512));
+  std::vector<uint8_t> data(1000, 0xFF);
+  queue_->Push(data.data(), static_cast<int>(data.size()));
+  // Writing from the start of the buffer again would overwrite it too.
+  queue_->Reset();
+  queue_->Push(data.data(), static_cast<int>(data.size()));
+
+  for (int i = 0; i < 16; i++)
+    EXPECT_EQ(400 - 256 + i, slice.get()[i]);
+  queue_->Peek(&buf, &size);
+  EXPECT_EQ(1000, size);
+  EXPECT_EQ(0xFF, buf[0]);
+}
+
+TEST_F(OffsetByteQueueTest, SharedSlicesAreIndependent) {
+  const uint8_t* buf;
+  int size;
+  queue_->PeekAt(400, &buf, &size);
+  std::shared_ptr<uint8_t> slice = queue_->Share(buf, 16);
+  std::shared_ptr<uint8_t> next_slice = queue_->Share(buf + 16, 16);
+
+  // Each slice has its own reference, which is not shared with the queue.
+  EXPECT_EQ(1, slice.use_count());
+  EXPECT_EQ(buf, slice.get());
+  EXPECT_EQ(1, next_slice.use_count());
+  EXPECT_EQ(buf + 16, next_slice.get());
+
+  // The holder of a slice may modify it.
+  memset(slice.get(), 0xFF, 16);
+  EXPECT_EQ(400 - 256 + 16, next_slice.get()[0]);
+}
+
+TEST_F(OffsetByteQueueTest, OverlappingSliceIsCopied) {
+  const uint8_t* buf;
+  int size;
+  queue_->PeekAt(400, &buf, &size);
+  std::shared_ptr<uint8_t> slice = queue_->Share(buf, 16);
+  std::shared_ptr<uint8_t> overlapping_slice = queue_->Share(buf + 8, 16);
+
+  EXPECT_NE(buf + 8, overlapping_slice.get());
+  EXPECT_EQ(1, overlapping_slice.use_count());
+  memset(slice.get(), 0xFF, 16);
+  for (int i = 0; i < 16; i++)
+    EXPECT_EQ(400 - 256 + 8 + i, overlapping_slice.get()[i]);
+
+  // Once the earlier slice is released, the bytes can be shared again.
+  slice.reset();
+  EXPECT_EQ(buf, queue_->Share(buf, 16).get());
+}
+
 }  // namespace media
 }  // namespace shaka
@@ -0,0 +1,190 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/base/prefetching_key_source.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include <absl/log/check.h>
+#include <absl/log/log.h>
+
+namespace shaka {
+namespace media {
+
+PrefetchingKeySource::PrefetchingKeySource(
+    std::unique_ptr<KeySource> key_source,
+    uint32_t lookahead)
+    : key_source_(std::move(key_source)),
+      lookahead_(lookahead),
+      fetch_thread_(&PrefetchingKeySource::FetchThread, this) {
+  DCHECK(key_source_);
+}
+
+PrefetchingKeySource::~PrefetchingKeySource() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stopped_ = true;
+    fetch_requested_.Signal();
+  }
+  fetch_thread_.join();
+}
+
+Status PrefetchingKeySource::FetchKeys(EmeInitDataType init_data_type,
+                                       const std::vector<uint8_t>& init_data) {
+  absl::MutexLock lock(&key_source_mutex_);
+  return key_source_->FetchKeys(init_data_type, init_data);
+}
+
+Status PrefetchingKeySource::GetKey(const std::string& stream_label,
+                                    EncryptionKey* key) {
+  absl::MutexLock lock(&key_source_mutex_);
+  return key_source_->GetKey(stream_label, key);
+}
+
+Status PrefetchingKeySource::GetKey(const std::vector<uint8_t>& key_id,
+                                    EncryptionKey* key) {
+  absl::MutexLock lock(&key_source_mutex_);
+  return key_source_->GetKey(key_id, key);
+}
+
+Status PrefetchingKeySource::GetCryptoPeriodKey(
+    uint32_t crypto_period_index,
+    int32_t crypto_period_duration_in_seconds,
+    const std::string& stream_label,
+    EncryptionKey* key) {
+  DCHECK(key);
+  const KeyIndex key_index(stream_label, crypto_period_index);
+
+  absl::MutexLock lock(&mutex_);
+  crypto_period_duration_in_seconds_ = crypto_period_duration_in_seconds;
+  ++stats_.num_requests;
+
+  const bool prefetched = keys_.find(key_index) != keys_.end();
+  std::shared_ptr<CryptoPeriodKey> crypto_period_key =
+      ScheduleFetch(key_index, true);
+  for (uint32_t i = 1; i <= lookahead_; ++i)
+    ScheduleFetch(KeyIndex(stream_label, crypto_period_index + i), false);
+  fetch_requested_.Signal();
+
+  // Drop the keys of the periods that are over. Keep the last few in case
+  // several streams share the label and some of them lag behind. Keys not
+  // fetched yet may still be waited for.
+  for (auto iter = keys_.begin(); iter != keys_.end();) {
+    if (iter->first.first == stream_label &&
+        iter->first.second + lookahead_ < crypto_period_index &&
+        iter->second->fetched) {
+      iter = keys_.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+
+  if (!crypto_period_key->fetched) {
+    ++stats_.num_waits;
+    const auto start = std::chrono::steady_clock::now();
+    while (!crypto_period_key->fetched)
+      key_fetched_.Wait(&mutex_);
+    stats_.wait_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+  }
+
+  if (!crypto_period_key->status.ok() && prefetched) {
+    // The failure may have been transient, and prefetching should not make
+    // key rotation less reliable, so try again before giving up.
+    LOG(WARNING) << "Failed to prefetch the key of crypto period "
+                 << crypto_period_index << " for '" << stream_label
+                 << "': " << crypto_period_key->status << ". Retrying.";
+    const auto start = std::chrono::steady_clock::now();
+    Status status;
+    EncryptionKey fetched_key;
+    mutex_.Unlock();
+    {
+      absl::MutexLock key_source_lock(&key_source_mutex_);
+      status = key_source_->GetCryptoPeriodKey(
+          crypto_period_index, crypto_period_duration_in_seconds, stream_label,
+          &fetched_key);
+    }
+    mutex_.Lock();
+    ++stats_.num_waits;
+    stats_.wait_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    crypto_period_key->status = status;
+    crypto_period_key->key = fetched_key;
+  }
+
+  if (!crypto_period_key->status.ok())
+    return crypto_period_key->status;
+  *key = crypto_period_key->key;
+  return Status::OK;
+}
+
+KeyPrefetchStats PrefetchingKeySource::GetStats() const {
+  absl::MutexLock lock(&mutex_);
+  return stats_;
+}
+
+std::shared_ptr<PrefetchingKeySource::CryptoPeriodKey>
+PrefetchingKeySource::ScheduleFetch(const KeyIndex& key_index, bool needed) {
+  std::shared_ptr<CryptoPeriodKey>& crypto_period_key = keys_[key_index];
+  if (!crypto_period_key) {
+    crypto_period_key = std::make_shared<CryptoPeriodKey>();
+    if (needed)
+      fetch_queue_.push_front(key_index);
+    else
+      fetch_queue_.push_back(key_index);
+    return crypto_period_key;
+  }
+  if (needed && !crypto_period_key->fetching && !crypto_period_key->fetched) {
+    auto iter = std::find(fetch_queue_.begin(), fetch_queue_.end(), key_index);
+    DCHECK(iter != fetch_queue_.end());
+    fetch_queue_.erase(iter);
+    fetch_queue_.push_front(key_index);
+  }
+  return crypto_period_key;
+}
+
+void PrefetchingKeySource::FetchThread() {
+  absl::MutexLock lock(&mutex_);
+  while (true) {
+    while (!stopped_ && fetch_queue_.empty())
+      fetch_requested_.Wait(&mutex_);
+    if (stopped_)
+      return;
+
+    const KeyIndex key_index = fetch_queue_.front();
+    fetch_queue_.pop_front();
+    auto iter = keys_.find(key_index);
+    // The key may have been fetched and dropped since it was scheduled.
+    if (iter == keys_.end() || iter->second->fetching)
+      continue;
+    std::shared_ptr<CryptoPeriodKey> crypto_period_key = iter->second;
+    crypto_period_key->fetching = true;
+    const int32_t crypto_period_duration_in_seconds =
+        crypto_period_duration_in_seconds_;
+
+    Status status;
+    EncryptionKey key;
+    mutex_.Unlock();
+    {
+      absl::MutexLock key_source_lock(&key_source_mutex_);
+      status = key_source_->GetCryptoPeriodKey(
+          key_index.second, crypto_period_duration_in_seconds, key_index.first,
+          &key);
+    }
+    mutex_.Lock();
+
+    crypto_period_key->status = status;
+    crypto_period_key->key = key;
+    crypto_period_key->fetched = true;
+    key_fetched_.SignalAll();
+  }
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,115 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_BASE_PREFETCHING_KEY_SOURCE_H_
+#define PACKAGER_MEDIA_BASE_PREFETCHING_KEY_SOURCE_H_
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+
+#include <packager/macros/classes.h>
+#include <packager/media/base/key_source.h>
+
+namespace shaka {
+namespace media {
+
+/// Statistics of the crypto period keys requested from a
+/// PrefetchingKeySource.
+struct KeyPrefetchStats {
+  /// Number of crypto period keys requested.
+  uint64_t num_requests = 0;
+  /// Number of those which were not prefetched yet, i.e. the caller waited.
+  uint64_t num_waits = 0;
+  /// Total time the callers waited for keys.
+  uint64_t wait_time_ns = 0;
+};
+
+/// A KeySource decorator which fetches the keys of the next crypto periods in
+/// the background, so that the encryptors are not blocked by a key server
+/// round trip at every crypto period boundary.
+///
+/// When the key of crypto period N is requested for a stream label, the keys
+/// of periods N+1 to N+lookahead are fetched for the same label on a
+/// background thread. All the calls to the decorated key source are
+/// serialized, so it does not need to be thread safe.
+class PrefetchingKeySource : public KeySource {
+ public:
+  /// @param key_source is the decorated key source.
+  /// @param lookahead is the number of crypto periods whose keys are fetched
+  ///        ahead of the latest requested one.
+  PrefetchingKeySource(std::unique_ptr<KeySource> key_source,
+                       uint32_t lookahead);
+  ~PrefetchingKeySource() override;
+
+  /// @name KeySource implementation overrides.
+  /// @{
+  Status FetchKeys(EmeInitDataType init_data_type,
+                   const std::vector<uint8_t>& init_data) override;
+  Status GetKey(const std::string& stream_label, EncryptionKey* key) override;
+  Status GetKey(const std::vector<uint8_t>& key_id,
+                EncryptionKey* key) override;
+  Status GetCryptoPeriodKey(uint32_t crypto_period_index,
+                            int32_t crypto_period_duration_in_seconds,
+                            const std::string& stream_label,
+                            EncryptionKey* key) override;
+  /// @}
+
+  /// @return The statistics of the calls to GetCryptoPeriodKey() so far.
+  KeyPrefetchStats GetStats() const;
+
+ private:
+  // Stream label and crypto period index.
+  using KeyIndex = std::pair<std::string, uint32_t>;
+
+  struct CryptoPeriodKey {
+    // Set when the fetch thread takes it out of |fetch_queue_|.
+    bool fetching = false;
+    bool fetched = false;
+    Status status;
+    EncryptionKey key;
+  };
+
+  // Schedules the fetching of a key, unless it is already scheduled. A key
+  // which is needed right away is fetched before the prefetched ones.
+  std::shared_ptr<CryptoPeriodKey> ScheduleFetch(const KeyIndex& key_index,
+                                                 bool needed)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void FetchThread();
+
+  const std::unique_ptr<KeySource> key_source_;
+  const uint32_t lookahead_;
+
+  // Serializes the calls to |key_source_|.
+  absl::Mutex key_source_mutex_;
+
+  mutable absl::Mutex mutex_;
+  absl::CondVar fetch_requested_;
+  absl::CondVar key_fetched_;
+  std::map<KeyIndex, std::shared_ptr<CryptoPeriodKey>> keys_
+      ABSL_GUARDED_BY(mutex_);
+  // Keys to fetch, in order.
+  std::deque<KeyIndex> fetch_queue_ ABSL_GUARDED_BY(mutex_);
+  int32_t crypto_period_duration_in_seconds_ ABSL_GUARDED_BY(mutex_) = 0;
+  KeyPrefetchStats stats_ ABSL_GUARDED_BY(mutex_);
+  bool stopped_ ABSL_GUARDED_BY(mutex_) = false;
+
+  std::thread fetch_thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(PrefetchingKeySource);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_BASE_PREFETCHING_KEY_SOURCE_H_
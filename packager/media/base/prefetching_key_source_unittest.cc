@@ -0,0 +1,149 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/base/prefetching_key_source.h>
+
+#include <map>
+#include <set>
+
+#include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
+#include <gtest/gtest.h>
+
+#include <packager/status/status_test_util.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+const char kStreamLabel[] = "SD";
+const int32_t kCryptoPeriodDurationInSeconds = 10;
+const uint32_t kLookahead = 2;
+
+// Returns a key made of the crypto period index, and records the calls.
+class FakeKeySource : public KeySource {
+ public:
+  Status FetchKeys(EmeInitDataType init_data_type,
+                   const std::vector<uint8_t>& init_data) override {
+    return Status::OK;
+  }
+  Status GetKey(const std::string& stream_label, EncryptionKey* key) override {
+    return Status(error::UNIMPLEMENTED, "");
+  }
+  Status GetKey(const std::vector<uint8_t>& key_id,
+                EncryptionKey* key) override {
+    return Status(error::UNIMPLEMENTED, "");
+  }
+  Status GetCryptoPeriodKey(uint32_t crypto_period_index,
+                            int32_t crypto_period_duration_in_seconds,
+                            const std::string& stream_label,
+                            EncryptionKey* key) override {
+    absl::MutexLock lock(&mutex_);
+    EXPECT_EQ(kCryptoPeriodDurationInSeconds,
+              crypto_period_duration_in_seconds);
+    EXPECT_EQ(kStreamLabel, stream_label);
+    ++num_calls_[crypto_period_index];
+    if (failures_.erase(crypto_period_index) > 0)
+      return Status(error::SERVER_ERROR, "Key server failure.");
+    key->key_id.assign(1, static_cast<uint8_t>(crypto_period_index));
+    return Status::OK;
+  }
+
+  // Makes the next fetch of the key of |crypto_period_index| fail.
+  void FailNextFetch(uint32_t crypto_period_index) {
+    absl::MutexLock lock(&mutex_);
+    failures_.insert(crypto_period_index);
+  }
+
+  // Waits until the key of |crypto_period_index| has been fetched.
+  bool WaitForFetch(uint32_t crypto_period_index) {
+    auto fetched = [this, crypto_period_index]() {
+      mutex_.AssertHeld();
+      return num_calls_.count(crypto_period_index) > 0;
+    };
+    absl::MutexLock lock(&mutex_);
+    return mutex_.AwaitWithTimeout(absl::Condition(&fetched),
+                                   absl::Seconds(10));
+  }
+
+  int num_calls(uint32_t crypto_period_index) {
+    absl::MutexLock lock(&mutex_);
+    auto iter = num_calls_.find(crypto_period_index);
+    return iter == num_calls_.end() ? 0 : iter->second;
+  }
+
+ private:
+  absl::Mutex mutex_;
+  std::map<uint32_t, int> num_calls_;
+  std::set<uint32_t> failures_;
+};
+
+}  // namespace
+
+class PrefetchingKeySourceTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    fake_key_source_ = new FakeKeySource;
+    key_source_.reset(new PrefetchingKeySource(
+        std::unique_ptr<KeySource>(fake_key_source_), kLookahead));
+  }
+
+  Status GetCryptoPeriodKey(uint32_t crypto_period_index, EncryptionKey* key) {
+    return key_source_->GetCryptoPeriodKey(
+        crypto_period_index, kCryptoPeriodDurationInSeconds, kStreamLabel, key);
+  }
+
+  FakeKeySource* fake_key_source_;
+  std::unique_ptr<PrefetchingKeySource> key_source_;
+};
+
+TEST_F(PrefetchingKeySourceTest, PrefetchesNextCryptoPeriodKeys) {
+  EncryptionKey key;
+  ASSERT_OK(GetCryptoPeriodKey(5, &key));
+  EXPECT_EQ(std::vector<uint8_t>({5}), key.key_id);
+
+  // The keys are fetched in order, so once the key of the next period is
+  // being fetched, the key of the current one is available.
+  ASSERT_TRUE(fake_key_source_->WaitForFetch(7));
+  ASSERT_OK(GetCryptoPeriodKey(6, &key));
+  EXPECT_EQ(std::vector<uint8_t>({6}), key.key_id);
+  ASSERT_TRUE(fake_key_source_->WaitForFetch(8));
+  ASSERT_OK(GetCryptoPeriodKey(7, &key));
+  EXPECT_EQ(std::vector<uint8_t>({7}), key.key_id);
+  ASSERT_TRUE(fake_key_source_->WaitForFetch(9));
+
+  // Only the first key was waited for.
+  KeyPrefetchStats stats = key_source_->GetStats();
+  EXPECT_EQ(3u, stats.num_requests);
+  EXPECT_EQ(1u, stats.num_waits);
+  EXPECT_GT(stats.wait_time_ns, 0u);
+
+  for (uint32_t index = 5; index <= 9; ++index)
+    EXPECT_EQ(1, fake_key_source_->num_calls(index));
+  EXPECT_EQ(0, fake_key_source_->num_calls(10));
+}
+
+TEST_F(PrefetchingKeySourceTest, RetriesFailedPrefetch) {
+  fake_key_source_->FailNextFetch(1);
+
+  EncryptionKey key;
+  ASSERT_OK(GetCryptoPeriodKey(0, &key));
+  ASSERT_TRUE(fake_key_source_->WaitForFetch(1));
+  ASSERT_OK(GetCryptoPeriodKey(1, &key));
+  EXPECT_EQ(std::vector<uint8_t>({1}), key.key_id);
+  EXPECT_EQ(2, fake_key_source_->num_calls(1));
+}
+
+TEST_F(PrefetchingKeySourceTest, ReturnsFetchError) {
+  fake_key_source_->FailNextFetch(0);
+
+  EncryptionKey key;
+  EXPECT_EQ(error::SERVER_ERROR, GetCryptoPeriodKey(0, &key).error_code());
+  EXPECT_EQ(1, fake_key_source_->num_calls(0));
+}
+
+}  // namespace media
+}  // namespace shaka
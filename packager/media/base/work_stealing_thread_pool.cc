@@ -0,0 +1,131 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/base/work_stealing_thread_pool.h>
+
+#include <algorithm>
+
+#include <absl/log/check.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+// The pool and worker index of the calling thread, if it is a worker.
+thread_local const WorkStealingThreadPool* g_current_pool = nullptr;
+thread_local size_t g_current_worker_index = 0;
+
+}  // namespace
+
+WorkStealingThreadPool::WorkStealingThreadPool(size_t num_threads) {
+  DCHECK_GT(num_threads, 0u);
+  num_threads = std::max<size_t>(num_threads, 1);
+
+  // All the queues must exist before any worker starts stealing.
+  for (size_t i = 0; i < num_threads; ++i)
+    workers_.emplace_back(new Worker);
+  for (size_t i = 0; i < num_threads; ++i) {
+    workers_[i]->thread =
+        std::thread(&WorkStealingThreadPool::ThreadMain, this, i);
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stopping_ = true;
+    task_available_.SignalAll();
+  }
+  for (auto& worker : workers_)
+    worker->thread.join();
+}
+
+void WorkStealingThreadPool::PostTask(Task task) {
+  DCHECK(task);
+
+  absl::MutexLock lock(&mutex_);
+  DCHECK(!stopping_) << "Should not post tasks to a pool being destroyed.";
+
+  size_t worker_index;
+  if (IsWorkerThread()) {
+    worker_index = g_current_worker_index;
+  } else {
+    worker_index = next_worker_;
+    next_worker_ = (next_worker_ + 1) % workers_.size();
+  }
+  {
+    Worker& worker = *workers_[worker_index];
+    absl::MutexLock worker_lock(&worker.mutex);
+    worker.tasks.push_back(std::move(task));
+  }
+  ++num_queued_tasks_;
+  task_available_.Signal();
+}
+
+void WorkStealingThreadPool::WaitForIdle() {
+  DCHECK(!IsWorkerThread()) << "A worker cannot wait for itself.";
+
+  absl::MutexLock lock(&mutex_);
+  while (num_queued_tasks_ > 0 || num_running_tasks_ > 0)
+    idle_.Wait(&mutex_);
+}
+
+bool WorkStealingThreadPool::IsWorkerThread() const {
+  return g_current_pool == this;
+}
+
+void WorkStealingThreadPool::ThreadMain(size_t worker_index) {
+  g_current_pool = this;
+  g_current_worker_index = worker_index;
+
+  while (true) {
+    {
+      absl::MutexLock lock(&mutex_);
+      while (num_queued_tasks_ == 0 && !stopping_)
+        task_available_.Wait(&mutex_);
+      // Pending tasks are still run when stopping.
+      if (num_queued_tasks_ == 0)
+        break;
+      --num_queued_tasks_;
+      ++num_running_tasks_;
+    }
+
+    TakeTask(worker_index)();
+
+    absl::MutexLock lock(&mutex_);
+    --num_running_tasks_;
+    if (num_queued_tasks_ == 0 && num_running_tasks_ == 0)
+      idle_.SignalAll();
+  }
+
+  g_current_pool = nullptr;
+}
+
+WorkStealingThreadPool::Task WorkStealingThreadPool::TakeTask(
+    size_t worker_index) {
+  // Every task is pushed to a queue before it is counted in
+  // |num_queued_tasks_|, so the task reserved by the caller is in one of the
+  // queues.
+  for (size_t i = 0;; i = (i + 1) % workers_.size()) {
+    Worker& worker = *workers_[(worker_index + i) % workers_.size()];
+    absl::MutexLock lock(&worker.mutex);
+    if (worker.tasks.empty())
+      continue;
+
+    Task task;
+    if (i == 0) {
+      task = std::move(worker.tasks.front());
+      worker.tasks.pop_front();
+    } else {
+      task = std::move(worker.tasks.back());
+      worker.tasks.pop_back();
+    }
+    return task;
+  }
+}
+
+}  // namespace media
+}  // namespace shaka
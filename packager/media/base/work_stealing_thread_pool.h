@@ -0,0 +1,83 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_BASE_WORK_STEALING_THREAD_POOL_H_
+#define PACKAGER_MEDIA_BASE_WORK_STEALING_THREAD_POOL_H_
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+
+#include <packager/macros/classes.h>
+
+namespace shaka {
+namespace media {
+
+/// A fixed size thread pool where every worker owns a task queue. Tasks
+/// posted from a worker go to its own queue, which keeps a pipeline branch on
+/// the same core while it has work; tasks posted from other threads are
+/// spread over the workers. An idle worker steals from the back of the other
+/// queues.
+class WorkStealingThreadPool {
+ public:
+  typedef std::function<void()> Task;
+
+  /// @param num_threads is the number of worker threads, at least 1.
+  explicit WorkStealingThreadPool(size_t num_threads);
+
+  /// Runs the tasks which are still pending, then joins the workers.
+  ~WorkStealingThreadPool();
+
+  /// Queue |task| to be run by one of the workers. Tasks posted by the same
+  /// thread are not guaranteed to run in order.
+  void PostTask(Task task);
+
+  /// Block until all the posted tasks, including the tasks they post, have
+  /// completed.
+  void WaitForIdle();
+
+  /// @return true if the calling thread is one of the workers of this pool.
+  bool IsWorkerThread() const;
+
+  size_t num_threads() const { return workers_.size(); }
+
+ private:
+  struct Worker {
+    absl::Mutex mutex;
+    std::deque<Task> tasks ABSL_GUARDED_BY(mutex);
+    std::thread thread;
+  };
+
+  void ThreadMain(size_t worker_index);
+  // Pops a task from the front of the queue of |worker_index|, or steals one
+  // from the back of another queue. The caller must have reserved a task
+  // through |num_queued_tasks_|, so this never fails.
+  Task TakeTask(size_t worker_index);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  absl::Mutex mutex_;
+  absl::CondVar task_available_ ABSL_GUARDED_BY(mutex_);
+  absl::CondVar idle_ ABSL_GUARDED_BY(mutex_);
+  // Tasks sitting in a worker queue, not yet picked by any worker.
+  size_t num_queued_tasks_ ABSL_GUARDED_BY(mutex_) = 0;
+  size_t num_running_tasks_ ABSL_GUARDED_BY(mutex_) = 0;
+  // The worker receiving the next task posted from outside the pool.
+  size_t next_worker_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool stopping_ ABSL_GUARDED_BY(mutex_) = false;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingThreadPool);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_BASE_WORK_STEALING_THREAD_POOL_H_
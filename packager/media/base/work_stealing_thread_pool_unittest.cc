@@ -0,0 +1,87 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/base/work_stealing_thread_pool.h>
+
+#include <atomic>
+
+#include <absl/synchronization/blocking_counter.h>
+#include <absl/synchronization/notification.h>
+#include <absl/time/time.h>
+#include <gtest/gtest.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+const size_t kNumThreads = 4;
+const size_t kNumTasks = 1000;
+const absl::Duration kTimeout = absl::Seconds(10);
+
+}  // namespace
+
+TEST(WorkStealingThreadPoolTest, RunsAllTasks) {
+  std::atomic<size_t> num_tasks_run(0);
+  WorkStealingThreadPool pool(kNumThreads);
+  EXPECT_EQ(kNumThreads, pool.num_threads());
+
+  for (size_t i = 0; i < kNumTasks; ++i)
+    pool.PostTask([&num_tasks_run]() { ++num_tasks_run; });
+  pool.WaitForIdle();
+  EXPECT_EQ(kNumTasks, num_tasks_run);
+}
+
+TEST(WorkStealingThreadPoolTest, WaitsForNestedTasks) {
+  std::atomic<size_t> num_tasks_run(0);
+  WorkStealingThreadPool pool(kNumThreads);
+
+  pool.PostTask([&pool, &num_tasks_run]() {
+    EXPECT_TRUE(pool.IsWorkerThread());
+    for (size_t i = 0; i < kNumTasks; ++i)
+      pool.PostTask([&num_tasks_run]() { ++num_tasks_run; });
+  });
+  pool.WaitForIdle();
+  EXPECT_EQ(kNumTasks, num_tasks_run);
+  EXPECT_FALSE(pool.IsWorkerThread());
+}
+
+TEST(WorkStealingThreadPoolTest, IdleWorkersStealTasks) {
+  WorkStealingThreadPool pool(kNumThreads);
+
+  // The tasks are posted to the queue of the worker running the outer task,
+  // which then blocks until all of them run concurrently. This only completes
+  // if the other workers steal them.
+  const size_t kNumStolenTasks = kNumThreads - 1;
+  absl::BlockingCounter all_running(kNumStolenTasks);
+  absl::Notification release;
+  absl::Notification done;
+  pool.PostTask([&]() {
+    for (size_t i = 0; i < kNumStolenTasks; ++i) {
+      pool.PostTask([&]() {
+        all_running.DecrementCount();
+        release.WaitForNotificationWithTimeout(kTimeout);
+      });
+    }
+    all_running.Wait();
+    release.Notify();
+    done.Notify();
+  });
+  EXPECT_TRUE(done.WaitForNotificationWithTimeout(kTimeout));
+  pool.WaitForIdle();
+}
+
+TEST(WorkStealingThreadPoolTest, RunsPendingTasksOnDestruction) {
+  std::atomic<size_t> num_tasks_run(0);
+  {
+    WorkStealingThreadPool pool(1);
+    for (size_t i = 0; i < kNumTasks; ++i)
+      pool.PostTask([&num_tasks_run]() { ++num_tasks_run; });
+  }
+  EXPECT_EQ(kNumTasks, num_tasks_run);
+}
+
+}  // namespace media
+}  // namespace shaka
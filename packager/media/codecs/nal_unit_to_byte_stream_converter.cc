@@ -6,6 +6,7 @@
 
 #include <packager/media/codecs/nal_unit_to_byte_stream_converter.h>
 
+#include <cstring>
 #include <list>
 
 #include <absl/log/check.h>
@@ -16,6 +17,7 @@
 #include <packager/media/base/buffer_reader.h>
 #include <packager/media/base/buffer_writer.h>
 #include <packager/media/codecs/nalu_reader.h>
+#include <packager/media/codecs/zero_byte_pair_finder.h>
 
 namespace shaka {
 namespace media {
@@ -63,38 +65,34 @@ void AddAccessUnitDelimiter(BufferWriter* buffer_writer) {
 void EscapeNalByteSequence(const uint8_t* input,
                            size_t input_size,
                            BufferWriter* output_writer) {
-  // Keep track of consecutive zeros that it has seen (not including the current
-  // byte), so that the algorithm doesn't need to go back to check the same
-  // bytes.
-  int consecutive_zero_count = 0;
-  for (size_t i = 0; i < input_size; ++i) {
-    if (consecutive_zero_count <= 1) {
-      output_writer->AppendInt(input[i]);
-    } else if (consecutive_zero_count == 2) {
-      if (input[i] == 0 || input[i] == 1 || input[i] == 2 || input[i] == 3) {
-        // Must be escaped.
-        output_writer->AppendInt(kEmulationPreventionByte);
-      }
-
-      output_writer->AppendInt(input[i]);
-      // Note that input[i] can be 0.
-      // 00 00 00 00 00 00 should become
-      // 00 00 03 00 00 03 00 00 03
-      // So consecutive_zero_count is reset here and incremented below if
-      // input[i] is 0.
-      consecutive_zero_count = 0;
+  // Copies the bytes between the escaped sequences in bulk. Only pairs of zero
+  // bytes, which are rare, need a closer look.
+  size_t copied = 0;
+  size_t position = 0;
+  while (true) {
+    position = FindZeroBytePair(input, position, input_size);
+    if (position + 2 >= input_size)
+      break;
+    if (input[position + 2] > 3) {
+      position += 3;
+      continue;
     }
-
-    consecutive_zero_count = input[i] == 0 ? consecutive_zero_count + 1 : 0;
+    // Must be escaped.
+    output_writer->AppendArray(input + copied, position + 2 - copied);
+    output_writer->AppendInt(kEmulationPreventionByte);
+    // Note that input[position + 2] can be 0.
+    // 00 00 00 00 00 00 should become
+    // 00 00 03 00 00 03 00 00 03
+    // So the search restarts at the byte after the emulation prevention byte.
+    copied = position + 2;
+    position = copied;
   }
+  output_writer->AppendArray(input + copied, input_size - copied);
 
   // ISO 14496-10 Section 7.4.1.1 mentions that if the last byte is 0 (which
   // only happens if RBSP has cabac_zero_word), 0x03 must be appended.
-  if (consecutive_zero_count > 0) {
-    DCHECK_GT(input_size, 0u);
-    DCHECK_EQ(input[input_size - 1], 0u);
+  if (input_size > 0 && input[input_size - 1] == 0)
     output_writer->AppendInt(kEmulationPreventionByte);
-  }
 }
 
 // This functions creates a new subsample entry (|clear_bytes|, |cipher_bytes|)
@@ -9,6 +9,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <packager/media/base/buffer_writer.h>
 #include <packager/media/base/media_sample.h>
 #include <packager/media/formats/mp4/box_definitions_comparison.h>
 
@@ -1054,5 +1055,55 @@ TEST(NalUnitToByteStreamConverterTest,
   EXPECT_EQ(kExpectedOutputSubsamples, subsamples);
 }
 
+TEST(NalUnitToByteStreamConverterTest, EscapeRunOfZeros) {
+  const uint8_t kZeros[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+  BufferWriter writer;
+  EscapeNalByteSequence(kZeros, std::size(kZeros), &writer);
+
+  const uint8_t kExpectedOutput[] = {
+      0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03,
+  };
+  EXPECT_EQ(std::vector<uint8_t>(kExpectedOutput,
+                                 kExpectedOutput + std::size(kExpectedOutput)),
+            std::vector<uint8_t>(writer.Buffer(),
+                                 writer.Buffer() + writer.Size()));
+}
+
+// Checks the bulk escaping against a byte by byte implementation, with
+// escaped sequences around the block boundaries of the zero pair search.
+TEST(NalUnitToByteStreamConverterTest, EscapeMatchesByteByByteEscape) {
+  const size_t kMaxDataSize = 100;
+  std::vector<uint8_t> data(kMaxDataSize);
+  uint32_t random_state = 1;
+  for (size_t iteration = 0; iteration < 20000; ++iteration) {
+    const size_t data_size = iteration % kMaxDataSize;
+    for (uint8_t& byte : data) {
+      random_state = random_state * 1103515245 + 12345;
+      const uint8_t value = static_cast<uint8_t>(random_state >> 16);
+      // Mostly zeros and bytes that need escaping after two zeros.
+      byte = iteration % 2 == 0 ? value % 6 : (value < 16 ? 0 : value);
+    }
+
+    std::vector<uint8_t> expected;
+    int consecutive_zero_count = 0;
+    for (size_t i = 0; i < data_size; ++i) {
+      if (consecutive_zero_count == 2 && data[i] <= 3) {
+        expected.push_back(0x03);
+        consecutive_zero_count = 0;
+      }
+      expected.push_back(data[i]);
+      consecutive_zero_count = data[i] == 0 ? consecutive_zero_count + 1 : 0;
+    }
+    if (consecutive_zero_count > 0)
+      expected.push_back(0x03);
+
+    BufferWriter writer;
+    EscapeNalByteSequence(data.data(), data_size, &writer);
+    ASSERT_EQ(expected, std::vector<uint8_t>(writer.Buffer(),
+                                             writer.Buffer() + writer.Size()))
+        << "iteration " << iteration;
+  }
+}
+
 }  // namespace media
 }  // namespace shaka
@@ -14,6 +14,7 @@
 #include <packager/macros/logging.h>
 #include <packager/media/base/buffer_reader.h>
 #include <packager/media/codecs/h264_parser.h>
+#include <packager/media/codecs/zero_byte_pair_finder.h>
 
 namespace shaka {
 namespace media {
@@ -23,6 +24,22 @@ inline bool IsStartCode(const uint8_t* data) {
   return data[0] == 0x00 && data[1] == 0x00 && data[2] == 0x01;
 }
 
+// Returns the position of the first three-byte start code in |data|, or
+// |data_size| if there is none.
+uint64_t ScanForStartCode(const uint8_t* data, uint64_t data_size) {
+  uint64_t position = 0;
+  while (true) {
+    position = FindZeroBytePair(data, position, data_size);
+    if (position + 2 >= data_size)
+      return data_size;
+    const uint8_t third_byte = data[position + 2];
+    if (third_byte == 1)
+      return position;
+    // 00 00 00 may still be followed by a start code at the next position.
+    position += third_byte == 0 ? 1 : 3;
+  }
+}
+
 // Edits |subsamples| given the number of consumed bytes.
 void UpdateSubsamples(uint64_t consumed_bytes,
                       std::vector<SubsampleEntry>* subsamples) {
@@ -316,31 +333,25 @@ bool NaluReader::FindStartCode(const uint8_t* data,
                                uint64_t data_size,
                                uint64_t* offset,
                                uint8_t* start_code_size) {
-  uint64_t bytes_left = data_size;
-
-  while (bytes_left >= 3) {
-    if (IsStartCode(data)) {
-      // Found three-byte start code, set pointer at its beginning.
-      *offset = data_size - bytes_left;
-      *start_code_size = 3;
-
-      // If there is a zero byte before this start code,
-      // then it's actually a four-byte start code, so backtrack one byte.
-      if (*offset > 0 && *(data - 1) == 0x00) {
-        --(*offset);
-        ++(*start_code_size);
-      }
-
-      return true;
+  const uint64_t position = ScanForStartCode(data, data_size);
+  if (position < data_size) {
+    // Found three-byte start code, set pointer at its beginning.
+    *offset = position;
+    *start_code_size = 3;
+
+    // If there is a zero byte before this start code,
+    // then it's actually a four-byte start code, so backtrack one byte.
+    if (position > 0 && data[position - 1] == 0x00) {
+      --(*offset);
+      ++(*start_code_size);
     }
 
-    ++data;
-    --bytes_left;
+    return true;
   }
 
   // End of data: offset is pointing to the first byte that was not considered
   // as a possible start of a start code.
-  *offset = data_size - bytes_left;
+  *offset = data_size >= 3 ? data_size - 2 : 0;
   *start_code_size = 0;
   return false;
 }
@@ -0,0 +1,95 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// Benchmarks for the NALU start code search over H.264 and H.265 byte streams
+// and transport streams from the test data, and over random data without
+// start codes, and for reading the NAL units of an H.264 byte stream.
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <packager/media/codecs/nalu_reader.h>
+#include <packager/media/test/test_data_util.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+const size_t kRandomDataSize = 1024 * 1024;
+
+// Random bytes without zeros, the best case.
+std::vector<uint8_t> GetRandomData() {
+  std::vector<uint8_t> random_data(kRandomDataSize);
+  uint32_t random_state = 1;
+  for (uint8_t& byte : random_data) {
+    random_state = random_state * 1103515245 + 12345;
+    byte = static_cast<uint8_t>(random_state >> 16) | 0x80;
+  }
+  return random_data;
+}
+
+void FindAllStartCodes(benchmark::State& state,
+                       const std::vector<uint8_t>& data) {
+  if (data.empty()) {
+    state.SkipWithError("Test data not found.");
+    return;
+  }
+
+  size_t num_start_codes = 0;
+  for (auto _ : state) {
+    num_start_codes = 0;
+    const uint8_t* position = data.data();
+    uint64_t bytes_left = data.size();
+    uint64_t offset = 0;
+    uint8_t start_code_size = 0;
+    while (NaluReader::FindStartCode(position, bytes_left, &offset,
+                                     &start_code_size)) {
+      ++num_start_codes;
+      position += offset + start_code_size;
+      bytes_left -= offset + start_code_size;
+    }
+    benchmark::DoNotOptimize(num_start_codes);
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+  state.counters["start_codes"] = num_start_codes;
+}
+
+void BM_FindStartCode(benchmark::State& state, const char* file_name) {
+  FindAllStartCodes(state, ReadTestDataFile(file_name));
+}
+
+void BM_FindStartCodeInRandomData(benchmark::State& state) {
+  FindAllStartCodes(state, GetRandomData());
+}
+
+void BM_ReadH264Nalus(benchmark::State& state) {
+  const std::vector<uint8_t> data = ReadTestDataFile("bear.h264");
+  if (data.empty()) {
+    state.SkipWithError("Test data not found.");
+    return;
+  }
+
+  for (auto _ : state) {
+    NaluReader reader(Nalu::kH264, kIsAnnexbByteStream, data.data(),
+                      data.size());
+    Nalu nalu;
+    while (reader.Advance(&nalu) == NaluReader::kOk)
+      benchmark::DoNotOptimize(nalu.type());
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+BENCHMARK_CAPTURE(BM_FindStartCode, h264, "bear.h264");
+BENCHMARK_CAPTURE(BM_FindStartCode, h264_25fps, "test-25fps.h264");
+BENCHMARK_CAPTURE(BM_FindStartCode, ts, "bear-640x360.ts");
+BENCHMARK_CAPTURE(BM_FindStartCode, hevc_ts, "bear-640x360-hevc.ts");
+BENCHMARK(BM_FindStartCodeInRandomData);
+BENCHMARK(BM_ReadH264Nalus);
+
+}  // namespace
+}  // namespace media
+}  // namespace shaka
@@ -309,6 +309,54 @@ TEST(NaluReaderTest, SubsamplesWithInvalidNalu) {
   EXPECT_EQ(0x14, nalu.type());
 }
 
+// Checks the vectorized start code search against a byte by byte search, with
+// start codes and runs of zeros around the block boundaries.
+TEST(NaluReaderTest, FindStartCodeMatchesByteByByteSearch) {
+  const size_t kMaxDataSize = 100;
+  std::vector<uint8_t> data(kMaxDataSize);
+  uint32_t random_state = 1;
+  for (size_t iteration = 0; iteration < 20000; ++iteration) {
+    const size_t data_size = iteration % kMaxDataSize;
+    for (uint8_t& byte : data) {
+      random_state = random_state * 1103515245 + 12345;
+      const uint8_t value = static_cast<uint8_t>(random_state >> 16);
+      switch (iteration % 3) {
+        case 0:
+          // Many zeros and ones.
+          byte = value < 160 ? 0 : (value < 200 ? 1 : value);
+          break;
+        case 1:
+          // Few zeros, like coded slices.
+          byte = value < 8 ? 0 : (value < 12 ? 1 : value);
+          break;
+        default:
+          // Long runs of zeros with a few ones.
+          byte = value < 252 ? 0 : (value == 255 ? 1 : value);
+          break;
+      }
+    }
+
+    uint64_t expected_offset = data_size >= 3 ? data_size - 2 : 0;
+    uint8_t expected_start_code_size = 0;
+    for (size_t i = 0; i + 3 <= data_size; ++i) {
+      if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+        const bool four_bytes = i > 0 && data[i - 1] == 0;
+        expected_offset = four_bytes ? i - 1 : i;
+        expected_start_code_size = four_bytes ? 4 : 3;
+        break;
+      }
+    }
+
+    uint64_t offset = 0;
+    uint8_t start_code_size = 0;
+    EXPECT_EQ(expected_start_code_size > 0,
+              NaluReader::FindStartCode(data.data(), data_size, &offset,
+                                        &start_code_size));
+    EXPECT_EQ(expected_offset, offset) << "data_size " << data_size;
+    EXPECT_EQ(expected_start_code_size, start_code_size);
+  }
+}
+
 // No NALU start code in the subsample range. A NALU start code in the buffer
 // not specified by subsamples.
 TEST(NaluReaderTest, FindStartCodeInClearRangeNoNalu) {
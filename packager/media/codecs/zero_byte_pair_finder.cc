@@ -0,0 +1,132 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/codecs/zero_byte_pair_finder.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define ZERO_BYTE_PAIR_FINDER_USE_X86_INTRINSICS 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && (defined(__GNUC__) || defined(__clang__))
+#define ZERO_BYTE_PAIR_FINDER_USE_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace shaka {
+namespace media {
+namespace {
+
+size_t FindZeroBytePairScalar(const uint8_t* data, size_t begin, size_t size) {
+  size_t position = begin;
+  while (position + 2 <= size) {
+    // A non-zero byte cannot be part of a pair, so neither of the two
+    // candidates overlapping it can match.
+    if (data[position + 1] != 0) {
+      position += 2;
+      continue;
+    }
+    if (data[position] == 0)
+      return position;
+    ++position;
+  }
+  return size;
+}
+
+// The vector versions OR each block with the same block shifted by one byte,
+// so a zero in the result marks a pair of zeros. A block is only scanned if
+// the second byte of its last candidate is in |data|.
+
+#if defined(ZERO_BYTE_PAIR_FINDER_USE_X86_INTRINSICS)
+
+__attribute__((target("sse2"))) size_t FindZeroBytePairSse2(
+    const uint8_t* data,
+    size_t begin,
+    size_t size) {
+  const size_t kBlockSize = 16;
+  const __m128i zero = _mm_setzero_si128();
+  size_t position = begin;
+  for (; position + kBlockSize + 1 <= size; position += kBlockSize) {
+    const __m128i first =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + position));
+    const __m128i second =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + position + 1));
+    const uint32_t zero_pairs = static_cast<uint32_t>(_mm_movemask_epi8(
+        _mm_cmpeq_epi8(_mm_or_si128(first, second), zero)));
+    if (zero_pairs != 0)
+      return position + __builtin_ctz(zero_pairs);
+  }
+  return FindZeroBytePairScalar(data, position, size);
+}
+
+__attribute__((target("avx2"))) size_t FindZeroBytePairAvx2(
+    const uint8_t* data,
+    size_t begin,
+    size_t size) {
+  const size_t kBlockSize = 32;
+  const __m256i zero = _mm256_setzero_si256();
+  size_t position = begin;
+  for (; position + kBlockSize + 1 <= size; position += kBlockSize) {
+    const __m256i first =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + position));
+    const __m256i second = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(data + position + 1));
+    const uint32_t zero_pairs = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_or_si256(first, second), zero)));
+    if (zero_pairs != 0)
+      return position + __builtin_ctz(zero_pairs);
+  }
+  return FindZeroBytePairScalar(data, position, size);
+}
+
+#elif defined(ZERO_BYTE_PAIR_FINDER_USE_NEON)
+
+size_t FindZeroBytePairNeon(const uint8_t* data, size_t begin, size_t size) {
+  const size_t kBlockSize = 16;
+  size_t position = begin;
+  for (; position + kBlockSize + 1 <= size; position += kBlockSize) {
+    const uint8x16_t first = vld1q_u8(data + position);
+    const uint8x16_t second = vld1q_u8(data + position + 1);
+    const uint8x16_t is_zero_pair =
+        vceqq_u8(vorrq_u8(first, second), vdupq_n_u8(0));
+    // NEON has no movemask. Narrowing keeps four bits per byte instead.
+    const uint64_t zero_pairs = vget_lane_u64(
+        vreinterpret_u64_u8(
+            vshrn_n_u16(vreinterpretq_u16_u8(is_zero_pair), 4)),
+        0);
+    if (zero_pairs != 0)
+      return position + __builtin_ctzll(zero_pairs) / 4;
+  }
+  return FindZeroBytePairScalar(data, position, size);
+}
+
+#endif
+
+typedef size_t (*ZeroBytePairFinder)(const uint8_t* data,
+                                     size_t begin,
+                                     size_t size);
+
+ZeroBytePairFinder GetZeroBytePairFinder() {
+#if defined(ZERO_BYTE_PAIR_FINDER_USE_X86_INTRINSICS)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return FindZeroBytePairAvx2;
+  if (__builtin_cpu_supports("sse2"))
+    return FindZeroBytePairSse2;
+#elif defined(ZERO_BYTE_PAIR_FINDER_USE_NEON)
+  return FindZeroBytePairNeon;
+#endif
+  return FindZeroBytePairScalar;
+}
+
+}  // namespace
+
+size_t FindZeroBytePair(const uint8_t* data, size_t begin, size_t size) {
+  static const ZeroBytePairFinder kFindZeroBytePair = GetZeroBytePairFinder();
+  return kFindZeroBytePair(data, begin, size);
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,30 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_CODECS_ZERO_BYTE_PAIR_FINDER_H_
+#define PACKAGER_MEDIA_CODECS_ZERO_BYTE_PAIR_FINDER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace shaka {
+namespace media {
+
+/// Finds the next pair of consecutive zero bytes, which start both NALU start
+/// codes (00 00 01) and the sequences escaped by emulation prevention
+/// (00 00 0x, x <= 3). Pairs of zeros are rare in coded video, so this scans
+/// wide blocks with SSE2, AVX2 or NEON where available.
+/// @param data is the data to search.
+/// @param begin is the position to start searching at.
+/// @param size is the size of @a data.
+/// @return the position of the first byte of the first pair of zero bytes at
+///         or after @a begin, or @a size if there is none.
+size_t FindZeroBytePair(const uint8_t* data, size_t begin, size_t size);
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_CODECS_ZERO_BYTE_PAIR_FINDER_H_
@@ -6,6 +6,7 @@
 
 #include <packager/media/crypto/aes_encryptor_factory.h>
 
+#include <packager/media/base/aes_cbcs_encryptor.h>
 #include <packager/media/base/aes_encryptor.h>
 #include <packager/media/base/aes_pattern_cryptor.h>
 #include <packager/media/crypto/sample_aes_ec3_cryptor.h>
@@ -36,11 +37,9 @@ std::unique_ptr<AesCryptor> AesEncryptorFactory::CreateEncryptor(
           std::unique_ptr<AesCryptor>(new AesCtrEncryptor)));
       break;
     case FOURCC_cbcs:
-      encryptor.reset(new AesPatternCryptor(
+      encryptor.reset(new AesCbcsEncryptor(
           crypt_byte_block, skip_byte_block,
-          AesPatternCryptor::kEncryptIfCryptByteBlockRemaining,
-          AesCryptor::kUseConstantIv,
-          std::unique_ptr<AesCryptor>(new AesCbcEncryptor(kNoPadding))));
+          AesPatternCryptor::kEncryptIfCryptByteBlockRemaining));
       break;
     case kAppleSampleAesProtectionScheme:
       if (crypt_byte_block == 0 && skip_byte_block == 0) {
@@ -52,11 +51,9 @@ std::unique_ptr<AesCryptor> AesEncryptorFactory::CreateEncryptor(
               new AesCbcEncryptor(kNoPadding, AesCryptor::kUseConstantIv));
         }
       } else {
-        encryptor.reset(new AesPatternCryptor(
+        encryptor.reset(new AesCbcsEncryptor(
             crypt_byte_block, skip_byte_block,
-            AesPatternCryptor::kSkipIfCryptByteBlockRemaining,
-            AesCryptor::kUseConstantIv,
-            std::unique_ptr<AesCryptor>(new AesCbcEncryptor(kNoPadding))));
+            AesPatternCryptor::kSkipIfCryptByteBlockRemaining));
       }
       break;
     default:
@@ -16,6 +16,7 @@
 #include <packager/macros/status.h>
 #include <packager/media/base/aes_encryptor.h>
 #include <packager/media/base/audio_stream_info.h>
+#include <packager/media/base/buffer_pool.h>
 #include <packager/media/base/common_pssh_generator.h>
 #include <packager/media/base/key_source.h>
 #include <packager/media/base/media_sample.h>
@@ -171,8 +172,54 @@ EncryptionHandler::EncryptionHandler(const EncryptionParams& encryption_params,
           new SubsampleGenerator(encryption_params.vp9_subsample_encryption)),
       encryptor_factory_(new AesEncryptorFactory) {}
 
+EncryptionHandler::EncryptionHandler(const EncryptionParams& encryption_params,
+                                     KeySource* key_source,
+                                     const StartState& start_state)
+    : encryption_params_(encryption_params),
+      protection_scheme_(
+          static_cast<FourCC>(encryption_params.protection_scheme)),
+      key_source_(key_source),
+      start_state_(start_state),
+      subsample_generator_(
+          new SubsampleGenerator(encryption_params.vp9_subsample_encryption)),
+      encryptor_factory_(new AesEncryptorFactory) {}
+
 EncryptionHandler::~EncryptionHandler() = default;
 
+Status EncryptionHandler::CheckStartStateSupported(
+    const EncryptionParams& encryption_params,
+    KeySource* key_source,
+    const StreamInfo& stream_info) {
+  DCHECK(key_source);
+  if (encryption_params.crypto_period_duration_in_seconds > 0) {
+    return Status(error::UNIMPLEMENTED,
+                  "Key rotation cannot start in the middle of a stream.");
+  }
+  const FourCC protection_scheme =
+      static_cast<FourCC>(encryption_params.protection_scheme);
+  // cbc1 always uses 16-byte per-sample IVs, and cbcs and SAMPLE-AES use a
+  // constant IV, which is not advanced.
+  if (protection_scheme == FOURCC_cbc1) {
+    return Status(error::UNIMPLEMENTED,
+                  "cbc1 cannot start in the middle of a stream.");
+  }
+  if (protection_scheme != FOURCC_cenc && protection_scheme != FOURCC_cens)
+    return Status::OK;
+
+  EncryptionKey encryption_key;
+  RETURN_IF_ERROR(key_source->GetKey(
+      GetStreamLabelForEncryption(stream_info,
+                                  encryption_params.stream_label_func),
+      &encryption_key));
+  // Without an IV in the key, the 8-byte IV of the StartState is used.
+  if (!encryption_key.iv.empty() && encryption_key.iv.size() != 8) {
+    return Status(error::UNIMPLEMENTED,
+                  "A 16-byte per-sample IV cannot start in the middle of a "
+                  "stream.");
+  }
+  return Status::OK;
+}
+
 Status EncryptionHandler::InitializeInternal() {
   if (!encryption_params_.stream_label_func) {
     return Status(error::INVALID_ARGUMENT, "Stream label function not set.");
@@ -227,8 +274,12 @@ Status EncryptionHandler::ProcessStreamInfo(const StreamInfo& clear_info) {
   RETURN_IF_ERROR(
       subsample_generator_->Initialize(protection_scheme_, *stream_info));
 
-  remaining_clear_lead_ =
-      encryption_params_.clear_lead_in_seconds * stream_info->time_scale();
+  if (start_state_) {
+    remaining_clear_lead_ = start_state_->remaining_clear_lead;
+  } else {
+    remaining_clear_lead_ =
+        encryption_params_.clear_lead_in_seconds * stream_info->time_scale();
+  }
   crypto_period_duration_ =
       encryption_params_.crypto_period_duration_in_seconds *
       stream_info->time_scale();
@@ -241,6 +292,10 @@ Status EncryptionHandler::ProcessStreamInfo(const StreamInfo& clear_info) {
   EncryptionKey encryption_key;
   const bool key_rotation_enabled = crypto_period_duration_ != 0;
   if (key_rotation_enabled) {
+    if (start_state_) {
+      return Status(error::INVALID_ARGUMENT,
+                    "Key rotation cannot start in the middle of a stream.");
+    }
     check_new_crypto_period_ = true;
     // Setup dummy key id, key and iv to signal encryption for key rotation.
     encryption_key.key_id.assign(std::begin(kKeyRotationDefaultKeyId),
@@ -251,9 +306,13 @@ Status EncryptionHandler::ProcessStreamInfo(const StreamInfo& clear_info) {
                              std::end(kKeyRotationDefaultIv));
   } else {
     RETURN_IF_ERROR(key_source_->GetKey(stream_label_, &encryption_key));
+    if (start_state_ && encryption_key.iv.empty())
+      encryption_key.iv = start_state_->iv;
   }
   if (!CreateEncryptor(encryption_key))
     return Status(error::ENCRYPTION_FAILURE, "Failed to create encryptor");
+  if (start_state_)
+    RETURN_IF_ERROR(AdvanceIv(start_state_->num_encrypted_samples));
 
   stream_info->set_is_encrypted(true);
   stream_info->set_has_clear_lead(encryption_params_.clear_lead_in_seconds > 0);
@@ -303,37 +362,57 @@ Status EncryptionHandler::ProcessMediaSample(
   size_t ciphertext_size =
       encryptor_->RequiredOutputSize(clear_sample->data_size());
 
-  std::shared_ptr<uint8_t> cipher_sample_data(new uint8_t[ciphertext_size],
-                                              std::default_delete<uint8_t[]>());
-
+  // If this handler holds the only reference to the sample and its data, which
+  // is the usual case for samples coming from a demuxer, take over the sample
+  // and encrypt its data in place. Otherwise, e.g. when a Replicator has sent
+  // the same sample to several outputs, encrypt into a copy.
+  std::shared_ptr<MediaSample> cipher_sample;
+  std::shared_ptr<uint8_t> cipher_sample_data;
   const uint8_t* source = clear_sample->data();
-  uint8_t* dest = cipher_sample_data.get();
+  uint8_t* dest = nullptr;
+  if (clear_sample.use_count() == 1 && clear_sample->has_exclusive_data() &&
+      ciphertext_size == clear_sample->data_size()) {
+    cipher_sample = std::const_pointer_cast<MediaSample>(clear_sample);
+    dest = cipher_sample->writable_data();
+  } else {
+    cipher_sample_data = BufferPool::GetInstance()->Allocate(ciphertext_size);
+    dest = cipher_sample_data.get();
+  }
+
   if (!subsamples.empty()) {
+    // The protected ranges are encrypted in one call, so that cryptors which
+    // can work on independent subsamples in parallel get all of them at once.
+    std::vector<AesCryptor::CryptRange> protected_ranges;
+    protected_ranges.reserve(subsamples.size());
     size_t total_size = 0;
     for (const SubsampleEntry& subsample : subsamples) {
       if (subsample.clear_bytes > 0) {
         // clear_bytes is the number of bytes to leave in the clear
-        memcpy(dest, source, subsample.clear_bytes);
+        if (dest != source)
+          memcpy(dest, source, subsample.clear_bytes);
         source += subsample.clear_bytes;
         dest += subsample.clear_bytes;
         total_size += subsample.clear_bytes;
       }
       if (subsample.cipher_bytes > 0) {
         // cipher_bytes is the number of bytes we want to encrypt
-        EncryptBytes(source, subsample.cipher_bytes, dest, ciphertext_size);
+        protected_ranges.push_back({source, subsample.cipher_bytes, dest});
         source += subsample.cipher_bytes;
         dest += subsample.cipher_bytes;
         total_size += subsample.cipher_bytes;
       }
     }
     DCHECK_EQ(total_size, clear_sample->data_size());
+    CHECK(encryptor_->CryptRanges(protected_ranges));
   } else {
     EncryptBytes(source, clear_sample->data_size(), dest, ciphertext_size);
   }
 
-  std::shared_ptr<MediaSample> cipher_sample(clear_sample->Clone());
-  cipher_sample->TransferData(std::move(cipher_sample_data),
-                              clear_sample->data_size());
+  if (!cipher_sample) {
+    cipher_sample = clear_sample->Clone();
+    cipher_sample->TransferData(std::move(cipher_sample_data),
+                                clear_sample->data_size());
+  }
 
   // Finish initializing the sample before sending it downstream. We must
   // wait until now to finish the initialization as we will lose access to
@@ -390,6 +469,28 @@ bool EncryptionHandler::CreateEncryptor(const EncryptionKey& encryption_key) {
   return status.ok();
 }
 
+Status EncryptionHandler::AdvanceIv(uint64_t num_samples) {
+  if (num_samples == 0 || encryptor_->use_constant_iv())
+    return Status::OK;
+  // Only 8-byte IVs are incremented by one per sample, see
+  // AesCryptor::UpdateIv().
+  std::vector<uint8_t> iv = encryptor_->iv();
+  if (iv.size() != 8) {
+    return Status(error::ENCRYPTION_FAILURE,
+                  "Cannot advance a 16-byte per-sample IV without the sizes "
+                  "of the previous samples.");
+  }
+  uint64_t increment = num_samples;
+  for (int i = static_cast<int>(iv.size()) - 1; increment > 0 && i >= 0; --i) {
+    increment += iv[i];
+    iv[i] = increment & 0xFF;
+    increment >>= 8;
+  }
+  if (!encryptor_->SetIv(iv))
+    return Status(error::ENCRYPTION_FAILURE, "Failed to set the IV.");
+  return Status::OK;
+}
+
 void EncryptionHandler::EncryptBytes(const uint8_t* source,
                                      size_t source_size,
                                      uint8_t* dest,
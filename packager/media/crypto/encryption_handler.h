@@ -7,6 +7,10 @@
 #ifndef PACKAGER_MEDIA_CRYPTO_ENCRYPTION_HANDLER_H_
 #define PACKAGER_MEDIA_CRYPTO_ENCRYPTION_HANDLER_H_
 
+#include <cstdint>
+#include <optional>
+#include <vector>
+
 #include <packager/crypto_params.h>
 #include <packager/media/base/key_source.h>
 #include <packager/media/base/media_handler.h>
@@ -21,11 +25,42 @@ struct EncryptionKey;
 
 class EncryptionHandler : public MediaHandler {
  public:
+  /// The state of the encryption of a stream where a handler starts, when the
+  /// segments of the stream are encrypted by several handlers, e.g. in
+  /// parallel. The output of the handler then continues the output of the
+  /// handler of the previous segments.
+  struct StartState {
+    /// The IV of the stream if the key has none, instead of the random IV
+    /// which would differ between the handlers.
+    std::vector<uint8_t> iv;
+    /// The clear lead left, in the stream's time scale.
+    int64_t remaining_clear_lead = 0;
+    /// The number of samples encrypted before, which the IV is advanced by.
+    uint64_t num_encrypted_samples = 0;
+  };
+
   EncryptionHandler(const EncryptionParams& encryption_params,
                     KeySource* key_source);
+  /// @param start_state is where the handler starts in the stream. Key
+  ///        rotation and 16-byte per-sample IVs, which depend on the sizes of
+  ///        the previous samples, are not supported.
+  EncryptionHandler(const EncryptionParams& encryption_params,
+                    KeySource* key_source,
+                    const StartState& start_state);
 
   ~EncryptionHandler() override;
 
+  /// Checks whether a handler created with a StartState can encrypt a stream.
+  /// @param stream_info is the stream to encrypt.
+  /// @param key_source provides the key, whose per-sample IV must be one that
+  ///        can be advanced without the sizes of the previous samples.
+  /// @return OK if it can, UNIMPLEMENTED if it cannot, or the error getting
+  ///         the key.
+  static Status CheckStartStateSupported(
+      const EncryptionParams& encryption_params,
+      KeySource* key_source,
+      const StreamInfo& stream_info);
+
  protected:
   /// @name MediaHandler implementation overrides.
   /// @{
@@ -46,6 +81,8 @@ class EncryptionHandler : public MediaHandler {
 
   void SetupProtectionPattern(StreamType stream_type);
   bool CreateEncryptor(const EncryptionKey& encryption_key);
+  // Advances the IV of |encryptor_| past |num_samples| encrypted samples.
+  Status AdvanceIv(uint64_t num_samples);
   // Encrypt an E-AC3 frame with size |source_size| according to SAMPLE-AES
   // specification. |dest| should have at least |source_size| bytes.
   bool SampleAesEncryptEac3Frame(const uint8_t* source,
@@ -74,6 +111,7 @@ class EncryptionHandler : public MediaHandler {
   const EncryptionParams encryption_params_;
   const FourCC protection_scheme_ = FOURCC_NULL;
   KeySource* key_source_ = nullptr;
+  const std::optional<StartState> start_state_;
   std::string stream_label_;
   // Current encryption config and encryptor.
   std::shared_ptr<EncryptionConfig> encryption_config_;
@@ -101,7 +101,9 @@ class EncryptionHandlerTest : public MediaHandlerGraphTestBase {
  public:
   void SetUp() override { SetUpEncryptionHandler(EncryptionParams()); }
 
-  void SetUpEncryptionHandler(const EncryptionParams& encryption_params) {
+  void SetUpEncryptionHandler(
+      const EncryptionParams& encryption_params,
+      const EncryptionHandler::StartState* start_state = nullptr) {
     EncryptionParams new_encryption_params = encryption_params;
     if (!encryption_params.stream_label_func) {
       // Setup default stream label function.
@@ -115,8 +117,13 @@ class EncryptionHandlerTest : public MediaHandlerGraphTestBase {
             return kSdVideoStreamLabel;
           };
     }
-    encryption_handler_.reset(
-        new EncryptionHandler(new_encryption_params, &mock_key_source_));
+    if (start_state) {
+      encryption_handler_.reset(new EncryptionHandler(
+          new_encryption_params, &mock_key_source_, *start_state));
+    } else {
+      encryption_handler_.reset(
+          new EncryptionHandler(new_encryption_params, &mock_key_source_));
+    }
     SetUpGraph(1 /* one input */, 1 /* one output */, encryption_handler_);
     // Inject default subsamples to avoid parsing problems.
     const std::vector<SubsampleEntry> empty_subsamples;
@@ -560,6 +567,86 @@ TEST_P(EncryptionHandlerSubsampleTest, SubsampleTest) {
   EXPECT_EQ(GetParam().subsamples, decrypt_config.subsamples());
 }
 
+class EncryptionHandlerInPlaceTest : public EncryptionHandlerTest {
+ public:
+  void SetUp() override {
+    EncryptionHandlerTest::SetUp();
+
+    std::unique_ptr<MockAesCryptor> mock_encryptor(new MockAesCryptor);
+    EXPECT_CALL(*mock_encryptor, CryptInternal(_, _, _, _))
+        .WillRepeatedly(Invoke(MockEncrypt));
+    ASSERT_TRUE(mock_encryptor->SetIv(
+        std::vector<uint8_t>(std::begin(kIv), std::end(kIv))));
+
+    std::unique_ptr<MockAesEncryptorFactory> mock_encryptor_factory(
+        new MockAesEncryptorFactory);
+    EXPECT_CALL(*mock_encryptor_factory, CreateEncryptor(_, _, _, _, _, _))
+        .WillOnce(Return(ByMove(std::move(mock_encryptor))));
+    InjectEncryptorFactoryForTesting(std::move(mock_encryptor_factory));
+
+    InjectSubsamples({{6, 2}, {0, 2}});
+
+    EXPECT_CALL(mock_key_source_, GetKey(_, _))
+        .WillOnce(DoAll(SetArgPointee<1>(GetMockEncryptionKey()),
+                        Return(Status::OK)));
+    ASSERT_OK(Process(StreamData::FromStreamInfo(
+        kStreamIndex, GetVideoStreamInfo(kTimeScale, kCodecH264))));
+  }
+
+  const MediaSample& GetOutputSample() {
+    return *GetOutputStreamDataVector().back()->media_sample;
+  }
+
+  std::vector<uint8_t> GetData(const MediaSample& sample) {
+    return std::vector<uint8_t>(sample.data(),
+                                sample.data() + sample.data_size());
+  }
+
+ protected:
+  const std::vector<uint8_t> clear_data_{std::begin(kData), std::end(kData)};
+  const std::vector<uint8_t> encrypted_data_{
+      0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x16, 0x17, 0x18, 0x19};
+};
+
+TEST_F(EncryptionHandlerInPlaceTest, EncryptsExclusiveSampleInPlace) {
+  std::shared_ptr<MediaSample> sample =
+      GetMediaSample(0, kSampleDuration, kIsKeyFrame, kData, kDataSize);
+  const MediaSample* sample_ptr = sample.get();
+  const uint8_t* data_ptr = sample->data();
+  ASSERT_OK(Process(
+      StreamData::FromMediaSample(kStreamIndex, std::move(sample))));
+
+  const MediaSample& output_sample = GetOutputSample();
+  EXPECT_EQ(sample_ptr, &output_sample);
+  EXPECT_EQ(data_ptr, output_sample.data());
+  EXPECT_TRUE(output_sample.is_encrypted());
+  EXPECT_EQ(encrypted_data_, GetData(output_sample));
+}
+
+TEST_F(EncryptionHandlerInPlaceTest, CopiesSharedSample) {
+  // E.g. a sample sent to several outputs by a Replicator.
+  std::shared_ptr<MediaSample> sample =
+      GetMediaSample(0, kSampleDuration, kIsKeyFrame, kData, kDataSize);
+  ASSERT_OK(Process(StreamData::FromMediaSample(kStreamIndex, sample)));
+
+  const MediaSample& output_sample = GetOutputSample();
+  EXPECT_NE(sample.get(), &output_sample);
+  EXPECT_FALSE(sample->is_encrypted());
+  EXPECT_EQ(clear_data_, GetData(*sample));
+  EXPECT_EQ(encrypted_data_, GetData(output_sample));
+}
+
+TEST_F(EncryptionHandlerInPlaceTest, CopiesSampleWithSharedData) {
+  std::shared_ptr<MediaSample> sample =
+      GetMediaSample(0, kSampleDuration, kIsKeyFrame, kData, kDataSize);
+  std::shared_ptr<MediaSample> clone = sample->Clone();
+  ASSERT_OK(Process(
+      StreamData::FromMediaSample(kStreamIndex, std::move(sample))));
+
+  EXPECT_EQ(clear_data_, GetData(*clone));
+  EXPECT_EQ(encrypted_data_, GetData(GetOutputSample()));
+}
+
 class EncryptionHandlerTrackTypeTest : public EncryptionHandlerTest {};
 
 TEST_F(EncryptionHandlerTrackTypeTest, AudioTrackType) {
@@ -669,5 +756,159 @@ TEST_F(EncryptionHandlerPsshTest, UsesKeyInfoFirst) {
       stream_info->encryption_config().key_system_info[0].psshs.empty());
 }
 
+class EncryptionHandlerStartStateTest
+    : public EncryptionHandlerTest,
+      public WithParamInterface<std::tuple<FourCC, bool>> {
+ public:
+  void SetUp() override {
+    protection_scheme_ = std::get<0>(GetParam());
+    key_has_iv_ = std::get<1>(GetParam());
+    // 8-byte per-sample IVs for cenc and cens, a 16-byte constant IV for cbcs.
+    iv_.assign(std::begin(kIv), std::end(kIv));
+    if (protection_scheme_ != FOURCC_cbcs)
+      iv_.resize(8);
+  }
+
+ protected:
+  struct Output {
+    StreamDataType type;
+    std::shared_ptr<const MediaSample> media_sample;
+    std::shared_ptr<const SegmentInfo> segment_info;
+  };
+
+  static constexpr int kSamplesPerSegment = 3;
+  static constexpr int kNumSegments = 5;
+  static constexpr int64_t kStartStateSegmentDuration =
+      kSamplesPerSegment * kSampleDuration;
+
+  // Encrypts the segments from |first_segment| to |end_segment|, with a clear
+  // lead of one and a half segment, and appends the output to |outputs|. The
+  // samples have several subsamples, so that only parts of them are
+  // encrypted, following the pattern with cens and cbcs.
+  void EncryptSegments(int first_segment,
+                       int end_segment,
+                       bool key_has_iv,
+                       const EncryptionHandler::StartState* start_state,
+                       std::vector<Output>* outputs) {
+    EncryptionParams encryption_params;
+    encryption_params.protection_scheme = protection_scheme_;
+    encryption_params.clear_lead_in_seconds =
+        1.5 * kStartStateSegmentDuration / kTimeScale;
+    SetUpEncryptionHandler(encryption_params, start_state);
+    ClearOutputStreamDataVector();
+    InjectSubsamples({{5, 64}, {10, 0}, {3, 118}});
+
+    EncryptionKey encryption_key = GetMockEncryptionKey();
+    encryption_key.iv = key_has_iv ? iv_ : std::vector<uint8_t>();
+    EXPECT_CALL(mock_key_source_, GetKey(_, _))
+        .WillOnce(DoAll(SetArgPointee<1>(encryption_key), Return(Status::OK)));
+
+    ASSERT_OK(Process(StreamData::FromStreamInfo(
+        kStreamIndex, GetVideoStreamInfo(kTimeScale, kCodecH264))));
+    for (int i = first_segment; i < end_segment; ++i) {
+      for (int j = 0; j < kSamplesPerSegment; ++j) {
+        const int sample_index = i * kSamplesPerSegment + j;
+        std::vector<uint8_t> data(200);
+        for (size_t k = 0; k < data.size(); ++k)
+          data[k] = static_cast<uint8_t>(k * 7 + sample_index);
+        ASSERT_OK(Process(StreamData::FromMediaSample(
+            kStreamIndex,
+            GetMediaSample(sample_index * kSampleDuration, kSampleDuration,
+                           j == 0, data.data(), data.size()))));
+      }
+      ASSERT_OK(Process(StreamData::FromSegmentInfo(
+          kStreamIndex, GetSegmentInfo(i * kStartStateSegmentDuration,
+                                       kStartStateSegmentDuration,
+                                       !kIsSubsegment, i + 1))));
+    }
+    for (const auto& stream_data : GetOutputStreamDataVector()) {
+      outputs->push_back({stream_data->stream_data_type,
+                          stream_data->media_sample,
+                          stream_data->segment_info});
+    }
+    Mock::VerifyAndClearExpectations(&mock_key_source_);
+  }
+
+  FourCC protection_scheme_;
+  bool key_has_iv_;
+  std::vector<uint8_t> iv_;
+};
+
+TEST_P(EncryptionHandlerStartStateTest, ContinuesPreviousSegments) {
+  std::vector<Output> serial_outputs;
+  EncryptSegments(0, kNumSegments, true, nullptr, &serial_outputs);
+
+  // The first handler encrypts the two segments of the clear lead and the
+  // first encrypted one. The second handler continues from there.
+  const int kSplitSegment = 3;
+  EncryptionHandler::StartState start_state;
+  start_state.iv = iv_;
+  start_state.remaining_clear_lead =
+      static_cast<int64_t>(1.5 * kStartStateSegmentDuration);
+  std::vector<Output> outputs;
+  EncryptSegments(0, kSplitSegment, key_has_iv_, &start_state, &outputs);
+  start_state.remaining_clear_lead -= 2 * kStartStateSegmentDuration;
+  start_state.num_encrypted_samples = kSamplesPerSegment;
+  std::vector<Output> second_outputs;
+  EncryptSegments(kSplitSegment, kNumSegments, key_has_iv_, &start_state,
+                  &second_outputs);
+  ASSERT_FALSE(second_outputs.empty());
+  EXPECT_EQ(StreamDataType::kStreamInfo, second_outputs.front().type);
+  outputs.insert(outputs.end(), second_outputs.begin() + 1,
+                 second_outputs.end());
+
+  ASSERT_EQ(serial_outputs.size(), outputs.size());
+  size_t num_encrypted_samples = 0;
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    ASSERT_EQ(serial_outputs[i].type, outputs[i].type);
+    if (outputs[i].segment_info) {
+      EXPECT_EQ(serial_outputs[i].segment_info->is_encrypted,
+                outputs[i].segment_info->is_encrypted);
+    }
+    if (!outputs[i].media_sample)
+      continue;
+    const MediaSample& serial_sample = *serial_outputs[i].media_sample;
+    const MediaSample& sample = *outputs[i].media_sample;
+    EXPECT_EQ(serial_sample.dts(), sample.dts());
+    EXPECT_EQ(std::vector<uint8_t>(
+                  serial_sample.data(),
+                  serial_sample.data() + serial_sample.data_size()),
+              std::vector<uint8_t>(sample.data(),
+                                   sample.data() + sample.data_size()));
+    ASSERT_EQ(serial_sample.is_encrypted(), sample.is_encrypted());
+    if (!sample.is_encrypted())
+      continue;
+    ++num_encrypted_samples;
+    EXPECT_EQ(serial_sample.decrypt_config()->iv(),
+              sample.decrypt_config()->iv());
+    EXPECT_EQ(serial_sample.decrypt_config()->subsamples(),
+              sample.decrypt_config()->subsamples());
+  }
+  EXPECT_EQ(static_cast<size_t>(kSamplesPerSegment * 3),
+            num_encrypted_samples);
+}
+
+INSTANTIATE_TEST_CASE_P(ProtectionSchemes,
+                        EncryptionHandlerStartStateTest,
+                        Combine(Values(FOURCC_cenc, FOURCC_cens, FOURCC_cbcs),
+                                Values(true, false)));
+
+TEST_F(EncryptionHandlerTest, StartStateWith16BytePerSampleIv) {
+  EncryptionParams encryption_params;
+  encryption_params.protection_scheme = FOURCC_cenc;
+  EncryptionHandler::StartState start_state;
+  start_state.num_encrypted_samples = 1;
+  SetUpEncryptionHandler(encryption_params, &start_state);
+
+  EXPECT_CALL(mock_key_source_, GetKey(_, _))
+      .WillOnce(
+          DoAll(SetArgPointee<1>(GetMockEncryptionKey()), Return(Status::OK)));
+  EXPECT_EQ(error::ENCRYPTION_FAILURE,
+            Process(StreamData::FromStreamInfo(
+                        kStreamIndex, GetVideoStreamInfo(kTimeScale,
+                                                         kCodecH264)))
+                .error_code());
+}
+
 }  // namespace media
 }  // namespace shaka
@@ -0,0 +1,100 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// Benchmark for generating the subsamples of the H.264 frames of the test
+// data, which parses their slice headers.
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <packager/media/base/fourccs.h>
+#include <packager/media/base/video_stream_info.h>
+#include <packager/media/codecs/h264_byte_to_unit_stream_converter.h>
+#include <packager/media/codecs/nalu_reader.h>
+#include <packager/media/crypto/subsample_generator.h>
+#include <packager/media/test/test_data_util.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+const bool kVP9SubsampleEncryption = true;
+const uint8_t kNaluLengthSize = 4;
+
+struct H264Frames {
+  std::vector<uint8_t> decoder_config;
+  std::vector<std::vector<uint8_t>> frames;
+  size_t total_size = 0;
+};
+
+// Splits the byte stream of the test data in frames, each ending with a
+// slice, and converts them to NAL unit streams.
+bool ReadH264Frames(H264Frames* frames) {
+  const std::vector<uint8_t> data = ReadTestDataFile("bear.h264");
+  H264ByteToUnitStreamConverter converter;
+  NaluReader reader(Nalu::kH264, kIsAnnexbByteStream, data.data(),
+                    data.size());
+  const uint8_t* frame_start = data.data();
+  Nalu nalu;
+  while (reader.Advance(&nalu) == NaluReader::kOk) {
+    if (!nalu.is_video_slice())
+      continue;
+    const uint8_t* frame_end =
+        nalu.data() + nalu.header_size() + nalu.payload_size();
+    std::vector<uint8_t> frame;
+    if (!converter.ConvertByteStreamToNalUnitStream(
+            frame_start, frame_end - frame_start, &frame)) {
+      return false;
+    }
+    frames->total_size += frame.size();
+    frames->frames.push_back(std::move(frame));
+    frame_start = frame_end;
+  }
+  return !frames->frames.empty() &&
+         converter.GetDecoderConfigurationRecord(&frames->decoder_config);
+}
+
+void BM_GenerateH264Subsamples(benchmark::State& state,
+                               FourCC protection_scheme) {
+  H264Frames frames;
+  if (!ReadH264Frames(&frames)) {
+    state.SkipWithError("Failed to read the test data.");
+    return;
+  }
+  const VideoStreamInfo stream_info(
+      1, 90000, 0, kCodecH264,
+      H26xStreamFormat::kNalUnitStreamWithoutParameterSetNalus, "avc1",
+      frames.decoder_config.data(), frames.decoder_config.size(), 640, 360, 1,
+      1, 0, 0, 0, 0, kNaluLengthSize, "und", false);
+
+  SubsampleGenerator generator(kVP9SubsampleEncryption);
+  if (!generator.Initialize(protection_scheme, stream_info).ok()) {
+    state.SkipWithError("Failed to initialize the subsample generator.");
+    return;
+  }
+
+  std::vector<SubsampleEntry> subsamples;
+  for (auto _ : state) {
+    for (const std::vector<uint8_t>& frame : frames.frames) {
+      if (!generator.GenerateSubsamples(frame.data(), frame.size(), &subsamples)
+               .ok()) {
+        state.SkipWithError("Failed to generate the subsamples.");
+        return;
+      }
+      benchmark::DoNotOptimize(subsamples.data());
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * frames.total_size);
+  state.SetItemsProcessed(state.iterations() * frames.frames.size());
+}
+
+BENCHMARK_CAPTURE(BM_GenerateH264Subsamples, cenc, FOURCC_cenc);
+BENCHMARK_CAPTURE(BM_GenerateH264Subsamples, cbcs, FOURCC_cbcs);
+
+}  // namespace
+}  // namespace media
+}  // namespace shaka
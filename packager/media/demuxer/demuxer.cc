@@ -16,6 +16,7 @@
 #include <absl/strings/str_format.h>
 
 #include <packager/file.h>
+#include <packager/file/local_file.h>
 #include <packager/macros/compiler.h>
 #include <packager/macros/logging.h>
 #include <packager/media/base/decryptor_source.h>
@@ -164,6 +165,9 @@ Status Demuxer::InitializeParser() {
     return Status(error::FILE_FAILURE,
                   "Cannot open file for reading " + file_name_);
   }
+  mapped_file_ = dynamic_cast<LocalFile*>(media_file_);
+  if (mapped_file_ && !mapped_file_->is_mapped())
+    mapped_file_ = nullptr;
 
   int64_t bytes_read = 0;
   bool eof = false;
@@ -316,7 +320,7 @@ bool Demuxer::NewMediaSampleEvent(uint32_t track_id,
       LOG(ERROR) << "Queued samples limit reached: " << kQueuedSamplesLimit;
       return false;
     }
-    queued_media_samples_.emplace_back(track_id, sample);
+    queued_media_samples_.emplace_back(track_id, std::move(sample));
     return true;
   }
   if (!init_event_status_.ok()) {
@@ -325,12 +329,12 @@ bool Demuxer::NewMediaSampleEvent(uint32_t track_id,
 
   while (!queued_media_samples_.empty()) {
     if (!PushMediaSample(queued_media_samples_.front().track_id,
-                         queued_media_samples_.front().sample)) {
+                         std::move(queued_media_samples_.front().sample))) {
       return false;
     }
     queued_media_samples_.pop_front();
   }
-  return PushMediaSample(track_id, sample);
+  return PushMediaSample(track_id, std::move(sample));
 }
 
 bool Demuxer::NewTextSampleEvent(uint32_t track_id,
@@ -366,7 +370,8 @@ bool Demuxer::PushMediaSample(uint32_t track_id,
   }
   if (stream_index_iter->second == kInvalidStreamIndex)
     return true;
-  Status status = DispatchMediaSample(stream_index_iter->second, sample);
+  Status status =
+      DispatchMediaSample(stream_index_iter->second, std::move(sample));
   if (!status.ok()) {
     LOG(ERROR) << "Failed to process sample " << stream_index_iter->second
                << " " << status;
@@ -398,7 +403,10 @@ Status Demuxer::Parse() {
   DCHECK(parser_);
   DCHECK(buffer_);
 
-  int64_t bytes_read = media_file_->Read(buffer_.get(), kBufSize);
+  const uint8_t* data = buffer_.get();
+  int64_t bytes_read = mapped_file_
+                           ? mapped_file_->ReadView(kBufSize, &data)
+                           : media_file_->Read(buffer_.get(), kBufSize);
   if (bytes_read == 0) {
     if (!parser_->Flush())
       return Status(error::PARSER_FAILURE, "Failed to flush.");
@@ -407,7 +415,7 @@ Status Demuxer::Parse() {
     return Status(error::FILE_FAILURE, "Cannot read file " + file_name_);
   }
 
-  return parser_->Parse(buffer_.get(), bytes_read)
+  return parser_->Parse(data, bytes_read)
              ? Status::OK
              : Status(error::PARSER_FAILURE,
                       "Cannot parse media file " + file_name_);
@@ -19,6 +19,7 @@
 namespace shaka {
 
 class File;
+class LocalFile;
 
 namespace media {
 
@@ -101,7 +102,7 @@ class Demuxer : public OriginHandler {
   template <typename T>
   struct QueuedSample {
     QueuedSample(uint32_t track_id, std::shared_ptr<T> sample)
-        : track_id(track_id), sample(sample) {}
+        : track_id(track_id), sample(std::move(sample)) {}
 
     ~QueuedSample() {}
 
@@ -132,6 +133,9 @@ class Demuxer : public OriginHandler {
 
   std::string file_name_;
   File* media_file_ = nullptr;
+  // |media_file_| if it is a memory mapped local file, which is read without
+  // copying.
+  LocalFile* mapped_file_ = nullptr;
   // A stream is considered ready after receiving the stream info.
   bool all_streams_ready_ = false;
   // Queued samples received in NewSampleEvent() before ParserInitEvent().
@@ -10,7 +10,10 @@
 #include <gtest/gtest.h>
 
 #include <packager/media/base/media_handler_test_base.h>
+#include <packager/media/base/media_sample.h>
 #include <packager/media/base/raw_key_source.h>
+#include <packager/media/chunking/chunking_handler.h>
+#include <packager/media/crypto/encryption_handler.h>
 #include <packager/media/test/test_data_util.h>
 #include <packager/status/status_test_util.h>
 
@@ -28,6 +31,25 @@ class MockKeySource : public RawKeySource {
   MOCK_METHOD2(GetKey,
                Status(const std::vector<uint8_t>& key_id, EncryptionKey* key));
 };
+
+// Records where the data of the samples passing through it is.
+class SampleDataRecorder : public MediaHandler {
+ public:
+  const std::vector<const uint8_t*>& sample_data() const {
+    return sample_data_;
+  }
+
+ private:
+  Status InitializeInternal() override { return Status::OK; }
+
+  Status Process(std::unique_ptr<StreamData> stream_data) override {
+    if (stream_data->stream_data_type == StreamDataType::kMediaSample)
+      sample_data_.push_back(stream_data->media_sample->data());
+    return Dispatch(std::move(stream_data));
+  }
+
+  std::vector<const uint8_t*> sample_data_;
+};
 }  // namespace
 
 class DemuxerTest : public MediaHandlerGraphTestBase {
@@ -73,6 +95,50 @@ TEST_F(DemuxerTest, EncryptedContentWithKeySource) {
   EXPECT_OK(demuxer.Run());
 }
 
+TEST_F(DemuxerTest, EncryptsMp4SamplesInPlace) {
+  RawKeyParams raw_key;
+  RawKeyParams::KeyInfo& key_info = raw_key.key_map[""];
+  key_info.key_id = GetMockEncryptionKey().key_id;
+  key_info.key = GetMockEncryptionKey().key;
+  std::unique_ptr<RawKeySource> key_source = RawKeySource::Create(raw_key);
+  ASSERT_TRUE(key_source);
+
+  EncryptionParams encryption_params;
+  encryption_params.protection_scheme = FOURCC_cenc;
+  encryption_params.stream_label_func =
+      [](const EncryptionParams::EncryptedStreamAttributes&) {
+        return std::string();
+      };
+
+  // Demuxer -> ChunkingHandler -> EncryptionHandler, as set up by the
+  // packager, with the clear samples recorded before the encryption.
+  ChunkingParams chunking_params;
+  chunking_params.segment_duration_in_seconds = 1;
+  auto chunking_handler = std::make_shared<ChunkingHandler>(chunking_params);
+  auto recorder = std::make_shared<SampleDataRecorder>();
+  auto output = std::make_shared<CachingMediaHandler>();
+  ASSERT_OK(MediaHandler::Chain(
+      {chunking_handler, recorder,
+       std::make_shared<EncryptionHandler>(encryption_params,
+                                           key_source.get()),
+       output}));
+
+  Demuxer demuxer(GetTestDataFilePath("bear-640x360.mp4").string());
+  ASSERT_OK(demuxer.SetHandler("video", chunking_handler));
+  ASSERT_OK(demuxer.Run());
+
+  // The samples are encrypted where the demuxer left them, without a copy.
+  std::vector<const uint8_t*> encrypted_sample_data;
+  for (const auto& stream_data : output->Cache()) {
+    if (stream_data->stream_data_type != StreamDataType::kMediaSample)
+      continue;
+    EXPECT_TRUE(stream_data->media_sample->is_encrypted());
+    encrypted_sample_data.push_back(stream_data->media_sample->data());
+  }
+  ASSERT_FALSE(encrypted_sample_data.empty());
+  EXPECT_EQ(recorder->sample_data(), encrypted_sample_data);
+}
+
 // TODO(kqyang): Add more tests.
 
 }  // namespace media
@@ -0,0 +1,520 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/demuxer/parallel_mp4_demuxer.h>
+
+#include <algorithm>
+#include <map>
+
+#include <absl/log/check.h>
+#include <absl/log/log.h>
+#include <absl/strings/numbers.h>
+
+#include <packager/file.h>
+#include <packager/file/file_closer.h>
+#include <packager/macros/logging.h>
+#include <packager/macros/status.h>
+#include <packager/media/base/aes_cryptor.h>
+#include <packager/media/base/buffer_pool.h>
+#include <packager/media/base/media_sample.h>
+#include <packager/media/base/stream_info.h>
+#include <packager/media/base/work_stealing_thread_pool.h>
+#include <packager/media/chunking/chunking_handler.h>
+#include <packager/media/formats/mp4/box_definitions.h>
+#include <packager/media/formats/mp4/box_reader.h>
+#include <packager/media/formats/mp4/mp4_media_parser.h>
+#include <packager/media/formats/mp4/track_run_iterator.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+const size_t kStreamIndex = 0;
+
+// Reads exactly |size| bytes, which a single File::Read() does not guarantee.
+bool ReadFully(File* file, uint8_t* data, int64_t size) {
+  while (size > 0) {
+    const int64_t bytes_read = file->Read(data, size);
+    if (bytes_read <= 0)
+      return false;
+    data += bytes_read;
+    size -= bytes_read;
+  }
+  return true;
+}
+
+// Feeds the stream data of a segment to the handlers of the segment.
+class SegmentSource : public MediaHandler {
+ public:
+  Status Send(std::unique_ptr<StreamData> stream_data) {
+    return Dispatch(std::move(stream_data));
+  }
+  Status Flush() { return FlushDownstream(kStreamIndex); }
+
+ protected:
+  Status InitializeInternal() override { return Status::OK; }
+  Status Process(std::unique_ptr<StreamData> stream_data) override {
+    return Status(error::INTERNAL_ERROR,
+                  "SegmentSource should not be the downstream handler.");
+  }
+  bool ValidateOutputStreamIndex(size_t stream_index) const override {
+    return stream_index == kStreamIndex;
+  }
+};
+
+// Keeps the stream data of a segment until it is dispatched in order.
+class SegmentSink : public MediaHandler {
+ public:
+  explicit SegmentSink(std::vector<std::unique_ptr<StreamData>>* output)
+      : output_(output) {}
+
+ protected:
+  Status InitializeInternal() override { return Status::OK; }
+  Status Process(std::unique_ptr<StreamData> stream_data) override {
+    output_->push_back(std::move(stream_data));
+    return Status::OK;
+  }
+  Status OnFlushRequest(size_t input_stream_index) override {
+    return Status::OK;
+  }
+
+ private:
+  std::vector<std::unique_ptr<StreamData>>* const output_;
+};
+
+// Records the number of samples and the duration of every segment.
+class SegmentRecorder : public MediaHandler {
+ public:
+  struct Record {
+    size_t num_samples = 0;
+    int64_t duration = 0;
+  };
+
+  const std::vector<Record>& records() const { return records_; }
+
+ protected:
+  Status InitializeInternal() override { return Status::OK; }
+  Status Process(std::unique_ptr<StreamData> stream_data) override {
+    if (stream_data->stream_data_type == StreamDataType::kMediaSample) {
+      ++num_samples_;
+    } else if (stream_data->stream_data_type == StreamDataType::kSegmentInfo &&
+               !stream_data->segment_info->is_subsegment) {
+      records_.push_back({num_samples_, stream_data->segment_info->duration});
+      num_samples_ = 0;
+    }
+    return Status::OK;
+  }
+  Status OnFlushRequest(size_t input_stream_index) override {
+    return Status::OK;
+  }
+
+ private:
+  size_t num_samples_ = 0;
+  std::vector<Record> records_;
+};
+
+}  // namespace
+
+ParallelMp4Demuxer::ParallelMp4Demuxer(const std::string& file_name,
+                                       const ChunkingParams& chunking_params,
+                                       WorkStealingThreadPool* thread_pool,
+                                       size_t max_parallel_segments)
+    : file_name_(file_name),
+      chunking_params_(chunking_params),
+      thread_pool_(thread_pool),
+      max_parallel_segments_(std::max<size_t>(max_parallel_segments, 1)) {
+  DCHECK(!chunking_params.low_latency_dash_mode);
+}
+
+ParallelMp4Demuxer::~ParallelMp4Demuxer() = default;
+
+Status ParallelMp4Demuxer::Open() {
+  DCHECK(streams_.empty());
+
+  std::unique_ptr<File, FileCloser> file(
+      File::OpenWithNoBuffering(file_name_.c_str(), "r"));
+  if (!file) {
+    return Status(error::FILE_FAILURE,
+                  "Cannot open file for reading " + file_name_);
+  }
+
+  // Look for the 'moov' box, wherever it is in the file.
+  std::vector<uint8_t> moov;
+  uint64_t file_position = 0;
+  while (moov.empty()) {
+    const size_t kBoxHeaderReadSize = 16;
+    uint8_t header[kBoxHeaderReadSize];
+    const int64_t bytes_read = file->Read(header, kBoxHeaderReadSize);
+    if (bytes_read < 0)
+      return Status(error::FILE_FAILURE, "Cannot read file " + file_name_);
+    FourCC box_type = FOURCC_NULL;
+    uint64_t box_size = 0;
+    bool err = false;
+    if (bytes_read == 0 ||
+        !mp4::BoxReader::StartBox(header, bytes_read, &box_type, &box_size,
+                                  &err) ||
+        box_size == 0) {
+      return Status(error::UNIMPLEMENTED,
+                    "Could not find 'moov' box in file " + file_name_);
+    }
+    if (box_type == FOURCC_moof) {
+      return Status(error::UNIMPLEMENTED,
+                    "Fragmented file cannot be split into segments.");
+    }
+    if (box_type == FOURCC_moov) {
+      moov.resize(box_size);
+      if (!file->Seek(file_position) ||
+          !ReadFully(file.get(), moov.data(), box_size)) {
+        return Status(error::FILE_FAILURE,
+                      "Cannot read 'moov' box from file " + file_name_);
+      }
+    }
+    file_position += box_size;
+    if (!file->Seek(file_position))
+      return Status(error::FILE_FAILURE, "Cannot seek in file " + file_name_);
+  }
+
+  std::vector<std::shared_ptr<StreamInfo>> stream_infos;
+  mp4::MP4MediaParser parser;
+  parser.Init(
+      [&stream_infos](const std::vector<std::shared_ptr<StreamInfo>>& infos) {
+        stream_infos = infos;
+      },
+      [](uint32_t, std::shared_ptr<MediaSample>) { return true; },
+      [](uint32_t, std::shared_ptr<TextSample>) { return true; }, nullptr);
+  const mp4::Movie* movie = parser.ParseMovie(moov.data(), moov.size());
+  if (!movie) {
+    return Status(error::PARSER_FAILURE,
+                  "Cannot parse media file " + file_name_);
+  }
+  if (!movie->extends.tracks.empty()) {
+    return Status(error::UNIMPLEMENTED,
+                  "Fragmented file cannot be split into segments.");
+  }
+
+  std::map<uint32_t, size_t> track_id_to_stream_index;
+  for (const std::shared_ptr<StreamInfo>& stream_info : stream_infos) {
+    if (stream_info->is_encrypted()) {
+      return Status(error::UNIMPLEMENTED,
+                    "Encrypted file cannot be split into segments.");
+    }
+    track_id_to_stream_index[stream_info->track_id()] = streams_.size();
+    streams_.emplace_back();
+    streams_.back().info = stream_info;
+  }
+
+  mp4::TrackRunIterator runs(movie);
+  if (!runs.Init()) {
+    return Status(error::PARSER_FAILURE,
+                  "Cannot parse media file " + file_name_);
+  }
+  for (; runs.IsRunValid(); runs.AdvanceRun()) {
+    auto iter = track_id_to_stream_index.find(runs.track_id());
+    if (iter == track_id_to_stream_index.end())
+      continue;
+    std::vector<Sample>& samples = streams_[iter->second].samples;
+    for (; runs.IsSampleValid(); runs.AdvanceSample()) {
+      Sample sample;
+      sample.offset = runs.sample_offset();
+      sample.size = runs.sample_size();
+      sample.dts = runs.dts();
+      sample.pts = runs.cts();
+      sample.duration = runs.duration();
+      sample.is_key_frame = runs.is_keyframe();
+      samples.push_back(sample);
+    }
+  }
+  return Status::OK;
+}
+
+bool ParallelMp4Demuxer::CanSplitStream(const std::string& stream_label) const {
+  size_t stream_index = 0;
+  if (!GetStreamIndex(stream_label, &stream_index))
+    return false;
+  const StreamType stream_type = streams_[stream_index].info->stream_type();
+  return stream_type == kStreamAudio || stream_type == kStreamVideo;
+}
+
+bool ParallelMp4Demuxer::CanEncryptStream(
+    const std::string& stream_label,
+    const EncryptionParams& encryption_params,
+    KeySource* key_source) const {
+  size_t stream_index = 0;
+  if (!GetStreamIndex(stream_label, &stream_index) ||
+      !CanSplitStream(stream_label)) {
+    return false;
+  }
+  Status status = EncryptionHandler::CheckStartStateSupported(
+      encryption_params, key_source, *streams_[stream_index].info);
+  if (!status.ok()) {
+    VLOG(1) << "Cannot encrypt the segments of stream " << stream_label
+            << " separately: " << status;
+    return false;
+  }
+  return true;
+}
+
+Status ParallelMp4Demuxer::SetHandler(const std::string& stream_label,
+                                      const EncryptionParams* encryption_params,
+                                      KeySource* key_source,
+                                      std::shared_ptr<MediaHandler> handler) {
+  size_t stream_index = 0;
+  if (!GetStreamIndex(stream_label, &stream_index)) {
+    return Status(error::INVALID_ARGUMENT,
+                  "Invalid stream: " + stream_label);
+  }
+  if (!CanSplitStream(stream_label)) {
+    return Status(error::UNIMPLEMENTED,
+                  "Stream cannot be split into segments: " + stream_label);
+  }
+  if (encryption_params) {
+    RETURN_IF_ERROR(EncryptionHandler::CheckStartStateSupported(
+        *encryption_params, key_source, *streams_[stream_index].info));
+    streams_[stream_index].encryption_params = *encryption_params;
+    streams_[stream_index].key_source = key_source;
+  }
+  return MediaHandler::SetHandler(stream_index, std::move(handler));
+}
+
+void ParallelMp4Demuxer::SetLanguageOverride(
+    const std::string& stream_label,
+    const std::string& language_override) {
+  size_t stream_index = 0;
+  if (!GetStreamIndex(stream_label, &stream_index)) {
+    LOG(WARNING) << "Invalid stream for language override " << stream_label;
+    return;
+  }
+  StreamInfo* stream_info = streams_[stream_index].info.get();
+  if (stream_info->stream_type() != kStreamVideo)
+    stream_info->set_language(language_override);
+}
+
+Status ParallelMp4Demuxer::Run() {
+  LOG(INFO) << "ParallelMp4Demuxer::Run() on file '" << file_name_ << "'.";
+
+  std::vector<std::unique_ptr<Segment>> segments;
+  for (const auto& pair : output_handlers())
+    RETURN_IF_ERROR(PlanSegments(pair.first, &segments));
+
+  // Keep up to |max_parallel_segments_| segments in flight, dispatching them
+  // in order.
+  Status status;
+  size_t num_posted_segments = 0;
+  for (size_t i = 0; i < segments.size() && status.ok(); ++i) {
+    while (num_posted_segments < segments.size() &&
+           num_posted_segments < i + max_parallel_segments_) {
+      PostSegment(segments[num_posted_segments++].get());
+    }
+    WaitForSegment(*segments[i]);
+    if (cancelled_)
+      status = Status(error::CANCELLED, "Demuxer run cancelled");
+    else
+      status = DispatchSegment(segments[i].get());
+  }
+  // The segments still in flight reference this demuxer.
+  for (size_t i = 0; i < num_posted_segments; ++i)
+    WaitForSegment(*segments[i]);
+  return status;
+}
+
+void ParallelMp4Demuxer::Cancel() {
+  cancelled_ = true;
+}
+
+bool ParallelMp4Demuxer::ValidateOutputStreamIndex(size_t stream_index) const {
+  return stream_index < streams_.size();
+}
+
+bool ParallelMp4Demuxer::GetStreamIndex(const std::string& stream_label,
+                                        size_t* stream_index) const {
+  DCHECK(stream_index);
+  StreamType stream_type = kStreamUnknown;
+  if (stream_label == "video") {
+    stream_type = kStreamVideo;
+  } else if (stream_label == "audio") {
+    stream_type = kStreamAudio;
+  } else if (stream_label == "text") {
+    stream_type = kStreamText;
+  } else {
+    // Expect stream_label to be a zero based stream id.
+    return absl::SimpleAtoi(stream_label, stream_index) &&
+           *stream_index < streams_.size();
+  }
+  // The first stream of the type.
+  for (size_t i = 0; i < streams_.size(); ++i) {
+    if (streams_[i].info->stream_type() == stream_type) {
+      *stream_index = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+Status ParallelMp4Demuxer::PlanSegments(
+    size_t stream_index,
+    std::vector<std::unique_ptr<Segment>>* segments) {
+  const Stream& stream = streams_[stream_index];
+
+  // Chunk the samples without their data to find the segments.
+  auto source = std::make_shared<SegmentSource>();
+  auto recorder = std::make_shared<SegmentRecorder>();
+  RETURN_IF_ERROR(MediaHandler::Chain(
+      {source, std::make_shared<ChunkingHandler>(chunking_params_),
+       recorder}));
+  RETURN_IF_ERROR(source->Initialize());
+  RETURN_IF_ERROR(
+      source->Send(StreamData::FromStreamInfo(kStreamIndex, stream.info)));
+  // A sample without data is an end of stream sample, so all the samples
+  // share a placeholder byte instead.
+  std::shared_ptr<uint8_t> placeholder = BufferPool::GetInstance()->Allocate(1);
+  for (const Sample& sample : stream.samples) {
+    std::shared_ptr<MediaSample> media_sample =
+        MediaSample::CreateEmptyMediaSample();
+    media_sample->TransferData(placeholder, 1);
+    media_sample->set_dts(sample.dts);
+    media_sample->set_pts(sample.pts);
+    media_sample->set_duration(sample.duration);
+    media_sample->set_is_key_frame(sample.is_key_frame);
+    RETURN_IF_ERROR(source->Send(
+        StreamData::FromMediaSample(kStreamIndex, std::move(media_sample))));
+  }
+  RETURN_IF_ERROR(source->Flush());
+
+  // The samples before the first segment are dropped by the chunking.
+  size_t first_sample = stream.samples.size();
+  for (const SegmentRecorder::Record& record : recorder->records())
+    first_sample -= record.num_samples;
+
+  EncryptionHandler::StartState encryption_start_state;
+  if (stream.encryption_params) {
+    const FourCC protection_scheme =
+        static_cast<FourCC>(stream.encryption_params->protection_scheme);
+    // Used if the key has no IV, so that all the segments share it.
+    if (!AesCryptor::GenerateRandomIv(protection_scheme,
+                                      &encryption_start_state.iv)) {
+      return Status(error::ENCRYPTION_FAILURE, "Failed to generate an IV.");
+    }
+    encryption_start_state.remaining_clear_lead =
+        stream.encryption_params->clear_lead_in_seconds *
+        stream.info->time_scale();
+  }
+
+  // A stream with no samples still sends its stream info downstream.
+  const size_t num_segments = std::max<size_t>(recorder->records().size(), 1);
+  for (size_t i = 0; i < num_segments; ++i) {
+    auto segment = std::make_unique<Segment>();
+    segment->stream_index = stream_index;
+    segment->index = i;
+    segment->first_sample = first_sample;
+    segment->encryption_start_state = encryption_start_state;
+    segment->last_in_stream = i + 1 == num_segments;
+    if (i < recorder->records().size()) {
+      const SegmentRecorder::Record& record = recorder->records()[i];
+      segment->num_samples = record.num_samples;
+      first_sample += record.num_samples;
+      // Same as EncryptionHandler at the end of a segment.
+      if (encryption_start_state.remaining_clear_lead > 0) {
+        encryption_start_state.remaining_clear_lead -= record.duration;
+      } else {
+        encryption_start_state.num_encrypted_samples += record.num_samples;
+      }
+    }
+    segments->push_back(std::move(segment));
+  }
+  return Status::OK;
+}
+
+Status ParallelMp4Demuxer::PackageSegment(Segment* segment) const {
+  const Stream& stream = streams_[segment->stream_index];
+
+  ChunkingParams chunking_params = chunking_params_;
+  chunking_params.start_segment_number += segment->index;
+  auto source = std::make_shared<SegmentSource>();
+  std::vector<std::shared_ptr<MediaHandler>> handlers{
+      source, std::make_shared<ChunkingHandler>(chunking_params)};
+  if (stream.encryption_params) {
+    handlers.push_back(std::make_shared<EncryptionHandler>(
+        *stream.encryption_params, stream.key_source,
+        segment->encryption_start_state));
+  }
+  handlers.push_back(std::make_shared<SegmentSink>(&segment->output));
+  RETURN_IF_ERROR(MediaHandler::Chain(handlers));
+  RETURN_IF_ERROR(source->Initialize());
+
+  RETURN_IF_ERROR(
+      source->Send(StreamData::FromStreamInfo(kStreamIndex, stream.info)));
+  if (segment->num_samples > 0) {
+    std::unique_ptr<File, FileCloser> file(
+        File::OpenWithNoBuffering(file_name_.c_str(), "r"));
+    if (!file) {
+      return Status(error::FILE_FAILURE,
+                    "Cannot open file for reading " + file_name_);
+    }
+    for (size_t i = segment->first_sample;
+         i < segment->first_sample + segment->num_samples; ++i) {
+      if (cancelled_)
+        return Status(error::CANCELLED, "Demuxer run cancelled");
+      const Sample& sample = stream.samples[i];
+      std::shared_ptr<uint8_t> data =
+          BufferPool::GetInstance()->Allocate(sample.size);
+      if (!file->Seek(sample.offset) ||
+          !ReadFully(file.get(), data.get(), sample.size)) {
+        return Status(error::FILE_FAILURE, "Cannot read file " + file_name_);
+      }
+      std::shared_ptr<MediaSample> media_sample =
+          MediaSample::CreateEmptyMediaSample();
+      media_sample->TransferData(std::move(data), sample.size);
+      media_sample->set_dts(sample.dts);
+      media_sample->set_pts(sample.pts);
+      media_sample->set_duration(sample.duration);
+      media_sample->set_is_key_frame(sample.is_key_frame);
+      RETURN_IF_ERROR(source->Send(
+          StreamData::FromMediaSample(kStreamIndex, std::move(media_sample))));
+    }
+  }
+  return source->Flush();
+}
+
+void ParallelMp4Demuxer::PostSegment(Segment* segment) {
+  auto package = [this, segment]() {
+    Status status = PackageSegment(segment);
+    absl::MutexLock lock(&mutex_);
+    segment->status = status;
+    segment->done = true;
+    segment_done_.SignalAll();
+  };
+  if (thread_pool_)
+    thread_pool_->PostTask(std::move(package));
+  else
+    package();
+}
+
+void ParallelMp4Demuxer::WaitForSegment(const Segment& segment) {
+  absl::MutexLock lock(&mutex_);
+  while (!segment.done)
+    segment_done_.Wait(&mutex_);
+}
+
+Status ParallelMp4Demuxer::DispatchSegment(Segment* segment) {
+  RETURN_IF_ERROR(segment->status);
+  for (std::unique_ptr<StreamData>& stream_data : segment->output) {
+    // Every segment starts with the stream info, which is sent downstream
+    // only once.
+    if (stream_data->stream_data_type == StreamDataType::kStreamInfo &&
+        segment->index > 0) {
+      continue;
+    }
+    stream_data->stream_index = segment->stream_index;
+    RETURN_IF_ERROR(Dispatch(std::move(stream_data)));
+  }
+  segment->output.clear();
+  if (segment->last_in_stream)
+    return FlushDownstream(segment->stream_index);
+  return Status::OK;
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,179 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_DEMUXER_PARALLEL_MP4_DEMUXER_H_
+#define PACKAGER_MEDIA_DEMUXER_PARALLEL_MP4_DEMUXER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+
+#include <packager/chunking_params.h>
+#include <packager/crypto_params.h>
+#include <packager/media/crypto/encryption_handler.h>
+#include <packager/media/origin/origin_handler.h>
+#include <packager/status.h>
+
+namespace shaka {
+namespace media {
+
+class KeySource;
+class StreamInfo;
+class WorkStealingThreadPool;
+
+/// ParallelMp4Demuxer packages the audio and video streams of a local,
+/// non-fragmented MP4 file segment by segment on a thread pool. It takes the
+/// place of a Demuxer followed by a ChunkingHandler and an optional
+/// EncryptionHandler per stream.
+///
+/// The sample table in the 'moov' box gives the segment boundaries before
+/// any media data is read. Every segment is then read, chunked and encrypted
+/// by its own handlers on the pool, the encryption continuing the IV and the
+/// clear lead of the previous segments, and the results are dispatched in
+/// order. The output is the same as the output of the serial handlers.
+class ParallelMp4Demuxer : public OriginHandler {
+ public:
+  /// @param file_name is the input file, which must be a local file.
+  /// @param chunking_params are the parameters of the ChunkingHandler which
+  ///        this demuxer replaces. Cue points and low latency DASH are not
+  ///        supported.
+  /// @param thread_pool runs the segments. With no pool, the segments are
+  ///        packaged on the thread calling Run().
+  /// @param max_parallel_segments is the number of segments packaged at the
+  ///        same time, at least 1.
+  ParallelMp4Demuxer(const std::string& file_name,
+                     const ChunkingParams& chunking_params,
+                     WorkStealingThreadPool* thread_pool,
+                     size_t max_parallel_segments);
+  ~ParallelMp4Demuxer() override;
+
+  /// Read the 'moov' box of the file and index its samples. It must be called
+  /// before the other methods.
+  /// @return OK on success, UNIMPLEMENTED if the file cannot be split into
+  ///         segments, e.g. if it is fragmented or encrypted, in which case a
+  ///         Demuxer should be used instead.
+  Status Open();
+
+  /// @param stream_label can be 'audio', 'video', or stream number (zero
+  ///        based).
+  /// @return true if the specified stream exists and can be split into
+  ///         segments.
+  bool CanSplitStream(const std::string& stream_label) const;
+
+  /// @param stream_label can be 'audio', 'video', or stream number (zero
+  ///        based).
+  /// @param encryption_params are the parameters to encrypt the stream with.
+  /// @param key_source provides the encryption key.
+  /// @return true if the specified stream can be split into segments and its
+  ///         segments can be encrypted separately, which depends on the key
+  ///         returned by |key_source|.
+  bool CanEncryptStream(const std::string& stream_label,
+                        const EncryptionParams& encryption_params,
+                        KeySource* key_source) const;
+
+  /// Set the handler for the specified stream.
+  /// @param stream_label can be 'audio', 'video', or stream number (zero
+  ///        based).
+  /// @param encryption_params, if not null, are the parameters to encrypt the
+  ///        stream with. Key rotation and 16-byte per-sample IVs are not
+  ///        supported, see CanEncryptStream().
+  /// @param key_source provides the encryption key. It is used from several
+  ///        threads at the same time.
+  /// @param handler is the handler for the specified stream.
+  Status SetHandler(const std::string& stream_label,
+                    const EncryptionParams* encryption_params,
+                    KeySource* key_source,
+                    std::shared_ptr<MediaHandler> handler);
+
+  /// Override the language in the specified stream. If the specified stream is
+  /// a video stream or invalid, this function is a no-op.
+  /// @param stream_label can be 'audio', 'video', or stream number (zero
+  ///        based).
+  /// @param language_override is the new language.
+  void SetLanguageOverride(const std::string& stream_label,
+                           const std::string& language_override);
+
+  /// @name OriginHandler implementation overrides.
+  /// @{
+  Status Run() override;
+  void Cancel() override;
+  /// @}
+
+ protected:
+  /// @name MediaHandler implementation overrides.
+  /// @{
+  Status InitializeInternal() override { return Status::OK; }
+  bool ValidateOutputStreamIndex(size_t stream_index) const override;
+  /// @}
+
+ private:
+  ParallelMp4Demuxer(const ParallelMp4Demuxer&) = delete;
+  ParallelMp4Demuxer& operator=(const ParallelMp4Demuxer&) = delete;
+
+  struct Sample {
+    int64_t offset = 0;
+    int64_t size = 0;
+    int64_t dts = 0;
+    int64_t pts = 0;
+    int64_t duration = 0;
+    bool is_key_frame = false;
+  };
+
+  struct Stream {
+    std::shared_ptr<StreamInfo> info;
+    std::vector<Sample> samples;
+    std::optional<EncryptionParams> encryption_params;
+    KeySource* key_source = nullptr;
+  };
+
+  struct Segment {
+    size_t stream_index = 0;
+    // Zero based index of the segment in the stream.
+    int64_t index = 0;
+    size_t first_sample = 0;
+    size_t num_samples = 0;
+    EncryptionHandler::StartState encryption_start_state;
+    bool last_in_stream = false;
+
+    // Set by the task packaging the segment.
+    bool done = false;
+    Status status;
+    std::vector<std::unique_ptr<StreamData>> output;
+  };
+
+  bool GetStreamIndex(const std::string& stream_label,
+                      size_t* stream_index) const;
+  // Appends the segments of the stream at |stream_index| to |segments|.
+  Status PlanSegments(size_t stream_index,
+                      std::vector<std::unique_ptr<Segment>>* segments);
+  // Reads, chunks and encrypts |segment|, which can run on any thread.
+  Status PackageSegment(Segment* segment) const;
+  void PostSegment(Segment* segment);
+  void WaitForSegment(const Segment& segment);
+  Status DispatchSegment(Segment* segment);
+
+  const std::string file_name_;
+  const ChunkingParams chunking_params_;
+  WorkStealingThreadPool* const thread_pool_;
+  const size_t max_parallel_segments_;
+
+  std::vector<Stream> streams_;
+  std::atomic<bool> cancelled_{false};
+
+  absl::Mutex mutex_;
+  absl::CondVar segment_done_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_DEMUXER_PARALLEL_MP4_DEMUXER_H_
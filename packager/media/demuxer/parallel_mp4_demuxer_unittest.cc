@@ -0,0 +1,388 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/demuxer/parallel_mp4_demuxer.h>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <packager/media/base/decrypt_config.h>
+#include <packager/media/base/media_handler_test_base.h>
+#include <packager/media/base/media_sample.h>
+#include <packager/media/base/raw_key_source.h>
+#include <packager/media/base/stream_info.h>
+#include <packager/media/base/work_stealing_thread_pool.h>
+#include <packager/media/chunking/chunking_handler.h>
+#include <packager/media/crypto/encryption_handler.h>
+#include <packager/media/demuxer/demuxer.h>
+#include <packager/media/test/test_data_util.h>
+#include <packager/status/status_test_util.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+const char kInput[] = "bear-640x360.mp4";
+const char* const kStreams[] = {"video", "audio"};
+const size_t kNumThreads = 4;
+const size_t kMaxParallelSegments = 2;
+
+const uint8_t kKeyId[]{
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15,
+};
+const uint8_t kKey[]{
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15,
+};
+const uint8_t kIv[]{
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+    0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+};
+
+// A key server's key source, which returns the same key for all the streams.
+class FakeKeySource : public KeySource {
+ public:
+  explicit FakeKeySource(size_t iv_size) {
+    key_.key_id.assign(std::begin(kKeyId), std::end(kKeyId));
+    key_.key.assign(std::begin(kKey), std::end(kKey));
+    key_.iv.assign(kIv, kIv + iv_size);
+  }
+
+  Status FetchKeys(EmeInitDataType init_data_type,
+                   const std::vector<uint8_t>& init_data) override {
+    return Status::OK;
+  }
+  Status GetKey(const std::string& stream_label, EncryptionKey* key) override {
+    *key = key_;
+    return Status::OK;
+  }
+  Status GetKey(const std::vector<uint8_t>& key_id,
+                EncryptionKey* key) override {
+    *key = key_;
+    return Status::OK;
+  }
+  Status GetCryptoPeriodKey(uint32_t crypto_period_index,
+                            int32_t crypto_period_duration_in_seconds,
+                            const std::string& stream_label,
+                            EncryptionKey* key) override {
+    return Status(error::UNIMPLEMENTED, "");
+  }
+
+ private:
+  EncryptionKey key_;
+};
+
+std::vector<uint8_t> GetData(const MediaSample& sample) {
+  return std::vector<uint8_t>(sample.data(),
+                              sample.data() + sample.data_size());
+}
+
+// Compares stream data from the serial and the parallel pipelines, the IV of
+// the encrypted samples only if |compare_ivs|.
+void ExpectSameStreamData(
+    const std::vector<std::unique_ptr<StreamData>>& expected,
+    const std::vector<std::unique_ptr<StreamData>>& actual,
+    bool compare_ivs) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    SCOPED_TRACE("Stream data " + std::to_string(i));
+    const StreamData& e = *expected[i];
+    const StreamData& a = *actual[i];
+    ASSERT_EQ(e.stream_data_type, a.stream_data_type);
+    switch (e.stream_data_type) {
+      case StreamDataType::kStreamInfo:
+        EXPECT_EQ(e.stream_info->ToString(), a.stream_info->ToString());
+        EXPECT_EQ(e.stream_info->is_encrypted(),
+                  a.stream_info->is_encrypted());
+        break;
+      case StreamDataType::kSegmentInfo:
+        EXPECT_EQ(e.segment_info->start_timestamp,
+                  a.segment_info->start_timestamp);
+        EXPECT_EQ(e.segment_info->duration, a.segment_info->duration);
+        EXPECT_EQ(e.segment_info->segment_number,
+                  a.segment_info->segment_number);
+        EXPECT_EQ(e.segment_info->is_subsegment,
+                  a.segment_info->is_subsegment);
+        EXPECT_EQ(e.segment_info->is_encrypted, a.segment_info->is_encrypted);
+        break;
+      case StreamDataType::kMediaSample: {
+        const MediaSample& es = *e.media_sample;
+        const MediaSample& as = *a.media_sample;
+        EXPECT_EQ(es.dts(), as.dts());
+        EXPECT_EQ(es.pts(), as.pts());
+        EXPECT_EQ(es.duration(), as.duration());
+        EXPECT_EQ(es.is_key_frame(), as.is_key_frame());
+        ASSERT_EQ(es.is_encrypted(), as.is_encrypted());
+        if (es.is_encrypted()) {
+          const DecryptConfig& ec = *es.decrypt_config();
+          const DecryptConfig& ac = *as.decrypt_config();
+          ASSERT_EQ(ec.subsamples().size(), ac.subsamples().size());
+          for (size_t j = 0; j < ec.subsamples().size(); ++j) {
+            EXPECT_EQ(ec.subsamples()[j].clear_bytes,
+                      ac.subsamples()[j].clear_bytes);
+            EXPECT_EQ(ec.subsamples()[j].cipher_bytes,
+                      ac.subsamples()[j].cipher_bytes);
+          }
+          if (compare_ivs) {
+            EXPECT_EQ(ec.iv(), ac.iv());
+            EXPECT_EQ(GetData(es), GetData(as));
+          }
+        } else {
+          EXPECT_EQ(GetData(es), GetData(as));
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
+}
+
+// Expects the IV of every encrypted sample to follow the IV of the previous
+// one, which is the same for a constant IV.
+void ExpectContinuousIvs(
+    const std::vector<std::unique_ptr<StreamData>>& stream_data,
+    bool constant_iv) {
+  std::vector<uint8_t> expected_iv;
+  size_t num_encrypted_samples = 0;
+  for (const auto& data : stream_data) {
+    if (data->stream_data_type != StreamDataType::kMediaSample ||
+        !data->media_sample->is_encrypted()) {
+      continue;
+    }
+    const std::vector<uint8_t>& iv = data->media_sample->decrypt_config()->iv();
+    if (!expected_iv.empty())
+      EXPECT_EQ(expected_iv, iv) << "Encrypted sample "
+                                 << num_encrypted_samples;
+    expected_iv = iv;
+    if (!constant_iv) {
+      ASSERT_EQ(8u, expected_iv.size());
+      for (size_t i = expected_iv.size(); i > 0 && ++expected_iv[i - 1] == 0;
+           --i) {
+      }
+    }
+    ++num_encrypted_samples;
+  }
+  EXPECT_GT(num_encrypted_samples, 0u);
+}
+
+}  // namespace
+
+class ParallelMp4DemuxerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    chunking_params_.segment_duration_in_seconds = 0.5;
+    chunking_params_.subsegment_duration_in_seconds = 0.25;
+    chunking_params_.start_segment_number = 3;
+  }
+
+  std::unique_ptr<KeySource> CreateKeySource(bool key_has_iv,
+                                             FourCC protection_scheme) {
+    RawKeyParams raw_key;
+    RawKeyParams::KeyInfo& key_info = raw_key.key_map[""];
+    key_info.key_id.assign(std::begin(kKeyId), std::end(kKeyId));
+    key_info.key.assign(std::begin(kKey), std::end(kKey));
+    if (key_has_iv) {
+      const size_t iv_size = protection_scheme == FOURCC_cbcs ? 16 : 8;
+      raw_key.iv.assign(kIv, kIv + iv_size);
+      key_info.iv = raw_key.iv;
+    }
+    return RawKeySource::Create(raw_key);
+  }
+
+  EncryptionParams GetEncryptionParams(FourCC protection_scheme) {
+    EncryptionParams encryption_params;
+    encryption_params.protection_scheme = protection_scheme;
+    encryption_params.clear_lead_in_seconds = 0.7;
+    encryption_params.stream_label_func =
+        [](const EncryptionParams::EncryptedStreamAttributes&) {
+          return std::string();
+        };
+    return encryption_params;
+  }
+
+  // Runs Demuxer -> ChunkingHandler -> EncryptionHandler, the encryption
+  // only with |key_source|.
+  void RunSerial(KeySource* key_source,
+                 const EncryptionParams& encryption_params) {
+    Demuxer demuxer(GetTestDataFilePath(kInput).string());
+    for (size_t i = 0; i < std::size(kStreams); ++i) {
+      std::vector<std::shared_ptr<MediaHandler>> handlers{
+          std::make_shared<ChunkingHandler>(chunking_params_)};
+      if (key_source) {
+        handlers.push_back(
+            std::make_shared<EncryptionHandler>(encryption_params, key_source));
+      }
+      serial_outputs_[i] = std::make_shared<CachingMediaHandler>();
+      handlers.push_back(serial_outputs_[i]);
+      ASSERT_OK(MediaHandler::Chain(handlers));
+      ASSERT_OK(demuxer.SetHandler(kStreams[i], handlers.front()));
+    }
+    ASSERT_OK(demuxer.Initialize());
+    ASSERT_OK(demuxer.Run());
+  }
+
+  void RunParallel(KeySource* key_source,
+                   const EncryptionParams& encryption_params) {
+    WorkStealingThreadPool thread_pool(kNumThreads);
+    ParallelMp4Demuxer demuxer(GetTestDataFilePath(kInput).string(),
+                               chunking_params_, &thread_pool,
+                               kMaxParallelSegments);
+    ASSERT_OK(demuxer.Open());
+    for (size_t i = 0; i < std::size(kStreams); ++i) {
+      parallel_outputs_[i] = std::make_shared<CachingMediaHandler>();
+      ASSERT_OK(demuxer.SetHandler(kStreams[i],
+                                   key_source ? &encryption_params : nullptr,
+                                   key_source, parallel_outputs_[i]));
+    }
+    ASSERT_OK(demuxer.Initialize());
+    ASSERT_OK(demuxer.Run());
+  }
+
+  size_t CountSegments(const CachingMediaHandler& output) {
+    size_t num_segments = 0;
+    for (const auto& stream_data : output.Cache()) {
+      if (stream_data->stream_data_type == StreamDataType::kSegmentInfo &&
+          !stream_data->segment_info->is_subsegment) {
+        ++num_segments;
+      }
+    }
+    return num_segments;
+  }
+
+  ChunkingParams chunking_params_;
+  std::shared_ptr<CachingMediaHandler> serial_outputs_[std::size(kStreams)];
+  std::shared_ptr<CachingMediaHandler> parallel_outputs_[std::size(kStreams)];
+};
+
+TEST_F(ParallelMp4DemuxerTest, SameAsSerialClear) {
+  ASSERT_NO_FATAL_FAILURE(RunSerial(nullptr, EncryptionParams()));
+  ASSERT_NO_FATAL_FAILURE(RunParallel(nullptr, EncryptionParams()));
+  for (size_t i = 0; i < std::size(kStreams); ++i) {
+    SCOPED_TRACE(kStreams[i]);
+    EXPECT_GT(CountSegments(*serial_outputs_[i]), kMaxParallelSegments);
+    ExpectSameStreamData(serial_outputs_[i]->Cache(),
+                         parallel_outputs_[i]->Cache(), true);
+  }
+}
+
+class ParallelMp4DemuxerEncryptionTest
+    : public ParallelMp4DemuxerTest,
+      public ::testing::WithParamInterface<FourCC> {};
+
+TEST_P(ParallelMp4DemuxerEncryptionTest, SameAsSerial) {
+  std::unique_ptr<KeySource> key_source = CreateKeySource(true, GetParam());
+  const EncryptionParams encryption_params = GetEncryptionParams(GetParam());
+  ASSERT_NO_FATAL_FAILURE(RunSerial(key_source.get(), encryption_params));
+  ASSERT_NO_FATAL_FAILURE(RunParallel(key_source.get(), encryption_params));
+  for (size_t i = 0; i < std::size(kStreams); ++i) {
+    SCOPED_TRACE(kStreams[i]);
+    ExpectSameStreamData(serial_outputs_[i]->Cache(),
+                         parallel_outputs_[i]->Cache(), true);
+  }
+}
+
+TEST_P(ParallelMp4DemuxerEncryptionTest, KeyWithoutIv) {
+  // The IV is random, so only its continuity across the segments is checked.
+  std::unique_ptr<KeySource> key_source = CreateKeySource(false, GetParam());
+  const EncryptionParams encryption_params = GetEncryptionParams(GetParam());
+  ASSERT_NO_FATAL_FAILURE(RunSerial(key_source.get(), encryption_params));
+  ASSERT_NO_FATAL_FAILURE(RunParallel(key_source.get(), encryption_params));
+  for (size_t i = 0; i < std::size(kStreams); ++i) {
+    SCOPED_TRACE(kStreams[i]);
+    ExpectSameStreamData(serial_outputs_[i]->Cache(),
+                         parallel_outputs_[i]->Cache(), false);
+    ExpectContinuousIvs(parallel_outputs_[i]->Cache(),
+                        GetParam() == FOURCC_cbcs);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Schemes,
+                         ParallelMp4DemuxerEncryptionTest,
+                         ::testing::Values(FOURCC_cenc, FOURCC_cbcs));
+
+TEST_F(ParallelMp4DemuxerTest, FragmentedFileIsNotSupported) {
+  ParallelMp4Demuxer demuxer(
+      GetTestDataFilePath("bear-640x360-av_frag.mp4").string(),
+      chunking_params_, nullptr, kMaxParallelSegments);
+  EXPECT_EQ(error::UNIMPLEMENTED, demuxer.Open().error_code());
+}
+
+TEST_F(ParallelMp4DemuxerTest, TrailingMoov) {
+  ParallelMp4Demuxer demuxer(
+      GetTestDataFilePath("bear-640x360-trailing-moov.mp4").string(),
+      chunking_params_, nullptr, kMaxParallelSegments);
+  ASSERT_OK(demuxer.Open());
+  EXPECT_TRUE(demuxer.CanSplitStream("video"));
+  EXPECT_TRUE(demuxer.CanSplitStream("1"));
+  EXPECT_FALSE(demuxer.CanSplitStream("text"));
+  EXPECT_FALSE(demuxer.CanSplitStream("2"));
+}
+
+TEST_F(ParallelMp4DemuxerTest, NotMp4IsNotSupported) {
+  ParallelMp4Demuxer demuxer(GetTestDataFilePath("bear-640x360.ts").string(),
+                             chunking_params_, nullptr, kMaxParallelSegments);
+  EXPECT_EQ(error::UNIMPLEMENTED, demuxer.Open().error_code());
+}
+
+TEST_F(ParallelMp4DemuxerTest, KeyRotationIsNotSupported) {
+  ParallelMp4Demuxer demuxer(GetTestDataFilePath(kInput).string(),
+                             chunking_params_, nullptr, kMaxParallelSegments);
+  ASSERT_OK(demuxer.Open());
+  std::unique_ptr<KeySource> key_source = CreateKeySource(true, FOURCC_cenc);
+  EncryptionParams encryption_params = GetEncryptionParams(FOURCC_cenc);
+  encryption_params.crypto_period_duration_in_seconds = 1;
+  EXPECT_EQ(error::UNIMPLEMENTED,
+            demuxer
+                .SetHandler("video", &encryption_params, key_source.get(),
+                            std::make_shared<CachingMediaHandler>())
+                .error_code());
+}
+
+// A key server may return a 16-byte IV, which cannot be advanced over the
+// samples of the previous segments with cenc.
+TEST_F(ParallelMp4DemuxerTest, KeyServer16ByteIvIsNotSupportedWithCenc) {
+  ParallelMp4Demuxer demuxer(GetTestDataFilePath(kInput).string(),
+                             chunking_params_, nullptr, kMaxParallelSegments);
+  ASSERT_OK(demuxer.Open());
+  FakeKeySource key_source(16);
+  const EncryptionParams encryption_params = GetEncryptionParams(FOURCC_cenc);
+  EXPECT_FALSE(
+      demuxer.CanEncryptStream("video", encryption_params, &key_source));
+  EXPECT_EQ(error::UNIMPLEMENTED,
+            demuxer
+                .SetHandler("video", &encryption_params, &key_source,
+                            std::make_shared<CachingMediaHandler>())
+                .error_code());
+
+  // The IV is constant with cbcs, so it does not need to be advanced.
+  EXPECT_TRUE(demuxer.CanEncryptStream(
+      "video", GetEncryptionParams(FOURCC_cbcs), &key_source));
+}
+
+TEST_F(ParallelMp4DemuxerTest, KeyServer8ByteIv) {
+  FakeKeySource key_source(8);
+  const EncryptionParams encryption_params = GetEncryptionParams(FOURCC_cenc);
+  {
+    ParallelMp4Demuxer demuxer(GetTestDataFilePath(kInput).string(),
+                               chunking_params_, nullptr,
+                               kMaxParallelSegments);
+    ASSERT_OK(demuxer.Open());
+    EXPECT_TRUE(
+        demuxer.CanEncryptStream("video", encryption_params, &key_source));
+  }
+  ASSERT_NO_FATAL_FAILURE(RunSerial(&key_source, encryption_params));
+  ASSERT_NO_FATAL_FAILURE(RunParallel(&key_source, encryption_params));
+  for (size_t i = 0; i < std::size(kStreams); ++i) {
+    SCOPED_TRACE(kStreams[i]);
+    ExpectSameStreamData(serial_outputs_[i]->Cache(),
+                         parallel_outputs_[i]->Cache(), true);
+  }
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -86,6 +86,17 @@ void CombinedMuxerListener::OnCompletedSegment(int64_t duration,
   }
 }
 
+void CombinedMuxerListener::OnNewChunk(int64_t start_time,
+                                       int64_t duration,
+                                       uint64_t start_byte_offset,
+                                       uint64_t size,
+                                       bool is_independent) {
+  for (auto& listener : muxer_listeners_) {
+    listener->OnNewChunk(start_time, duration, start_byte_offset, size,
+                         is_independent);
+  }
+}
+
 void CombinedMuxerListener::OnKeyFrame(int64_t timestamp,
                                        uint64_t start_byte_offset,
                                        uint64_t size) {
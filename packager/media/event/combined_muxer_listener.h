@@ -48,6 +48,11 @@ class CombinedMuxerListener : public MuxerListener {
                     int64_t segment_number) override;
   void OnCompletedSegment(int64_t duration,
                           uint64_t segment_file_size) override;
+  void OnNewChunk(int64_t start_time,
+                  int64_t duration,
+                  uint64_t start_byte_offset,
+                  uint64_t size,
+                  bool is_independent) override;
   void OnKeyFrame(int64_t timestamp,
                   uint64_t start_byte_offset,
                   uint64_t size) override;
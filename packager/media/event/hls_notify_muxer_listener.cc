@@ -131,6 +131,14 @@ void HlsNotifyMuxerListener::OnMediaStart(const MuxerOptions& muxer_options,
     return;
   }
 
+  is_low_latency_ = muxer_options.mp4_params.low_latency_dash_mode;
+  // I-frames only playlists do not have parts.
+  if (is_low_latency_ && !iframes_only_) {
+    part_target_duration_ = static_cast<int64_t>(
+        hls_notifier_->hls_params().part_target_duration *
+        media_info_->reference_time_scale());
+  }
+
   if (!NotifyNewStream())
     return;
   DCHECK(stream_id_);
@@ -252,6 +260,14 @@ void HlsNotifyMuxerListener::OnNewSegment(const std::string& file_name,
     event_info.segment_info = {start_time, duration, segment_file_size,
                                segment_number};
     event_info_.push_back(event_info);
+  } else if (is_low_latency_) {
+    // Only the first chunk is written; the segment is notified when it is
+    // complete, in OnCompletedSegment(), with its full duration and size.
+    UNUSED(duration);
+    UNUSED(segment_file_size);
+    open_segment_name_ = file_name;
+    open_segment_start_time_ = start_time;
+    pending_part_.reset();
   } else {
     // For multisegment, it always starts from the beginning of the file.
     const size_t kStartingByteOffset = 0u;
@@ -262,6 +278,44 @@ void HlsNotifyMuxerListener::OnNewSegment(const std::string& file_name,
   }
 }
 
+void HlsNotifyMuxerListener::OnCompletedSegment(int64_t duration,
+                                                 uint64_t segment_file_size) {
+  if (!is_low_latency_ || open_segment_name_.empty())
+    return;
+  NotifyPendingPart();
+  const size_t kStartingByteOffset = 0u;
+  const bool result = hls_notifier_->NotifyNewSegment(
+      stream_id_.value(), open_segment_name_, open_segment_start_time_,
+      duration, kStartingByteOffset, segment_file_size);
+  LOG_IF(WARNING, !result) << "Failed to add new segment.";
+  open_segment_name_.clear();
+}
+
+void HlsNotifyMuxerListener::OnNewChunk(int64_t start_time,
+                                        int64_t duration,
+                                        uint64_t start_byte_offset,
+                                        uint64_t size,
+                                        bool is_independent) {
+  UNUSED(start_time);
+  if (part_target_duration_ <= 0 || open_segment_name_.empty())
+    return;
+  // Chunks are aggregated into parts no longer than the part target duration.
+  if (pending_part_ &&
+      pending_part_->duration + duration > part_target_duration_) {
+    NotifyPendingPart();
+  }
+  if (!pending_part_) {
+    pending_part_ = PartInfo();
+    pending_part_->start_byte_offset = start_byte_offset;
+    pending_part_->is_independent = is_independent;
+  }
+  pending_part_->duration += duration;
+  pending_part_->size += size;
+  // Notify as soon as the part cannot be extended, for lower latency.
+  if (pending_part_->duration >= part_target_duration_)
+    NotifyPendingPart();
+}
+
 void HlsNotifyMuxerListener::OnKeyFrame(int64_t timestamp,
                                         uint64_t start_byte_offset,
                                         uint64_t size) {
@@ -292,6 +346,17 @@ void HlsNotifyMuxerListener::OnCueEvent(int64_t timestamp,
   }
 }
 
+void HlsNotifyMuxerListener::NotifyPendingPart() {
+  if (!pending_part_)
+    return;
+  const bool result = hls_notifier_->NotifyNewPart(
+      stream_id_.value(), open_segment_name_, pending_part_->duration,
+      pending_part_->start_byte_offset, pending_part_->size,
+      pending_part_->is_independent);
+  LOG_IF(WARNING, !result) << "Failed to add new part.";
+  pending_part_.reset();
+}
+
 bool HlsNotifyMuxerListener::NotifyNewStream() {
   DCHECK(media_info_);
 
@@ -74,6 +74,13 @@ class HlsNotifyMuxerListener : public MuxerListener {
                     int64_t duration,
                     uint64_t segment_file_size,
                     int64_t segment_number) override;
+  void OnCompletedSegment(int64_t duration,
+                          uint64_t segment_file_size) override;
+  void OnNewChunk(int64_t start_time,
+                  int64_t duration,
+                  uint64_t start_byte_offset,
+                  uint64_t size,
+                  bool is_independent) override;
   void OnKeyFrame(int64_t timestamp,
                   uint64_t start_byte_offset,
                   uint64_t size) override;
@@ -85,6 +92,8 @@ class HlsNotifyMuxerListener : public MuxerListener {
   HlsNotifyMuxerListener& operator=(const HlsNotifyMuxerListener&) = delete;
 
   bool NotifyNewStream();
+  // Notifies the chunks aggregated in |pending_part_|, if any.
+  void NotifyPendingPart();
 
   const std::string playlist_name_;
   const bool iframes_only_;
@@ -110,6 +119,22 @@ class HlsNotifyMuxerListener : public MuxerListener {
   // NotifyCueEvent) after NotifyNewStream is called in OnMediaEnd. Only needed
   // for on-demand as the functions are called immediately in live mode.
   std::vector<EventInfo> event_info_;
+
+  // Low latency segments are notified when they are complete, after their
+  // chunks are notified as LL-HLS parts if |part_target_duration_| is set.
+  bool is_low_latency_ = false;
+  // In timescale of the media.
+  int64_t part_target_duration_ = 0;
+  std::string open_segment_name_;
+  int64_t open_segment_start_time_ = 0;
+  // Consecutive chunks of the open segment, not notified yet.
+  struct PartInfo {
+    int64_t duration = 0;
+    uint64_t start_byte_offset = 0;
+    uint64_t size = 0;
+    bool is_independent = false;
+  };
+  std::optional<PartInfo> pending_part_;
 };
 
 }  // namespace media
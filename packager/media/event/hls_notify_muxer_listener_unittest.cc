@@ -31,6 +31,8 @@ namespace {
 class MockHlsNotifier : public hls::HlsNotifier {
  public:
   MockHlsNotifier() : HlsNotifier(HlsParams()) {}
+  explicit MockHlsNotifier(const HlsParams& hls_params)
+      : HlsNotifier(hls_params) {}
 
   MOCK_METHOD0(Init, bool());
   MOCK_METHOD5(NotifyNewStream,
@@ -48,6 +50,13 @@ class MockHlsNotifier : public hls::HlsNotifier {
                     int64_t duration,
                     uint64_t start_byte_offset,
                     uint64_t size));
+  MOCK_METHOD6(NotifyNewPart,
+               bool(uint32_t stream_id,
+                    const std::string& segment_name,
+                    int64_t duration,
+                    uint64_t start_byte_offset,
+                    uint64_t size,
+                    bool is_independent));
   MOCK_METHOD4(NotifyKeyFrame,
                bool(uint32_t stream_id,
                     int64_t timestamp,
@@ -80,6 +89,7 @@ const int64_t kSegmentStartTime = 19283;
 const int64_t kSegmentDuration = 98028;
 const uint64_t kSegmentSize = 756739;
 const int64_t kAnySegmentNumber = 10;
+const int32_t kTimeScale = 90000;
 
 const int64_t kCueStartTime = kSegmentStartTime;
 
@@ -527,5 +537,110 @@ INSTANTIATE_TEST_CASE_P(InstantiationName,
                         HlsNotifyMuxerListenerKeyFrameTest,
                         Bool());
 
+class HlsNotifyMuxerListenerLowLatencyTest : public ::testing::Test {
+ protected:
+  explicit HlsNotifyMuxerListenerLowLatencyTest(
+      double part_target_duration = 0.5)
+      : mock_notifier_(GetHlsParams(part_target_duration)),
+        listener_(kDefaultPlaylistName,
+                  !kIFramesOnlyPlaylist,
+                  kDefaultName,
+                  kDefaultGroupId,
+                  std::vector<std::string>(),  // no characteristics.
+                  kForced,
+                  &mock_notifier_,
+                  0) {}
+
+  static HlsParams GetHlsParams(double part_target_duration) {
+    HlsParams hls_params;
+    hls_params.playlist_type = HlsPlaylistType::kLive;
+    hls_params.part_target_duration = part_target_duration;
+    return hls_params;
+  }
+
+  void SetUp() override {
+    ON_CALL(mock_notifier_, NotifyNewStream(_, _, _, _, _))
+        .WillByDefault(Return(true));
+    std::shared_ptr<StreamInfo> video_stream_info =
+        CreateVideoStreamInfo(GetDefaultVideoStreamInfoParams());
+    MuxerOptions muxer_options;
+    muxer_options.segment_template = "$Number$.m4s";
+    muxer_options.mp4_params.low_latency_dash_mode = true;
+    listener_.OnMediaStart(muxer_options, *video_stream_info, kTimeScale,
+                           MuxerListener::kContainerMp4);
+  }
+
+  MockHlsNotifier mock_notifier_;
+  HlsNotifyMuxerListener listener_;
+};
+
+// Verify that the chunks are notified as parts of up to the part target
+// duration, and that the segment is notified once it is complete.
+TEST_F(HlsNotifyMuxerListenerLowLatencyTest, ChunksToParts) {
+  const int64_t kChunkDuration = kTimeScale / 5;  // 0.2 seconds.
+  const uint64_t kChunkSize = 1000;
+  const uint64_t kHeaderSize = 24;
+  const int kNumChunks = 5;
+
+  InSequence in_sequence;
+  EXPECT_CALL(mock_notifier_,
+              NotifyNewPart(_, StrEq("1.m4s"), 2 * kChunkDuration, kHeaderSize,
+                            2 * kChunkSize, true));
+  EXPECT_CALL(mock_notifier_,
+              NotifyNewPart(_, StrEq("1.m4s"), 2 * kChunkDuration,
+                            kHeaderSize + 2 * kChunkSize, 2 * kChunkSize,
+                            false));
+  EXPECT_CALL(mock_notifier_,
+              NotifyNewPart(_, StrEq("1.m4s"), kChunkDuration,
+                            kHeaderSize + 4 * kChunkSize, kChunkSize, false));
+  EXPECT_CALL(mock_notifier_,
+              NotifyNewSegment(_, StrEq("1.m4s"), kSegmentStartTime,
+                               kNumChunks * kChunkDuration, 0,
+                               kHeaderSize + kNumChunks * kChunkSize));
+
+  // The segment is announced with its first chunk.
+  listener_.OnNewSegment("1.m4s", kSegmentStartTime, kChunkDuration,
+                         kHeaderSize + kChunkSize, kAnySegmentNumber);
+  for (int i = 0; i < kNumChunks; ++i) {
+    listener_.OnNewChunk(kSegmentStartTime + i * kChunkDuration,
+                         kChunkDuration, kHeaderSize + i * kChunkSize,
+                         kChunkSize, i == 0);
+  }
+  listener_.OnCompletedSegment(kNumChunks * kChunkDuration,
+                               kHeaderSize + kNumChunks * kChunkSize);
+}
+
+class HlsNotifyMuxerListenerLowLatencyNoPartsTest
+    : public HlsNotifyMuxerListenerLowLatencyTest {
+ protected:
+  HlsNotifyMuxerListenerLowLatencyNoPartsTest()
+      : HlsNotifyMuxerListenerLowLatencyTest(0) {}
+};
+
+// Verify that without parts, the segment is still notified once it is
+// complete, with its full duration and size.
+TEST_F(HlsNotifyMuxerListenerLowLatencyNoPartsTest, CompletedSegment) {
+  const int64_t kChunkDuration = kTimeScale / 5;  // 0.2 seconds.
+  const uint64_t kChunkSize = 1000;
+  const uint64_t kHeaderSize = 24;
+  const int kNumChunks = 5;
+
+  EXPECT_CALL(mock_notifier_, NotifyNewPart(_, _, _, _, _, _)).Times(0);
+  EXPECT_CALL(mock_notifier_,
+              NotifyNewSegment(_, StrEq("1.m4s"), kSegmentStartTime,
+                               kNumChunks * kChunkDuration, 0,
+                               kHeaderSize + kNumChunks * kChunkSize));
+
+  listener_.OnNewSegment("1.m4s", kSegmentStartTime, kChunkDuration,
+                         kHeaderSize + kChunkSize, kAnySegmentNumber);
+  for (int i = 0; i < kNumChunks; ++i) {
+    listener_.OnNewChunk(kSegmentStartTime + i * kChunkDuration,
+                         kChunkDuration, kHeaderSize + i * kChunkSize,
+                         kChunkSize, i == 0);
+  }
+  listener_.OnCompletedSegment(kNumChunks * kChunkDuration,
+                               kHeaderSize + kNumChunks * kChunkSize);
+}
+
 }  // namespace media
 }  // namespace shaka
@@ -651,7 +651,7 @@ TEST_F(MpdNotifyMuxerListenerTest, LowLatencyDash) {
   EXPECT_CALL(*notifier_, NotifyCueEvent(_, kStartTime2));
   EXPECT_CALL(*notifier_, NotifyNewSegment(_, kStartTime2, kDuration,
                                            kSegmentSize2, kSegmentNumber2));
-  EXPECT_CALL(*notifier_, Flush()).Times(2);
+  EXPECT_CALL(*notifier_, ScheduleFlush()).Times(2);
 
   listener_->OnMediaStart(muxer_options, *video_stream_info,
                           kDefaultReferenceTimeScale,
@@ -730,12 +730,12 @@ TEST_P(MpdNotifyMuxerListenerTest, LiveNoKeyRotation) {
                                            kSegmentFileSize1, kSegmentNumber1));
   // Flush should only be called once in OnMediaEnd.
   if (GetParam() == MpdType::kDynamic)
-    EXPECT_CALL(*notifier_, Flush());
+    EXPECT_CALL(*notifier_, ScheduleFlush());
   EXPECT_CALL(*notifier_, NotifyCueEvent(_, kStartTime2));
   EXPECT_CALL(*notifier_, NotifyNewSegment(_, kStartTime2, kDuration2,
                                            kSegmentFileSize2, kSegmentNumber2));
   if (GetParam() == MpdType::kDynamic)
-    EXPECT_CALL(*notifier_, Flush());
+    EXPECT_CALL(*notifier_, ScheduleFlush());
 
   std::vector<uint8_t> iv(kBogusIv, kBogusIv + std::size(kBogusIv));
   listener_->OnEncryptionInfoReady(kInitialEncryptionInfo, FOURCC_cbcs,
@@ -811,11 +811,11 @@ TEST_P(MpdNotifyMuxerListenerTest, LiveWithKeyRotation) {
                                            kSegmentFileSize1, kSegmentNumber1));
   // Flush should only be called once in OnMediaEnd.
   if (GetParam() == MpdType::kDynamic)
-    EXPECT_CALL(*notifier_, Flush());
+    EXPECT_CALL(*notifier_, ScheduleFlush());
   EXPECT_CALL(*notifier_, NotifyNewSegment(_, kStartTime2, kDuration2,
                                            kSegmentFileSize2, kSegmentNumber2));
   if (GetParam() == MpdType::kDynamic)
-    EXPECT_CALL(*notifier_, Flush());
+    EXPECT_CALL(*notifier_, ScheduleFlush());
 
   std::vector<uint8_t> iv(kBogusIv, kBogusIv + std::size(kBogusIv));
   listener_->OnEncryptionInfoReady(kInitialEncryptionInfo, FOURCC_cbc1,
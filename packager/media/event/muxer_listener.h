@@ -152,6 +152,28 @@ class MuxerListener {
     UNUSED(segment_file_size);
   }
 
+  /// Called when a chunk of a low latency segment has been written. For Low
+  /// Latency only. Called after OnNewSegment for every chunk of the segment,
+  /// including the first one, and before OnCompletedSegment.
+  /// @param start_time is the start time of the chunk, relative to the
+  ///        timescale specified by MediaInfo passed to OnMediaStart().
+  /// @param duration is the duration of the chunk, relative to the timescale
+  ///        specified by MediaInfo passed to OnMediaStart().
+  /// @param start_byte_offset is the offset of the chunk in the segment file.
+  /// @param size is the chunk size in bytes.
+  /// @param is_independent is true if the chunk starts with a key frame.
+  virtual void OnNewChunk(int64_t start_time,
+                          int64_t duration,
+                          uint64_t start_byte_offset,
+                          uint64_t size,
+                          bool is_independent) {
+    UNUSED(start_time);
+    UNUSED(duration);
+    UNUSED(start_byte_offset);
+    UNUSED(size);
+    UNUSED(is_independent);
+  }
+
   /// Called when there is a new key frame. For Video only. Note that it should
   /// be called before OnNewSegment is called on the containing segment.
   /// @param timestamp is in terms of the timescale of the media.
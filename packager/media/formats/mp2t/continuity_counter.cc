@@ -20,6 +20,12 @@ int ContinuityCounter::GetNext() {
   return ret;
 }
 
+int ContinuityCounter::GetNext(size_t count) {
+  int ret = counter_;
+  counter_ = static_cast<int>((counter_ + count) % 16);
+  return ret;
+}
+
 }  // namespace mp2t
 }  // namespace media
 }  // namespace shaka
@@ -7,6 +7,8 @@
 #ifndef PACKAGER_MEDIA_FORMATS_MP2T_CONTINUITY_COUNTER_H_
 #define PACKAGER_MEDIA_FORMATS_MP2T_CONTINUITY_COUNTER_H_
 
+#include <cstddef>
+
 #include <packager/macros/classes.h>
 
 namespace shaka {
@@ -23,6 +25,11 @@ class ContinuityCounter {
   /// @return counter value.
   int GetNext();
 
+  /// Reserves the counter values of @a count consecutive packets at once.
+  /// @return the counter value of the first packet. The following packets use
+  ///         the next values, modulo 16.
+  int GetNext(size_t count);
+
  private:
   int counter_ = 0;
   DISALLOW_COPY_AND_ASSIGN(ContinuityCounter);
@@ -15,7 +15,6 @@
 #include <packager/media/base/buffer_writer.h>
 #include <packager/media/base/fourccs.h>
 #include <packager/media/codecs/hls_audio_util.h>
-#include <packager/media/formats/mp2t/ts_packet_writer_util.h>
 #include <packager/media/formats/mp2t/ts_stream_type.h>
 
 namespace shaka {
@@ -116,14 +115,13 @@ uint32_t Crc32Mpeg2(const uint8_t* data, size_t data_size) {
 
 void WritePmtToBuffer(const uint8_t* pmt,
                       size_t pmt_size,
-                      ContinuityCounter* continuity_counter,
+                      TsPacketizer* packetizer,
                       BufferWriter* writer) {
   const bool kPayloadUnitStartIndicator = true;
   const bool kHasPcr = true;
   const uint64_t kAnyPcrBase = 0;
-  WritePayloadToBufferWriter(pmt, pmt_size, kPayloadUnitStartIndicator,
-                             ProgramMapTableWriter::kPmtPid, !kHasPcr,
-                             kAnyPcrBase, continuity_counter, writer);
+  packetizer->WritePayload(pmt, pmt_size, kPayloadUnitStartIndicator, !kHasPcr,
+                           kAnyPcrBase, writer);
 }
 
 void WritePrivateDataIndicatorDescriptor(FourCC fourcc, BufferWriter* output) {
@@ -215,7 +213,8 @@ void WritePmtWithParameters(uint8_t stream_type,
 
 }  // namespace
 
-ProgramMapTableWriter::ProgramMapTableWriter(Codec codec) : codec_(codec) {}
+ProgramMapTableWriter::ProgramMapTableWriter(Codec codec)
+    : codec_(codec), packetizer_(kPmtPid) {}
 
 bool ProgramMapTableWriter::EncryptedSegmentPmt(BufferWriter* writer) {
   if (encrypted_pmt_.Size() == 0) {
@@ -250,7 +249,7 @@ bool ProgramMapTableWriter::EncryptedSegmentPmt(BufferWriter* writer) {
     DCHECK_NE(encrypted_pmt_.Size(), 0u);
   }
   WritePmtToBuffer(encrypted_pmt_.Buffer(), encrypted_pmt_.Size(),
-                   &continuity_counter_, writer);
+                   &packetizer_, writer);
   return true;
 }
 
@@ -282,7 +281,7 @@ bool ProgramMapTableWriter::ClearSegmentPmt(BufferWriter* writer) {
                            kCurrent, nullptr, 0, &clear_pmt_);
     DCHECK_NE(clear_pmt_.Size(), 0u);
   }
-  WritePmtToBuffer(clear_pmt_.Buffer(), clear_pmt_.Size(), &continuity_counter_,
+  WritePmtToBuffer(clear_pmt_.Buffer(), clear_pmt_.Size(), &packetizer_,
                    writer);
   return true;
 }
@@ -13,7 +13,7 @@
 #include <packager/media/base/buffer_writer.h>
 // TODO(kqyang): Move codec to codec.h.
 #include <packager/media/base/stream_info.h>
-#include <packager/media/formats/mp2t/continuity_counter.h>
+#include <packager/media/formats/mp2t/ts_packetizer.h>
 
 namespace shaka {
 namespace media {
@@ -55,7 +55,7 @@ class ProgramMapTableWriter {
   virtual bool WriteDescriptors(BufferWriter* writer) const = 0;
 
   const Codec codec_;
-  ContinuityCounter continuity_counter_;
+  TsPacketizer packetizer_;
   BufferWriter clear_pmt_;
   BufferWriter encrypted_pmt_;
 };
@@ -0,0 +1,188 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/formats/mp2t/ts_packetizer.h>
+
+#include <cstring>
+
+#include <absl/base/internal/endian.h>
+#include <absl/log/check.h>
+
+#include <packager/media/base/buffer_writer.h>
+
+namespace shaka {
+namespace media {
+namespace mp2t {
+
+namespace {
+
+const uint8_t kSyncByte = 0x47;
+const uint8_t kPayloadUnitStartIndicatorMask = 0x40;
+const uint8_t kPaddingByte = 0xFF;
+
+// This is the size of the first few fields in a TS packet, i.e. TS packet size
+// without adaptation field or the payload.
+const size_t kTsPacketHeaderSize = 4;
+const size_t kTsPacketSize = 188;
+const size_t kTsPacketMaximumPayloadSize = kTsPacketSize - kTsPacketHeaderSize;
+
+// The size of the adaptation_field_length field.
+const size_t kAdaptationFieldLengthSize = 1;
+// The size of all leading flags (not including the adaptation_field_length).
+const size_t kAdaptationFieldHeaderSize = 1;
+const size_t kPcrFieldsSize = 6;
+
+// Writes the adaptation field of a TS packet at |out|, and returns its size.
+// |remaining_data_size| is the amount of data that has to be written. This may
+// be bigger than a TS packet size.
+// |remaining_data_size| matters if it is short and requires padding.
+size_t WriteAdaptationField(bool has_pcr,
+                            uint64_t pcr_base,
+                            size_t remaining_data_size,
+                            uint8_t* out) {
+  // Special case where a TS packet requires 1 byte padding.
+  if (!has_pcr && remaining_data_size == kTsPacketMaximumPayloadSize - 1) {
+    out[0] = 0;
+    return kAdaptationFieldLengthSize;
+  }
+
+  size_t adaptation_field_length =
+      kAdaptationFieldHeaderSize + (has_pcr ? kPcrFieldsSize : 0);
+  const size_t max_payload_size = kTsPacketMaximumPayloadSize -
+                                  kAdaptationFieldLengthSize -
+                                  adaptation_field_length;
+  const size_t padding_size = remaining_data_size < max_payload_size
+                                  ? max_payload_size - remaining_data_size
+                                  : 0;
+  adaptation_field_length += padding_size;
+
+  out[0] = static_cast<uint8_t>(adaptation_field_length);
+  // All flags except PCR_flag are 0.
+  out[1] = static_cast<uint8_t>(has_pcr) << 4;
+  uint8_t* padding = out + kAdaptationFieldLengthSize +
+                     kAdaptationFieldHeaderSize;
+  if (has_pcr) {
+    // program_clock_reference_extension = 0.
+    const uint32_t most_significant_32bits_pcr =
+        static_cast<uint32_t>(pcr_base >> 1);
+    const uint16_t pcr_last_bit_reserved_and_pcr_extension =
+        ((pcr_base & 1) << 15) | 0x7e00;  // Set the 6 reserved bits to '1'
+    absl::big_endian::Store32(padding, most_significant_32bits_pcr);
+    absl::big_endian::Store16(padding + 4,
+                              pcr_last_bit_reserved_and_pcr_extension);
+    padding += kPcrFieldsSize;
+  }
+  memset(padding, kPaddingByte, padding_size);
+  return kAdaptationFieldLengthSize + adaptation_field_length;
+}
+
+}  // namespace
+
+TsPacketizer::TsPacketizer(int pid)
+    : header_template_{kSyncByte, static_cast<uint8_t>((pid >> 8) & 0x1F),
+                       static_cast<uint8_t>(pid & 0xFF)} {
+  DCHECK_EQ(pid & ~0x1FFF, 0);
+}
+
+TsPacketizer::~TsPacketizer() {}
+
+void TsPacketizer::WritePayload(const uint8_t* payload,
+                                size_t payload_size,
+                                bool payload_unit_start_indicator,
+                                bool has_pcr,
+                                uint64_t pcr_base,
+                                BufferWriter* output) {
+  WritePackets(nullptr, 0, payload, payload_size, payload_unit_start_indicator,
+               has_pcr, pcr_base, output);
+}
+
+void TsPacketizer::WritePesPacket(const uint8_t* pes_header,
+                                  size_t pes_header_size,
+                                  const uint8_t* pes_data,
+                                  size_t pes_data_size,
+                                  uint64_t pcr_base,
+                                  BufferWriter* output) {
+  const bool kPayloadUnitStartIndicator = true;
+  const bool kHasPcr = true;
+  WritePackets(pes_header, pes_header_size, pes_data, pes_data_size,
+               kPayloadUnitStartIndicator, kHasPcr, pcr_base, output);
+}
+
+void TsPacketizer::WritePackets(const uint8_t* prefix,
+                                size_t prefix_size,
+                                const uint8_t* payload,
+                                size_t payload_size,
+                                bool payload_unit_start_indicator,
+                                bool has_pcr,
+                                uint64_t pcr_base,
+                                BufferWriter* output) {
+  const size_t first_packet_max_payload_size =
+      has_pcr ? kTsPacketMaximumPayloadSize - kAdaptationFieldLengthSize -
+                    kAdaptationFieldHeaderSize - kPcrFieldsSize
+              : kTsPacketMaximumPayloadSize;
+  DCHECK_LE(prefix_size, first_packet_max_payload_size);
+
+  // An empty payload still takes a packet, filled with the adaptation field.
+  size_t bytes_left = prefix_size + payload_size;
+  const size_t num_packets =
+      bytes_left <= first_packet_max_payload_size
+          ? 1
+          : 1 + (bytes_left - first_packet_max_payload_size +
+                 kTsPacketMaximumPayloadSize - 1) /
+                    kTsPacketMaximumPayloadSize;
+  const int first_continuity_counter =
+      continuity_counter_.GetNext(num_packets);
+
+  uint8_t* packet = output->Grow(num_packets * kTsPacketSize);
+  for (size_t i = 0; i < num_packets; ++i, packet += kTsPacketSize) {
+    const bool has_adaptation_field =
+        has_pcr || bytes_left < kTsPacketMaximumPayloadSize;
+    const uint8_t adaptation_field_control =
+        ((has_adaptation_field ? 1 : 0) << 1) | ((bytes_left != 0) ? 1 : 0);
+
+    // transport_error_indicator and transport_priority are both '0'.
+    memcpy(packet, header_template_, sizeof(header_template_));
+    if (payload_unit_start_indicator)
+      packet[1] |= kPayloadUnitStartIndicatorMask;
+    // transport_scrambling_control is '00'.
+    packet[3] = static_cast<uint8_t>(
+        adaptation_field_control << 4 | ((first_continuity_counter + i) % 16));
+
+    uint8_t* data = packet + kTsPacketHeaderSize;
+    if (!has_adaptation_field && prefix_size == 0) {
+      // The common case: a full packet of payload.
+      memcpy(data, payload, kTsPacketMaximumPayloadSize);
+      payload += kTsPacketMaximumPayloadSize;
+      bytes_left -= kTsPacketMaximumPayloadSize;
+      payload_unit_start_indicator = false;
+      continue;
+    }
+
+    if (has_adaptation_field)
+      data += WriteAdaptationField(has_pcr, pcr_base, bytes_left, data);
+    size_t write_bytes = packet + kTsPacketSize - data;
+    if (prefix_size > 0) {
+      memcpy(data, prefix, prefix_size);
+      data += prefix_size;
+      write_bytes -= prefix_size;
+      bytes_left -= prefix_size;
+      prefix_size = 0;
+    }
+    if (write_bytes > 0)
+      memcpy(data, payload, write_bytes);
+    payload += write_bytes;
+    bytes_left -= write_bytes;
+
+    // Once written, not needed for this payload.
+    has_pcr = false;
+    payload_unit_start_indicator = false;
+  }
+  DCHECK_EQ(bytes_left, 0u);
+}
+
+}  // namespace mp2t
+}  // namespace media
+}  // namespace shaka
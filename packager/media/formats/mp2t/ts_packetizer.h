@@ -0,0 +1,88 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_FORMATS_MP2T_TS_PACKETIZER_H_
+#define PACKAGER_MEDIA_FORMATS_MP2T_TS_PACKETIZER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <packager/media/formats/mp2t/continuity_counter.h>
+
+namespace shaka {
+namespace media {
+
+class BufferWriter;
+
+namespace mp2t {
+
+/// Puts the payloads of a PID into TS packets. The packet header is built once
+/// for the PID, the continuity counters of all the packets of a payload are
+/// reserved at once, and the packets are written in place at the end of the
+/// output buffer, which grows once per payload.
+class TsPacketizer {
+ public:
+  /// @param pid is the PID of all the packets written by this instance.
+  explicit TsPacketizer(int pid);
+  ~TsPacketizer();
+
+  /// Writes @a payload in TS packets to @a output.
+  /// @param payload can be any payload. Most likely raw PSI tables.
+  /// @param payload_size is the size of payload.
+  /// @param payload_unit_start_indicator is the same as the definition in spec.
+  /// @param has_pcr is true if @a pcr_base should be used.
+  /// @param pcr_base is the PCR_base value in the spec.
+  /// @param output is where the TS packets get written.
+  void WritePayload(const uint8_t* payload,
+                    size_t payload_size,
+                    bool payload_unit_start_indicator,
+                    bool has_pcr,
+                    uint64_t pcr_base,
+                    BufferWriter* output);
+
+  /// Writes a PES packet in TS packets to @a output. This is the same as
+  /// writing the concatenation of @a pes_header and @a pes_data with
+  /// payload_unit_start_indicator and a PCR, without the concatenation.
+  /// @param pes_header is the PES packet up to PES_packet_data_byte, which
+  ///        must fit in the first TS packet.
+  /// @param pes_header_size is the size of @a pes_header.
+  /// @param pes_data is the PES_packet_data_byte of the PES packet.
+  /// @param pes_data_size is the size of @a pes_data.
+  /// @param pcr_base is the PCR_base value in the spec.
+  /// @param output is where the TS packets get written.
+  void WritePesPacket(const uint8_t* pes_header,
+                      size_t pes_header_size,
+                      const uint8_t* pes_data,
+                      size_t pes_data_size,
+                      uint64_t pcr_base,
+                      BufferWriter* output);
+
+ private:
+  TsPacketizer(const TsPacketizer&) = delete;
+  TsPacketizer& operator=(const TsPacketizer&) = delete;
+
+  // Writes the concatenation of |prefix| and |payload|. |prefix| must fit in
+  // the first packet.
+  void WritePackets(const uint8_t* prefix,
+                    size_t prefix_size,
+                    const uint8_t* payload,
+                    size_t payload_size,
+                    bool payload_unit_start_indicator,
+                    bool has_pcr,
+                    uint64_t pcr_base,
+                    BufferWriter* output);
+
+  // The first three bytes of the header of every TS packet of the PID, i.e.
+  // sync_byte and PID, with payload_unit_start_indicator unset.
+  uint8_t header_template_[3];
+  ContinuityCounter continuity_counter_;
+};
+
+}  // namespace mp2t
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_FORMATS_MP2T_TS_PACKETIZER_H_
@@ -0,0 +1,193 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/formats/mp2t/ts_packetizer.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <packager/media/base/buffer_writer.h>
+
+namespace shaka {
+namespace media {
+namespace mp2t {
+
+namespace {
+
+const size_t kTsPacketSize = 188;
+const int kPid = 0x50;
+const bool kPayloadUnitStartIndicator = true;
+const bool kHasPcr = true;
+const uint64_t kPcrBase = 0x123456789ull;
+
+std::vector<uint8_t> CreatePayload(size_t size) {
+  std::vector<uint8_t> payload(size);
+  for (size_t i = 0; i < size; ++i)
+    payload[i] = static_cast<uint8_t>(i * 7 + 3);
+  return payload;
+}
+
+std::vector<uint8_t> GetPacket(const BufferWriter& writer, size_t index) {
+  const uint8_t* packet = writer.Buffer() + index * kTsPacketSize;
+  return std::vector<uint8_t>(packet, packet + kTsPacketSize);
+}
+
+}  // namespace
+
+TEST(TsPacketizerTest, FullPackets) {
+  const std::vector<uint8_t> payload = CreatePayload(184 * 3);
+  TsPacketizer packetizer(kPid);
+  BufferWriter writer;
+  packetizer.WritePayload(payload.data(), payload.size(),
+                          kPayloadUnitStartIndicator, !kHasPcr, 0, &writer);
+  ASSERT_EQ(3 * kTsPacketSize, writer.Size());
+
+  for (size_t i = 0; i < 3; ++i) {
+    const std::vector<uint8_t> packet = GetPacket(writer, i);
+    EXPECT_EQ(0x47, packet[0]);
+    // payload_unit_start_indicator is only set on the first packet.
+    EXPECT_EQ(i == 0 ? 0x40 : 0x00, packet[1]);
+    EXPECT_EQ(0x50, packet[2]);
+    // Payload only.
+    EXPECT_EQ(0x10 | i, packet[3]);
+    EXPECT_EQ(std::vector<uint8_t>(payload.begin() + i * 184,
+                                   payload.begin() + (i + 1) * 184),
+              std::vector<uint8_t>(packet.begin() + 4, packet.end()));
+  }
+}
+
+TEST(TsPacketizerTest, Padding) {
+  const std::vector<uint8_t> payload = CreatePayload(184 + 10);
+  TsPacketizer packetizer(kPid);
+  BufferWriter writer;
+  packetizer.WritePayload(payload.data(), payload.size(),
+                          !kPayloadUnitStartIndicator, !kHasPcr, 0, &writer);
+  ASSERT_EQ(2 * kTsPacketSize, writer.Size());
+
+  const std::vector<uint8_t> packet = GetPacket(writer, 1);
+  const uint8_t kExpectedPrefix[] = {
+      0x47, 0x00, 0x50,
+      0x31,  // Adaptation field and payload are both present. counter = 1.
+      0xAD,  // Adaptation field length.
+      0x00,  // All adaptation field flags 0.
+  };
+  EXPECT_EQ(std::vector<uint8_t>(std::begin(kExpectedPrefix),
+                                 std::end(kExpectedPrefix)),
+            std::vector<uint8_t>(packet.begin(), packet.begin() + 6));
+  for (size_t i = 6; i < kTsPacketSize - 10; ++i)
+    EXPECT_EQ(0xFF, packet[i]) << "at index " << i;
+  EXPECT_EQ(std::vector<uint8_t>(payload.begin() + 184, payload.end()),
+            std::vector<uint8_t>(packet.end() - 10, packet.end()));
+}
+
+TEST(TsPacketizerTest, OneBytePadding) {
+  const std::vector<uint8_t> payload = CreatePayload(183);
+  TsPacketizer packetizer(kPid);
+  BufferWriter writer;
+  packetizer.WritePayload(payload.data(), payload.size(),
+                          kPayloadUnitStartIndicator, !kHasPcr, 0, &writer);
+  ASSERT_EQ(kTsPacketSize, writer.Size());
+
+  const std::vector<uint8_t> packet = GetPacket(writer, 0);
+  // Only adaptation_field_length, which is 0.
+  const uint8_t kExpectedPrefix[] = {0x47, 0x40, 0x50, 0x30, 0x00};
+  EXPECT_EQ(std::vector<uint8_t>(std::begin(kExpectedPrefix),
+                                 std::end(kExpectedPrefix)),
+            std::vector<uint8_t>(packet.begin(), packet.begin() + 5));
+  EXPECT_EQ(payload, std::vector<uint8_t>(packet.begin() + 5, packet.end()));
+}
+
+TEST(TsPacketizerTest, EmptyPayload) {
+  TsPacketizer packetizer(kPid);
+  BufferWriter writer;
+  packetizer.WritePayload(nullptr, 0, kPayloadUnitStartIndicator, !kHasPcr, 0,
+                          &writer);
+  ASSERT_EQ(kTsPacketSize, writer.Size());
+
+  const std::vector<uint8_t> packet = GetPacket(writer, 0);
+  // Adaptation field only, for the whole packet.
+  const uint8_t kExpectedPrefix[] = {0x47, 0x40, 0x50, 0x20, 0xB7, 0x00};
+  EXPECT_EQ(std::vector<uint8_t>(std::begin(kExpectedPrefix),
+                                 std::end(kExpectedPrefix)),
+            std::vector<uint8_t>(packet.begin(), packet.begin() + 6));
+  for (size_t i = 6; i < kTsPacketSize; ++i)
+    EXPECT_EQ(0xFF, packet[i]) << "at index " << i;
+}
+
+TEST(TsPacketizerTest, Pcr) {
+  const std::vector<uint8_t> payload = CreatePayload(400);
+  TsPacketizer packetizer(kPid);
+  BufferWriter writer;
+  packetizer.WritePayload(payload.data(), payload.size(),
+                          kPayloadUnitStartIndicator, kHasPcr, kPcrBase,
+                          &writer);
+  // 176 bytes in the first packet, then 184 and 40.
+  ASSERT_EQ(3 * kTsPacketSize, writer.Size());
+
+  const std::vector<uint8_t> packet = GetPacket(writer, 0);
+  const uint8_t kExpectedPrefix[] = {
+      0x47, 0x40, 0x50, 0x30,
+      0x07,  // Adaptation field length.
+      0x10,  // PCR_flag.
+      // PCR_base, reserved bits and PCR_extension.
+      0x91, 0xA2, 0xB3, 0xC4, 0xFE, 0x00,
+  };
+  EXPECT_EQ(std::vector<uint8_t>(std::begin(kExpectedPrefix),
+                                 std::end(kExpectedPrefix)),
+            std::vector<uint8_t>(packet.begin(), packet.begin() + 12));
+  EXPECT_EQ(std::vector<uint8_t>(payload.begin(), payload.begin() + 176),
+            std::vector<uint8_t>(packet.begin() + 12, packet.end()));
+
+  // The following packets do not carry a PCR.
+  EXPECT_EQ(0x11, GetPacket(writer, 1)[3]);
+  EXPECT_EQ(0x32, GetPacket(writer, 2)[3]);
+  EXPECT_EQ(0x00, GetPacket(writer, 2)[5]);
+}
+
+TEST(TsPacketizerTest, ContinuityCounterWraps) {
+  const std::vector<uint8_t> payload = CreatePayload(184 * 10);
+  TsPacketizer packetizer(kPid);
+  BufferWriter writer;
+  packetizer.WritePayload(payload.data(), payload.size(),
+                          kPayloadUnitStartIndicator, !kHasPcr, 0, &writer);
+  packetizer.WritePayload(payload.data(), payload.size(),
+                          kPayloadUnitStartIndicator, !kHasPcr, 0, &writer);
+  ASSERT_EQ(20 * kTsPacketSize, writer.Size());
+  for (size_t i = 0; i < 20; ++i)
+    EXPECT_EQ(i % 16, GetPacket(writer, i)[3] & 0x0F) << "at packet " << i;
+}
+
+// A PES packet is written as if its header and its data were one payload.
+TEST(TsPacketizerTest, PesPacketMatchesPayload) {
+  const std::vector<uint8_t> pes_header = CreatePayload(19);
+  for (size_t data_size : {0, 1, 156, 157, 158, 164, 165, 341, 342, 1000}) {
+    const std::vector<uint8_t> data = CreatePayload(data_size);
+    std::vector<uint8_t> pes_packet = pes_header;
+    pes_packet.insert(pes_packet.end(), data.begin(), data.end());
+
+    TsPacketizer payload_packetizer(kPid);
+    BufferWriter expected;
+    payload_packetizer.WritePayload(pes_packet.data(), pes_packet.size(),
+                                    kPayloadUnitStartIndicator, kHasPcr,
+                                    kPcrBase, &expected);
+
+    TsPacketizer pes_packetizer(kPid);
+    BufferWriter actual;
+    pes_packetizer.WritePesPacket(pes_header.data(), pes_header.size(),
+                                  data.data(), data.size(), kPcrBase, &actual);
+
+    EXPECT_EQ(std::vector<uint8_t>(expected.Buffer(),
+                                   expected.Buffer() + expected.Size()),
+              std::vector<uint8_t>(actual.Buffer(),
+                                   actual.Buffer() + actual.Size()))
+        << "data size " << data_size;
+  }
+}
+
+}  // namespace mp2t
+}  // namespace media
+}  // namespace shaka
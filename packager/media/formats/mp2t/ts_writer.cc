@@ -6,15 +6,13 @@
 
 #include <packager/media/formats/mp2t/ts_writer.h>
 
-#include <algorithm>
-
+#include <absl/base/internal/endian.h>
 #include <absl/log/log.h>
 
 #include <packager/media/base/buffer_writer.h>
 #include <packager/media/base/media_sample.h>
 #include <packager/media/formats/mp2t/pes_packet.h>
 #include <packager/media/formats/mp2t/program_map_table_writer.h>
-#include <packager/media/formats/mp2t/ts_packet_writer_util.h>
 
 namespace shaka {
 namespace media {
@@ -26,6 +24,7 @@ namespace {
 // part of PAT or PMT but it's there so that TsPacket can point to a memory
 // location that starts from pointer field.
 const uint8_t kProgramAssociationTableId = 0x00;
+const int kPatPid = 0;
 
 // This PAT can be used for both encrypted and clear.
 const uint8_t kPat[] = {
@@ -47,128 +46,96 @@ const uint8_t kPat[] = {
 
 const bool kHasPcr = true;
 const bool kPayloadUnitStartIndicator = true;
+const uint64_t kAnyPcrBase = 0;
 
-// This is the size of the first few fields in a TS packet, i.e. TS packet size
-// without adaptation field or the payload.
-const int kTsPacketHeaderSize = 4;
-const int kTsPacketSize = 188;
-const int kTsPacketMaximumPayloadSize =
-    kTsPacketSize - kTsPacketHeaderSize;
+// The size of packet_start_code_prefix, stream_id and PES_packet_length.
+const size_t kPesPacketStartSize = 6;
+// The size of the PES header fields up to PES_header_data_length.
+const size_t kPesHeaderFixedSize = 9;
+const size_t kPtsOrDtsSize = 5;
+const size_t kMaxPesHeaderSize = kPesHeaderFixedSize + 2 * kPtsOrDtsSize;
 
 const size_t kMaxPesPacketLengthValue = 0xFFFF;
 
-void WritePatToBuffer(const uint8_t* pat,
-                      int pat_size,
-                      ContinuityCounter* continuity_counter,
-                      BufferWriter* writer) {
-  const int kPatPid = 0;
-  WritePayloadToBufferWriter(pat, pat_size, kPayloadUnitStartIndicator, kPatPid,
-                             !kHasPcr, 0, continuity_counter, writer);
-}
-
 // The only difference between writing PTS or DTS is the leading bits.
-void WritePtsOrDts(uint8_t leading_bits,
-                   uint64_t pts_or_dts,
-                   BufferWriter* writer) {
+void WritePtsOrDts(uint8_t leading_bits, uint64_t pts_or_dts, uint8_t* out) {
   // First byte has 3 MSB of PTS.
-  uint8_t first_byte =
-      leading_bits << 4 | (((pts_or_dts >> 30) & 0x07) << 1) | 1;
+  out[0] = leading_bits << 4 | (((pts_or_dts >> 30) & 0x07) << 1) | 1;
   // Second byte has the next 8 bits of pts.
-  uint8_t second_byte = (pts_or_dts >> 22) & 0xFF;
+  out[1] = (pts_or_dts >> 22) & 0xFF;
   // Third byte has the next 7 bits of pts followed by a marker bit.
-  uint8_t third_byte = (((pts_or_dts >> 15) & 0x7F) << 1) | 1;
+  out[2] = (((pts_or_dts >> 15) & 0x7F) << 1) | 1;
   // Fourth byte has the next 8 bits of pts.
-  uint8_t fourth_byte = ((pts_or_dts >> 7) & 0xFF);
+  out[3] = ((pts_or_dts >> 7) & 0xFF);
   // Fifth byte has the last 7 bits of pts followed by a marker bit.
-  uint8_t fifth_byte = ((pts_or_dts & 0x7F) << 1) | 1;
-  writer->AppendInt(first_byte);
-  writer->AppendInt(second_byte);
-  writer->AppendInt(third_byte);
-  writer->AppendInt(fourth_byte);
-  writer->AppendInt(fifth_byte);
+  out[4] = ((pts_or_dts & 0x7F) << 1) | 1;
 }
 
 bool WritePesToBuffer(const PesPacket& pes,
-                      ContinuityCounter* continuity_counter,
+                      TsPacketizer* packetizer,
                       BufferWriter* current_buffer) {
-  // The size of the length field.
-  const int kAdaptationFieldLengthSize = 1;
-  // The size of the flags field.
-  const int kAdaptationFieldHeaderSize = 1;
-  const int kPcrFieldSize = 6;
-  const int kTsPacketMaxPayloadWithPcr =
-      kTsPacketMaximumPayloadSize - kAdaptationFieldLengthSize -
-      kAdaptationFieldHeaderSize - kPcrFieldSize;
   const uint64_t pcr_base = pes.has_dts() ? pes.dts() : pes.pts();
-  const int pid = ProgramMapTableWriter::kElementaryPid;
 
-  // This writer will hold part of PES packet after PES_packet_length field.
-  BufferWriter pes_header_writer;
+  // The PES packet header goes into the first TS packet along with the start
+  // of the data, so it is built on the stack instead of in a BufferWriter.
+  uint8_t pes_header[kMaxPesHeaderSize];
+  // packet_start_code_prefix.
+  pes_header[0] = 0x00;
+  pes_header[1] = 0x00;
+  pes_header[2] = 0x01;
+  pes_header[3] = pes.stream_id();
+  // PES_packet_length is filled in below, once the header size is known.
+
   // The first bit must be '10' for PES with video or audio stream id. The other
   // flags (bits) don't matter so they are 0.
-  pes_header_writer.AppendInt(static_cast<uint8_t>(0x80));
-  pes_header_writer.AppendInt(
-      static_cast<uint8_t>(static_cast<int>(pes.has_pts()) << 7 |
-                           static_cast<int>(pes.has_dts()) << 6
-                           // Other fields are all 0.
-                           ));
+  pes_header[6] = 0x80;
+  pes_header[7] = static_cast<uint8_t>(static_cast<int>(pes.has_pts()) << 7 |
+                                       static_cast<int>(pes.has_dts()) << 6
+                                       // Other fields are all 0.
+  );
   uint8_t pes_header_data_length = 0;
   if (pes.has_pts())
-    pes_header_data_length += 5;
+    pes_header_data_length += kPtsOrDtsSize;
   if (pes.has_dts())
-    pes_header_data_length += 5;
-  pes_header_writer.AppendInt(pes_header_data_length);
+    pes_header_data_length += kPtsOrDtsSize;
+  pes_header[8] = pes_header_data_length;
 
+  uint8_t* pts_and_dts = pes_header + kPesHeaderFixedSize;
   if (pes.has_pts() && pes.has_dts()) {
-    WritePtsOrDts(0x03, pes.pts(), &pes_header_writer);
-    WritePtsOrDts(0x01, pes.dts(), &pes_header_writer);
+    WritePtsOrDts(0x03, pes.pts(), pts_and_dts);
+    WritePtsOrDts(0x01, pes.dts(), pts_and_dts + kPtsOrDtsSize);
   } else if (pes.has_pts()) {
-    WritePtsOrDts(0x02, pes.pts(), &pes_header_writer);
-  }
-
-  // Put the first TS packet's payload into a buffer. This contains the PES
-  // packet's header.
-  BufferWriter first_ts_packet_buffer(kTsPacketSize);
-  first_ts_packet_buffer.AppendNBytes(static_cast<uint64_t>(0x000001), 3);
-  first_ts_packet_buffer.AppendInt(pes.stream_id());
-  const size_t pes_packet_length = pes.data().size() + pes_header_writer.Size();
-  first_ts_packet_buffer.AppendInt(static_cast<uint16_t>(
-      pes_packet_length > kMaxPesPacketLengthValue ? 0 : pes_packet_length));
-  first_ts_packet_buffer.AppendBuffer(pes_header_writer);
-
-  const size_t available_payload =
-      kTsPacketMaxPayloadWithPcr - first_ts_packet_buffer.Size();
-  const size_t bytes_consumed = std::min(pes.data().size(), available_payload);
-  first_ts_packet_buffer.AppendArray(pes.data().data(), bytes_consumed);
-
-  BufferWriter output_writer;
-  WritePayloadToBufferWriter(first_ts_packet_buffer.Buffer(),
-                             first_ts_packet_buffer.Size(),
-                             kPayloadUnitStartIndicator, pid, kHasPcr, pcr_base,
-                             continuity_counter, &output_writer);
-
-  const size_t remaining_pes_data_size = pes.data().size() - bytes_consumed;
-  if (remaining_pes_data_size > 0) {
-    WritePayloadToBufferWriter(pes.data().data() + bytes_consumed,
-                               remaining_pes_data_size,
-                               !kPayloadUnitStartIndicator, pid, !kHasPcr, 0,
-                               continuity_counter, &output_writer);
+    WritePtsOrDts(0x02, pes.pts(), pts_and_dts);
   }
 
-  current_buffer->AppendBuffer(output_writer);
+  const size_t pes_header_size = kPesHeaderFixedSize + pes_header_data_length;
+  const size_t pes_packet_length =
+      pes.data().size() + pes_header_size - kPesPacketStartSize;
+  absl::big_endian::Store16(
+      pes_header + 4,
+      static_cast<uint16_t>(pes_packet_length > kMaxPesPacketLengthValue
+                                ? 0
+                                : pes_packet_length));
+
+  packetizer->WritePesPacket(pes_header, pes_header_size, pes.data().data(),
+                             pes.data().size(), pcr_base, current_buffer);
   return true;
 }
 
 }  // namespace
 
 TsWriter::TsWriter(std::unique_ptr<ProgramMapTableWriter> pmt_writer)
-    : pmt_writer_(std::move(pmt_writer)) {}
+    : pat_packetizer_(kPatPid),
+      elementary_stream_packetizer_(ProgramMapTableWriter::kElementaryPid),
+      pmt_writer_(std::move(pmt_writer)) {}
 
 TsWriter::~TsWriter() {}
 
 bool TsWriter::NewSegment(BufferWriter* buffer) {
   BufferWriter psi;
-  WritePatToBuffer(kPat, std::size(kPat), &pat_continuity_counter_, &psi);
+  pat_packetizer_.WritePayload(kPat, std::size(kPat),
+                               kPayloadUnitStartIndicator, !kHasPcr,
+                               kAnyPcrBase, &psi);
   if (encrypted_) {
     if (!pmt_writer_->EncryptedSegmentPmt(&psi)) {
       return false;
@@ -189,8 +156,7 @@ void TsWriter::SignalEncrypted() {
 
 bool TsWriter::AddPesPacket(std::unique_ptr<PesPacket> pes_packet,
                             BufferWriter* buffer) {
-  if (!WritePesToBuffer(*pes_packet, &elementary_stream_continuity_counter_,
-                        buffer)) {
+  if (!WritePesToBuffer(*pes_packet, &elementary_stream_packetizer_, buffer)) {
     LOG(ERROR) << "Failed to write pes to buffer.";
     return false;
   }
@@ -16,7 +16,7 @@
 #include <packager/file.h>
 #include <packager/file/file_closer.h>
 #include <packager/media/base/buffer_writer.h>
-#include <packager/media/formats/mp2t/continuity_counter.h>
+#include <packager/media/formats/mp2t/ts_packetizer.h>
 #include <optional>
 
 namespace shaka {
@@ -55,8 +55,8 @@ class TsWriter {
   // True if further segments generated by this instance should be encrypted.
   bool encrypted_ = false;
 
-  ContinuityCounter pat_continuity_counter_;
-  ContinuityCounter elementary_stream_continuity_counter_;
+  TsPacketizer pat_packetizer_;
+  TsPacketizer elementary_stream_packetizer_;
 
   std::unique_ptr<ProgramMapTableWriter> pmt_writer_;
 };
@@ -0,0 +1,123 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// Benchmark for packetizing PES packets into transport stream segments, with
+// video frames and with small audio frames.
+
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <packager/media/base/buffer_writer.h>
+#include <packager/media/formats/mp2t/pes_packet.h>
+#include <packager/media/formats/mp2t/program_map_table_writer.h>
+#include <packager/media/formats/mp2t/ts_writer.h>
+
+namespace shaka {
+namespace media {
+namespace mp2t {
+namespace {
+
+const uint8_t kVideoStreamId = 0xe0;
+const uint8_t kAudioStreamId = 0xc0;
+const int64_t kVideoFrameDuration = 3000;  // 30 fps in 90 kHz.
+const int64_t kAudioFrameDuration = 1920;  // 1024 samples at 48 kHz.
+const size_t kNumVideoFrames = 60;
+const size_t kNumAudioFrames = 94;
+const size_t kKeyFrameSize = 64 * 1024;
+const size_t kMaxFrameSize = 16 * 1024;
+const size_t kAudioFrameSize = 384;
+
+struct Frame {
+  size_t size;
+  int64_t pts;
+  int64_t dts;
+  bool is_key_frame;
+};
+
+// Returns 2 seconds of video frames of varied sizes.
+std::vector<Frame> GetVideoFrames() {
+  std::vector<Frame> frames;
+  uint32_t random_state = 1;
+  for (size_t i = 0; i < kNumVideoFrames; ++i) {
+    random_state = random_state * 1103515245 + 12345;
+    const bool is_key_frame = i == 0;
+    frames.push_back(
+        {is_key_frame ? kKeyFrameSize
+                      : 1024 + (random_state >> 8) % kMaxFrameSize,
+         static_cast<int64_t>((i + (i % 3 == 1 ? 2 : 0)) * kVideoFrameDuration),
+         static_cast<int64_t>(i * kVideoFrameDuration), is_key_frame});
+  }
+  return frames;
+}
+
+// Returns 2 seconds of AAC frames.
+std::vector<Frame> GetAudioFrames() {
+  std::vector<Frame> frames;
+  for (size_t i = 0; i < kNumAudioFrames; ++i) {
+    const int64_t timestamp = i * kAudioFrameDuration;
+    frames.push_back({kAudioFrameSize, timestamp, timestamp, true});
+  }
+  return frames;
+}
+
+void WriteSegments(benchmark::State& state,
+                   std::unique_ptr<ProgramMapTableWriter> pmt_writer,
+                   uint8_t stream_id,
+                   const std::vector<Frame>& frames) {
+  const std::vector<uint8_t> data(kKeyFrameSize, 0x42);
+  TsWriter ts_writer(std::move(pmt_writer));
+  BufferWriter buffer;
+  size_t bytes_written = 0;
+  for (auto _ : state) {
+    if (!ts_writer.NewSegment(&buffer)) {
+      state.SkipWithError("Failed to start a segment.");
+      return;
+    }
+    for (const Frame& frame : frames) {
+      std::unique_ptr<PesPacket> pes_packet(new PesPacket);
+      pes_packet->set_stream_id(stream_id);
+      pes_packet->set_pts(frame.pts);
+      pes_packet->set_dts(frame.dts);
+      pes_packet->set_is_key_frame(frame.is_key_frame);
+      pes_packet->mutable_data()->assign(data.begin(),
+                                         data.begin() + frame.size);
+      if (!ts_writer.AddPesPacket(std::move(pes_packet), &buffer)) {
+        state.SkipWithError("Failed to add a PES packet.");
+        return;
+      }
+    }
+    bytes_written += buffer.Size();
+    buffer.Clear();
+  }
+  state.SetBytesProcessed(bytes_written);
+  state.SetItemsProcessed(state.iterations() * frames.size());
+}
+
+void BM_WriteVideoSegment(benchmark::State& state) {
+  WriteSegments(state,
+                std::unique_ptr<ProgramMapTableWriter>(
+                    new VideoProgramMapTableWriter(kCodecH264)),
+                kVideoStreamId, GetVideoFrames());
+}
+
+void BM_WriteAudioSegment(benchmark::State& state) {
+  const std::vector<uint8_t> kAudioSpecificConfig = {0x12, 0x10};
+  WriteSegments(state,
+                std::unique_ptr<ProgramMapTableWriter>(
+                    new AudioProgramMapTableWriter(kCodecAAC,
+                                                   kAudioSpecificConfig)),
+                kAudioStreamId, GetAudioFrames());
+}
+
+BENCHMARK(BM_WriteVideoSegment);
+BENCHMARK(BM_WriteAudioSegment);
+
+}  // namespace
+}  // namespace mp2t
+}  // namespace media
+}  // namespace shaka
@@ -52,7 +52,7 @@ struct Box {
 
   /// @return The size of result box including child boxes. Note that this
   //          function expects that ComputeSize has been invoked already.
-  uint32_t box_size() { return box_size_; }
+  uint32_t box_size() const { return box_size_; }
 
  protected:
   /// Read/write mp4 box header. Note that this function expects that
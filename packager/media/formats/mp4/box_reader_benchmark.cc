@@ -0,0 +1,132 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// Benchmark for parsing large 'moov' boxes, as found at the start of long
+// non-fragmented MP4 files.
+
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <packager/media/base/buffer_writer.h>
+#include <packager/media/formats/mp4/box_definitions.h>
+#include <packager/media/formats/mp4/box_reader.h>
+#include <packager/media/test/test_data_util.h>
+
+namespace shaka {
+namespace media {
+namespace mp4 {
+namespace {
+
+// Returns the top-level 'moov' box of |data|, or an empty vector.
+std::vector<uint8_t> FindMoov(const std::vector<uint8_t>& data) {
+  size_t offset = 0;
+  while (offset < data.size()) {
+    FourCC type = FOURCC_NULL;
+    uint64_t box_size = 0;
+    bool err = false;
+    if (!BoxReader::StartBox(data.data() + offset, data.size() - offset,
+                             &type, &box_size, &err) ||
+        box_size == 0 || box_size > data.size() - offset) {
+      break;
+    }
+    if (type == FOURCC_moov) {
+      return std::vector<uint8_t>(data.begin() + offset,
+                                  data.begin() + offset + box_size);
+    }
+    offset += box_size;
+  }
+  return std::vector<uint8_t>();
+}
+
+// Appends |repetitions| - 1 copies of the entries of |entries|.
+template <typename T>
+void Repeat(int repetitions, std::vector<T>* entries) {
+  const size_t num_entries = entries->size();
+  entries->reserve(num_entries * repetitions);
+  for (int i = 1; i < repetitions; ++i) {
+    for (size_t j = 0; j < num_entries; ++j)
+      entries->push_back((*entries)[j]);
+  }
+}
+
+// Returns the 'moov' box of a test file, with the sample tables of its tracks
+// repeated |repetitions| times, as if the content were that much longer.
+std::vector<uint8_t> GetLargeMoov(int repetitions) {
+  const std::vector<uint8_t> moov =
+      FindMoov(ReadTestDataFile("bear-640x360.mp4"));
+  bool err = false;
+  std::unique_ptr<BoxReader> reader(
+      BoxReader::ReadBox(moov.data(), moov.size(), &err));
+  Movie movie;
+  if (!reader || !movie.Parse(reader.get()))
+    return std::vector<uint8_t>();
+
+  for (Track& track : movie.tracks) {
+    SampleTable& sample_table = track.media.information.sample_table;
+    const uint32_t num_samples = sample_table.sample_size.sample_count;
+    const uint32_t num_chunks =
+        static_cast<uint32_t>(sample_table.chunk_large_offset.offsets.size());
+
+    Repeat(repetitions, &sample_table.decoding_time_to_sample.decoding_time);
+    Repeat(repetitions,
+           &sample_table.composition_time_to_sample.composition_offset);
+    Repeat(repetitions, &sample_table.sample_size.sizes);
+    sample_table.sample_size.sample_count = num_samples * repetitions;
+    Repeat(repetitions, &sample_table.chunk_large_offset.offsets);
+
+    std::vector<ChunkInfo>& chunk_info =
+        sample_table.sample_to_chunk.chunk_info;
+    const size_t num_chunk_info = chunk_info.size();
+    Repeat(repetitions, &chunk_info);
+    for (size_t i = num_chunk_info; i < chunk_info.size(); ++i)
+      chunk_info[i].first_chunk += num_chunks * (i / num_chunk_info);
+
+    std::vector<uint32_t>& sync_samples =
+        sample_table.sync_sample.sample_number;
+    const size_t num_sync_samples = sync_samples.size();
+    Repeat(repetitions, &sync_samples);
+    for (size_t i = num_sync_samples; i < sync_samples.size(); ++i)
+      sync_samples[i] += num_samples * (i / num_sync_samples);
+  }
+
+  BufferWriter writer;
+  movie.Write(&writer);
+  return std::vector<uint8_t>(writer.Buffer(),
+                              writer.Buffer() + writer.Size());
+}
+
+// The argument is the number of times the sample tables are repeated.
+void BM_ParseMoov(benchmark::State& state) {
+  const std::vector<uint8_t> moov = GetLargeMoov(state.range(0));
+  if (moov.empty()) {
+    state.SkipWithError("Failed to read the test data.");
+    return;
+  }
+
+  for (auto _ : state) {
+    bool err = false;
+    std::unique_ptr<BoxReader> reader(
+        BoxReader::ReadBox(moov.data(), moov.size(), &err));
+    Movie movie;
+    if (!reader || !movie.Parse(reader.get())) {
+      state.SkipWithError("Failed to parse the 'moov' box.");
+      return;
+    }
+    benchmark::DoNotOptimize(movie.tracks.data());
+  }
+  state.SetBytesProcessed(state.iterations() * moov.size());
+  state.counters["moov_bytes"] = moov.size();
+}
+
+// About 3 seconds, 45 minutes and 2 hours of content.
+BENCHMARK(BM_ParseMoov)->Arg(1)->Arg(1000)->Arg(2700);
+
+}  // namespace
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,343 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/formats/mp4/fast_box_writer.h>
+
+#include <array>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include <absl/base/internal/endian.h>
+#include <absl/log/check.h>
+#include <absl/log/log.h>
+
+#include <packager/macros/classes.h>
+#include <packager/media/base/buffer_writer.h>
+#include <packager/media/formats/mp4/box_definitions.h>
+
+namespace shaka {
+namespace media {
+namespace mp4 {
+
+namespace {
+
+// The trun sample field flags are bits 8 to 11 of the box flags.
+const int kSampleFieldsShift = 8;
+const size_t kNumSampleFieldCombinations = 16;
+
+// Stores big-endian fields in a buffer sized upfront. There is no bounds
+// checking: the callers verify that exactly the computed box size is written.
+class FieldWriter {
+ public:
+  explicit FieldWriter(uint8_t* data) : position_(data) {}
+
+  void WriteUInt8(uint8_t v) { *position_++ = v; }
+  void WriteUInt16(uint16_t v) {
+    absl::big_endian::Store16(position_, v);
+    position_ += sizeof(v);
+  }
+  void WriteUInt32(uint32_t v) {
+    absl::big_endian::Store32(position_, v);
+    position_ += sizeof(v);
+  }
+  void WriteUInt64(uint64_t v) {
+    absl::big_endian::Store64(position_, v);
+    position_ += sizeof(v);
+  }
+  // Writes |v| in 8 bytes for version 1 boxes and 4 bytes otherwise.
+  void WriteUInt64ForVersion(uint64_t v, uint8_t version) {
+    if (version == 1)
+      WriteUInt64(v);
+    else
+      WriteUInt32(static_cast<uint32_t>(v));
+  }
+  void WriteArray(const uint8_t* data, size_t size) {
+    memcpy(position_, data, size);
+    position_ += size;
+  }
+
+  void WriteBoxHeader(const Box& box) {
+    WriteUInt32(box.box_size());
+    WriteUInt32(box.BoxType());
+  }
+  void WriteFullBoxHeader(const FullBox& box) {
+    WriteBoxHeader(box);
+    WriteUInt32((static_cast<uint32_t>(box.version) << 24) | box.flags);
+  }
+
+  uint8_t* position() const { return position_; }
+
+ private:
+  uint8_t* position_;
+
+  DISALLOW_COPY_AND_ASSIGN(FieldWriter);
+};
+
+// Writes the boxes which are not specialized, e.g. the sample group boxes
+// used with key rotation, through the generic writer.
+void WriteGenericBox(Box* box, FieldWriter* out) {
+  BufferWriter buffer;
+  box->Write(&buffer);
+  out->WriteArray(buffer.Buffer(), buffer.Size());
+}
+
+// Writes the per-sample fields of a trun box. |kFields| is the combination of
+// sample fields present, so that the loop does not test the flags for every
+// sample. Returns true if any of the composition time offsets is negative.
+template <size_t kFields>
+bool WriteTrackFragmentRunSamples(const TrackFragmentRun& trun,
+                                  FieldWriter* out) {
+  constexpr bool kDurationPresent =
+      (kFields << kSampleFieldsShift) &
+      TrackFragmentRun::kSampleDurationPresentMask;
+  constexpr bool kSizePresent = (kFields << kSampleFieldsShift) &
+                                TrackFragmentRun::kSampleSizePresentMask;
+  constexpr bool kFlagsPresent = (kFields << kSampleFieldsShift) &
+                                 TrackFragmentRun::kSampleFlagsPresentMask;
+  constexpr bool kCompTimeOffsetsPresent =
+      (kFields << kSampleFieldsShift) &
+      TrackFragmentRun::kSampleCompTimeOffsetsPresentMask;
+
+  if (kDurationPresent)
+    DCHECK_EQ(trun.sample_durations.size(), trun.sample_count);
+  if (kSizePresent)
+    DCHECK_EQ(trun.sample_sizes.size(), trun.sample_count);
+  if (kFlagsPresent)
+    DCHECK_EQ(trun.sample_flags.size(), trun.sample_count);
+  if (kCompTimeOffsetsPresent) {
+    DCHECK_EQ(trun.sample_composition_time_offsets.size(),
+              trun.sample_count);
+  }
+
+  bool has_negative_offset = false;
+  for (uint32_t i = 0; i < trun.sample_count; ++i) {
+    if (kDurationPresent)
+      out->WriteUInt32(trun.sample_durations[i]);
+    if (kSizePresent)
+      out->WriteUInt32(trun.sample_sizes[i]);
+    if (kFlagsPresent)
+      out->WriteUInt32(trun.sample_flags[i]);
+    if (kCompTimeOffsetsPresent) {
+      // Version 0 stores the offsets unsigned and version 1 signed, which is
+      // the same 32 bits.
+      const int64_t offset = trun.sample_composition_time_offsets[i];
+      out->WriteUInt32(static_cast<uint32_t>(offset));
+      has_negative_offset |= offset < 0;
+    }
+  }
+  return has_negative_offset;
+}
+
+using SampleFieldsWriter = bool (*)(const TrackFragmentRun&, FieldWriter*);
+
+template <size_t... kFields>
+constexpr std::array<SampleFieldsWriter, sizeof...(kFields)>
+MakeSampleFieldsWriters(std::index_sequence<kFields...>) {
+  return {{&WriteTrackFragmentRunSamples<kFields>...}};
+}
+
+constexpr std::array<SampleFieldsWriter, kNumSampleFieldCombinations>
+    kSampleFieldsWriters = MakeSampleFieldsWriters(
+        std::make_index_sequence<kNumSampleFieldCombinations>());
+
+// The Write*Box functions below expect that ComputeSize has been invoked
+// already.
+
+void WriteTrackFragmentRunBox(TrackFragmentRun* trun, FieldWriter* out) {
+  // Version 0 is used unless there is a negative composition time offset,
+  // which is only known after going through the samples, so the version is
+  // patched after writing them.
+  uint8_t* box_start = out->position();
+  trun->version = 0;
+  out->WriteFullBoxHeader(*trun);
+  out->WriteUInt32(trun->sample_count);
+  if (trun->flags & TrackFragmentRun::kDataOffsetPresentMask)
+    out->WriteUInt32(trun->data_offset);
+  if (trun->flags & TrackFragmentRun::kFirstSampleFlagsPresentMask) {
+    DCHECK_EQ(trun->sample_flags.size(), 1u);
+    out->WriteUInt32(trun->sample_flags[0]);
+  }
+
+  const size_t fields = (trun->flags >> kSampleFieldsShift) &
+                        (kNumSampleFieldCombinations - 1);
+  if (kSampleFieldsWriters[fields](*trun, out)) {
+    trun->version = 1;
+    // The version is the first byte after the box size and type.
+    box_start[trun->Box::HeaderSize()] = trun->version;
+  }
+}
+
+void WriteSampleEncryptionBox(const SampleEncryption& senc, FieldWriter* out) {
+  const uint8_t iv_size = senc.iv_size;
+  out->WriteFullBoxHeader(senc);
+  out->WriteUInt32(
+      static_cast<uint32_t>(senc.sample_encryption_entries.size()));
+  if ((senc.flags & SampleEncryption::kUseSubsampleEncryption) == 0) {
+    for (const SampleEncryptionEntry& entry : senc.sample_encryption_entries) {
+      DCHECK_EQ(entry.initialization_vector.size(), iv_size);
+      out->WriteArray(entry.initialization_vector.data(), iv_size);
+    }
+    return;
+  }
+  for (const SampleEncryptionEntry& entry : senc.sample_encryption_entries) {
+    DCHECK_EQ(entry.initialization_vector.size(), iv_size);
+    DCHECK(!entry.subsamples.empty());
+    out->WriteArray(entry.initialization_vector.data(), iv_size);
+    out->WriteUInt16(static_cast<uint16_t>(entry.subsamples.size()));
+    for (const SubsampleEntry& subsample : entry.subsamples) {
+      out->WriteUInt16(subsample.clear_bytes);
+      out->WriteUInt32(subsample.cipher_bytes);
+    }
+  }
+}
+
+void WriteTrackFragmentBox(TrackFragment* traf, FieldWriter* out) {
+  out->WriteBoxHeader(*traf);
+
+  const TrackFragmentHeader& tfhd = traf->header;
+  // The generic writer does not account for the base data offset either. It
+  // is never set when writing, as the base is always the moof box.
+  DCHECK_EQ(tfhd.flags & TrackFragmentHeader::kBaseDataOffsetPresentMask, 0u);
+  out->WriteFullBoxHeader(tfhd);
+  out->WriteUInt32(tfhd.track_id);
+  if (tfhd.flags & TrackFragmentHeader::kSampleDescriptionIndexPresentMask)
+    out->WriteUInt32(tfhd.sample_description_index);
+  if (tfhd.flags & TrackFragmentHeader::kDefaultSampleDurationPresentMask)
+    out->WriteUInt32(tfhd.default_sample_duration);
+  if (tfhd.flags & TrackFragmentHeader::kDefaultSampleSizePresentMask)
+    out->WriteUInt32(tfhd.default_sample_size);
+  if (tfhd.flags & TrackFragmentHeader::kDefaultSampleFlagsPresentMask)
+    out->WriteUInt32(tfhd.default_sample_flags);
+
+  if (!traf->decode_time_absent) {
+    const TrackFragmentDecodeTime& tfdt = traf->decode_time;
+    out->WriteFullBoxHeader(tfdt);
+    out->WriteUInt64ForVersion(tfdt.decode_time, tfdt.version);
+  }
+
+  for (TrackFragmentRun& trun : traf->runs)
+    WriteTrackFragmentRunBox(&trun, out);
+  for (SampleToGroup& sbgp : traf->sample_to_groups)
+    WriteGenericBox(&sbgp, out);
+  for (SampleGroupDescription& sgpd : traf->sample_group_descriptions)
+    WriteGenericBox(&sgpd, out);
+
+  // The auxiliary information and sample encryption boxes are optional and
+  // skipped if empty.
+  const SampleAuxiliaryInformationSize& saiz = traf->auxiliary_size;
+  if (saiz.box_size() != 0) {
+    // aux_info_type is not written, as in the generic writer.
+    DCHECK_EQ(saiz.flags & 1, 0u);
+    out->WriteFullBoxHeader(saiz);
+    out->WriteUInt8(saiz.default_sample_info_size);
+    out->WriteUInt32(saiz.sample_count);
+    if (saiz.default_sample_info_size == 0) {
+      DCHECK_EQ(saiz.sample_info_sizes.size(), saiz.sample_count);
+      out->WriteArray(saiz.sample_info_sizes.data(),
+                      saiz.sample_info_sizes.size());
+    }
+  }
+  const SampleAuxiliaryInformationOffset& saio = traf->auxiliary_offset;
+  if (saio.box_size() != 0) {
+    DCHECK_EQ(saio.flags & 1, 0u);
+    out->WriteFullBoxHeader(saio);
+    out->WriteUInt32(static_cast<uint32_t>(saio.offsets.size()));
+    for (uint64_t offset : saio.offsets)
+      out->WriteUInt64ForVersion(offset, saio.version);
+  }
+  if (traf->sample_encryption.box_size() != 0)
+    WriteSampleEncryptionBox(traf->sample_encryption, out);
+}
+
+}  // namespace
+
+void WriteMovieFragment(MovieFragment* moof, BufferWriter* writer) {
+  DCHECK(moof);
+  DCHECK(writer);
+  // Compute and update the size of the box and its children.
+  const uint32_t size = moof->ComputeSize();
+  FieldWriter out(writer->Grow(size));
+  const uint8_t* start = out.position();
+
+  out.WriteBoxHeader(*moof);
+  out.WriteFullBoxHeader(moof->header);
+  out.WriteUInt32(moof->header.sequence_number);
+  for (TrackFragment& traf : moof->tracks)
+    WriteTrackFragmentBox(&traf, &out);
+  for (const ProtectionSystemSpecificHeader& pssh : moof->pssh) {
+    DCHECK(!pssh.raw_box.empty());
+    out.WriteArray(pssh.raw_box.data(), pssh.raw_box.size());
+  }
+  DCHECK_EQ(static_cast<size_t>(out.position() - start), size);
+}
+
+void WriteTrackFragmentRun(TrackFragmentRun* trun, BufferWriter* writer) {
+  DCHECK(trun);
+  DCHECK(writer);
+  const uint32_t size = trun->ComputeSize();
+  FieldWriter out(writer->Grow(size));
+  const uint8_t* start = out.position();
+  WriteTrackFragmentRunBox(trun, &out);
+  DCHECK_EQ(static_cast<size_t>(out.position() - start), size);
+}
+
+void WriteSampleEncryption(SampleEncryption* senc, BufferWriter* writer) {
+  DCHECK(senc);
+  DCHECK(writer);
+  // An empty box is skipped, as when it is written as a child box.
+  const uint32_t size = senc->ComputeSize();
+  if (size == 0)
+    return;
+  FieldWriter out(writer->Grow(size));
+  const uint8_t* start = out.position();
+  WriteSampleEncryptionBox(*senc, &out);
+  DCHECK_EQ(static_cast<size_t>(out.position() - start), size);
+}
+
+void WriteSegmentIndex(SegmentIndex* sidx, BufferWriter* writer) {
+  DCHECK(sidx);
+  DCHECK(writer);
+  // Also selects the version from the earliest presentation time and the
+  // first offset.
+  const uint32_t size = sidx->ComputeSize();
+  FieldWriter out(writer->Grow(size));
+  const uint8_t* start = out.position();
+
+  out.WriteFullBoxHeader(*sidx);
+  out.WriteUInt32(sidx->reference_id);
+  out.WriteUInt32(sidx->timescale);
+  out.WriteUInt64ForVersion(sidx->earliest_presentation_time, sidx->version);
+  out.WriteUInt64ForVersion(sidx->first_offset, sidx->version);
+
+  size_t reference_count = sidx->references.size();
+  if (reference_count > std::numeric_limits<uint16_t>::max()) {
+    reference_count = std::numeric_limits<uint16_t>::max();
+    LOG(WARNING) << "Seeing " << sidx->references.size()
+                 << " subsegment references, but at most " << reference_count
+                 << " references can be stored in 'sidx' box."
+                 << " The extra references are truncated.";
+    LOG(WARNING) << "The stream will not play to the end in DASH.";
+    LOG(WARNING) << "A possible workaround is to increase segment duration.";
+  }
+  out.WriteUInt16(0);  // reserved.
+  out.WriteUInt16(static_cast<uint16_t>(reference_count));
+
+  for (size_t i = 0; i < reference_count; ++i) {
+    const SegmentReference& reference = sidx->references[i];
+    out.WriteUInt32(reference.referenced_size |
+                    (static_cast<uint32_t>(reference.reference_type) << 31));
+    out.WriteUInt32(reference.subsegment_duration);
+    out.WriteUInt32((static_cast<uint32_t>(reference.starts_with_sap) << 31) |
+                    (static_cast<uint32_t>(reference.sap_type) << 28) |
+                    reference.sap_delta_time);
+  }
+  DCHECK_EQ(static_cast<size_t>(out.position() - start), size);
+}
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
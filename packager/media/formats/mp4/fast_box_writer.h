@@ -0,0 +1,39 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_FORMATS_MP4_FAST_BOX_WRITER_H_
+#define PACKAGER_MEDIA_FORMATS_MP4_FAST_BOX_WRITER_H_
+
+namespace shaka {
+namespace media {
+
+class BufferWriter;
+
+namespace mp4 {
+
+struct MovieFragment;
+struct SampleEncryption;
+struct SegmentIndex;
+struct TrackFragmentRun;
+
+/// Writers for the boxes serialized for every fragment. They produce the same
+/// bytes as Box::Write, but do not go through BoxBuffer, which is shared with
+/// the parser and checks the direction for every field: the box size is
+/// computed once, the buffer is grown by that size, and the fields are stored
+/// in place in a single pass.
+/// Like Box::Write, the writers update the size and version of the boxes.
+/// @{
+void WriteMovieFragment(MovieFragment* moof, BufferWriter* writer);
+void WriteTrackFragmentRun(TrackFragmentRun* trun, BufferWriter* writer);
+void WriteSampleEncryption(SampleEncryption* senc, BufferWriter* writer);
+void WriteSegmentIndex(SegmentIndex* sidx, BufferWriter* writer);
+/// @}
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_FORMATS_MP4_FAST_BOX_WRITER_H_
@@ -0,0 +1,253 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/formats/mp4/fast_box_writer.h>
+
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <packager/media/base/buffer_writer.h>
+#include <packager/media/formats/mp4/box_definitions.h>
+
+namespace shaka {
+namespace media {
+namespace mp4 {
+namespace {
+
+const uint8_t kPsshBox[] = {0, 0, 0, 0x22, 'p', 's', 's', 'h', 0,    0,   0, 0,
+                            0, 0, 0, 0,    0,   0,   0,   0,   0,    0,   0, 0,
+                            0, 0, 0, 0,    0,   0,   0,   2,   0xf0, 0x00};
+const uint32_t kAllSampleFields =
+    TrackFragmentRun::kSampleDurationPresentMask |
+    TrackFragmentRun::kSampleSizePresentMask |
+    TrackFragmentRun::kSampleFlagsPresentMask |
+    TrackFragmentRun::kSampleCompTimeOffsetsPresentMask;
+
+// Returns the box serialized with the generic writer.
+std::vector<uint8_t> GenericWrite(Box* box) {
+  BufferWriter writer;
+  box->Write(&writer);
+  return std::vector<uint8_t>(writer.Buffer(),
+                              writer.Buffer() + writer.Size());
+}
+
+template <typename T>
+std::vector<uint8_t> FastWrite(T* box,
+                               void (*write_function)(T*, BufferWriter*)) {
+  // The box is appended to the existing data.
+  const uint8_t kPrefix[] = {1, 2, 3};
+  BufferWriter writer;
+  writer.AppendArray(kPrefix, sizeof(kPrefix));
+  write_function(box, &writer);
+  EXPECT_EQ(0, memcmp(kPrefix, writer.Buffer(), sizeof(kPrefix)));
+  return std::vector<uint8_t>(writer.Buffer() + sizeof(kPrefix),
+                              writer.Buffer() + writer.Size());
+}
+
+void FillTrackFragmentRun(uint32_t flags,
+                          uint32_t sample_count,
+                          TrackFragmentRun* trun) {
+  trun->flags = TrackFragmentRun::kDataOffsetPresentMask | flags;
+  trun->sample_count = sample_count;
+  trun->data_offset = 1234;
+  for (uint32_t i = 0; i < sample_count; ++i) {
+    if (flags & TrackFragmentRun::kSampleDurationPresentMask)
+      trun->sample_durations.push_back(1000 + i);
+    if (flags & TrackFragmentRun::kSampleSizePresentMask)
+      trun->sample_sizes.push_back(5000 + 7 * i);
+    if (flags & TrackFragmentRun::kSampleFlagsPresentMask)
+      trun->sample_flags.push_back(i == 0 ? 0x02000000 : 0x01010000);
+    if (flags & TrackFragmentRun::kSampleCompTimeOffsetsPresentMask)
+      trun->sample_composition_time_offsets.push_back(2000 * (i % 3));
+  }
+  if (flags & TrackFragmentRun::kFirstSampleFlagsPresentMask)
+    trun->sample_flags.assign(1, 0x02000000);
+}
+
+void FillSampleEncryption(bool use_subsamples,
+                          uint32_t sample_count,
+                          SampleEncryption* senc) {
+  senc->iv_size = 8;
+  senc->flags = use_subsamples ? SampleEncryption::kUseSubsampleEncryption : 0;
+  for (uint32_t i = 0; i < sample_count; ++i) {
+    SampleEncryptionEntry entry;
+    entry.initialization_vector.assign(senc->iv_size, static_cast<uint8_t>(i));
+    if (use_subsamples) {
+      for (uint32_t j = 0; j <= i % 3; ++j)
+        entry.subsamples.emplace_back(static_cast<uint16_t>(16 + j), 70000 + i);
+    }
+    senc->sample_encryption_entries.push_back(entry);
+  }
+}
+
+void FillTrackFragment(uint32_t track_id,
+                       bool encrypted,
+                       uint32_t sample_count,
+                       TrackFragment* traf) {
+  traf->header.track_id = track_id;
+  traf->header.flags = TrackFragmentHeader::kDefaultBaseIsMoofMask |
+                       TrackFragmentHeader::kDefaultSampleDurationPresentMask |
+                       TrackFragmentHeader::kDefaultSampleFlagsPresentMask;
+  traf->header.default_sample_duration = 1024;
+  traf->header.default_sample_flags = 0x01010000;
+  traf->decode_time.decode_time = 90000;
+  traf->runs.resize(1);
+  FillTrackFragmentRun(kAllSampleFields, sample_count, &traf->runs[0]);
+  if (!encrypted)
+    return;
+  FillSampleEncryption(true, sample_count, &traf->sample_encryption);
+  traf->auxiliary_size.sample_count = sample_count;
+  for (uint32_t i = 0; i < sample_count; ++i) {
+    traf->auxiliary_size.sample_info_sizes.push_back(static_cast<uint8_t>(
+        traf->sample_encryption.sample_encryption_entries[i].ComputeSize()));
+  }
+  traf->auxiliary_offset.offsets.push_back(567);
+}
+
+void FillSegmentIndex(uint32_t reference_count, SegmentIndex* sidx) {
+  sidx->reference_id = 1;
+  sidx->timescale = 90000;
+  sidx->earliest_presentation_time = 12345;
+  sidx->first_offset = 678;
+  for (uint32_t i = 0; i < reference_count; ++i) {
+    SegmentReference reference;
+    reference.reference_type = i % 2 == 1;
+    reference.referenced_size = 100000 + i;
+    reference.subsegment_duration = 180000;
+    reference.starts_with_sap = i % 3 != 2;
+    reference.sap_type = SegmentReference::Type1;
+    reference.sap_delta_time = i;
+    sidx->references.push_back(reference);
+  }
+}
+
+}  // namespace
+
+TEST(FastBoxWriterTest, TrackFragmentRunAllSampleFieldCombinations) {
+  for (uint32_t fields = 0; fields < 16; ++fields) {
+    SCOPED_TRACE(fields);
+    TrackFragmentRun trun;
+    FillTrackFragmentRun(fields << 8, 5, &trun);
+    EXPECT_EQ(GenericWrite(&trun), FastWrite(&trun, &WriteTrackFragmentRun));
+  }
+}
+
+TEST(FastBoxWriterTest, TrackFragmentRunFirstSampleFlags) {
+  TrackFragmentRun trun;
+  FillTrackFragmentRun(TrackFragmentRun::kFirstSampleFlagsPresentMask |
+                           TrackFragmentRun::kSampleSizePresentMask,
+                       3, &trun);
+  EXPECT_EQ(GenericWrite(&trun), FastWrite(&trun, &WriteTrackFragmentRun));
+}
+
+TEST(FastBoxWriterTest, TrackFragmentRunNegativeCompositionOffset) {
+  TrackFragmentRun trun;
+  FillTrackFragmentRun(kAllSampleFields, 4, &trun);
+  trun.sample_composition_time_offsets[2] = -1000;
+  const std::vector<uint8_t> expected = GenericWrite(&trun);
+  ASSERT_EQ(1u, trun.version);
+
+  // The version is reset from the previous write.
+  trun.version = 0;
+  EXPECT_EQ(expected, FastWrite(&trun, &WriteTrackFragmentRun));
+  EXPECT_EQ(1u, trun.version);
+
+  trun.sample_composition_time_offsets[2] = 1000;
+  EXPECT_EQ(GenericWrite(&trun), FastWrite(&trun, &WriteTrackFragmentRun));
+  EXPECT_EQ(0u, trun.version);
+}
+
+TEST(FastBoxWriterTest, SampleEncryption) {
+  for (bool use_subsamples : {false, true}) {
+    SCOPED_TRACE(use_subsamples);
+    SampleEncryption senc;
+    FillSampleEncryption(use_subsamples, 4, &senc);
+    EXPECT_EQ(GenericWrite(&senc), FastWrite(&senc, &WriteSampleEncryption));
+  }
+}
+
+TEST(FastBoxWriterTest, EmptySampleEncryption) {
+  SampleEncryption senc;
+  senc.iv_size = 16;
+  EXPECT_TRUE(FastWrite(&senc, &WriteSampleEncryption).empty());
+}
+
+TEST(FastBoxWriterTest, MovieFragment) {
+  for (bool encrypted : {false, true}) {
+    SCOPED_TRACE(encrypted);
+    MovieFragment moof;
+    moof.header.sequence_number = 42;
+    moof.tracks.resize(2);
+    FillTrackFragment(1, encrypted, 2, &moof.tracks[0]);
+    FillTrackFragment(2, encrypted, 30, &moof.tracks[1]);
+    if (encrypted) {
+      ProtectionSystemSpecificHeader pssh;
+      pssh.raw_box.assign(kPsshBox, kPsshBox + sizeof(kPsshBox));
+      moof.pssh.push_back(pssh);
+    }
+    EXPECT_EQ(GenericWrite(&moof), FastWrite(&moof, &WriteMovieFragment));
+  }
+}
+
+TEST(FastBoxWriterTest, MovieFragmentWithLargeDecodeTime) {
+  MovieFragment moof;
+  moof.tracks.resize(1);
+  FillTrackFragment(1, false, 3, &moof.tracks[0]);
+  moof.tracks[0].decode_time.decode_time = 0x123456789ull;
+  moof.tracks[0].runs[0].sample_composition_time_offsets[1] = -3000;
+  EXPECT_EQ(GenericWrite(&moof), FastWrite(&moof, &WriteMovieFragment));
+  EXPECT_EQ(1u, moof.tracks[0].decode_time.version);
+}
+
+TEST(FastBoxWriterTest, MovieFragmentWithSampleGroups) {
+  MovieFragment moof;
+  moof.tracks.resize(1);
+  FillTrackFragment(1, true, 3, &moof.tracks[0]);
+  TrackFragment& traf = moof.tracks[0];
+
+  traf.sample_group_descriptions.resize(1);
+  SampleGroupDescription& sgpd = traf.sample_group_descriptions[0];
+  sgpd.grouping_type = FOURCC_seig;
+  sgpd.cenc_sample_encryption_info_entries.resize(1);
+  CencSampleEncryptionInfoEntry& entry =
+      sgpd.cenc_sample_encryption_info_entries[0];
+  entry.is_protected = 1;
+  entry.per_sample_iv_size = 8;
+  entry.key_id.assign(16, 0x11);
+
+  traf.sample_to_groups.resize(1);
+  SampleToGroup& sbgp = traf.sample_to_groups[0];
+  sbgp.grouping_type = FOURCC_seig;
+  sbgp.entries.resize(1);
+  sbgp.entries[0].sample_count = 3;
+  sbgp.entries[0].group_description_index =
+      SampleToGroupEntry::kTrackFragmentGroupDescriptionIndexBase + 1;
+
+  EXPECT_EQ(GenericWrite(&moof), FastWrite(&moof, &WriteMovieFragment));
+}
+
+TEST(FastBoxWriterTest, SegmentIndex) {
+  SegmentIndex sidx;
+  FillSegmentIndex(5, &sidx);
+  EXPECT_EQ(GenericWrite(&sidx), FastWrite(&sidx, &WriteSegmentIndex));
+  EXPECT_EQ(0u, sidx.version);
+
+  sidx.earliest_presentation_time = 0x123456789ull;
+  EXPECT_EQ(GenericWrite(&sidx), FastWrite(&sidx, &WriteSegmentIndex));
+  EXPECT_EQ(1u, sidx.version);
+}
+
+TEST(FastBoxWriterTest, SegmentIndexWithTooManyReferences) {
+  SegmentIndex sidx;
+  FillSegmentIndex(70000, &sidx);
+  EXPECT_EQ(GenericWrite(&sidx), FastWrite(&sidx, &WriteSegmentIndex));
+}
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
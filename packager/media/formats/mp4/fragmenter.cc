@@ -13,7 +13,7 @@
 
 #include <packager/macros/status.h>
 #include <packager/media/base/audio_stream_info.h>
-#include <packager/media/base/buffer_writer.h>
+#include <packager/media/base/buffer_chain.h>
 #include <packager/media/base/media_sample.h>
 #include <packager/media/formats/mp4/box_definitions.h>
 #include <packager/media/formats/mp4/key_frame_info.h>
@@ -96,7 +96,7 @@ Status Fragmenter::AddSample(const MediaSample& sample) {
     key_frame_infos_.push_back({pts, data_->Size(), sample.data_size()});
   }
 
-  data_->AppendArray(sample.data(), sample.data_size());
+  data_->AppendSharedData(sample.shared_data(), sample.data_size());
 
   traf_->runs[0].sample_composition_time_offsets.push_back(pts - dts);
   if (pts != dts)
@@ -153,7 +153,7 @@ Status Fragmenter::InitializeFragment(int64_t first_sample_dts) {
   fragment_duration_ = 0;
   earliest_presentation_time_ = kInvalidTime;
   first_sap_time_ = kInvalidTime;
-  data_.reset(new BufferWriter());
+  data_.reset(new BufferChain());
   key_frame_infos_.clear();
   return Status::OK;
 }
@@ -0,0 +1,174 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// Benchmark for generating video fragments: adding the samples to a
+// Fragmenter, and writing the resulting 'moof' and 'mdat' boxes.
+
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <packager/media/base/buffer_chain.h>
+#include <packager/media/base/buffer_writer.h>
+#include <packager/media/base/decrypt_config.h>
+#include <packager/media/base/fourccs.h>
+#include <packager/media/base/media_sample.h>
+#include <packager/media/base/video_stream_info.h>
+#include <packager/media/formats/mp4/box_definitions.h>
+#include <packager/media/formats/mp4/fast_box_writer.h>
+#include <packager/media/formats/mp4/fragmenter.h>
+
+namespace shaka {
+namespace media {
+namespace mp4 {
+namespace {
+
+const int32_t kTimeScale = 90000;
+const int64_t kSampleDuration = 3000;  // 30 fps.
+const size_t kKeyFrameSize = 64 * 1024;
+const size_t kMaxFrameSize = 16 * 1024;
+const uint8_t kNaluLengthSize = 4;
+const size_t kClearBytes = 64;
+
+// Returns a GOP of |num_samples| video samples of varied sizes.
+std::vector<std::shared_ptr<MediaSample>> CreateSamples(size_t num_samples,
+                                                        bool encrypted) {
+  const std::vector<uint8_t> data(kKeyFrameSize, 0x42);
+  const std::vector<uint8_t> key_id(16, 0x01);
+  std::vector<uint8_t> iv(8, 0x02);
+
+  std::vector<std::shared_ptr<MediaSample>> samples;
+  uint32_t random_state = 1;
+  for (size_t i = 0; i < num_samples; ++i) {
+    random_state = random_state * 1103515245 + 12345;
+    const bool is_key_frame = i == 0;
+    const size_t size = is_key_frame
+                            ? kKeyFrameSize
+                            : 1024 + (random_state >> 8) % kMaxFrameSize;
+    std::shared_ptr<MediaSample> sample =
+        MediaSample::CopyFrom(data.data(), size, is_key_frame);
+    sample->set_duration(kSampleDuration);
+    // B-frames, so that the composition offsets are written.
+    sample->set_dts(i * kSampleDuration);
+    sample->set_pts((i + (i % 3 == 1 ? 2 : 0)) * kSampleDuration);
+    if (encrypted) {
+      iv[7] = static_cast<uint8_t>(i);
+      const std::vector<SubsampleEntry> subsamples = {
+          {static_cast<uint16_t>(kClearBytes),
+           static_cast<uint32_t>(size - kClearBytes)}};
+      sample->set_decrypt_config(std::unique_ptr<DecryptConfig>(
+          new DecryptConfig(key_id, iv, subsamples, FOURCC_cenc, 0, 0)));
+    }
+    samples.push_back(sample);
+  }
+  return samples;
+}
+
+// The argument is the number of samples per fragment.
+void BM_Fragment(benchmark::State& state, bool encrypted) {
+  const std::vector<uint8_t> kCodecConfig = {0x01, 0x64, 0x00, 0x1e};
+  auto stream_info = std::make_shared<VideoStreamInfo>(
+      1, kTimeScale, 0, kCodecH264,
+      H26xStreamFormat::kNalUnitStreamWithoutParameterSetNalus, "avc1",
+      kCodecConfig.data(), kCodecConfig.size(), 1280, 720, 1, 1, 0, 0, 0, 0,
+      kNaluLengthSize, "und", encrypted);
+  if (encrypted) {
+    EncryptionConfig encryption_config;
+    encryption_config.per_sample_iv_size = 8;
+    stream_info->set_encryption_config(encryption_config);
+  }
+  const std::vector<std::shared_ptr<MediaSample>> samples =
+      CreateSamples(state.range(0), encrypted);
+
+  MovieFragment moof;
+  moof.tracks.resize(1);
+  moof.tracks[0].header.track_id = 1;
+  Fragmenter fragmenter(stream_info, &moof.tracks[0], 0);
+  BufferWriter moof_buffer;
+  BufferChain buffer;
+  size_t bytes_written = 0;
+  for (auto _ : state) {
+    for (const std::shared_ptr<MediaSample>& sample : samples) {
+      if (!fragmenter.AddSample(*sample).ok()) {
+        state.SkipWithError("Failed to add a sample.");
+        return;
+      }
+    }
+    if (!fragmenter.FinalizeFragment().ok()) {
+      state.SkipWithError("Failed to finalize the fragment.");
+      return;
+    }
+
+    ++moof.header.sequence_number;
+    MediaData mdat;
+    mdat.data_size = static_cast<uint32_t>(fragmenter.data()->Size());
+    moof.tracks[0].runs[0].data_offset =
+        moof.ComputeSize() + mdat.HeaderSize();
+    WriteMovieFragment(&moof, &moof_buffer);
+    mdat.WriteHeader(&moof_buffer);
+    buffer.AppendBuffer(moof_buffer);
+    buffer.AppendChain(*fragmenter.data());
+    bytes_written += buffer.Size();
+    moof_buffer.Clear();
+    buffer.Clear();
+    fragmenter.ClearFragmentFinalized();
+  }
+  state.SetBytesProcessed(bytes_written);
+  state.SetItemsProcessed(state.iterations() * samples.size());
+}
+
+// The argument is the number of samples in the fragment. Compares the
+// serialization of the moof box with the generic and the fast path writers.
+void BM_WriteMovieFragment(benchmark::State& state, bool fast_path) {
+  auto stream_info = std::make_shared<VideoStreamInfo>(
+      1, kTimeScale, 0, kCodecH264,
+      H26xStreamFormat::kNalUnitStreamWithoutParameterSetNalus, "avc1",
+      nullptr, 0, 1280, 720, 1, 1, 0, 0, 0, 0, kNaluLengthSize, "und", true);
+  EncryptionConfig encryption_config;
+  encryption_config.per_sample_iv_size = 8;
+  stream_info->set_encryption_config(encryption_config);
+
+  MovieFragment moof;
+  moof.tracks.resize(1);
+  moof.tracks[0].header.track_id = 1;
+  Fragmenter fragmenter(stream_info, &moof.tracks[0], 0);
+  for (const std::shared_ptr<MediaSample>& sample :
+       CreateSamples(state.range(0), true)) {
+    if (!fragmenter.AddSample(*sample).ok()) {
+      state.SkipWithError("Failed to add a sample.");
+      return;
+    }
+  }
+  if (!fragmenter.FinalizeFragment().ok()) {
+    state.SkipWithError("Failed to finalize the fragment.");
+    return;
+  }
+
+  BufferWriter moof_buffer;
+  size_t bytes_written = 0;
+  for (auto _ : state) {
+    if (fast_path)
+      WriteMovieFragment(&moof, &moof_buffer);
+    else
+      moof.Write(&moof_buffer);
+    bytes_written += moof_buffer.Size();
+    moof_buffer.Clear();
+  }
+  state.SetBytesProcessed(bytes_written);
+}
+
+// 2 seconds, and 10 seconds of video.
+BENCHMARK_CAPTURE(BM_Fragment, clear, false)->Arg(60)->Arg(300);
+BENCHMARK_CAPTURE(BM_Fragment, cenc, true)->Arg(60)->Arg(300);
+// 2-frame low latency chunks, and 10 seconds of video.
+BENCHMARK_CAPTURE(BM_WriteMovieFragment, generic, false)->Arg(2)->Arg(300);
+BENCHMARK_CAPTURE(BM_WriteMovieFragment, fast_path, true)->Arg(2)->Arg(300);
+
+}  // namespace
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
@@ -14,6 +14,7 @@
 #include <packager/file/file_closer.h>
 #include <packager/macros/logging.h>
 #include <packager/macros/status.h>
+#include <packager/media/base/buffer_chain.h>
 #include <packager/media/base/buffer_writer.h>
 #include <packager/media/base/media_handler.h>
 #include <packager/media/base/muxer_options.h>
@@ -164,6 +165,7 @@ Status LowLatencySegmentSegmenter::WriteInitialChunk(int64_t segment_number) {
     muxer_listener()->OnNewSegment(
         file_name_, sidx()->earliest_presentation_time, segment_duration,
         segment_size_, segment_number);
+    NotifyNewChunk(segment_header_size, segment_size_ - segment_header_size);
     is_initial_chunk_in_seg_ = false;
   }
 
@@ -173,14 +175,35 @@ Status LowLatencySegmentSegmenter::WriteInitialChunk(int64_t segment_number) {
 Status LowLatencySegmentSegmenter::WriteChunk() {
   DCHECK(fragment_buffer());
 
+  // The chunks are appended to the segment, which is reported with its full
+  // size when it is finalized.
+  const uint64_t chunk_offset = segment_size_;
+  const uint64_t chunk_size = fragment_buffer()->Size();
+  segment_size_ += chunk_size;
+
   // Write the chunk data to the file
   RETURN_IF_ERROR(fragment_buffer()->WriteToFile(segment_file_.get()));
 
   UpdateProgress(GetSegmentDuration());
 
+  if (muxer_listener())
+    NotifyNewChunk(chunk_offset, chunk_size);
+
   return Status::OK;
 }
 
+void LowLatencySegmentSegmenter::NotifyNewChunk(uint64_t start_byte_offset,
+                                                uint64_t size) {
+  DCHECK(sidx());
+  DCHECK(!sidx()->references.empty());
+  // Every chunk adds a reference, so the last one describes this chunk.
+  const SegmentReference& reference = sidx()->references.back();
+  muxer_listener()->OnNewChunk(reference.earliest_presentation_time,
+                               reference.subsegment_duration,
+                               start_byte_offset, size,
+                               reference.starts_with_sap);
+}
+
 Status LowLatencySegmentSegmenter::FinalizeSegment() {
   if (muxer_listener()) {
     muxer_listener()->OnCompletedSegment(GetSegmentDuration(), segment_size_);
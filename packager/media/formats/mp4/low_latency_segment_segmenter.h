@@ -52,6 +52,9 @@ class LowLatencySegmentSegmenter : public Segmenter {
   Status WriteChunk();
   Status WriteInitialChunk(int64_t segment_number);
   Status FinalizeSegment();
+  // Notifies the listener of the chunk just written, which is the last
+  // reference in 'sidx'.
+  void NotifyNewChunk(uint64_t start_byte_offset, uint64_t size);
 
   uint64_t GetSegmentDuration();
 
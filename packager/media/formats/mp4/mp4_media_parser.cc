@@ -14,9 +14,11 @@
 
 #include <packager/file.h>
 #include <packager/file/file_closer.h>
+#include <packager/file/local_file.h>
 #include <packager/macros/compiler.h>
 #include <packager/macros/logging.h>
 #include <packager/media/base/audio_stream_info.h>
+#include <packager/media/base/buffer_pool.h>
 #include <packager/media/base/buffer_reader.h>
 #include <packager/media/base/decrypt_config.h>
 #include <packager/media/base/key_source.h>
@@ -325,12 +327,26 @@ bool MP4MediaParser::LoadMoov(const std::string& file_path) {
     return false;
   }
 
+  // Memory mapped files are parsed directly from the mapping.
+  LocalFile* mapped_file = dynamic_cast<LocalFile*>(file.get());
+  if (mapped_file && !mapped_file->is_mapped())
+    mapped_file = nullptr;
+  std::vector<uint8_t> buffer;
+  auto read = [&file, mapped_file, &buffer](uint64_t size,
+                                            const uint8_t** data) {
+    if (mapped_file)
+      return mapped_file->ReadView(size, data);
+    buffer.resize(size);
+    *data = buffer.data();
+    return file->Read(buffer.data(), size);
+  };
+
   uint64_t file_position(0);
   bool mdat_seen(false);
   while (true) {
     const uint32_t kBoxHeaderReadSize(16);
-    std::vector<uint8_t> buffer(kBoxHeaderReadSize);
-    int64_t bytes_read = file->Read(&buffer[0], kBoxHeaderReadSize);
+    const uint8_t* data = nullptr;
+    int64_t bytes_read = read(kBoxHeaderReadSize, &data);
     if (bytes_read == 0) {
       LOG(ERROR) << "Could not find 'moov' box in file '" << file_path << "'";
       return false;
@@ -342,8 +358,8 @@ bool MP4MediaParser::LoadMoov(const std::string& file_path) {
     uint64_t box_size;
     FourCC box_type;
     bool err;
-    if (!BoxReader::StartBox(&buffer[0], kBoxHeaderReadSize, &box_type,
-                             &box_size, &err)) {
+    if (!BoxReader::StartBox(data, kBoxHeaderReadSize, &box_type, &box_size,
+                             &err)) {
       LOG(ERROR) << "Could not start box from file '" << file_path << "'";
       return false;
     }
@@ -355,20 +371,19 @@ bool MP4MediaParser::LoadMoov(const std::string& file_path) {
         break;
       }
       // 'mdat' before 'moov'. Read and parse 'moov'.
-      if (!Parse(&buffer[0], bytes_read)) {
+      if (!Parse(data, bytes_read)) {
         LOG(ERROR) << "Error parsing mp4 file '" << file_path << "'";
         return false;
       }
       uint64_t bytes_to_read = box_size - bytes_read;
-      buffer.resize(bytes_to_read);
       while (bytes_to_read > 0) {
-        bytes_read = file->Read(&buffer[0], bytes_to_read);
+        bytes_read = read(bytes_to_read, &data);
         if (bytes_read <= 0) {
           LOG(ERROR) << "Error reading 'moov' contents from file '" << file_path
                      << "'";
           return false;
         }
-        if (!Parse(&buffer[0], bytes_read)) {
+        if (!Parse(data, bytes_read)) {
           LOG(ERROR) << "Error parsing mp4 file '" << file_path << "'";
           return false;
         }
@@ -387,6 +402,19 @@ bool MP4MediaParser::LoadMoov(const std::string& file_path) {
   return true;
 }
 
+const Movie* MP4MediaParser::ParseMovie(const uint8_t* buf, size_t size) {
+  DCHECK_NE(state_, kWaitingForInit);
+  bool err = false;
+  std::unique_ptr<BoxReader> reader(BoxReader::ReadBox(buf, size, &err));
+  if (!reader || reader->type() != FOURCC_moov) {
+    LOG(ERROR) << "Expecting a complete 'moov' box.";
+    return nullptr;
+  }
+  if (!ParseMoov(reader.get()))
+    return nullptr;
+  return moov_.get();
+}
+
 bool MP4MediaParser::ParseBox(bool* err) {
   const uint8_t* buf;
   int size;
@@ -984,8 +1012,6 @@ bool MP4MediaParser::EnqueueSample(bool* err) {
       MediaSample::CopyFrom(media_data, kDummyDataSize, runs_->is_keyframe()));
 
   if (runs_->is_encrypted()) {
-    std::shared_ptr<uint8_t> decrypted_media_data(
-        new uint8_t[media_data_size], std::default_delete<uint8_t[]>());
     std::unique_ptr<DecryptConfig> decrypt_config = runs_->GetDecryptConfig();
     if (!decrypt_config) {
       *err = true;
@@ -994,12 +1020,16 @@ bool MP4MediaParser::EnqueueSample(bool* err) {
     }
 
     if (!decryptor_source_) {
-      stream_sample->SetData(media_data, media_data_size);
+      // The sample references the input data instead of copying it.
+      stream_sample->TransferData(queue_.Share(media_data, media_data_size),
+                                  media_data_size);
       // If the demuxer does not have the decryptor_source_, store
       // decrypt_config so that the demuxed sample can be decrypted later.
       stream_sample->set_decrypt_config(std::move(decrypt_config));
       stream_sample->set_is_encrypted(true);
     } else {
+      std::shared_ptr<uint8_t> decrypted_media_data =
+          BufferPool::GetInstance()->Allocate(media_data_size);
       if (!decryptor_source_->DecryptSampleBuffer(decrypt_config.get(),
                                                   media_data, media_data_size,
                                                   decrypted_media_data.get())) {
@@ -1011,7 +1041,9 @@ bool MP4MediaParser::EnqueueSample(bool* err) {
                                   media_data_size);
     }
   } else {
-    stream_sample->SetData(media_data, media_data_size);
+    // The sample references the input data instead of copying it.
+    stream_sample->TransferData(queue_.Share(media_data, media_data_size),
+                                media_data_size);
   }
 
   stream_sample->set_dts(runs_->dts());
@@ -1025,7 +1057,9 @@ bool MP4MediaParser::EnqueueSample(bool* err) {
            << ", cts=" << runs_->cts()
            << ", size=" << runs_->sample_size();
 
-  if (!new_sample_cb_(runs_->track_id(), stream_sample)) {
+  // The sample is handed over, so that it can be modified in place
+  // downstream, e.g. by an EncryptionHandler.
+  if (!new_sample_cb_(runs_->track_id(), std::move(stream_sample))) {
     *err = true;
     LOG(ERROR) << "Failed to process the sample.";
     return false;
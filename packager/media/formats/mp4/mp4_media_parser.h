@@ -54,6 +54,14 @@ class MP4MediaParser : public MediaParser {
   /// @return true if successful, false otherwise.
   bool LoadMoov(const std::string& file_path);
 
+  /// Parses a complete 'moov' box without any media data, e.g. to index the
+  /// samples of a non-fragmented file before reading them. The streams are
+  /// reported through the init callback.
+  /// @param buf points to the 'moov' box.
+  /// @param size is the size of the box.
+  /// @return the parsed movie, owned by the parser, or nullptr on error.
+  const Movie* ParseMovie(const uint8_t* buf, size_t size);
+
  private:
   enum State {
     kWaitingForInit,
@@ -16,11 +16,13 @@
 #include <packager/file/file_closer.h>
 #include <packager/macros/logging.h>
 #include <packager/macros/status.h>
+#include <packager/media/base/buffer_chain.h>
 #include <packager/media/base/buffer_writer.h>
 #include <packager/media/base/muxer_options.h>
 #include <packager/media/base/muxer_util.h>
 #include <packager/media/event/muxer_listener.h>
 #include <packager/media/formats/mp4/box_definitions.h>
+#include <packager/media/formats/mp4/fast_box_writer.h>
 #include <packager/media/formats/mp4/key_frame_info.h>
 
 namespace shaka {
@@ -124,7 +126,7 @@ Status MultiSegmentSegmenter::WriteSegment(int64_t segment_number) {
   }
 
   if (options().mp4_params.generate_sidx_in_media_segments)
-    sidx()->Write(buffer.get());
+    WriteSegmentIndex(sidx(), buffer.get());
 
   const size_t segment_header_size = buffer->Size();
   const size_t segment_size = segment_header_size + fragment_buffer()->Size();
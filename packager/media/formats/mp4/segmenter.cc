@@ -11,6 +11,7 @@
 #include <absl/log/check.h>
 #include <absl/log/log.h>
 
+#include <packager/media/base/buffer_chain.h>
 #include <packager/media/base/buffer_writer.h>
 #include <packager/media/base/id3_tag.h>
 #include <packager/media/base/media_sample.h>
@@ -20,6 +21,7 @@
 #include <packager/media/chunking/chunking_handler.h>
 #include <packager/media/event/progress_listener.h>
 #include <packager/media/formats/mp4/box_definitions.h>
+#include <packager/media/formats/mp4/fast_box_writer.h>
 #include <packager/media/formats/mp4/fragmenter.h>
 #include <packager/media/formats/mp4/key_frame_info.h>
 #include <packager/version/version.h>
@@ -45,7 +47,7 @@ Segmenter::Segmenter(const MuxerOptions& options,
       ftyp_(std::move(ftyp)),
       moov_(std::move(moov)),
       moof_(new MovieFragment()),
-      fragment_buffer_(new BufferWriter()),
+      fragment_buffer_(new BufferChain()),
       sidx_(new SegmentIndex()) {}
 
 Segmenter::~Segmenter() {}
@@ -205,9 +207,12 @@ Status Segmenter::FinalizeSegment(size_t stream_id,
 
   const uint64_t moof_start_offset = fragment_buffer_->Size();
 
-  // Write the fragment to buffer.
-  moof_->Write(fragment_buffer_.get());
-  mdat.WriteHeader(fragment_buffer_.get());
+  // Write the fragment to buffer. Only the boxes are serialized, the sample
+  // data is referenced by the buffer and written from the samples directly.
+  BufferWriter moof_buffer;
+  WriteMovieFragment(moof_.get(), &moof_buffer);
+  mdat.WriteHeader(&moof_buffer);
+  fragment_buffer_->AppendBuffer(moof_buffer);
 
   bool first_key_frame = true;
   for (const std::unique_ptr<Fragmenter>& fragmenter : fragmenters_) {
@@ -223,7 +228,7 @@ Status Segmenter::FinalizeSegment(size_t stream_id,
           {key_frame_info.timestamp, moof_start_offset,
            fragment_buffer_->Size() - moof_start_offset + key_frame_info.size});
     }
-    fragment_buffer_->AppendBuffer(*fragmenter->data());
+    fragment_buffer_->AppendChain(*fragmenter->data());
   }
 
   // Increase sequence_number for next fragment.
@@ -7,18 +7,57 @@
 #include <packager/media/formats/mp4/single_segment_segmenter.h>
 
 #include <algorithm>
+#include <memory>
+#include <vector>
 
 #include <absl/log/check.h>
 
 #include <packager/file/file_util.h>
+#include <packager/macros/status.h>
+#include <packager/media/base/buffer_chain.h>
 #include <packager/media/base/buffer_writer.h>
 #include <packager/media/base/muxer_options.h>
 #include <packager/media/event/progress_listener.h>
+#include <packager/media/formats/mp4/fast_box_writer.h>
 #include <packager/media/formats/mp4/key_frame_info.h>
 
 namespace shaka {
 namespace media {
 namespace mp4 {
+namespace {
+
+const uint64_t kFreeBoxHeaderSize = 8;
+
+// Moves the data from |from| to the end of |file| to |to|, which must be
+// larger than |from|. The data is moved from its end backwards, so that no
+// byte is overwritten before it has been moved.
+Status MoveDataForward(File* file, uint64_t from, uint64_t to) {
+  DCHECK_GT(to, from);
+  const int64_t file_size = file->Size();
+  if (file_size < 0 || static_cast<uint64_t>(file_size) < from) {
+    return Status(error::FILE_FAILURE,
+                  "Cannot get the size of file " + file->file_name());
+  }
+
+  const uint64_t kBufSize = 0x200000;  // 2MB.
+  std::unique_ptr<uint8_t[]> buf(new uint8_t[kBufSize]);
+  uint64_t end = file_size;
+  while (end > from) {
+    const uint64_t size = std::min(kBufSize, end - from);
+    const uint64_t start = end - size;
+    if (!file->Seek(start) ||
+        file->Read(buf.get(), size) != static_cast<int64_t>(size) ||
+        !file->Seek(start + to - from) ||
+        file->Write(buf.get(), size) != static_cast<int64_t>(size)) {
+      return Status(error::FILE_FAILURE,
+                    "Failed to move data in file " + file->file_name());
+    }
+    end = start;
+  }
+  return Status::OK;
+}
+
+}  // namespace
 
 SingleSegmentSegmenter::SingleSegmentSegmenter(const MuxerOptions& options,
                                                std::unique_ptr<FileType> ftyp,
@@ -28,6 +67,8 @@ SingleSegmentSegmenter::SingleSegmentSegmenter(const MuxerOptions& options,
 SingleSegmentSegmenter::~SingleSegmentSegmenter() {
   if (temp_file_)
     temp_file_.release()->Close();
+  if (output_file_)
+    output_file_.release()->Close();
   if (!temp_file_name_.empty()) {
     if (!File::Delete(temp_file_name_.c_str()))
       LOG(ERROR) << "Unable to delete temporary file " << temp_file_name_;
@@ -70,6 +111,35 @@ std::vector<Range> SingleSegmentSegmenter::GetSegmentRanges() {
 }
 
 Status SingleSegmentSegmenter::DoInitialize() {
+  const uint32_t reserved_header_size =
+      options().mp4_params.reserved_header_size;
+  if (reserved_header_size > 0) {
+    // The header is written at the start of the file in the end, and the
+    // media data may have to be moved in place, which requires a local file.
+    // It is checked before the output is opened, which may already publish it,
+    // e.g. to an origin.
+    if (!File::IsLocalRegularOutputFile(options().output_file_name.c_str())) {
+      return Status(error::INVALID_ARGUMENT,
+                    "--mp4_reserved_header_size requires a local output "
+                    "file, which '" +
+                        options().output_file_name + "' is not.");
+    }
+    output_file_.reset(File::Open(options().output_file_name.c_str(), "w"));
+    if (!output_file_) {
+      return Status(error::FILE_FAILURE,
+                    "Cannot open file to write " + options().output_file_name);
+    }
+    // The reserved space is zeroed, so that only the header of the 'free' box
+    // filling it has to be written in the end.
+    std::vector<uint8_t> reserved_space(reserved_header_size);
+    if (output_file_->Write(reserved_space.data(), reserved_space.size()) !=
+        static_cast<int64_t>(reserved_space.size())) {
+      return Status(error::FILE_FAILURE,
+                    "Failed to write file " + options().output_file_name);
+    }
+    return Status::OK;
+  }
+
   // Single segment segmentation involves two stages:
   //   Stage 1: Create media subsegments from media samples
   //   Stage 2: Update media header (moov) which involves copying of media
@@ -88,10 +158,12 @@ Status SingleSegmentSegmenter::DoInitialize() {
 }
 
 Status SingleSegmentSegmenter::DoFinalize() {
-  DCHECK(temp_file_);
   DCHECK(ftyp());
   DCHECK(moov());
   DCHECK(vod_sidx_);
+  if (output_file_)
+    return FinalizeReservedHeader();
+  DCHECK(temp_file_);
 
   // Close the temp file to prepare for reading later.
   if (!temp_file_.release()->Close()) {
@@ -117,7 +189,7 @@ Status SingleSegmentSegmenter::DoFinalize() {
   moov()->Write(buffer.get());
 
   if (options().mp4_params.generate_sidx_in_media_segments)
-    vod_sidx_->Write(buffer.get());
+    WriteSegmentIndex(vod_sidx_.get(), buffer.get());
 
   Status status = buffer->WriteToFile(file.get());
   if (!status.ok())
@@ -166,6 +238,62 @@ Status SingleSegmentSegmenter::DoFinalize() {
   return Status::OK;
 }
 
+Status SingleSegmentSegmenter::FinalizeReservedHeader() {
+  const std::string& file_name = options().output_file_name;
+  const uint64_t reserved_header_size =
+      options().mp4_params.reserved_header_size;
+  const bool write_sidx = options().mp4_params.generate_sidx_in_media_segments;
+
+  const uint64_t header_size = ftyp()->ComputeSize() + moov()->ComputeSize() +
+                               (write_sidx ? vod_sidx_->ComputeSize() : 0);
+  uint64_t media_offset = reserved_header_size;
+  if (header_size != media_offset &&
+      header_size + kFreeBoxHeaderSize > media_offset) {
+    // There is no room for the header, or for a 'free' box after it.
+    media_offset = header_size > reserved_header_size
+                       ? header_size
+                       : header_size + kFreeBoxHeaderSize;
+    LOG(WARNING) << "The header of '" << file_name << "' needs "
+                 << header_size << " bytes, but " << reserved_header_size
+                 << " bytes are reserved. Moving the media data.";
+    if (!output_file_.release()->Close()) {
+      return Status(error::FILE_FAILURE, "Cannot close file " + file_name);
+    }
+    output_file_.reset(File::Open(file_name.c_str(), "r+"));
+    if (!output_file_) {
+      return Status(error::FILE_FAILURE,
+                    "Cannot open file to update " + file_name);
+    }
+    RETURN_IF_ERROR(MoveDataForward(output_file_.get(), reserved_header_size,
+                                    media_offset));
+  }
+  // The space left between the header and the media data is a 'free' box,
+  // which the sidx skips.
+  vod_sidx_->first_offset = media_offset - header_size;
+
+  BufferWriter buffer;
+  ftyp()->Write(&buffer);
+  moov()->Write(&buffer);
+  if (write_sidx)
+    WriteSegmentIndex(vod_sidx_.get(), &buffer);
+  if (vod_sidx_->first_offset > 0) {
+    buffer.AppendInt(static_cast<uint32_t>(vod_sidx_->first_offset));
+    buffer.AppendInt(static_cast<uint32_t>(FOURCC_free));
+  }
+  if (!output_file_->Seek(0))
+    return Status(error::FILE_FAILURE, "Cannot seek in file " + file_name);
+  RETURN_IF_ERROR(buffer.WriteToFile(output_file_.get()));
+
+  if (!output_file_.release()->Close()) {
+    return Status(
+        error::FILE_FAILURE,
+        "Cannot close file " + file_name +
+            ", possibly file permission issue or running out of disk space.");
+  }
+  SetComplete();
+  return Status::OK;
+}
+
 Status SingleSegmentSegmenter::DoFinalizeSegment(int64_t segment_number) {
   DCHECK(sidx());
   DCHECK(fragment_buffer());
@@ -216,9 +344,10 @@ Status SingleSegmentSegmenter::DoFinalizeSegment(int64_t segment_number) {
                                    key_frame_info.size);
     }
   }
-  // Append fragment buffer to temp file.
+  // Append fragment buffer to the output, or to the temp file.
   size_t segment_size = fragment_buffer()->Size();
-  Status status = fragment_buffer()->WriteToFile(temp_file_.get());
+  Status status = fragment_buffer()->WriteToFile(
+      output_file_ ? output_file_.get() : temp_file_.get());
   if (!status.ok()) return status;
 
   UpdateProgress(vod_ref.subsegment_duration);
@@ -46,9 +46,16 @@ class SingleSegmentSegmenter : public Segmenter {
   Status DoFinalize() override;
   Status DoFinalizeSegment(int64_t segment_number) override;
 
+  // Writes ftyp, moov and sidx into the space reserved at the start of
+  // |output_file_|, moving the media data if they do not fit.
+  Status FinalizeReservedHeader();
+
   std::unique_ptr<SegmentIndex> vod_sidx_;
   std::string temp_file_name_;
   std::unique_ptr<File, FileCloser> temp_file_;
+  // The output file, to which the media is written directly if
+  // mp4_params.reserved_header_size is set. |temp_file_| is not used then.
+  std::unique_ptr<File, FileCloser> output_file_;
 
   DISALLOW_COPY_AND_ASSIGN(SingleSegmentSegmenter);
 };
@@ -0,0 +1,153 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// Benchmark for single-segment MP4 output, with the default temporary file
+// and with a reserved header. Also reports the number of bytes written by the
+// process per byte of output.
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <packager/file.h>
+#include <packager/file/file_util.h>
+#include <packager/macros/status.h>
+#include <packager/media/base/audio_stream_info.h>
+#include <packager/media/base/media_handler.h>
+#include <packager/media/base/media_sample.h>
+#include <packager/media/base/muxer_options.h>
+#include <packager/media/formats/mp4/mp4_muxer.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+const int32_t kTimeScale = 48000;
+const int64_t kSampleDuration = 1024;
+const size_t kSampleSize = 64 * 1024;
+const size_t kNumSamples = 1024;
+const size_t kSamplesPerSegment = 94;  // About 2 seconds.
+const uint8_t kCodecConfig[] = {0x12, 0x10};
+const uint32_t kReservedHeaderSize = 64 * 1024;
+
+// Feeds the samples to the muxer.
+class SampleSource : public MediaHandler {
+ public:
+  Status Send(std::unique_ptr<StreamData> stream_data) {
+    return Dispatch(std::move(stream_data));
+  }
+  Status Flush() { return FlushAllDownstreams(); }
+
+ private:
+  Status InitializeInternal() override { return Status::OK; }
+  Status Process(std::unique_ptr<StreamData>) override {
+    return Status(error::INTERNAL_ERROR, "Unexpected input.");
+  }
+  bool ValidateOutputStreamIndex(size_t) const override { return true; }
+};
+
+// Returns the number of bytes the process has passed to write() and similar
+// system calls, or -1 if it is not available.
+int64_t GetBytesWritten() {
+  FILE* io = fopen("/proc/self/io", "r");
+  if (!io)
+    return -1;
+  int64_t bytes_written = -1;
+  char line[128];
+  while (fgets(line, sizeof(line), io)) {
+    long long value = 0;
+    if (sscanf(line, "wchar: %lld", &value) == 1)
+      bytes_written = value;
+  }
+  fclose(io);
+  return bytes_written;
+}
+
+Status Package(const std::string& output_file_name,
+               uint32_t reserved_header_size) {
+  MuxerOptions options;
+  options.output_file_name = output_file_name;
+  options.mp4_params.reserved_header_size = reserved_header_size;
+
+  auto source = std::make_shared<SampleSource>();
+  RETURN_IF_ERROR(
+      source->AddHandler(std::make_shared<mp4::MP4Muxer>(options)));
+  RETURN_IF_ERROR(source->Initialize());
+
+  const int64_t kDuration = kNumSamples * kSampleDuration;
+  RETURN_IF_ERROR(source->Send(StreamData::FromStreamInfo(
+      0, std::make_shared<AudioStreamInfo>(
+             1, kTimeScale, kDuration, kCodecAAC, "mp4a.40.2", kCodecConfig,
+             sizeof(kCodecConfig), 16, 2, kTimeScale, 0, 0, 0, 0, "und",
+             false))));
+
+  std::vector<uint8_t> data(kSampleSize, 0x42);
+  const bool kKeyFrame = true;
+  int64_t segment_start = 0;
+  int64_t segment_number = 1;
+  for (size_t i = 0; i < kNumSamples; ++i) {
+    std::shared_ptr<MediaSample> sample =
+        MediaSample::CopyFrom(data.data(), data.size(), kKeyFrame);
+    const int64_t timestamp = i * kSampleDuration;
+    sample->set_dts(timestamp);
+    sample->set_pts(timestamp);
+    sample->set_duration(kSampleDuration);
+    RETURN_IF_ERROR(source->Send(StreamData::FromMediaSample(0, sample)));
+
+    if ((i + 1) % kSamplesPerSegment == 0 || i + 1 == kNumSamples) {
+      auto segment_info = std::make_shared<SegmentInfo>();
+      segment_info->start_timestamp = segment_start;
+      segment_info->duration = timestamp + kSampleDuration - segment_start;
+      segment_info->segment_number = segment_number++;
+      segment_start += segment_info->duration;
+      RETURN_IF_ERROR(
+          source->Send(StreamData::FromSegmentInfo(0, segment_info)));
+    }
+  }
+  return source->Flush();
+}
+
+// The argument is the size of the reserved header.
+void BM_SingleSegment(benchmark::State& state) {
+  std::string output_file_name;
+  if (!TempFilePath("", &output_file_name)) {
+    state.SkipWithError("Cannot create a temporary file.");
+    return;
+  }
+
+  const bool has_bytes_written = GetBytesWritten() >= 0;
+  int64_t bytes_written = 0;
+  int64_t output_size = 0;
+  for (auto _ : state) {
+    const int64_t bytes_written_before = GetBytesWritten();
+    Status status = Package(output_file_name, state.range(0));
+    bytes_written += GetBytesWritten() - bytes_written_before;
+    if (!status.ok()) {
+      state.SkipWithError(status.ToString().c_str());
+      break;
+    }
+    output_size += File::GetFileSize(output_file_name.c_str());
+  }
+  File::Delete(output_file_name.c_str());
+
+  state.SetBytesProcessed(output_size);
+  if (has_bytes_written && output_size > 0) {
+    state.counters["written_per_output"] =
+        static_cast<double>(bytes_written) / output_size;
+  }
+}
+
+BENCHMARK(BM_SingleSegment)
+    ->Arg(0)
+    ->Arg(kReservedHeaderSize)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace media
+}  // namespace shaka
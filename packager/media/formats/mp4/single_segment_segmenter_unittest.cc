@@ -0,0 +1,267 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/formats/mp4/single_segment_segmenter.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <packager/file.h>
+#include <packager/file/file_util.h>
+#include <packager/macros/status.h>
+#include <packager/media/base/audio_stream_info.h>
+#include <packager/media/base/media_handler.h>
+#include <packager/media/base/media_sample.h>
+#include <packager/media/base/muxer_options.h>
+#include <packager/media/formats/mp4/box_definitions.h>
+#include <packager/media/formats/mp4/box_reader.h>
+#include <packager/media/formats/mp4/mp4_muxer.h>
+#include <packager/utils/clock.h>
+
+namespace shaka {
+namespace media {
+namespace mp4 {
+namespace {
+
+const int32_t kTimeScale = 48000;
+const int64_t kSampleDuration = 1024;
+const size_t kSampleSize = 1000;
+const size_t kNumSamples = 200;
+const size_t kSamplesPerSegment = 47;
+const uint8_t kCodecConfig[] = {0x12, 0x10};
+const uint64_t kFreeBoxHeaderSize = 8;
+
+class FakeClock : public Clock {
+ public:
+  time_point now() noexcept override {
+    return std::chrono::system_clock::time_point(std::chrono::seconds(0));
+  }
+};
+
+// Feeds the samples to the muxer.
+class SampleSource : public MediaHandler {
+ public:
+  Status Send(std::unique_ptr<StreamData> stream_data) {
+    return Dispatch(std::move(stream_data));
+  }
+  Status Flush() { return FlushAllDownstreams(); }
+
+ private:
+  Status InitializeInternal() override { return Status::OK; }
+  Status Process(std::unique_ptr<StreamData>) override {
+    return Status(error::INTERNAL_ERROR, "Unexpected input.");
+  }
+  bool ValidateOutputStreamIndex(size_t) const override { return true; }
+};
+
+struct TopLevelBox {
+  FourCC type;
+  uint64_t offset;
+  uint64_t size;
+};
+
+std::vector<TopLevelBox> GetTopLevelBoxes(const std::string& data) {
+  std::vector<TopLevelBox> boxes;
+  uint64_t offset = 0;
+  while (offset < data.size()) {
+    const uint8_t* buf = reinterpret_cast<const uint8_t*>(data.data());
+    TopLevelBox box;
+    bool err = false;
+    if (!BoxReader::StartBox(buf + offset, data.size() - offset, &box.type,
+                             &box.size, &err)) {
+      ADD_FAILURE() << "Invalid box at offset " << offset;
+      break;
+    }
+    box.offset = offset;
+    boxes.push_back(box);
+    offset += box.size;
+  }
+  return boxes;
+}
+
+bool ParseSegmentIndex(const std::string& data,
+                       const TopLevelBox& box,
+                       SegmentIndex* sidx) {
+  bool err = false;
+  std::unique_ptr<BoxReader> reader(BoxReader::ReadBox(
+      reinterpret_cast<const uint8_t*>(data.data()) + box.offset, box.size,
+      &err));
+  return reader && sidx->Parse(reader.get());
+}
+
+}  // namespace
+
+class SingleSegmentSegmenterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(TempFilePath("", &output_file_name_));
+    // The output without a reserved header, which goes through a temporary
+    // file, is the reference.
+    ASSERT_EQ(Status::OK, Package(output_file_name_, 0));
+    ASSERT_TRUE(File::ReadFileToString(output_file_name_.c_str(),
+                                       &reference_output_));
+    reference_boxes_ = GetTopLevelBoxes(reference_output_);
+    ASSERT_GE(reference_boxes_.size(), 4u);
+    ASSERT_EQ(FOURCC_ftyp, reference_boxes_[0].type);
+    ASSERT_EQ(FOURCC_moov, reference_boxes_[1].type);
+    ASSERT_EQ(FOURCC_sidx, reference_boxes_[2].type);
+    ASSERT_EQ(FOURCC_moof, reference_boxes_[3].type);
+    header_size_ = reference_boxes_[3].offset;
+  }
+
+  void TearDown() override { File::Delete(output_file_name_.c_str()); }
+
+  Status Package(const std::string& output_file_name,
+                 uint32_t reserved_header_size) {
+    MuxerOptions options;
+    options.output_file_name = output_file_name;
+    options.mp4_params.generate_sidx_in_media_segments = true;
+    options.mp4_params.reserved_header_size = reserved_header_size;
+
+    auto muxer = std::make_shared<MP4Muxer>(options);
+    muxer->set_clock(std::make_shared<FakeClock>());
+    auto source = std::make_shared<SampleSource>();
+    RETURN_IF_ERROR(source->AddHandler(muxer));
+    RETURN_IF_ERROR(source->Initialize());
+
+    const int64_t kDuration = kNumSamples * kSampleDuration;
+    RETURN_IF_ERROR(source->Send(StreamData::FromStreamInfo(
+        0, std::make_shared<AudioStreamInfo>(
+               1, kTimeScale, kDuration, kCodecAAC, "mp4a.40.2", kCodecConfig,
+               sizeof(kCodecConfig), 16, 2, kTimeScale, 0, 0, 0, 0, "und",
+               false))));
+
+    const bool kKeyFrame = true;
+    int64_t segment_start = 0;
+    int64_t segment_number = 1;
+    for (size_t i = 0; i < kNumSamples; ++i) {
+      std::vector<uint8_t> data(kSampleSize, static_cast<uint8_t>(i));
+      std::shared_ptr<MediaSample> sample =
+          MediaSample::CopyFrom(data.data(), data.size(), kKeyFrame);
+      const int64_t timestamp = i * kSampleDuration;
+      sample->set_dts(timestamp);
+      sample->set_pts(timestamp);
+      sample->set_duration(kSampleDuration);
+      RETURN_IF_ERROR(source->Send(StreamData::FromMediaSample(0, sample)));
+
+      if ((i + 1) % kSamplesPerSegment == 0 || i + 1 == kNumSamples) {
+        auto segment_info = std::make_shared<SegmentInfo>();
+        segment_info->start_timestamp = segment_start;
+        segment_info->duration = timestamp + kSampleDuration - segment_start;
+        segment_info->segment_number = segment_number++;
+        segment_start += segment_info->duration;
+        RETURN_IF_ERROR(
+            source->Send(StreamData::FromSegmentInfo(0, segment_info)));
+      }
+    }
+    return source->Flush();
+  }
+
+  // Checks that the output has the header of the reference output followed by
+  // a 'free' box of |free_box_size| bytes, if not 0, and the media data of
+  // the reference output.
+  void CheckOutput(uint64_t free_box_size) {
+    std::string output;
+    ASSERT_TRUE(File::ReadFileToString(output_file_name_.c_str(), &output));
+    const uint64_t media_offset = header_size_ + free_box_size;
+    ASSERT_EQ(reference_output_.size() + free_box_size, output.size());
+
+    std::vector<TopLevelBox> boxes = GetTopLevelBoxes(output);
+    ASSERT_EQ(reference_boxes_.size() + (free_box_size > 0 ? 1 : 0),
+              boxes.size());
+    // ftyp and moov are the same.
+    const uint64_t sidx_offset = reference_boxes_[2].offset;
+    EXPECT_EQ(reference_output_.substr(0, sidx_offset),
+              output.substr(0, sidx_offset));
+    ASSERT_EQ(FOURCC_sidx, boxes[2].type);
+    EXPECT_EQ(sidx_offset, boxes[2].offset);
+    EXPECT_EQ(reference_boxes_[2].size, boxes[2].size);
+
+    // The sidx skips the 'free' box.
+    SegmentIndex reference_sidx;
+    SegmentIndex sidx;
+    ASSERT_TRUE(
+        ParseSegmentIndex(reference_output_, reference_boxes_[2],
+                          &reference_sidx));
+    ASSERT_TRUE(ParseSegmentIndex(output, boxes[2], &sidx));
+    EXPECT_EQ(0u, reference_sidx.first_offset);
+    EXPECT_EQ(free_box_size, sidx.first_offset);
+    ASSERT_EQ(reference_sidx.references.size(), sidx.references.size());
+    for (size_t i = 0; i < sidx.references.size(); ++i) {
+      EXPECT_EQ(reference_sidx.references[i].referenced_size,
+                sidx.references[i].referenced_size);
+    }
+
+    size_t media_box_index = 3;
+    if (free_box_size > 0) {
+      const TopLevelBox& free_box = boxes[media_box_index++];
+      ASSERT_EQ(FOURCC_free, free_box.type);
+      EXPECT_EQ(header_size_, free_box.offset);
+      EXPECT_EQ(free_box_size, free_box.size);
+      // The content of the 'free' box is the zeroed reserved space.
+      EXPECT_EQ(std::string(free_box_size - kFreeBoxHeaderSize, '\0'),
+                output.substr(header_size_ + kFreeBoxHeaderSize,
+                              free_box_size - kFreeBoxHeaderSize));
+    }
+    ASSERT_EQ(FOURCC_moof, boxes[media_box_index].type);
+    EXPECT_EQ(media_offset, boxes[media_box_index].offset);
+    EXPECT_EQ(reference_output_.substr(header_size_),
+              output.substr(media_offset));
+  }
+
+  std::string output_file_name_;
+  std::string reference_output_;
+  std::vector<TopLevelBox> reference_boxes_;
+  uint64_t header_size_ = 0;
+};
+
+TEST_F(SingleSegmentSegmenterTest, ReservedHeader) {
+  const uint32_t kReservedHeaderSize = 4096;
+  ASSERT_LT(header_size_ + kFreeBoxHeaderSize, kReservedHeaderSize);
+  ASSERT_EQ(Status::OK, Package(output_file_name_, kReservedHeaderSize));
+  CheckOutput(kReservedHeaderSize - header_size_);
+}
+
+TEST_F(SingleSegmentSegmenterTest, ReservedHeaderFitsExactly) {
+  ASSERT_EQ(Status::OK, Package(output_file_name_, header_size_));
+  CheckOutput(0);
+}
+
+TEST_F(SingleSegmentSegmenterTest, NoRoomForFreeBoxMovesMediaData) {
+  // The header fits, but not a 'free' box after it, so the media data is
+  // moved to make room for an empty 'free' box.
+  ASSERT_EQ(Status::OK, Package(output_file_name_, header_size_ + 4));
+  CheckOutput(kFreeBoxHeaderSize);
+}
+
+TEST_F(SingleSegmentSegmenterTest, ReservedHeaderTooSmallMovesMediaData) {
+  ASSERT_EQ(Status::OK, Package(output_file_name_, 64));
+  CheckOutput(0);
+}
+
+TEST_F(SingleSegmentSegmenterTest, ReservedHeaderRequiresLocalFile) {
+  const char kMemoryFileName[] = "memory://output.mp4";
+  Status status = Package(kMemoryFileName, 4096);
+  EXPECT_EQ(error::INVALID_ARGUMENT, status.error_code());
+  // The output is rejected before it is created.
+  std::string output;
+  EXPECT_FALSE(File::ReadFileToString(kMemoryFileName, &output));
+  File::Delete(kMemoryFileName);
+}
+
+TEST_F(SingleSegmentSegmenterTest, ReservedHeaderCreatesLocalFile) {
+  const uint32_t kReservedHeaderSize = 4096;
+  ASSERT_TRUE(File::Delete(output_file_name_.c_str()));
+  ASSERT_EQ(Status::OK, Package(output_file_name_, kReservedHeaderSize));
+  CheckOutput(kReservedHeaderSize - header_size_);
+}
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
@@ -6,13 +6,134 @@
 
 #include <packager/media/replicator/replicator.h>
 
+#include <thread>
+
+#include <absl/base/thread_annotations.h>
 #include <absl/log/check.h>
 #include <absl/log/log.h>
+#include <absl/synchronization/mutex.h>
+
+#include <packager/macros/status.h>
+#include <packager/media/base/bounded_spsc_queue.h>
 
 namespace shaka {
 namespace media {
 
+// A downstream branch of a parallel replicator, processed on its own thread.
+// The replicator's thread is the only producer of the queue, and the
+// branch's thread its only consumer.
+class Replicator::Branch {
+ public:
+  Branch(Replicator* replicator, size_t output_stream_index, size_t queue_size)
+      : replicator_(replicator),
+        output_stream_index_(output_stream_index),
+        queue_(queue_size),
+        thread_(&Branch::ThreadMain, this) {}
+
+  ~Branch() {
+    queue_.Stop();
+    thread_.join();
+  }
+
+  // Queues |stream_data| for the branch, blocking while the queue is full.
+  Status Push(std::unique_ptr<StreamData> stream_data) {
+    RETURN_IF_ERROR(status());
+    // Counted before it is queued, so the depth never goes below zero when
+    // the branch pops it right away.
+    replicator_->UpdateQueueDepth(1);
+    if (!queue_.Push(std::move(stream_data))) {
+      replicator_->UpdateQueueDepth(-1);
+      return Status(error::CANCELLED, "Replicator stopped.");
+    }
+    return Status::OK;
+  }
+
+  // Queues a flush request behind the queued stream data. Call
+  // WaitForFlush() to wait for it to complete.
+  void RequestFlush() {
+    {
+      absl::MutexLock lock(&mutex_);
+      ++num_pending_flushes_;
+    }
+    // A null entry is a flush request.
+    if (!queue_.Push(nullptr)) {
+      absl::MutexLock lock(&mutex_);
+      --num_pending_flushes_;
+    }
+  }
+
+  // Blocks until all the requested flushes have completed.
+  Status WaitForFlush() {
+    absl::MutexLock lock(&mutex_);
+    while (num_pending_flushes_ > 0)
+      flushed_.Wait(&mutex_);
+    return status_;
+  }
+
+  Status status() {
+    absl::MutexLock lock(&mutex_);
+    return status_;
+  }
+
+ private:
+  Branch(const Branch&) = delete;
+  Branch& operator=(const Branch&) = delete;
+
+  void ThreadMain() {
+    std::unique_ptr<StreamData> stream_data;
+    while (queue_.Pop(&stream_data)) {
+      const bool is_flush = !stream_data;
+      if (!is_flush)
+        replicator_->UpdateQueueDepth(-1);
+
+      // After an error, the stream data is dropped so the upstream is never
+      // blocked on a dead branch.
+      Status result = status();
+      if (result.ok()) {
+        result = is_flush
+                     ? replicator_->FlushDownstream(output_stream_index_)
+                     : replicator_->Dispatch(std::move(stream_data));
+      }
+
+      absl::MutexLock lock(&mutex_);
+      status_.Update(std::move(result));
+      if (is_flush) {
+        --num_pending_flushes_;
+        flushed_.SignalAll();
+      }
+    }
+  }
+
+  Replicator* const replicator_;
+  const size_t output_stream_index_;
+  BoundedSpscQueue<std::unique_ptr<StreamData>> queue_;
+
+  absl::Mutex mutex_;
+  absl::CondVar flushed_ ABSL_GUARDED_BY(mutex_);
+  size_t num_pending_flushes_ ABSL_GUARDED_BY(mutex_) = 0;
+  // The first error returned by the branch.
+  Status status_ ABSL_GUARDED_BY(mutex_);
+
+  // Started last, once the members it uses are constructed.
+  std::thread thread_;
+};
+
+Replicator::Replicator() : queue_size_(0) {}
+
+Replicator::Replicator(size_t queue_size) : queue_size_(queue_size) {
+  DCHECK_GT(queue_size_, 0u);
+}
+
+// Stops and joins the branch threads before the output handlers they use are
+// released by MediaHandler.
+Replicator::~Replicator() = default;
+
 Status Replicator::InitializeInternal() {
+  if (queue_size_ > 0) {
+    for (const auto& out : output_handlers()) {
+      branches_[out.first].reset(new Branch(this, out.first, queue_size_));
+    }
+  }
   return Status::OK;
 }
 
@@ -23,19 +144,41 @@ Status Replicator::Process(std::unique_ptr<StreamData> stream_data) {
     std::unique_ptr<StreamData> copy(new StreamData(*stream_data));
     copy->stream_index = out.first;
 
-    status.Update(Dispatch(std::move(copy)));
+    if (queue_size_ > 0) {
+      status.Update(branches_[out.first]->Push(std::move(copy)));
+    } else {
+      status.Update(Dispatch(std::move(copy)));
+    }
   }
 
   return status;
 }
 
+void Replicator::UpdateQueueDepth(int64_t delta) {
+  const int64_t queue_depth = queue_depth_.fetch_add(delta) + delta;
+  if (stats())
+    stats()->SetQueueDepth(queue_depth);
+}
+
 bool Replicator::ValidateOutputStreamIndex(size_t /* ignored */) const {
   return true;
 }
 
 Status Replicator::OnFlushRequest(size_t input_stream_index) {
   DCHECK_EQ(input_stream_index, 0u);
-  return FlushAllDownstreams();
+  if (queue_size_ == 0)
+    return FlushAllDownstreams();
+
+  // Let all the branches drain and flush at the same time.
+  for (auto& branch : branches_)
+    branch.second->RequestFlush();
+  Status status;
+  for (auto& branch : branches_)
+    status.Update(branch.second->WaitForFlush());
+  // The branches report the depth concurrently, so the last one reported may
+  // be out of date. They are idle now.
+  UpdateQueueDepth(0);
+  return status;
 }
 
 }  // namespace media
@@ -7,6 +7,11 @@
 #ifndef PACKAGER_MEDIA_REPLICATOR_HANDLER_H_
 #define PACKAGER_MEDIA_REPLICATOR_HANDLER_H_
 
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+
 #include <packager/media/base/media_handler.h>
 
 namespace shaka {
@@ -16,12 +21,42 @@ namespace media {
 /// downstream handlers. The messages that are sent downstream are not copies,
 /// they are the original message. It is the responsibility of downstream
 /// handlers to make a copy before modifying the message.
+///
+/// In parallel mode, every downstream branch runs on its own thread, fed
+/// through its own bounded queue. Each branch still receives the messages in
+/// order, a flush request returns once every branch has processed its queue
+/// and flushed, and a full queue blocks the upstream handlers, so the
+/// slowest branch sets the pace.
 class Replicator : public MediaHandler {
+ public:
+  /// Create a replicator which dispatches to its outputs one after another on
+  /// the calling thread.
+  Replicator();
+
+  /// Create a replicator in parallel mode.
+  /// @param queue_size is the number of messages which can be queued for a
+  ///        branch before Process() blocks.
+  explicit Replicator(size_t queue_size);
+
+  ~Replicator() override;
+
  private:
+  class Branch;
+
   Status InitializeInternal() override;
   Status Process(std::unique_ptr<StreamData> stream_data) override;
   bool ValidateOutputStreamIndex(size_t stream_index) const override;
   Status OnFlushRequest(size_t input_stream_index) override;
+
+  // Adds |delta| to the number of stream data queued for the branches, and
+  // reports it to the stats.
+  void UpdateQueueDepth(int64_t delta);
+
+  // Zero if not in parallel mode.
+  const size_t queue_size_;
+  // Output stream index -> branch. Only used in parallel mode.
+  std::map<size_t, std::unique_ptr<Branch>> branches_;
+  std::atomic<int64_t> queue_depth_{0};
 };
 
 }  // namespace media
@@ -0,0 +1,179 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/replicator/replicator.h>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <absl/synchronization/notification.h>
+
+#include <packager/macros/compiler.h>
+#include <packager/media/base/media_handler_test_base.h>
+#include <packager/status/status_test_util.h>
+
+using ::testing::_;
+using ::testing::Sequence;
+
+namespace shaka {
+namespace media {
+namespace {
+
+const size_t kNumOutputs = 3;
+const size_t kQueueSize = 4;
+const size_t kStreamIndex = 0;
+const int32_t kTimeScale = 1000;
+const int64_t kDuration = 100;
+const bool kKeyFrame = true;
+const bool kEncrypted = true;
+const size_t kNumSamples = 50;
+
+// A downstream handler which fails every stream data.
+class FailingMediaHandler : public MediaHandler {
+ private:
+  Status InitializeInternal() override { return Status::OK; }
+
+  Status Process(std::unique_ptr<StreamData> stream_data) override {
+    UNUSED(stream_data);
+    return Status(error::MUXER_FAILURE, "muxer failure");
+  }
+};
+
+// A downstream handler which blocks on the first stream data until it is
+// released.
+class BlockingMediaHandler : public MediaHandler {
+ public:
+  void WaitUntilBlocked() { blocked_.WaitForNotification(); }
+  void Release() { released_.Notify(); }
+
+ private:
+  Status InitializeInternal() override { return Status::OK; }
+
+  Status Process(std::unique_ptr<StreamData> stream_data) override {
+    UNUSED(stream_data);
+    if (!blocked_.HasBeenNotified())
+      blocked_.Notify();
+    released_.WaitForNotification();
+    return Status::OK;
+  }
+
+  Status OnFlushRequest(size_t input_stream_index) override {
+    UNUSED(input_stream_index);
+    return Status::OK;
+  }
+
+  absl::Notification blocked_;
+  absl::Notification released_;
+};
+
+}  // namespace
+
+// The parameter is the queue size, or 0 for the sequential mode.
+class ReplicatorTest : public MediaHandlerTestBase,
+                       public ::testing::WithParamInterface<size_t> {
+ protected:
+  std::shared_ptr<Replicator> CreateReplicator() {
+    return GetParam() > 0 ? std::make_shared<Replicator>(GetParam())
+                          : std::make_shared<Replicator>();
+  }
+
+  Status DispatchSample(FakeInputMediaHandler* input, int64_t timestamp) {
+    return input->Dispatch(StreamData::FromMediaSample(
+        kStreamIndex, GetMediaSample(timestamp, kDuration, kKeyFrame)));
+  }
+};
+
+TEST_P(ReplicatorTest, SendsEverythingToEveryOutputInOrder) {
+  ASSERT_OK(SetUpAndInitializeGraph(CreateReplicator(), 1, kNumOutputs));
+
+  // The outputs may run in parallel, so the order is only checked within each
+  // output.
+  for (size_t output = 0; output < kNumOutputs; ++output) {
+    Sequence sequence;
+    EXPECT_CALL(*Output(output),
+                OnProcess(IsStreamInfo(kStreamIndex, kTimeScale, !kEncrypted,
+                                       _)))
+        .InSequence(sequence);
+    for (size_t i = 0; i < kNumSamples; ++i) {
+      EXPECT_CALL(*Output(output),
+                  OnProcess(IsMediaSample(kStreamIndex, i * kDuration,
+                                          kDuration, !kEncrypted, kKeyFrame)))
+          .InSequence(sequence);
+    }
+    EXPECT_CALL(*Output(output), OnFlush(kStreamIndex)).InSequence(sequence);
+  }
+
+  ASSERT_OK(Input(0)->Dispatch(StreamData::FromStreamInfo(
+      kStreamIndex, GetVideoStreamInfo(kTimeScale))));
+  for (size_t i = 0; i < kNumSamples; ++i)
+    ASSERT_OK(DispatchSample(Input(0), i * kDuration));
+  // The outputs have processed everything once the flush returns.
+  ASSERT_OK(Input(0)->FlushAllDownstreams());
+  for (size_t output = 0; output < kNumOutputs; ++output)
+    testing::Mock::VerifyAndClearExpectations(Output(output));
+}
+
+TEST_P(ReplicatorTest, ReturnsOutputError) {
+  auto input = std::make_shared<FakeInputMediaHandler>();
+  auto replicator = CreateReplicator();
+  ASSERT_OK(input->AddHandler(replicator));
+  ASSERT_OK(replicator->AddHandler(std::make_shared<CachingMediaHandler>()));
+  ASSERT_OK(replicator->AddHandler(std::make_shared<FailingMediaHandler>()));
+  ASSERT_OK(input->Initialize());
+
+  // In parallel mode, the error is reported once the branch has processed
+  // the sample, at the latest when flushing.
+  Status status = DispatchSample(input.get(), 0);
+  status.Update(input->FlushAllDownstreams());
+  EXPECT_EQ(error::MUXER_FAILURE, status.error_code());
+  EXPECT_EQ(error::MUXER_FAILURE,
+            DispatchSample(input.get(), kDuration).error_code());
+}
+
+// The parameter is the queue size.
+class ParallelReplicatorTest : public ReplicatorTest {};
+
+TEST_P(ParallelReplicatorTest, ReportsQueueDepth) {
+  auto input = std::make_shared<FakeInputMediaHandler>();
+  auto replicator = CreateReplicator();
+  auto output1 = std::make_shared<BlockingMediaHandler>();
+  auto output2 = std::make_shared<BlockingMediaHandler>();
+  ASSERT_OK(input->AddHandler(replicator));
+  ASSERT_OK(replicator->AddHandler(output1));
+  ASSERT_OK(replicator->AddHandler(output2));
+  replicator->EnableStats();
+  ASSERT_OK(input->Initialize());
+
+  // Once both branches are blocked on the first sample, the next ones stay
+  // in their queues.
+  ASSERT_OK(DispatchSample(input.get(), 0));
+  output1->WaitUntilBlocked();
+  output2->WaitUntilBlocked();
+  for (size_t i = 1; i < kQueueSize; ++i)
+    ASSERT_OK(DispatchSample(input.get(), i * kDuration));
+
+  MediaHandlerStats stats;
+  replicator->stats()->GetStats(&stats);
+  EXPECT_EQ(2 * (kQueueSize - 1), stats.queue_depth);
+  EXPECT_EQ(2 * (kQueueSize - 1), stats.max_queue_depth);
+
+  output1->Release();
+  output2->Release();
+  ASSERT_OK(input->FlushAllDownstreams());
+  replicator->stats()->GetStats(&stats);
+  EXPECT_EQ(0u, stats.queue_depth);
+  EXPECT_EQ(2 * (kQueueSize - 1), stats.max_queue_depth);
+}
+
+INSTANTIATE_TEST_CASE_P(SequentialAndParallel,
+                        ReplicatorTest,
+                        ::testing::Values(0, kQueueSize));
+INSTANTIATE_TEST_CASE_P(Parallel,
+                        ParallelReplicatorTest,
+                        ::testing::Values(kQueueSize));
+
+}  // namespace media
+}  // namespace shaka
@@ -21,6 +21,7 @@
 // 1. Reflect the request method, body, and headers
 // 2. Return a requested status code
 // 3. Delay a response by a requested amount of time
+// 4. Identify the connection a request was received on
 
 namespace {
 
@@ -272,6 +273,8 @@ bool TestWebServer::HandleReflect(struct mg_http_message* message,
     headers[MongooseStringView(header.name)] = MongooseStringView(header.value);
   }
   reply["headers"] = headers;
+  // Lets clients check whether their requests share a connection.
+  reply["connection"] = std::to_string(connection->id);
 
   mg_http_reply(connection, 200 /* OK */, NULL /* headers */, "%s\n",
                 reply.dump().c_str());
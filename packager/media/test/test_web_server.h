@@ -29,7 +29,8 @@ class TestWebServer {
 
   bool Start();
 
-  // Reflects back the request characteristics as a JSON response.
+  // Reflects back the request characteristics as a JSON response, along with
+  // an ID of the connection it was received on.
   std::string ReflectUrl() { return base_url_ + "/reflect"; }
 
   // Responds with a specific HTTP status code.
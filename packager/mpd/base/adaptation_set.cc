@@ -322,6 +322,23 @@ void AdaptationSet::AddRole(Role role) {
 // example, if AdaptationSet@width is set, then Representation@width is
 // redundant and should not be set.
 std::optional<xml::XmlNode> AdaptationSet::GetXml() {
+  return GenerateXml(/* format_representations= */ false);
+}
+
+std::shared_ptr<const xml::FormattedXml> AdaptationSet::GetFormattedXml(
+    uint32_t id) {
+  // MPD > Period > AdaptationSet.
+  const int kDepth = 2;
+
+  auto adaptation_set = GenerateXml(/* format_representations= */ true);
+  if (!adaptation_set || !adaptation_set->SetId(id))
+    return nullptr;
+  formatted_xml_ = adaptation_set->ToFormattedXml(kDepth, formatted_xml_);
+  return formatted_xml_;
+}
+
+std::optional<xml::XmlNode> AdaptationSet::GenerateXml(
+    bool format_representations) {
   xml::AdaptationSetXmlNode adaptation_set;
 
   bool suppress_representation_width = false;
@@ -486,9 +503,15 @@ std::optional<xml::XmlNode> AdaptationSet::GetXml() {
       representation->SuppressOnce(Representation::kSuppressHeight);
     if (suppress_representation_frame_rate)
       representation->SuppressOnce(Representation::kSuppressFrameRate);
-    auto child = representation->GetXml();
-    if (!child || !adaptation_set.AddChild(std::move(*child)))
-      return std::nullopt;
+    if (format_representations) {
+      auto child = representation->GetFormattedXml();
+      if (!child || !adaptation_set.AddFormattedChild(std::move(child)))
+        return std::nullopt;
+    } else {
+      auto child = representation->GetXml();
+      if (!child || !adaptation_set.AddChild(std::move(*child)))
+        return std::nullopt;
+    }
   }
 
   return adaptation_set;
@@ -294,6 +294,15 @@ class AdaptationSet {
   // 2 -> [0, 200, 400]
   typedef std::map<uint32_t, std::list<int64_t>> RepresentationTimeline;
 
+  // Returns <AdaptationSet> with @id set to |id|, formatted for an MPD, or
+  // nullptr on failure. The Representations are only generated again if they
+  // changed, and the AdaptationSet is only formatted again if it changed.
+  std::shared_ptr<const xml::FormattedXml> GetFormattedXml(uint32_t id);
+
+  // Implements GetXml(). The Representations are added formatted if
+  // |format_representations| is true.
+  std::optional<xml::XmlNode> GenerateXml(bool format_representations);
+
   // Update AdaptationSet attributes for new MediaInfo.
   void UpdateFromMediaInfo(const MediaInfo& media_info);
 
@@ -412,6 +421,9 @@ class AdaptationSet {
 
   // ProtectedContent of this AdaptationSet.
   MediaInfo::ProtectedContent* protected_content_;
+
+  // The result of the last GetFormattedXml().
+  std::shared_ptr<const xml::FormattedXml> formatted_xml_;
 };
 
 }  // namespace shaka
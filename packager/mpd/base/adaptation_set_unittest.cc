@@ -9,6 +9,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <absl/strings/str_format.h>
+
 #include <packager/mpd/base/content_protection_element.h>
 #include <packager/mpd/base/mpd_options.h>
 #include <packager/mpd/base/representation.h>
@@ -32,6 +34,12 @@ class AdaptationSetTest : public ::testing::Test {
         new AdaptationSet(lang, mpd_options_, &representation_counter_));
   }
 
+  std::shared_ptr<const xml::FormattedXml> GetFormattedXml(
+      AdaptationSet* adaptation_set,
+      uint32_t id) {
+    return adaptation_set->GetFormattedXml(id);
+  }
+
  protected:
   MpdOptions mpd_options_;
   uint32_t representation_counter_ = 0;
@@ -966,6 +974,59 @@ TEST_F(AdaptationSetTest, SetSampleDuration) {
   EXPECT_THAT(adaptation_set_xml, AttributeEqual("frameRate", "3000/2"));
 }
 
+// Verify that only the Representations which changed are formatted again.
+TEST_F(LiveAdaptationSetTest, FormattedXmlIsReusedIfUnchanged) {
+  const char kMediaInfo[] =
+      "video_info {\n"
+      "  codec: 'avc1'\n"
+      "  width: %d\n"
+      "  height: %d\n"
+      "  time_scale: 10\n"
+      "  frame_duration: 10\n"
+      "  pixel_width: 1\n"
+      "  pixel_height: 1\n"
+      "}\n"
+      "reference_time_scale: 1000\n"
+      "container_type: 1\n"
+      "segment_template_url: '$Time$.mp4'\n";
+  const uint32_t kAdaptationSetId = 3;
+
+  auto adaptation_set = CreateAdaptationSet(kNoLanguage);
+  Representation* representation_720 = adaptation_set->AddRepresentation(
+      ConvertToMediaInfo(absl::StrFormat(kMediaInfo, 1280, 720)));
+  Representation* representation_480 = adaptation_set->AddRepresentation(
+      ConvertToMediaInfo(absl::StrFormat(kMediaInfo, 854, 480)));
+  representation_720->AddNewSegment(0, 1000, 100, 1);
+  representation_480->AddNewSegment(0, 1000, 50, 1);
+
+  auto formatted = GetFormattedXml(adaptation_set.get(), kAdaptationSetId);
+  ASSERT_TRUE(formatted);
+  ASSERT_EQ(2u, formatted->children.size());
+  EXPECT_EQ(formatted, GetFormattedXml(adaptation_set.get(), kAdaptationSetId));
+
+  representation_720->AddNewSegment(1000, 1000, 100, 2);
+  auto updated = GetFormattedXml(adaptation_set.get(), kAdaptationSetId);
+  ASSERT_TRUE(updated);
+  ASSERT_EQ(2u, updated->children.size());
+  EXPECT_NE(formatted, updated);
+  EXPECT_NE(formatted->children[0], updated->children[0]);
+  EXPECT_EQ(formatted->children[1], updated->children[1]);
+
+  // The fragments produce the same document as formatting the whole tree.
+  auto adaptation_set_xml = adaptation_set->GetXml();
+  ASSERT_TRUE(adaptation_set_xml);
+  ASSERT_TRUE(adaptation_set_xml->SetId(kAdaptationSetId));
+  xml::XmlNode period("Period");
+  ASSERT_TRUE(period.AddFormattedChild(updated));
+  xml::XmlNode mpd("MPD");
+  ASSERT_TRUE(mpd.AddChild(std::move(period)));
+  xml::XmlNode expected_period("Period");
+  ASSERT_TRUE(expected_period.AddChild(std::move(*adaptation_set_xml)));
+  xml::XmlNode expected_mpd("MPD");
+  ASSERT_TRUE(expected_mpd.AddChild(std::move(expected_period)));
+  EXPECT_EQ(expected_mpd.ToString(""), mpd.ToString(""));
+}
+
 // Verify that AdaptationSet::AddContentProtection() and
 // UpdateContentProtectionPssh() works.
 TEST_F(AdaptationSetTest, AdaptationSetAddContentProtectionAndUpdate) {
@@ -26,6 +26,7 @@ class MockMpdBuilder : public MpdBuilder {
 
   MOCK_METHOD1(GetOrCreatePeriod, Period*(double start_time_in_seconds));
   MOCK_METHOD1(ToString, bool(std::string* output));
+  MOCK_METHOD0(GenerateMpd, std::optional<xml::XmlNode>());
 };
 
 class MockPeriod : public Period {
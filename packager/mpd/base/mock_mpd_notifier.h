@@ -44,6 +44,7 @@ class MockMpdNotifier : public MpdNotifier {
   MOCK_METHOD2(NotifyMediaInfoUpdate,
                bool(uint32_t container_id, const MediaInfo& media_info));
   MOCK_METHOD0(Flush, bool());
+  MOCK_METHOD0(ScheduleFlush, bool());
 };
 
 }  // namespace shaka
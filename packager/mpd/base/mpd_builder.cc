@@ -146,22 +146,28 @@ Period* MpdBuilder::GetOrCreatePeriod(double start_time_in_seconds) {
 
 bool MpdBuilder::ToString(std::string* output) {
   DCHECK(output);
-  static LibXmlInitializer lib_xml_initializer;
 
   auto mpd = GenerateMpd();
   if (!mpd)
     return false;
 
+  *output = FormatMpd(*mpd);
+  return true;
+}
+
+// static
+std::string MpdBuilder::FormatMpd(const XmlNode& mpd) {
   std::string version = GetPackagerVersion();
   if (!version.empty()) {
     version = absl::StrFormat("Generated with %s version %s",
                               GetPackagerProjectUrl().c_str(), version.c_str());
   }
-  *output = mpd->ToString(version);
-  return true;
+  return mpd.ToString(version);
 }
 
 std::optional<xml::XmlNode> MpdBuilder::GenerateMpd() {
+  static LibXmlInitializer lib_xml_initializer;
+
   XmlNode mpd("MPD");
 
   // Add baseurls to MPD.
@@ -182,8 +188,11 @@ std::optional<xml::XmlNode> MpdBuilder::GenerateMpd() {
     output_period_duration = periods_.size() > 1;
   }
 
+  // Only the elements which changed since the previous MPD are generated and
+  // formatted again.
   for (const auto& period : periods_) {
-    auto period_node = period->GetXml(output_period_duration);
+    auto period_node = period->GenerateXml(output_period_duration,
+                                           /* format_adaptation_sets= */ true);
     if (!period_node || !mpd.AddChild(std::move(*period_node)))
       return std::nullopt;
   }
@@ -59,6 +59,20 @@ class MpdBuilder {
   // TODO(kqyang): Handle file IO in this class as in HLS media_playlist?
   [[nodiscard]] virtual bool ToString(std::string* output);
 
+  /// Generates the XML tree of the MPD. This is the first half of ToString().
+  /// The tree does not refer to the MpdBuilder, so it can be formatted with
+  /// FormatMpd() without blocking updates to the MpdBuilder. Representations
+  /// and AdaptationSets which did not change since the previous MPD are
+  /// reused already formatted.
+  /// @return the MPD element on success, std::nullopt otherwise.
+  virtual std::optional<xml::XmlNode> GenerateMpd();
+
+  /// Formats an XML tree generated by GenerateMpd(). This is the second half
+  /// of ToString().
+  /// @param mpd is the MPD element.
+  /// @return the MPD.
+  static std::string FormatMpd(const xml::XmlNode& mpd);
+
   /// Adjusts the fields of MediaInfo so that paths are relative to the
   /// specified MPD path.
   /// @param mpd_path is the file path of the MPD file.
@@ -83,11 +97,6 @@ class MpdBuilder {
   template <DashProfile profile>
   friend class MpdBuilderTest;
 
-  // Returns the document pointer to the MPD. This must be freed by the caller
-  // using appropriate xmlDocPtr freeing function.
-  // On failure, this returns NULL.
-  std::optional<xml::XmlNode> GenerateMpd();
-
   // Set MPD attributes common to all profiles. Uses non-zero |mpd_options_| to
   // set attributes for the MPD.
   [[nodiscard]] bool AddCommonMpdInfo(xml::XmlNode* mpd_node);
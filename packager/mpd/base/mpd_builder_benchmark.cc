@@ -0,0 +1,87 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// Benchmark for rendering MPDs with long segment timelines.
+
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include <packager/mpd/base/adaptation_set.h>
+#include <packager/mpd/base/mpd_builder.h>
+#include <packager/mpd/base/period.h>
+#include <packager/mpd/base/representation.h>
+
+namespace shaka {
+namespace {
+
+const int32_t kTimeScale = 90000;
+const int64_t kSegmentDuration = 6 * kTimeScale;
+const uint64_t kSegmentSize = 1500000;
+
+MediaInfo GetVideoMediaInfo() {
+  MediaInfo media_info;
+  media_info.set_reference_time_scale(kTimeScale);
+  media_info.set_container_type(MediaInfo::CONTAINER_MP4);
+  media_info.set_init_segment_url("video-init.mp4");
+  media_info.set_segment_template_url("video-$Time$.m4s");
+  MediaInfo::VideoInfo* video_info = media_info.mutable_video_info();
+  video_info->set_codec("avc1.64001f");
+  video_info->set_time_scale(kTimeScale);
+  video_info->set_frame_duration(3000);
+  video_info->set_width(1280);
+  video_info->set_height(720);
+  video_info->set_pixel_width(1);
+  video_info->set_pixel_height(1);
+  return media_info;
+}
+
+// The argument is the number of segments.
+void BM_RenderMpd(benchmark::State& state) {
+  MpdOptions mpd_options;
+  mpd_options.dash_profile = DashProfile::kLive;
+  MpdBuilder mpd_builder(mpd_options);
+
+  const MediaInfo media_info = GetVideoMediaInfo();
+  const bool kContentProtectionInAdaptationSet = true;
+  AdaptationSet* adaptation_set =
+      mpd_builder.GetOrCreatePeriod(0)->GetOrCreateAdaptationSet(
+          media_info, kContentProtectionInAdaptationSet);
+  Representation* representation =
+      adaptation_set->AddRepresentation(media_info);
+  if (!representation) {
+    state.SkipWithError("Failed to add the representation.");
+    return;
+  }
+  int64_t start_time = 0;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    // Alternate the durations slightly, as encoders do, so that the segments
+    // are not collapsed in the timeline.
+    const int64_t duration = kSegmentDuration + (i % 2 ? 3000 : -3000);
+    representation->AddNewSegment(start_time, duration, kSegmentSize + i % 1000,
+                                  i + 1);
+    start_time += duration;
+  }
+
+  size_t mpd_size = 0;
+  for (auto _ : state) {
+    std::string mpd;
+    if (!mpd_builder.ToString(&mpd)) {
+      state.SkipWithError("Failed to generate the MPD.");
+      return;
+    }
+    mpd_size = mpd.size();
+    benchmark::DoNotOptimize(mpd.data());
+  }
+  state.SetBytesProcessed(state.iterations() * mpd_size);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// About 1.5 hours, 17 hours and a week of content.
+BENCHMARK(BM_RenderMpd)->Arg(1000)->Arg(10000)->Arg(100000);
+
+}  // namespace
+}  // namespace shaka
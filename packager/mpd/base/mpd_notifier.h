@@ -148,6 +148,10 @@ class MpdNotifier {
   /// forces a flush.
   virtual bool Flush() = 0;
 
+  /// Call this method to request a flush after an update. Unlike Flush(),
+  /// implementations may delay the write and combine it with later updates.
+  virtual bool ScheduleFlush() { return Flush(); }
+
   /// @return include_mspr_pro option flag
   bool include_mspr_pro() const { return mpd_options_.mpd_params.include_mspr_pro; }
 
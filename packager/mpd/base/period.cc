@@ -116,6 +116,12 @@ AdaptationSet* Period::GetOrCreateAdaptationSet(
 }
 
 std::optional<xml::XmlNode> Period::GetXml(bool output_period_duration) {
+  return GenerateXml(output_period_duration,
+                     /* format_adaptation_sets= */ false);
+}
+
+std::optional<xml::XmlNode> Period::GenerateXml(bool output_period_duration,
+                                                bool format_adaptation_sets) {
   adaptation_sets_.sort(
       [](const std::unique_ptr<AdaptationSet>& adaptation_set_a,
          const std::unique_ptr<AdaptationSet>& adaptation_set_b) {
@@ -161,9 +167,17 @@ std::optional<xml::XmlNode> Period::GetXml(bool output_period_duration) {
   // be the case if force_cl_index is used.
   int idx = 0;
   for (const auto& adaptation_set : adaptation_sets_) {
-    auto child = adaptation_set->GetXml();
-    if (!child || !child->SetId(idx++) || !period.AddChild(std::move(*child)))
-      return std::nullopt;
+    if (format_adaptation_sets) {
+      auto child = adaptation_set->GetFormattedXml(idx++);
+      if (!child || !period.AddFormattedChild(std::move(child)))
+        return std::nullopt;
+    } else {
+      auto child = adaptation_set->GetXml();
+      if (!child || !child->SetId(idx++) ||
+          !period.AddChild(std::move(*child))) {
+        return std::nullopt;
+      }
+    }
   }
 
   if (output_period_duration) {
@@ -86,6 +86,11 @@ class Period {
   friend class MpdBuilder;
   friend class PeriodTest;
 
+  // Implements GetXml(). The AdaptationSets are added formatted, see
+  // AdaptationSet::GetFormattedXml(), if |format_adaptation_sets| is true.
+  std::optional<xml::XmlNode> GenerateXml(bool output_period_duration,
+                                          bool format_adaptation_sets);
+
   // Calls AdaptationSet constructor. For mock injection.
   virtual std::unique_ptr<AdaptationSet> NewAdaptationSet(
       const std::string& lang,
@@ -160,12 +160,14 @@ void Representation::AddContentProtectionElement(
     const ContentProtectionElement& content_protection_element) {
   content_protection_elements_.push_back(content_protection_element);
   RemoveDuplicateAttributes(&content_protection_elements_.back());
+  formatted_xml_.reset();
 }
 
 void Representation::UpdateContentProtectionPssh(const std::string& drm_uuid,
                                                  const std::string& pssh) {
   UpdateContentProtectionPsshHelper(drm_uuid, pssh,
                                     &content_protection_elements_);
+  formatted_xml_.reset();
 }
 
 void Representation::AddNewSegment(int64_t start_time,
@@ -176,6 +178,7 @@ void Representation::AddNewSegment(int64_t start_time,
     LOG(WARNING) << "Got segment with start_time and duration == 0. Ignoring.";
     return;
   }
+  formatted_xml_.reset();
 
   // In order for the oldest segment to be accessible for at least
   // |time_shift_buffer_depth| seconds, the latest segment should not be in the
@@ -210,6 +213,7 @@ void Representation::UpdateCompletedSegment(int64_t duration, uint64_t size) {
   }
 
   UpdateSegmentInfo(duration);
+  formatted_xml_.reset();
 
   current_buffer_depth_ += segment_infos_.back().duration;
 
@@ -218,6 +222,7 @@ void Representation::UpdateCompletedSegment(int64_t duration, uint64_t size) {
 }
 
 void Representation::SetSampleDuration(int32_t frame_duration) {
+  formatted_xml_.reset();
   // Sample duration is used to generate approximate SegmentTimeline.
   // Text is required to have exactly the same segment duration.
   if (media_info_.has_audio_info() || media_info_.has_video_info())
@@ -238,6 +243,7 @@ void Representation::SetSegmentDuration() {
   if (sd <= 0)
     return;
   media_info_.set_segment_duration(sd);
+  formatted_xml_.reset();
 }
 
 const MediaInfo& Representation::GetMediaInfo() const {
@@ -328,6 +334,23 @@ std::optional<xml::XmlNode> Representation::GetXml() {
   return representation;
 }
 
+std::shared_ptr<const xml::FormattedXml> Representation::GetFormattedXml() {
+  // MPD > Period > AdaptationSet > Representation.
+  const int kDepth = 3;
+
+  if (!formatted_xml_ ||
+      output_suppression_flags_ != formatted_xml_suppression_flags_) {
+    const int suppression_flags = output_suppression_flags_;
+    auto representation = GetXml();
+    if (!representation)
+      return nullptr;
+    formatted_xml_ = representation->ToFormattedXml(kDepth, nullptr);
+    formatted_xml_suppression_flags_ = suppression_flags;
+  }
+  output_suppression_flags_ = 0;
+  return formatted_xml_;
+}
+
 void Representation::SuppressOnce(SuppressFlag flag) {
   output_suppression_flags_ |= flag;
 }
@@ -335,9 +358,12 @@ void Representation::SuppressOnce(SuppressFlag flag) {
 void Representation::SetPresentationTimeOffset(
     double presentation_time_offset) {
   int64_t pto = presentation_time_offset * media_info_.reference_time_scale();
-  if (pto <= 0)
+  if (pto <= 0 ||
+      static_cast<uint64_t>(pto) == media_info_.presentation_time_offset()) {
     return;
+  }
   media_info_.set_presentation_time_offset(pto);
+  formatted_xml_.reset();
 }
 
 void Representation::SetAvailabilityTimeOffset() {
@@ -355,6 +381,7 @@ void Representation::SetAvailabilityTimeOffset() {
   if (ato <= 0)
     return;
   media_info_.set_availability_time_offset(ato);
+  formatted_xml_.reset();
 }
 
 bool Representation::GetStartAndEndTimestamps(
@@ -163,7 +163,10 @@ class Representation {
   /// @return ID number for <Representation>.
   uint32_t id() const { return id_; }
 
-  void set_media_info(const MediaInfo& media_info) { media_info_ = media_info; }
+  void set_media_info(const MediaInfo& media_info) {
+    media_info_ = media_info;
+    formatted_xml_.reset();
+  }
 
  protected:
   /// @param media_info is a MediaInfo containing information on the media.
@@ -194,6 +197,10 @@ class Representation {
   friend class AdaptationSet;
   friend class RepresentationTest;
 
+  // Returns <Representation> formatted for an MPD, or nullptr on failure. It
+  // is only generated again after the Representation changed.
+  std::shared_ptr<const xml::FormattedXml> GetFormattedXml();
+
   // Returns true if |media_info_| has required fields to generate a valid
   // Representation. Otherwise returns false.
   bool HasRequiredMediaInfoFields() const;
@@ -261,6 +268,11 @@ class Representation {
   // Bit vector for tracking witch attributes should not be output.
   int output_suppression_flags_ = 0;
 
+  // The result of GetFormattedXml(), and the |output_suppression_flags_| it
+  // was generated with. Reset when the Representation changes.
+  std::shared_ptr<const xml::FormattedXml> formatted_xml_;
+  int formatted_xml_suppression_flags_ = 0;
+
   // When set to true, allows segments to have slightly different durations (up
   // to one sample).
   const bool allow_approximate_segment_timeline_ = false;
@@ -76,6 +76,11 @@ class RepresentationTest : public ::testing::Test {
     return std::unique_ptr<RepresentationStateChangeListener>();
   }
 
+  std::shared_ptr<const xml::FormattedXml> GetFormattedXml(
+      Representation* representation) {
+    return representation->GetFormattedXml();
+  }
+
  protected:
   MpdOptions mpd_options_;
 };
@@ -625,6 +630,35 @@ TEST_F(SegmentTemplateTest, PresentationTimeOffset) {
   EXPECT_THAT(representation_->GetXml(), XmlNodeEqual(kExpectedXml));
 }
 
+// Verify that the formatted Representation is only generated again after it
+// changes.
+TEST_F(SegmentTemplateTest, FormattedXmlIsReusedIfUnchanged) {
+  const int64_t kStartTime = 0;
+  const int64_t kDuration = 10;
+  const uint64_t kSize = 128;
+  AddSegments(kStartTime, kDuration, kSize, 0);
+
+  auto formatted = GetFormattedXml(representation_.get());
+  ASSERT_TRUE(formatted);
+  EXPECT_EQ(representation_->GetXml()->ToFormattedXml(3, nullptr)->xml,
+            formatted->xml);
+  EXPECT_EQ(formatted, GetFormattedXml(representation_.get()));
+
+  AddSegments(kStartTime + kDuration, kDuration, kSize, 0);
+  auto updated = GetFormattedXml(representation_.get());
+  ASSERT_TRUE(updated);
+  EXPECT_NE(formatted, updated);
+  EXPECT_EQ(representation_->GetXml()->ToFormattedXml(3, nullptr)->xml,
+            updated->xml);
+
+  // Suppressed attributes only apply to the next output.
+  representation_->SuppressOnce(Representation::kSuppressWidth);
+  auto suppressed = GetFormattedXml(representation_.get());
+  EXPECT_EQ(std::string::npos, suppressed->xml.find(" width="));
+  auto unsuppressed = GetFormattedXml(representation_.get());
+  EXPECT_NE(std::string::npos, unsuppressed->xml.find(" width="));
+}
+
 TEST_F(SegmentTemplateTest, GetStartAndEndTimestamps) {
   double start_timestamp;
   double end_timestamp;
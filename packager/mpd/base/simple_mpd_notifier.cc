@@ -6,9 +6,12 @@
 
 #include <packager/mpd/base/simple_mpd_notifier.h>
 
+#include <optional>
+
 #include <absl/log/check.h>
 #include <absl/log/log.h>
 
+#include <packager/file.h>
 #include <packager/mpd/base/adaptation_set.h>
 #include <packager/mpd/base/mpd_builder.h>
 #include <packager/mpd/base/mpd_notifier_util.h>
@@ -23,12 +26,31 @@ SimpleMpdNotifier::SimpleMpdNotifier(const MpdOptions& mpd_options)
       output_path_(mpd_options.mpd_params.mpd_output),
       mpd_builder_(new MpdBuilder(mpd_options)),
       content_protection_in_adaptation_set_(
-          mpd_options.mpd_params.generate_dash_if_iop_compliant_mpd) {
+          mpd_options.mpd_params.generate_dash_if_iop_compliant_mpd),
+      // The MPD may change at most once per minimumUpdatePeriod, so it is
+      // not written more often than that.
+      minimum_write_interval_(
+          mpd_options.mpd_params.minimum_update_period > 0
+              ? absl::Seconds(mpd_options.mpd_params.minimum_update_period)
+              : absl::ZeroDuration()) {
   for (const std::string& base_url : mpd_options.mpd_params.base_urls)
     mpd_builder_->AddBaseUrl(base_url);
+
+  if (mpd_options.mpd_type == MpdType::kDynamic) {
+    writer_thread_ =
+        std::thread(&SimpleMpdNotifier::WriteMpdInBackground, this);
+  }
 }
 
-SimpleMpdNotifier::~SimpleMpdNotifier() {}
+SimpleMpdNotifier::~SimpleMpdNotifier() {
+  if (writer_thread_.joinable()) {
+    {
+      absl::MutexLock lock(&lock_);
+      stop_writer_ = true;
+    }
+    writer_thread_.join();
+  }
+}
 
 bool SimpleMpdNotifier::Init() {
   return true;
@@ -220,7 +242,72 @@ bool SimpleMpdNotifier::NotifyMediaInfoUpdate(uint32_t container_id,
 
 bool SimpleMpdNotifier::Flush() {
   absl::MutexLock lock(&lock_);
+  // The MPD is written below. Wait for an ongoing background write to
+  // complete so it does not overwrite the MPD with older content.
+  mpd_to_write_ = false;
+  lock_.Await(absl::Condition(this, &SimpleMpdNotifier::IsWriterIdle));
+  next_write_time_ = absl::Now() + minimum_write_interval_;
   return WriteMpdToFile(output_path_, mpd_builder_.get());
 }
 
+bool SimpleMpdNotifier::ScheduleFlush() {
+  if (!writer_thread_.joinable())
+    return Flush();
+
+  absl::MutexLock lock(&lock_);
+  mpd_to_write_ = true;
+  return !mpd_write_failed_;
+}
+
+void SimpleMpdNotifier::WriteMpdInBackground() {
+  while (true) {
+    std::optional<xml::XmlNode> mpd;
+    {
+      absl::MutexLock lock(
+          &lock_, absl::Condition(this, &SimpleMpdNotifier::HasPendingWrite));
+      // Updates made before the next write is due are combined into it. A
+      // pending write is not delayed once the notifier is being destroyed.
+      while (!stop_writer_ && absl::Now() < next_write_time_) {
+        lock_.AwaitWithDeadline(absl::Condition(&stop_writer_),
+                                next_write_time_);
+      }
+      if (!mpd_to_write_) {
+        if (stop_writer_)
+          return;
+        continue;  // Written by Flush() in the meantime.
+      }
+
+      // Generating the MPD reads the MpdBuilder, so it is done under the lock.
+      // Only the Representations which changed are generated again.
+      mpd_to_write_ = false;
+      mpd = mpd_builder_->GenerateMpd();
+      next_write_time_ = absl::Now() + minimum_write_interval_;
+      writing_mpd_ = true;
+    }
+
+    bool success = false;
+    if (!mpd) {
+      LOG(ERROR) << "Failed to write MPD to string.";
+    } else if (!File::WriteFileAtomically(output_path_.c_str(),
+                                          MpdBuilder::FormatMpd(*mpd))) {
+      LOG(ERROR) << "Failed to write mpd to: " << output_path_;
+    } else {
+      success = true;
+    }
+
+    absl::MutexLock lock(&lock_);
+    writing_mpd_ = false;
+    if (!success)
+      mpd_write_failed_ = true;
+  }
+}
+
+bool SimpleMpdNotifier::HasPendingWrite() const {
+  return mpd_to_write_ || stop_writer_;
+}
+
+bool SimpleMpdNotifier::IsWriterIdle() const {
+  return !writing_mpd_;
+}
+
 }  // namespace shaka
@@ -10,9 +10,12 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include <absl/base/thread_annotations.h>
 #include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
 
 #include <packager/mpd/base/mpd_notifier.h>
 #include <packager/mpd/base/mpd_notifier_util.h>
@@ -27,12 +30,15 @@ struct MpdOptions;
 
 /// A simple MpdNotifier implementation which receives muxer listener event and
 /// generates an Mpd file.
+/// For dynamic MPDs, scheduled flushes are written by a background thread, at
+/// most once per minimumUpdatePeriod.
 class SimpleMpdNotifier : public MpdNotifier {
  public:
   explicit SimpleMpdNotifier(const MpdOptions& mpd_options);
   ~SimpleMpdNotifier() override;
 
-  /// None of the methods write out the MPD file until Flush() is called.
+  /// None of the methods write out the MPD file until Flush() or
+  /// ScheduleFlush() is called.
   /// @name MpdNotifier implemetation overrides.
   /// @{
   bool Init() override;
@@ -57,6 +63,7 @@ class SimpleMpdNotifier : public MpdNotifier {
   bool NotifyMediaInfoUpdate(uint32_t container_id,
                              const MediaInfo& media_info) override;
   bool Flush() override;
+  bool ScheduleFlush() override;
   /// @}
 
  private:
@@ -73,6 +80,12 @@ class SimpleMpdNotifier : public MpdNotifier {
     mpd_builder_ = std::move(mpd_builder);
   }
 
+  // Runs on |writer_thread_|. Generates the MPD when a flush is scheduled and
+  // writes it without holding |lock_|, until the notifier is destroyed.
+  void WriteMpdInBackground();
+  bool HasPendingWrite() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  bool IsWriterIdle() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // MPD output path.
   std::string output_path_;
   std::unique_ptr<MpdBuilder> mpd_builder_;
@@ -84,6 +97,15 @@ class SimpleMpdNotifier : public MpdNotifier {
   std::map<uint32_t, Representation*> representation_map_;
   // Maps Representation ID to AdaptationSet. This is for updating the PSSH.
   std::map<uint32_t, AdaptationSet*> representation_id_to_adaptation_set_;
+
+  // Minimum time between two writes by |writer_thread_|.
+  absl::Duration minimum_write_interval_;
+  bool mpd_to_write_ ABSL_GUARDED_BY(lock_) = false;
+  bool writing_mpd_ ABSL_GUARDED_BY(lock_) = false;
+  bool mpd_write_failed_ ABSL_GUARDED_BY(lock_) = false;
+  bool stop_writer_ ABSL_GUARDED_BY(lock_) = false;
+  absl::Time next_write_time_ ABSL_GUARDED_BY(lock_) = absl::InfinitePast();
+  std::thread writer_thread_;
 };
 
 }  // namespace shaka
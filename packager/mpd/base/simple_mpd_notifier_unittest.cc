@@ -8,10 +8,13 @@
 
 #include <filesystem>
 
+#include <absl/time/clock.h>
+
 #include <gmock/gmock.h>
 #include <google/protobuf/util/message_differencer.h>
 #include <gtest/gtest.h>
 
+#include <packager/file.h>
 #include <packager/file/file_test_util.h>
 #include <packager/mpd/base/mock_mpd_builder.h>
 #include <packager/mpd/base/mpd_builder.h>
@@ -21,6 +24,7 @@
 namespace shaka {
 
 using ::testing::_;
+using ::testing::ByMove;
 using ::testing::Eq;
 using ::testing::Ref;
 using ::testing::Return;
@@ -76,6 +80,24 @@ class SimpleMpdNotifierTest : public ::testing::Test {
     notifier->SetMpdBuilderForTesting(std::move(mpd_builder));
   }
 
+  std::string ReadMpd() {
+    std::string mpd;
+    EXPECT_TRUE(File::ReadFileToString(temp_file_.path().c_str(), &mpd));
+    return mpd;
+  }
+
+  // Returns the content of the MPD file once it contains |text|, or the last
+  // content read if it does not after a few seconds.
+  std::string WaitForMpdContaining(const std::string& text) {
+    const absl::Time deadline = absl::Now() + absl::Seconds(10);
+    std::string mpd = ReadMpd();
+    while (mpd.find(text) == std::string::npos && absl::Now() < deadline) {
+      absl::SleepFor(absl::Milliseconds(10));
+      mpd = ReadMpd();
+    }
+    return mpd;
+  }
+
  protected:
   // Empty mpd options except with output path specified, so that
   // WriteMpdToFile() doesn't crash.
@@ -214,6 +236,72 @@ TEST_F(SimpleMpdNotifierTest, NotifyNewContainerAndSampleDurationNoMock) {
   EXPECT_TRUE(notifier.Flush());
 }
 
+// Verify that flushes scheduled for a dynamic MPD are combined until
+// minimumUpdatePeriod has passed since the previous write.
+TEST_F(SimpleMpdNotifierTest, ScheduleFlushCombinesDynamicMpdWrites) {
+  MpdOptions dynamic_mpd_option = empty_mpd_option_;
+  dynamic_mpd_option.mpd_type = MpdType::kDynamic;
+  dynamic_mpd_option.mpd_params.minimum_update_period = 3600;
+  SimpleMpdNotifier notifier(dynamic_mpd_option);
+
+  std::unique_ptr<MockMpdBuilder> mock_mpd_builder(new MockMpdBuilder());
+  EXPECT_CALL(*mock_mpd_builder, ToString(_)).WillOnce(Return(true));
+  // The scheduled flushes are all written when the notifier is destroyed.
+  EXPECT_CALL(*mock_mpd_builder, GenerateMpd())
+      .WillOnce(Return(ByMove(std::optional<xml::XmlNode>(
+          xml::XmlNode("MPD")))));
+  SetMpdBuilder(&notifier, std::move(mock_mpd_builder));
+
+  EXPECT_TRUE(notifier.Flush());
+  EXPECT_TRUE(notifier.ScheduleFlush());
+  EXPECT_TRUE(notifier.ScheduleFlush());
+  EXPECT_TRUE(notifier.ScheduleFlush());
+}
+
+// Verify that the MPD written in the background for a scheduled flush is
+// complete, and that the updates scheduled before minimumUpdatePeriod has
+// passed are not written until then.
+TEST_F(SimpleMpdNotifierTest, ScheduleFlushWritesDynamicMpd) {
+  MpdOptions dynamic_mpd_option = empty_mpd_option_;
+  dynamic_mpd_option.mpd_type = MpdType::kDynamic;
+  dynamic_mpd_option.mpd_params.minimum_update_period = 3600;
+  auto notifier = std::make_unique<SimpleMpdNotifier>(dynamic_mpd_option);
+
+  MediaInfo media_info = valid_media_info1_;
+  media_info.set_init_segment_url("init.mp4");
+  media_info.set_segment_template_url("$Number$.m4s");
+  uint32_t container_id;
+  ASSERT_TRUE(notifier->NotifyNewContainer(media_info, &container_id));
+
+  const int64_t kSegmentDuration = 20;
+  const uint64_t kSegmentSize = 1000;
+  const char kFirstSegment[] = "<S t=\"0\" d=\"20\"/>";
+  const char kTwoSegments[] = "<S t=\"0\" d=\"20\" r=\"1\"/>";
+
+  // The first scheduled flush is written right away.
+  EXPECT_TRUE(notifier->NotifyNewSegment(container_id, 0, kSegmentDuration,
+                                         kSegmentSize, 1));
+  EXPECT_TRUE(notifier->ScheduleFlush());
+  std::string mpd = WaitForMpdContaining(kFirstSegment);
+  EXPECT_NE(std::string::npos, mpd.find(kFirstSegment)) << mpd;
+  EXPECT_NE(std::string::npos, mpd.find("type=\"dynamic\"")) << mpd;
+  EXPECT_TRUE(ValidateMpdSchema(mpd)) << mpd;
+
+  // The next one waits for minimumUpdatePeriod.
+  EXPECT_TRUE(notifier->NotifyNewSegment(container_id, kSegmentDuration,
+                                         kSegmentDuration, kSegmentSize, 2));
+  EXPECT_TRUE(notifier->ScheduleFlush());
+  absl::SleepFor(absl::Milliseconds(200));
+  mpd = ReadMpd();
+  EXPECT_NE(std::string::npos, mpd.find(kFirstSegment)) << mpd;
+
+  // It is written when the notifier is destroyed.
+  notifier.reset();
+  mpd = ReadMpd();
+  EXPECT_NE(std::string::npos, mpd.find(kTwoSegments)) << mpd;
+  EXPECT_TRUE(ValidateMpdSchema(mpd)) << mpd;
+}
+
 TEST_F(SimpleMpdNotifierTest, NotifyNewSegment) {
   SimpleMpdNotifier notifier(empty_mpd_option_);
 
@@ -32,6 +32,7 @@ struct XmlDeleter {
     xmlOutputBufferClose(ptr);
   }
   inline void operator()(xmlSchemaPtr ptr) const { xmlSchemaFree(ptr); }
+  inline void operator()(xmlBufferPtr ptr) const { xmlBufferFree(ptr); }
   inline void operator()(xmlNodePtr ptr) const { xmlFreeNode(ptr); }
   inline void operator()(xmlDocPtr ptr) const { xmlFreeDoc(ptr); }
   inline void operator()(xmlChar* ptr) const { xmlFree(ptr); }
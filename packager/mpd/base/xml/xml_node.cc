@@ -54,6 +54,12 @@ const char kDTSCCodec[] = "dtsc";
 const char kDTSECodec[] = "dtse";
 const char kDTSXCodec[] = "dtsx";
 
+// Formats XML with indentation.
+const int kNiceFormat = 1;
+
+// The element which stands for a formatted child in the tree of its parent.
+const char kFormattedChildElement[] = "shaka-formatted-child";
+
 std::string urlEncode(const std::string& input) {
   // NOTE: According to the docs, "Since 7.82.0, the curl parameter is ignored".
   CURL* curl = NULL;
@@ -139,6 +145,31 @@ void TraverseNodesAndCollectNamespaces(const xmlNode* node,
   }
 }
 
+// Replaces the placeholders in |layout| with |children|, in order.
+std::string InsertFormattedChildren(
+    const std::string& layout,
+    const std::vector<std::shared_ptr<const xml::FormattedXml>>& children) {
+  size_t output_size = layout.size();
+  for (const auto& child : children)
+    output_size += child->xml.size();
+  std::string output;
+  output.reserve(output_size);
+
+  // The placeholder cannot be confused with text, where '<' is escaped.
+  const std::string placeholder =
+      absl::StrFormat("<%s/>", kFormattedChildElement);
+  size_t pos = 0;
+  for (const auto& child : children) {
+    const size_t placeholder_pos = layout.find(placeholder, pos);
+    CHECK_NE(placeholder_pos, std::string::npos);
+    output.append(layout, pos, placeholder_pos - pos);
+    output.append(child->xml);
+    pos = placeholder_pos + placeholder.size();
+  }
+  output.append(layout, pos, std::string::npos);
+  return output;
+}
+
 }  // namespace
 
 namespace xml {
@@ -146,6 +177,9 @@ namespace xml {
 class XmlNode::Impl {
  public:
   scoped_xml_ptr<xmlNode> node;
+  // The formatted children of the element and its descendants, in document
+  // order as children are only ever appended.
+  std::vector<std::shared_ptr<const FormattedXml>> formatted_children;
 };
 
 XmlNode::XmlNode(const std::string& name) : impl_(new Impl) {
@@ -167,6 +201,16 @@ bool XmlNode::AddChild(XmlNode child) {
   // Reaching here means the ownership of |child| transfered to |node|.
   // Release the pointer so that it doesn't get destructed in this scope.
   UNUSED(child.impl_->node.release());
+
+  for (auto& formatted_child : child.impl_->formatted_children)
+    impl_->formatted_children.push_back(std::move(formatted_child));
+  return true;
+}
+
+bool XmlNode::AddFormattedChild(std::shared_ptr<const FormattedXml> child) {
+  DCHECK(child);
+  RCHECK(AddChild(XmlNode(kFormattedChildElement)));
+  impl_->formatted_children.push_back(std::move(child));
   return true;
 }
 
@@ -249,6 +293,10 @@ void XmlNode::SetUrlEncodedContent(const std::string& content) {
 std::set<std::string> XmlNode::ExtractReferencedNamespaces() const {
   std::set<std::string> namespaces;
   TraverseNodesAndCollectNamespaces(impl_->node.get(), &namespaces);
+  for (const auto& formatted_child : impl_->formatted_children) {
+    namespaces.insert(formatted_child->namespaces.begin(),
+                      formatted_child->namespaces.end());
+  }
   return namespaces;
 }
 
@@ -266,14 +314,47 @@ std::string XmlNode::ToString(const std::string& comment) const {
   }
 
   // Format the xmlDoc to string.
-  static const int kNiceFormat = 1;
   int doc_str_size = 0;
   xmlChar* doc_str = nullptr;
   xmlDocDumpFormatMemoryEnc(doc.get(), &doc_str, &doc_str_size, "UTF-8",
                             kNiceFormat);
   std::string output(doc_str, doc_str + doc_str_size);
   xmlFree(doc_str);
-  return output;
+  return InsertFormattedChildren(output, impl_->formatted_children);
+}
+
+std::shared_ptr<const FormattedXml> XmlNode::ToFormattedXml(
+    int depth,
+    std::shared_ptr<const FormattedXml> previous) const {
+  // The element is formatted in a UTF-8 document, like in ToString(), so that
+  // it is escaped the same way.
+  xml::scoped_xml_ptr<xmlDoc> doc(xmlNewDoc(BAD_CAST "1.0"));
+  doc->encoding = xmlStrdup(BAD_CAST "UTF-8");
+  xmlDocSetRootElement(doc.get(),
+                       xmlDocCopyNode(impl_->node.get(), doc.get(), true));
+  xml::scoped_xml_ptr<xmlBuffer> buffer(xmlBufferCreate());
+  xmlNodeDump(buffer.get(), doc.get(), xmlDocGetRootElement(doc.get()), depth,
+              kNiceFormat);
+  const xmlChar* content = xmlBufferContent(buffer.get());
+  std::string layout(content, content + xmlBufferLength(buffer.get()));
+
+  const auto& children = impl_->formatted_children;
+  if (previous && previous->children == children &&
+      (children.empty() ? previous->xml == layout
+                        : previous->layout == layout)) {
+    return previous;
+  }
+
+  auto formatted = std::make_shared<FormattedXml>();
+  formatted->namespaces = ExtractReferencedNamespaces();
+  if (children.empty()) {
+    formatted->xml = std::move(layout);
+  } else {
+    formatted->xml = InsertFormattedChildren(layout, children);
+    formatted->children = children;
+    formatted->layout = std::move(layout);
+  }
+  return formatted;
 }
 
 bool XmlNode::GetAttribute(const std::string& name, std::string* value) const {
@@ -12,6 +12,7 @@
 
 #include <cstdint>
 #include <list>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -36,6 +37,21 @@ bool XmlEqual(const std::string& xml1, const xml::XmlNode& xml2);
 
 namespace xml {
 
+/// An element formatted by XmlNode::ToFormattedXml(). It can be added to other
+/// elements with XmlNode::AddFormattedChild(), so that elements which did not
+/// change are not generated and formatted again for every MPD.
+struct FormattedXml {
+  /// The formatted element.
+  std::string xml;
+  /// The namespaces used in the element and its descendants.
+  std::set<std::string> namespaces;
+  /// The formatted children added to the element and its descendants, and
+  /// the formatted element without them. They tell whether the element
+  /// changed. Both are empty if the element has no formatted children.
+  std::vector<std::shared_ptr<const FormattedXml>> children;
+  std::string layout;
+};
+
 /// These classes are wrapper classes for XML elements for generating MPD.
 /// None of the pointer parameters should be NULL. None of the methods are meant
 /// to be overridden.
@@ -54,6 +70,13 @@ class XmlNode {
   /// @return true on success, false otherwise.
   [[nodiscard]] bool AddChild(XmlNode child);
 
+  /// Add a child element which has already been formatted.
+  /// @param child is the child element, formatted with the depth it has in
+  ///        the document.
+  /// @return true on success, false otherwise.
+  [[nodiscard]] bool AddFormattedChild(
+      std::shared_ptr<const FormattedXml> child);
+
   /// Adds Elements to this node using the Element struct.
   [[nodiscard]] bool AddElements(const std::vector<Element>& elements);
 
@@ -102,6 +125,17 @@ class XmlNode {
   /// @return A string containing the XML.
   std::string ToString(const std::string& comment) const;
 
+  /// Formats the element, so that it can be added to other elements with
+  /// AddFormattedChild().
+  /// @param depth is the depth of the element in the document, which
+  ///        determines its indentation.
+  /// @param previous is the element formatted before, if any. It is returned
+  ///        if the element did not change.
+  /// @return the formatted element.
+  std::shared_ptr<const FormattedXml> ToFormattedXml(
+      int depth,
+      std::shared_ptr<const FormattedXml> previous) const;
+
   /// Gets the attribute with the given name.
   /// @param name The name of the attribute to get.
   /// @param value [OUT] where to put the resulting value.
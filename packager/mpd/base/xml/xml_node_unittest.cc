@@ -175,6 +175,76 @@ TEST(XmlNodeTest, ExtractReferencedNamespacesFromAttributes) {
               ElementsAre("child_attribute_ns", "root_attribute_ns"));
 }
 
+namespace {
+
+// Makes <parent><ns:child a="..."><grand_child/></ns:child><sibling/></parent>
+// where ns:child is optionally added as an element formatted for depth 2.
+XmlNode MakeTreeWithChild(bool formatted_child) {
+  XmlNode grand_child("grand_child");
+  grand_child.SetContent("\u00e9 & <text>");
+  XmlNode child("ns:child");
+  EXPECT_TRUE(child.SetStringAttribute("a", "\u00e9"));
+  EXPECT_TRUE(child.AddChild(std::move(grand_child)));
+
+  XmlNode parent("parent");
+  if (formatted_child) {
+    EXPECT_TRUE(parent.AddFormattedChild(child.ToFormattedXml(2, nullptr)));
+  } else {
+    EXPECT_TRUE(parent.AddChild(std::move(child)));
+  }
+  EXPECT_TRUE(parent.AddChild(XmlNode("sibling")));
+  return parent;
+}
+
+}  // namespace
+
+TEST(XmlNodeTest, FormattedChild) {
+  XmlNode root("root");
+  ASSERT_TRUE(root.AddChild(MakeTreeWithChild(false)));
+  XmlNode root_with_formatted_child("root");
+  ASSERT_TRUE(root_with_formatted_child.AddChild(MakeTreeWithChild(true)));
+
+  EXPECT_EQ(root.ToString("comment"),
+            root_with_formatted_child.ToString("comment"));
+  EXPECT_THAT(root_with_formatted_child.ExtractReferencedNamespaces(),
+              ElementsAre("ns"));
+}
+
+TEST(XmlNodeTest, FormattedElementIsReusedIfUnchanged) {
+  std::shared_ptr<const FormattedXml> formatted_child =
+      XmlNode("child").ToFormattedXml(2, nullptr);
+  auto make_parent = [](std::shared_ptr<const FormattedXml> child) {
+    XmlNode parent("parent");
+    EXPECT_TRUE(parent.AddFormattedChild(std::move(child)));
+    EXPECT_TRUE(parent.AddChild(XmlNode("sibling")));
+    return parent;
+  };
+  std::shared_ptr<const FormattedXml> formatted =
+      make_parent(formatted_child).ToFormattedXml(1, nullptr);
+  EXPECT_EQ(formatted,
+            make_parent(formatted_child).ToFormattedXml(1, formatted));
+
+  // The layout of the element is the same, but not its formatted child.
+  std::shared_ptr<const FormattedXml> new_formatted =
+      make_parent(XmlNode("ns:child").ToFormattedXml(2, nullptr))
+          .ToFormattedXml(1, formatted);
+  EXPECT_NE(formatted, new_formatted);
+  EXPECT_EQ(
+      "<parent>\n"
+      "    <ns:child/>\n"
+      "    <sibling/>\n"
+      "  </parent>",
+      new_formatted->xml);
+
+  // An element without formatted children is compared as a whole.
+  XmlNode leaf("leaf");
+  std::shared_ptr<const FormattedXml> formatted_leaf =
+      leaf.ToFormattedXml(0, nullptr);
+  EXPECT_EQ(formatted_leaf, leaf.ToFormattedXml(0, formatted_leaf));
+  ASSERT_TRUE(leaf.SetIntegerAttribute("a", 1));
+  EXPECT_NE(formatted_leaf, leaf.ToFormattedXml(0, formatted_leaf));
+}
+
 // Verify that AddContentProtectionElements work.
 // xmlReadMemory() (used in XmlEqual()) doesn't like XML fragments that have
 // namespaces without context, e.g. <cenc:pssh> element.
@@ -0,0 +1,381 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/origin/http_origin.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <absl/log/check.h>
+#include <absl/log/log.h>
+#include <absl/strings/match.h>
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_format.h>
+#include <absl/strings/str_split.h>
+#include <absl/strings/strip.h>
+#include <mongoose.h>
+
+namespace shaka {
+namespace {
+
+// Mongoose polls the sockets for at most this long. It is also the maximum
+// delay between data being written to the store and being sent.
+const int kPollIntervalMs = 10;
+// Data of a file is only queued for sending while the send buffer of the
+// connection is smaller than this.
+const size_t kMaxSendBufferSize = 256 * 1024;
+const size_t kReadSize = 16 * 1024;
+// A blocking playlist reload request for a segment further ahead than this
+// is rejected, as recommended by the HLS specification.
+const int64_t kMaxMediaSequenceNumberAhead = 2;
+
+const char kCorsHeader[] = "Access-Control-Allow-Origin: *\r\n";
+
+std::string_view MongooseStringView(const mg_str& mg_string) {
+  return std::string_view(mg_string.ptr, mg_string.len);
+}
+
+bool GetIntQueryParameter(struct mg_http_message* message,
+                          const char* name,
+                          int64_t* value) {
+  struct mg_str value_mg_str = mg_http_var(message->query, mg_str(name));
+  if (value_mg_str.ptr == NULL)
+    return false;
+  return absl::SimpleAtoi(MongooseStringView(value_mg_str), value);
+}
+
+bool IsManifest(std::string_view path) {
+  return absl::EndsWith(path, ".mpd") || absl::EndsWith(path, ".m3u8");
+}
+
+const char* GetContentType(std::string_view path) {
+  if (absl::EndsWith(path, ".mpd"))
+    return "application/dash+xml";
+  if (absl::EndsWith(path, ".m3u8"))
+    return "application/vnd.apple.mpegurl";
+  if (absl::EndsWith(path, ".m4s") || absl::EndsWith(path, ".mp4"))
+    return "video/mp4";
+  if (absl::EndsWith(path, ".m4a"))
+    return "audio/mp4";
+  if (absl::EndsWith(path, ".ts"))
+    return "video/mp2t";
+  if (absl::EndsWith(path, ".aac"))
+    return "audio/aac";
+  if (absl::EndsWith(path, ".vtt"))
+    return "text/vtt";
+  return "application/octet-stream";
+}
+
+// Parses a single range "bytes=<first>-[<last>]". |end| is exclusive, and is
+// UINT64_MAX if open.
+bool ParseRange(std::string_view range, uint64_t* start, uint64_t* end) {
+  if (!absl::ConsumePrefix(&range, "bytes="))
+    return false;
+  std::vector<std::string_view> positions = absl::StrSplit(range, '-');
+  if (positions.size() != 2 || !absl::SimpleAtoi(positions[0], start))
+    return false;
+  if (positions[1].empty()) {
+    *end = UINT64_MAX;
+    return true;
+  }
+  uint64_t last = 0;
+  if (!absl::SimpleAtoi(positions[1], &last) || last < *start)
+    return false;
+  *end = last + 1;
+  return true;
+}
+
+void SendHeaders(struct mg_connection* connection,
+                 int status_code,
+                 const std::string& headers) {
+  const char* reason = "OK";
+  if (status_code == 206)
+    reason = "Partial Content";
+  mg_printf(connection, "HTTP/1.1 %d %s\r\n%s\r\n", status_code, reason,
+            headers.c_str());
+}
+
+}  // namespace
+
+HttpOrigin::HttpOrigin(const OriginParams& params)
+    : params_(params), store_(SegmentStore::GetInstance()) {}
+
+HttpOrigin::~HttpOrigin() {
+  Stop();
+}
+
+Status HttpOrigin::Start() {
+  DCHECK(!thread_);
+  thread_.reset(new std::thread(&HttpOrigin::ThreadCallback, this));
+
+  bool failed = false;
+  {
+    absl::MutexLock lock(&mutex_);
+    while (state_ == State::kNew)
+      state_changed_.Wait(&mutex_);
+    failed = state_ == State::kFailed;
+  }
+  if (failed) {
+    thread_->join();
+    thread_.reset();
+    return Status(error::INVALID_ARGUMENT,
+                  "Cannot listen on " + params_.listen_address);
+  }
+  LOG(INFO) << "Serving origin:// files on " << params_.listen_address;
+  return Status::OK;
+}
+
+void HttpOrigin::Stop() {
+  if (!thread_)
+    return;
+  {
+    absl::MutexLock lock(&mutex_);
+    stop_ = true;
+  }
+  thread_->join();
+  thread_.reset();
+}
+
+// static
+HttpOrigin::PlaylistPosition HttpOrigin::GetPlaylistPosition(
+    std::string_view playlist) {
+  PlaylistPosition position;
+  int64_t num_segments = 0;
+  for (std::string_view line : absl::StrSplit(playlist, '\n')) {
+    line = absl::StripTrailingAsciiWhitespace(line);
+    if (absl::ConsumePrefix(&line, "#EXT-X-MEDIA-SEQUENCE:")) {
+      if (!absl::SimpleAtoi(line, &position.next_media_sequence_number))
+        LOG(WARNING) << "Invalid media sequence number " << line;
+    } else if (absl::StartsWith(line, "#EXTINF:")) {
+      // The parts of a segment precede it.
+      ++num_segments;
+      position.num_next_segment_parts = 0;
+    } else if (absl::StartsWith(line, "#EXT-X-PART:")) {
+      ++position.num_next_segment_parts;
+    }
+  }
+  position.next_media_sequence_number += num_segments;
+  return position;
+}
+
+void HttpOrigin::ThreadCallback() {
+  struct mg_mgr manager;
+  mg_mgr_init(&manager);
+
+  const bool listening =
+      mg_http_listen(&manager, params_.listen_address.c_str(),
+                     &HttpOrigin::HandleEvent, this /* callback_data */) !=
+      NULL;
+  {
+    absl::MutexLock lock(&mutex_);
+    state_ = listening ? State::kStarted : State::kFailed;
+    state_changed_.Signal();
+  }
+
+  bool stop = !listening;
+  while (!stop) {
+    mg_mgr_poll(&manager, kPollIntervalMs);
+
+    absl::MutexLock lock(&mutex_);
+    stop = stop_;
+  }
+  mg_mgr_free(&manager);
+  streams_.clear();
+  blocked_requests_.clear();
+}
+
+// static
+void HttpOrigin::HandleEvent(struct mg_connection* connection,
+                             int event,
+                             void* event_data,
+                             void* callback_data) {
+  HttpOrigin* instance = static_cast<HttpOrigin*>(callback_data);
+
+  if (event == MG_EV_POLL) {
+    auto stream = instance->streams_.find(connection);
+    if (stream != instance->streams_.end() &&
+        instance->SendStream(&stream->second, connection)) {
+      instance->streams_.erase(stream);
+    }
+    auto request = instance->blocked_requests_.find(connection);
+    if (request != instance->blocked_requests_.end() &&
+        instance->ServeBlockedRequest(request->second, connection)) {
+      instance->blocked_requests_.erase(request);
+    }
+  } else if (event == MG_EV_CLOSE) {
+    // The client may hang up before the response is complete.
+    instance->streams_.erase(connection);
+    instance->blocked_requests_.erase(connection);
+  } else if (event == MG_EV_HTTP_MSG) {
+    instance->HandleRequest(static_cast<struct mg_http_message*>(event_data),
+                            connection);
+  }
+}
+
+void HttpOrigin::HandleRequest(struct mg_http_message* message,
+                               struct mg_connection* connection) {
+  // A new request on a kept-alive connection replaces any previous one.
+  streams_.erase(connection);
+  blocked_requests_.erase(connection);
+
+  const std::string_view method = MongooseStringView(message->method);
+  const bool head_only = method == "HEAD";
+  if (method != "GET" && !head_only) {
+    mg_http_reply(connection, 405 /* method not allowed */, kCorsHeader,
+                  "Method not allowed\n");
+    return;
+  }
+
+  std::vector<char> decoded_uri(message->uri.len + 1);
+  const int decoded_size =
+      mg_url_decode(message->uri.ptr, message->uri.len, decoded_uri.data(),
+                    decoded_uri.size(), 0 /* is_form_url_encoded */);
+  if (decoded_size <= 0) {
+    mg_http_reply(connection, 400 /* bad request */, kCorsHeader,
+                  "Bad request\n");
+    return;
+  }
+  // "/live/manifest.mpd" is served from "origin://live/manifest.mpd".
+  std::string_view path(decoded_uri.data(), decoded_size);
+  absl::ConsumePrefix(&path, "/");
+
+  BlockedRequest request;
+  if (GetIntQueryParameter(message, "_HLS_msn",
+                           &request.media_sequence_number)) {
+    request.path = std::string(path);
+    GetIntQueryParameter(message, "_HLS_part", &request.part);
+    request.deadline =
+        absl::Now() + absl::Seconds(params_.max_blocking_reload_in_seconds);
+    if (!ServeBlockedRequest(request, connection))
+      blocked_requests_[connection] = std::move(request);
+    return;
+  }
+
+  struct mg_str* range = mg_http_get_header(message, "Range");
+  ServeFile(std::string(path),
+            range ? MongooseStringView(*range) : std::string_view(), head_only,
+            connection);
+}
+
+void HttpOrigin::ServeFile(const std::string& path,
+                           std::string_view range,
+                           bool head_only,
+                           struct mg_connection* connection) {
+  Stream stream;
+  stream.entry = store_->Find(path);
+  if (!stream.entry) {
+    mg_http_reply(connection, 404 /* not found */, kCorsHeader, "Not found\n");
+    return;
+  }
+  // The size is final if the file was complete before reading it.
+  const bool complete = store_->IsComplete(*stream.entry);
+  const uint64_t size = store_->Size(*stream.entry);
+
+  int status_code = 200;
+  if (!range.empty()) {
+    if (!ParseRange(range, &stream.offset, &stream.end) ||
+        (complete && stream.offset >= size)) {
+      const std::string headers = absl::StrFormat(
+          "%sContent-Range: bytes */%u\r\n", kCorsHeader, size);
+      mg_http_reply(connection, 416 /* range not satisfiable */,
+                    headers.c_str(), "Range not satisfiable\n");
+      return;
+    }
+    status_code = 206;
+  }
+
+  std::string headers = absl::StrFormat(
+      "%sContent-Type: %s\r\n", kCorsHeader, GetContentType(path));
+  if (IsManifest(path))
+    headers += "Cache-Control: no-cache\r\n";
+  if (complete) {
+    stream.end = std::min(stream.end, size);
+    if (status_code == 206) {
+      absl::StrAppendFormat(&headers, "Content-Range: bytes %u-%u/%u\r\n",
+                            stream.offset, stream.end - 1, size);
+    }
+    absl::StrAppendFormat(&headers, "Content-Length: %u\r\n",
+                          stream.end - stream.offset);
+  } else {
+    // The file is sent as it is written.
+    stream.chunked = true;
+    // The size is not known yet, and neither is the last byte of an open
+    // range.
+    if (status_code == 206 && stream.end != UINT64_MAX) {
+      absl::StrAppendFormat(&headers, "Content-Range: bytes %u-%u/*\r\n",
+                            stream.offset, stream.end - 1);
+    } else if (status_code == 206) {
+      absl::StrAppendFormat(&headers, "Content-Range: bytes %u-*/*\r\n",
+                            stream.offset);
+    }
+    headers += "Transfer-Encoding: chunked\r\n";
+  }
+  SendHeaders(connection, status_code, headers);
+  if (head_only)
+    return;
+
+  if (!SendStream(&stream, connection))
+    streams_[connection] = std::move(stream);
+}
+
+bool HttpOrigin::ServeBlockedRequest(const BlockedRequest& request,
+                                     struct mg_connection* connection) {
+  std::string playlist;
+  if (store_->ReadToString(request.path, &playlist, nullptr)) {
+    const PlaylistPosition position = GetPlaylistPosition(playlist);
+    if (request.media_sequence_number >
+        position.next_media_sequence_number + kMaxMediaSequenceNumberAhead) {
+      mg_http_reply(connection, 400 /* bad request */, kCorsHeader,
+                    "_HLS_msn is too far ahead\n");
+      return true;
+    }
+    const bool ready =
+        request.media_sequence_number < position.next_media_sequence_number ||
+        (request.part >= 0 &&
+         request.media_sequence_number ==
+             position.next_media_sequence_number &&
+         request.part < position.num_next_segment_parts);
+    if (ready) {
+      ServeFile(request.path, std::string_view(), false, connection);
+      return true;
+    }
+  }
+  if (absl::Now() >= request.deadline) {
+    mg_http_reply(connection, 503 /* service unavailable */, kCorsHeader,
+                  "Timed out waiting for the playlist update\n");
+    return true;
+  }
+  return false;
+}
+
+bool HttpOrigin::SendStream(Stream* stream,
+                            struct mg_connection* connection) {
+  char buffer[kReadSize];
+  bool done = stream->offset >= stream->end;
+  while (!done && connection->send.len < kMaxSendBufferSize) {
+    const uint64_t length =
+        std::min<uint64_t>(sizeof(buffer), stream->end - stream->offset);
+    bool complete = false;
+    const uint64_t bytes_read = store_->Read(*stream->entry, stream->offset,
+                                             buffer, length, &complete);
+    if (bytes_read > 0) {
+      if (stream->chunked)
+        mg_http_write_chunk(connection, buffer, bytes_read);
+      else
+        mg_send(connection, buffer, bytes_read);
+      stream->offset += bytes_read;
+    }
+    done = stream->offset >= stream->end || (complete && bytes_read < length);
+    // Otherwise, wait for more data to be written.
+    if (bytes_read < length)
+      break;
+  }
+  if (done && stream->chunked)
+    mg_http_write_chunk(connection, "", 0);
+  return done;
+}
+
+}  // namespace shaka
@@ -0,0 +1,129 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_ORIGIN_HTTP_ORIGIN_H_
+#define PACKAGER_ORIGIN_HTTP_ORIGIN_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
+
+#include <packager/file/segment_store.h>
+#include <packager/origin_params.h>
+#include <packager/status.h>
+
+// Forward declare mongoose struct types, used as pointers below.
+struct mg_connection;
+struct mg_http_message;
+struct mg_mgr;
+
+namespace shaka {
+
+/// A built-in HTTP origin, which serves the files in the SegmentStore, i.e.
+/// the files written to "origin://" paths.
+///
+/// Files being written are delivered with chunked transfer encoding as they
+/// are written, so that low latency DASH and HLS segments can be played
+/// while they are packaged. HLS blocking playlist reload requests, with the
+/// `_HLS_msn` and `_HLS_part` query parameters, are held until the playlist
+/// contains the requested segment or part.
+class HttpOrigin {
+ public:
+  explicit HttpOrigin(const OriginParams& params);
+  ~HttpOrigin();
+
+  /// Starts serving on `OriginParams::listen_address`, on another thread.
+  Status Start();
+  /// Stops serving. Called by the destructor.
+  void Stop();
+
+  /// Position of the end of a media playlist, for blocking playlist reload.
+  struct PlaylistPosition {
+    /// Media sequence number of the next segment.
+    int64_t next_media_sequence_number = 0;
+    /// Number of parts of the next segment already in the playlist.
+    int64_t num_next_segment_parts = 0;
+  };
+
+  /// Finds the end of |playlist|.
+  static PlaylistPosition GetPlaylistPosition(std::string_view playlist);
+
+ private:
+  HttpOrigin(const HttpOrigin&) = delete;
+  HttpOrigin& operator=(const HttpOrigin&) = delete;
+
+  // A response whose body is sent as the file is written, or as the send
+  // buffer drains.
+  struct Stream {
+    std::shared_ptr<SegmentStore::Entry> entry;
+    // Next byte of |entry| to send.
+    uint64_t offset = 0;
+    // End of the requested range, exclusive.
+    uint64_t end = UINT64_MAX;
+    bool chunked = false;
+  };
+
+  // A blocking playlist reload request.
+  struct BlockedRequest {
+    std::string path;
+    int64_t media_sequence_number = 0;
+    // -1 if not requested.
+    int64_t part = -1;
+    absl::Time deadline;
+  };
+
+  enum class State {
+    kNew,
+    kFailed,
+    kStarted,
+  };
+
+  void ThreadCallback();
+
+  static void HandleEvent(struct mg_connection* connection,
+                          int event,
+                          void* event_data,
+                          void* callback_data);
+
+  void HandleRequest(struct mg_http_message* message,
+                     struct mg_connection* connection);
+  // Replies with the file at |path|, or starts streaming it.
+  void ServeFile(const std::string& path,
+                 std::string_view range,
+                 bool head_only,
+                 struct mg_connection* connection);
+  // Replies to a blocked request if the playlist is ready, or if it timed
+  // out. Returns true if it replied.
+  bool ServeBlockedRequest(const BlockedRequest& request,
+                           struct mg_connection* connection);
+  // Sends what is available of the stream of |connection|. Returns true if
+  // the stream is complete.
+  bool SendStream(Stream* stream, struct mg_connection* connection);
+
+  const OriginParams params_;
+  SegmentStore* const store_;
+
+  absl::Mutex mutex_;
+  State state_ ABSL_GUARDED_BY(mutex_) = State::kNew;
+  absl::CondVar state_changed_;
+  bool stop_ ABSL_GUARDED_BY(mutex_) = false;
+
+  // Only accessed from |thread_|.
+  std::map<struct mg_connection*, Stream> streams_;
+  std::map<struct mg_connection*, BlockedRequest> blocked_requests_;
+
+  std::unique_ptr<std::thread> thread_;
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_ORIGIN_HTTP_ORIGIN_H_
@@ -0,0 +1,272 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/origin/http_origin.h>
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+
+#include <absl/strings/str_format.h>
+#include <absl/time/clock.h>
+#include <curl/curl.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <packager/file.h>
+#include <packager/file/file_closer.h>
+#include <packager/file/http_file.h>
+#include <packager/file/segment_store.h>
+
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+namespace shaka {
+namespace {
+
+// A random HTTP port is chosen, and if there is a collision, we try again up
+// to |kMaxPortTries| times.
+const int kMinPortNumber = 59000;
+const int kMaxPortNumber = 59999;
+const int kMaxPortTries = 10;
+const int kTimeoutInSeconds = 10;
+
+const char kPlaylist[] =
+    "#EXTM3U\n"
+    "#EXT-X-TARGETDURATION:2\n"
+    "#EXT-X-MEDIA-SEQUENCE:5\n"
+    "#EXTINF:2.000,\n"
+    "seg-5.m4s\n"
+    "#EXT-X-PART:DURATION=0.500,URI=\"seg-6.m4s\",BYTERANGE=\"100@0\"\n"
+    "#EXT-X-PART:DURATION=0.500,URI=\"seg-6.m4s\",BYTERANGE=\"100@100\"\n"
+    "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"seg-6.m4s\",BYTERANGE-START=200\n";
+
+size_t AppendToString(char* data, size_t size, size_t count, void* string) {
+  static_cast<std::string*>(string)->append(data, size * count);
+  return size * count;
+}
+
+}  // namespace
+
+class HttpOriginTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    std::random_device random_device;
+    std::default_random_engine engine(random_device());
+    std::uniform_int_distribution<int> distribution(kMinPortNumber,
+                                                    kMaxPortNumber);
+    for (int i = 0; i < kMaxPortTries; ++i) {
+      base_url_ = absl::StrFormat("http://127.0.0.1:%d", distribution(engine));
+      OriginParams params;
+      params.listen_address = base_url_;
+      params.max_blocking_reload_in_seconds = 1;
+      origin_.reset(new HttpOrigin(params));
+      if (origin_->Start().ok())
+        return;
+    }
+    FAIL() << "Failed to start the origin.";
+  }
+
+  void TearDown() override {
+    origin_.reset();
+    SegmentStore::GetInstance()->DeleteAll();
+  }
+
+  // Returns false if the request failed, e.g. with 404.
+  bool Get(const std::string& path, std::string* contents) {
+    contents->clear();
+    std::unique_ptr<HttpFile, FileCloser> file(
+        new HttpFile(HttpMethod::kGet, base_url_ + path, "", {},
+                     kTimeoutInSeconds));
+    if (!file->Open())
+      return false;
+    char buffer[1024];
+    int64_t bytes_read = 0;
+    while ((bytes_read = file->Read(buffer, sizeof(buffer))) > 0)
+      contents->append(buffer, bytes_read);
+    return file.release()->Close() && bytes_read == 0;
+  }
+
+  struct Response {
+    long status_code = 0;
+    std::string headers;
+    std::string body;
+  };
+
+  // Sends a request with curl directly, to check the status code and the
+  // headers of the response. |range| is e.g. "0-99", without "bytes=".
+  Response Request(const std::string& path,
+                   const std::string& range,
+                   bool head_only) {
+    Response response;
+    CURL* curl = curl_easy_init();
+    const std::string url = base_url_ + path;
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    if (!range.empty())
+      curl_easy_setopt(curl, CURLOPT_RANGE, range.c_str());
+    if (head_only)
+      curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT,
+                     static_cast<long>(kTimeoutInSeconds));
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, AppendToString);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response.body);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, AppendToString);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response.headers);
+    // The status code stays 0 if there is no response.
+    curl_easy_perform(curl);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.status_code);
+    curl_easy_cleanup(curl);
+    return response;
+  }
+
+  std::string base_url_;
+  std::unique_ptr<HttpOrigin> origin_;
+};
+
+TEST(HttpOriginPlaylistTest, GetPlaylistPosition) {
+  HttpOrigin::PlaylistPosition position =
+      HttpOrigin::GetPlaylistPosition(kPlaylist);
+  EXPECT_EQ(6, position.next_media_sequence_number);
+  EXPECT_EQ(2, position.num_next_segment_parts);
+
+  position = HttpOrigin::GetPlaylistPosition("#EXTM3U\n");
+  EXPECT_EQ(0, position.next_media_sequence_number);
+  EXPECT_EQ(0, position.num_next_segment_parts);
+}
+
+TEST_F(HttpOriginTest, ServesFiles) {
+  ASSERT_TRUE(File::WriteStringToFile("origin://live/seg-1.m4s", "segment"));
+
+  std::string contents;
+  ASSERT_TRUE(Get("/live/seg-1.m4s", &contents));
+  EXPECT_EQ("segment", contents);
+  EXPECT_FALSE(Get("/live/seg-2.m4s", &contents));
+}
+
+TEST_F(HttpOriginTest, StreamsFilesBeingWritten) {
+  std::unique_ptr<File, FileCloser> writer(
+      File::Open("origin://live/seg-1.m4s", "w"));
+  ASSERT_TRUE(writer);
+  ASSERT_EQ(6, writer->Write("chunk1", 6));
+
+  std::string contents;
+  std::thread reader([this, &contents]() {
+    EXPECT_TRUE(Get("/live/seg-1.m4s", &contents));
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(6, writer->Write("chunk2", 6));
+  writer.reset();
+  reader.join();
+  EXPECT_EQ("chunk1chunk2", contents);
+}
+
+TEST_F(HttpOriginTest, BlockingPlaylistReload) {
+  ASSERT_TRUE(File::WriteStringToFile("origin://live/media.m3u8",
+                                      "#EXTM3U\n#EXT-X-MEDIA-SEQUENCE:5\n"));
+
+  std::string contents;
+  std::thread reader([this, &contents]() {
+    EXPECT_TRUE(Get("/live/media.m3u8?_HLS_msn=6&_HLS_part=1", &contents));
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_TRUE(File::WriteFileAtomically("origin://live/media.m3u8", kPlaylist));
+  reader.join();
+  EXPECT_EQ(kPlaylist, contents);
+
+  // The next part is not there yet.
+  EXPECT_FALSE(Get("/live/media.m3u8?_HLS_msn=6&_HLS_part=2", &contents));
+  // Too far ahead.
+  EXPECT_FALSE(Get("/live/media.m3u8?_HLS_msn=9", &contents));
+}
+
+TEST_F(HttpOriginTest, RangeRequests) {
+  ASSERT_TRUE(File::WriteStringToFile("origin://live/seg-1.m4s", "segment"));
+
+  Response response = Request("/live/seg-1.m4s", "2-4", false);
+  EXPECT_EQ(206, response.status_code);
+  EXPECT_THAT(response.headers, HasSubstr("Content-Range: bytes 2-4/7\r\n"));
+  EXPECT_EQ("gme", response.body);
+
+  // The last byte is clamped to the end of the file.
+  response = Request("/live/seg-1.m4s", "3-", false);
+  EXPECT_EQ(206, response.status_code);
+  EXPECT_THAT(response.headers, HasSubstr("Content-Range: bytes 3-6/7\r\n"));
+  EXPECT_EQ("ment", response.body);
+  response = Request("/live/seg-1.m4s", "5-100", false);
+  EXPECT_EQ(206, response.status_code);
+  EXPECT_THAT(response.headers, HasSubstr("Content-Range: bytes 5-6/7\r\n"));
+  EXPECT_EQ("nt", response.body);
+}
+
+TEST_F(HttpOriginTest, UnsatisfiableRange) {
+  ASSERT_TRUE(File::WriteStringToFile("origin://live/seg-1.m4s", "segment"));
+
+  for (const char* range : {"7-", "10-20", "4-2"}) {
+    SCOPED_TRACE(range);
+    Response response = Request("/live/seg-1.m4s", range, false);
+    EXPECT_EQ(416, response.status_code);
+    EXPECT_THAT(response.headers, HasSubstr("Content-Range: bytes */7\r\n"));
+  }
+}
+
+TEST_F(HttpOriginTest, HeadRequest) {
+  ASSERT_TRUE(File::WriteStringToFile("origin://live/seg-1.m4s", "segment"));
+
+  Response response = Request("/live/seg-1.m4s", "", true);
+  EXPECT_EQ(200, response.status_code);
+  EXPECT_THAT(response.headers, HasSubstr("Content-Length: 7\r\n"));
+  EXPECT_THAT(response.headers, HasSubstr("Content-Type: video/mp4\r\n"));
+  EXPECT_EQ("", response.body);
+
+  response = Request("/live/seg-1.m4s", "1-2", true);
+  EXPECT_EQ(206, response.status_code);
+  EXPECT_THAT(response.headers, HasSubstr("Content-Range: bytes 1-2/7\r\n"));
+  EXPECT_THAT(response.headers, HasSubstr("Content-Length: 2\r\n"));
+  EXPECT_EQ("", response.body);
+}
+
+// An open range of a file being written, e.g. from an LL-HLS preload hint,
+// is streamed up to the end of the file.
+TEST_F(HttpOriginTest, OpenRangeOfFileBeingWritten) {
+  std::unique_ptr<File, FileCloser> writer(
+      File::Open("origin://live/seg-1.m4s", "w"));
+  ASSERT_TRUE(writer);
+  ASSERT_EQ(6, writer->Write("chunk1", 6));
+
+  Response response;
+  std::thread reader([this, &response]() {
+    response = Request("/live/seg-1.m4s", "3-", false);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(6, writer->Write("chunk2", 6));
+  writer.reset();
+  reader.join();
+  EXPECT_EQ(206, response.status_code);
+  EXPECT_THAT(response.headers, HasSubstr("Content-Range: bytes 3-*/*\r\n"));
+  EXPECT_THAT(response.headers, Not(HasSubstr("Content-Length")));
+  EXPECT_EQ("nk1chunk2", response.body);
+}
+
+TEST_F(HttpOriginTest, BlockingPlaylistReloadTimesOut) {
+  ASSERT_TRUE(File::WriteStringToFile("origin://live/media.m3u8", kPlaylist));
+
+  // The playlist has the first two parts of segment 6, but not the third.
+  const absl::Time start = absl::Now();
+  Response response =
+      Request("/live/media.m3u8?_HLS_msn=6&_HLS_part=2", "", false);
+  EXPECT_EQ(503, response.status_code);
+  // |max_blocking_reload_in_seconds| is 1.
+  EXPECT_GE(absl::Now() - start, absl::Seconds(1));
+
+  // A part which is already there is served right away.
+  response = Request("/live/media.m3u8?_HLS_msn=6&_HLS_part=1", "", false);
+  EXPECT_EQ(200, response.status_code);
+  EXPECT_EQ(kPlaylist, response.body);
+}
+
+}  // namespace shaka
@@ -19,20 +19,26 @@
 #include <packager/app/muxer_factory.h>
 #include <packager/app/packager_util.h>
 #include <packager/app/single_thread_job_manager.h>
+#include <packager/app/stats_writer.h>
 #include <packager/file.h>
+#include <packager/file/segment_store.h>
 #include <packager/hls/base/hls_notifier.h>
 #include <packager/hls/base/simple_hls_notifier.h>
 #include <packager/macros/logging.h>
 #include <packager/macros/status.h>
+#include <packager/media/base/async_queue_handler.h>
+#include <packager/media/base/buffer_pool.h>
 #include <packager/media/base/cc_stream_filter.h>
 #include <packager/media/base/language_utils.h>
 #include <packager/media/base/muxer.h>
 #include <packager/media/base/muxer_util.h>
+#include <packager/media/base/prefetching_key_source.h>
 #include <packager/media/chunking/chunking_handler.h>
 #include <packager/media/chunking/cue_alignment_handler.h>
 #include <packager/media/chunking/text_chunker.h>
 #include <packager/media/crypto/encryption_handler.h>
 #include <packager/media/demuxer/demuxer.h>
+#include <packager/media/demuxer/parallel_mp4_demuxer.h>
 #include <packager/media/event/muxer_listener_factory.h>
 #include <packager/media/event/vod_media_info_dump_muxer_listener.h>
 #include <packager/media/formats/ttml/ttml_to_mp4_handler.h>
@@ -44,6 +50,10 @@
 #include <packager/mpd/base/simple_mpd_notifier.h>
 #include <packager/version/version.h>
 
+#if defined(SHAKA_HTTP_ORIGIN)
+#include <packager/origin/http_origin.h>
+#endif  // defined(SHAKA_HTTP_ORIGIN)
+
 namespace shaka {
 
 // TODO(kqyang): Clean up namespaces.
@@ -59,6 +69,10 @@ namespace {
 
 const char kMediaInfoSuffix[] = ".media_info";
 
+// Number of stream data which can be queued for an output branch running on
+// another thread before the demuxer is blocked.
+const size_t kMaxQueuedStreamDataPerOutput = 64;
+
 MuxerListenerFactory::StreamData ToMuxerListenerData(
     const StreamDescriptor& stream) {
   MuxerListenerFactory::StreamData data;
@@ -285,6 +299,26 @@ Status ValidateParams(const PackagingParams& packaging_params,
                   "Stream descriptors cannot be empty.");
   }
 
+  if (!packaging_params.stats_params.stats_output.empty() &&
+      packaging_params.stats_params.stats_output_interval_in_seconds <= 0) {
+    return Status(error::INVALID_ARGUMENT,
+                  "--stats_output_interval must be positive.");
+  }
+
+  const OriginParams& origin_params = packaging_params.origin_params;
+  if (!origin_params.listen_address.empty() &&
+      origin_params.max_blocking_reload_in_seconds <= 0) {
+    return Status(error::INVALID_ARGUMENT,
+                  "--http_origin_max_blocking_reload must be positive.");
+  }
+#if !defined(SHAKA_HTTP_ORIGIN)
+  if (!origin_params.listen_address.empty()) {
+    return Status(error::UNIMPLEMENTED,
+                  "The packager is built without the HTTP origin. Build it "
+                  "with ENABLE_HTTP_ORIGIN to use --http_origin_address.");
+  }
+#endif  // !defined(SHAKA_HTTP_ORIGIN)
+
   // On demand profile generates single file segment while live profile
   // generates multiple segments specified using segment template.
   const bool on_demand_dash_profile =
@@ -302,6 +336,18 @@ Status ValidateParams(const PackagingParams& packaging_params,
     RETURN_IF_ERROR(ValidateStreamDescriptor(
         packaging_params.test_params.dump_stream_info, descriptor));
 
+    // The files written to "origin://" paths can only be appended to, while a
+    // single-file MP4 output with a reserved header is rewritten at the end.
+    if (absl::StartsWith(descriptor.output, kOriginFilePrefix) &&
+        descriptor.segment_template.empty() &&
+        packaging_params.mp4_output_params.reserved_header_size > 0 &&
+        GetOutputFormat(descriptor) == CONTAINER_MOV) {
+      return Status(error::UNIMPLEMENTED,
+                    "--mp4_reserved_header_size is not supported with "
+                    "single-file \"origin://\" output '" +
+                        descriptor.output + "'.");
+    }
+
     if (absl::StartsWith(descriptor.input, "udp://")) {
       const HlsParams& hls_params = packaging_params.hls_params;
       if (!hls_params.master_playlist_output.empty() &&
@@ -375,6 +421,20 @@ Status ValidateParams(const PackagingParams& packaging_params,
                   "if --low_latency_dash_mode is enabled.");
   }
 
+  if (packaging_params.hls_params.part_target_duration > 0) {
+    // The partial segments are the CMAF chunks of the low latency segments.
+    if (!packaging_params.chunking_params.low_latency_dash_mode) {
+      return Status(error::INVALID_ARGUMENT,
+                    "--low_latency_dash_mode is required "
+                    "if --hls_part_target_duration is set.");
+    }
+    if (packaging_params.hls_params.playlist_type == HlsPlaylistType::kVod) {
+      return Status(error::INVALID_ARGUMENT,
+                    "--hls_part_target_duration is not supported "
+                    "for VOD playlists.");
+    }
+  }
+
   return Status::OK;
 }
 
@@ -474,20 +534,22 @@ Status CreateDemuxer(const StreamDescriptor& stream,
   return Status::OK;
 }
 
-std::shared_ptr<MediaHandler> CreateEncryptionHandler(
-    const PackagingParams& packaging_params,
-    const StreamDescriptor& stream,
-    KeySource* key_source) {
+/// Get the encryption parameters for the given stream. Returns false if the
+/// stream is not encrypted.
+bool GetStreamEncryptionParams(const PackagingParams& packaging_params,
+                               const StreamDescriptor& stream,
+                               KeySource* key_source,
+                               EncryptionParams* encryption_params) {
   if (stream.skip_encryption) {
-    return nullptr;
+    return false;
   }
 
   if (!key_source) {
-    return nullptr;
+    return false;
   }
 
   // Make a copy so that we can modify it for this specific stream.
-  EncryptionParams encryption_params = packaging_params.encryption_params;
+  *encryption_params = packaging_params.encryption_params;
 
   // Use Sample AES in MPEG2TS.
   // TODO(kqyang): Consider adding a new flag to enable Sample AES as we
@@ -497,27 +559,101 @@ std::shared_ptr<MediaHandler> CreateEncryptionHandler(
       GetOutputFormat(stream) == CONTAINER_AC3 ||
       GetOutputFormat(stream) == CONTAINER_EAC3) {
     VLOG(1) << "Use Apple Sample AES encryption for MPEG2TS or Packed Audio.";
-    encryption_params.protection_scheme = kAppleSampleAesProtectionScheme;
+    encryption_params->protection_scheme = kAppleSampleAesProtectionScheme;
   }
 
   if (!stream.drm_label.empty()) {
     const std::string& drm_label = stream.drm_label;
-    encryption_params.stream_label_func =
+    encryption_params->stream_label_func =
         [drm_label](const EncryptionParams::EncryptedStreamAttributes&) {
           return drm_label;
         };
-  } else if (!encryption_params.stream_label_func) {
+  } else if (!encryption_params->stream_label_func) {
     const int kDefaultMaxSdPixels = 768 * 576;
     const int kDefaultMaxHdPixels = 1920 * 1080;
     const int kDefaultMaxUhd1Pixels = 4096 * 2160;
-    encryption_params.stream_label_func = std::bind(
+    encryption_params->stream_label_func = std::bind(
         &Packager::DefaultStreamLabelFunction, kDefaultMaxSdPixels,
         kDefaultMaxHdPixels, kDefaultMaxUhd1Pixels, std::placeholders::_1);
   }
 
+  return true;
+}
+
+std::shared_ptr<MediaHandler> CreateEncryptionHandler(
+    const PackagingParams& packaging_params,
+    const StreamDescriptor& stream,
+    KeySource* key_source) {
+  EncryptionParams encryption_params;
+  if (!GetStreamEncryptionParams(packaging_params, stream, key_source,
+                                 &encryption_params)) {
+    return nullptr;
+  }
   return std::make_shared<EncryptionHandler>(encryption_params, key_source);
 }
 
+/// Create a demuxer packaging the segments of the streams of |input| in
+/// parallel, if the input and the packaging options allow it. Returns nullptr
+/// otherwise, in which case the input is packaged by a Demuxer.
+std::shared_ptr<ParallelMp4Demuxer> CreateParallelMp4Demuxer(
+    const std::string& input,
+    const std::vector<std::reference_wrapper<const StreamDescriptor>>& streams,
+    const PackagingParams& packaging_params,
+    bool has_sync_points,
+    KeySource* encryption_key_source,
+    WorkStealingThreadPool* thread_pool) {
+  if (packaging_params.max_parallel_segments == 0 || !thread_pool ||
+      has_sync_points ||
+      packaging_params.chunking_params.low_latency_dash_mode ||
+      packaging_params.test_params.dump_stream_info ||
+      packaging_params.decryption_params.key_provider != KeyProvider::kNone ||
+      !File::IsLocalRegularFile(input.c_str())) {
+    return nullptr;
+  }
+
+  const EncryptionParams& encryption_params =
+      packaging_params.encryption_params;
+  if (encryption_params.key_provider != KeyProvider::kNone &&
+      encryption_params.crypto_period_duration_in_seconds > 0) {
+    return nullptr;
+  }
+
+  for (const StreamDescriptor& stream : streams) {
+    if (stream.input == input &&
+        (!stream.input_format.empty() || IsTextStream(stream))) {
+      return nullptr;
+    }
+  }
+
+  auto demuxer = std::make_shared<ParallelMp4Demuxer>(
+      input, packaging_params.chunking_params, thread_pool,
+      packaging_params.max_parallel_segments);
+  Status status = demuxer->Open();
+  if (!status.ok()) {
+    VLOG(1) << "Not splitting '" << input << "' into segments: " << status;
+    return nullptr;
+  }
+  for (const StreamDescriptor& stream : streams) {
+    if (stream.input != input)
+      continue;
+    if (!demuxer->CanSplitStream(stream.stream_selector))
+      return nullptr;
+    // The segments continue the IV of the previous segments, which is only
+    // possible if it does not depend on the sizes of the previous samples, as
+    // it does with cbc1 or with a 16-byte cenc or cens IV from the key source.
+    EncryptionParams stream_encryption_params;
+    if (GetStreamEncryptionParams(packaging_params, stream,
+                                  encryption_key_source,
+                                  &stream_encryption_params) &&
+        !demuxer->CanEncryptStream(stream.stream_selector,
+                                   stream_encryption_params,
+                                   encryption_key_source)) {
+      return nullptr;
+    }
+  }
+  return demuxer;
+}
+
 std::unique_ptr<MediaHandler> CreateTextChunker(
     const ChunkingParams& chunking_params) {
   const float segment_length_in_seconds =
@@ -605,13 +741,27 @@ Status CreateAudioVideoJobs(
   // order.
   std::map<std::string, std::shared_ptr<Demuxer>> sources;
   std::map<std::string, std::shared_ptr<MediaHandler>> cue_aligners;
+  // The inputs whose streams are split into segments packaged in parallel.
+  std::map<std::string, std::shared_ptr<ParallelMp4Demuxer>> parallel_sources;
 
   for (const StreamDescriptor& stream : streams) {
-    bool seen_input_before = sources.find(stream.input) != sources.end();
+    bool seen_input_before =
+        sources.find(stream.input) != sources.end() ||
+        parallel_sources.find(stream.input) != parallel_sources.end();
     if (seen_input_before) {
       continue;
     }
 
+    std::shared_ptr<ParallelMp4Demuxer> parallel_demuxer =
+        CreateParallelMp4Demuxer(stream.input, streams, packaging_params,
+                                 sync_points != nullptr,
+                                 encryption_key_source,
+                                 job_manager->thread_pool());
+    if (parallel_demuxer) {
+      parallel_sources[stream.input] = std::move(parallel_demuxer);
+      continue;
+    }
+
     RETURN_IF_ERROR(
         CreateDemuxer(stream, packaging_params, &sources[stream.input]));
     cue_aligners[stream.input] =
@@ -622,19 +772,20 @@ Status CreateAudioVideoJobs(
   for (auto& source : sources) {
     job_manager->Add("RemuxJob", source.second);
   }
+  for (auto& source : parallel_sources) {
+    job_manager->Add("RemuxJob", source.second);
+  }
 
   // Replicators are shared among all streams with the same input and stream
   // selector.
   std::shared_ptr<MediaHandler> replicator;
+  const bool parallel_outputs =
+      packaging_params.parallel_outputs && !packaging_params.single_threaded;
 
   std::string previous_input;
   std::string previous_selector;
 
   for (const StreamDescriptor& stream : streams) {
-    // Get the demuxer for this stream.
-    auto& demuxer = sources[stream.input];
-    auto& cue_aligner = cue_aligners[stream.input];
-
     const bool new_input_file = stream.input != previous_input;
     const bool new_stream =
         new_input_file || previous_selector != stream.stream_selector;
@@ -652,30 +803,53 @@ Status CreateAudioVideoJobs(
     // new stream. Multiple stream descriptors may have the same stream but
     // only differ by trick play factor.
     if (new_stream) {
-      if (!stream.language.empty()) {
-        demuxer->SetLanguageOverride(stream.stream_selector, stream.language);
-      }
-
-      std::vector<std::shared_ptr<MediaHandler>> handlers;
-      if (is_text) {
-        handlers.emplace_back(std::make_shared<TextPadder>(
-            packaging_params.default_text_zero_bias_ms));
-      }
-      if (sync_points) {
-        handlers.emplace_back(cue_aligner);
-      }
-      if (!is_text) {
-        handlers.emplace_back(std::make_shared<ChunkingHandler>(
-            packaging_params.chunking_params));
-        handlers.emplace_back(CreateEncryptionHandler(packaging_params, stream,
-                                                      encryption_key_source));
-      }
+      replicator = parallel_outputs ? std::make_shared<Replicator>(
+                                          kMaxQueuedStreamDataPerOutput)
+                                    : std::make_shared<Replicator>();
+
+      auto parallel_source = parallel_sources.find(stream.input);
+      if (parallel_source != parallel_sources.end()) {
+        // The demuxer chunks and encrypts the segments itself.
+        ParallelMp4Demuxer* demuxer = parallel_source->second.get();
+        if (!stream.language.empty()) {
+          demuxer->SetLanguageOverride(stream.stream_selector, stream.language);
+        }
+        EncryptionParams encryption_params;
+        const bool encrypted = GetStreamEncryptionParams(
+            packaging_params, stream, encryption_key_source,
+            &encryption_params);
+        RETURN_IF_ERROR(demuxer->SetHandler(
+            stream.stream_selector, encrypted ? &encryption_params : nullptr,
+            encryption_key_source, replicator));
+      } else {
+        // Get the demuxer for this stream.
+        auto& demuxer = sources[stream.input];
+        auto& cue_aligner = cue_aligners[stream.input];
+
+        if (!stream.language.empty()) {
+          demuxer->SetLanguageOverride(stream.stream_selector, stream.language);
+        }
 
-      replicator = std::make_shared<Replicator>();
-      handlers.emplace_back(replicator);
+        std::vector<std::shared_ptr<MediaHandler>> handlers;
+        if (is_text) {
+          handlers.emplace_back(std::make_shared<TextPadder>(
+              packaging_params.default_text_zero_bias_ms));
+        }
+        if (sync_points) {
+          handlers.emplace_back(cue_aligner);
+        }
+        if (!is_text) {
+          handlers.emplace_back(std::make_shared<ChunkingHandler>(
+              packaging_params.chunking_params));
+          handlers.emplace_back(CreateEncryptionHandler(
+              packaging_params, stream, encryption_key_source));
+        }
+        handlers.emplace_back(replicator);
 
-      RETURN_IF_ERROR(MediaHandler::Chain(handlers));
-      RETURN_IF_ERROR(demuxer->SetHandler(stream.stream_selector, handlers[0]));
+        RETURN_IF_ERROR(MediaHandler::Chain(handlers));
+        RETURN_IF_ERROR(
+            demuxer->SetHandler(stream.stream_selector, handlers[0]));
+      }
     }
 
     // Create the muxer (output) for this track.
@@ -695,6 +869,14 @@ Status CreateAudioVideoJobs(
     std::vector<std::shared_ptr<MediaHandler>> handlers;
     handlers.emplace_back(replicator);
 
+    // With worker threads, the output branches run in parallel with each other
+    // and with the demuxer. A parallel replicator already gives every branch
+    // its own thread.
+    if (job_manager->thread_pool() && !parallel_outputs) {
+      handlers.emplace_back(std::make_shared<AsyncQueueHandler>(
+          job_manager->thread_pool(), kMaxQueuedStreamDataPerOutput));
+    }
+
     // Trick play is optional.
     if (stream.trick_play_factor) {
       handlers.emplace_back(
@@ -807,10 +989,16 @@ Status CreateAllJobs(const std::vector<StreamDescriptor>& stream_descriptors,
 struct Packager::PackagerInternal {
   std::shared_ptr<media::FakeClock> fake_clock;
   std::unique_ptr<KeySource> encryption_key_source;
+  // Owned by |encryption_key_source| if the keys are prefetched.
+  media::PrefetchingKeySource* prefetching_key_source = nullptr;
   std::unique_ptr<MpdNotifier> mpd_notifier;
   std::unique_ptr<hls::HlsNotifier> hls_notifier;
   BufferCallbackParams buffer_callback_params;
   std::unique_ptr<media::JobManager> job_manager;
+  std::unique_ptr<media::StatsWriter> stats_writer;
+#if defined(SHAKA_HTTP_ORIGIN)
+  std::unique_ptr<HttpOrigin> http_origin;
+#endif  // defined(SHAKA_HTTP_ORIGIN)
 };
 
 Packager::Packager() {}
@@ -832,6 +1020,18 @@ Status Packager::Initialize(
 
   std::unique_ptr<PackagerInternal> internal(new PackagerInternal);
 
+  // Files written to "origin://" paths are kept in memory, and served by the
+  // HTTP origin if enabled.
+  SegmentStore::GetInstance()->SetMaxSize(
+      packaging_params.origin_params.max_store_size);
+#if defined(SHAKA_HTTP_ORIGIN)
+  if (!packaging_params.origin_params.listen_address.empty()) {
+    internal->http_origin.reset(
+        new HttpOrigin(packaging_params.origin_params));
+    RETURN_IF_ERROR(internal->http_origin->Start());
+  }
+#endif  // defined(SHAKA_HTTP_ORIGIN)
+
   // Create encryption key source if needed.
   if (packaging_params.encryption_params.key_provider != KeyProvider::kNone) {
     internal->encryption_key_source = CreateEncryptionKeySource(
@@ -840,6 +1040,16 @@ Status Packager::Initialize(
         packaging_params.encryption_params);
     if (!internal->encryption_key_source)
       return Status(error::INVALID_ARGUMENT, "Failed to create key source.");
+
+    const EncryptionParams& encryption_params =
+        packaging_params.encryption_params;
+    if (encryption_params.crypto_period_duration_in_seconds > 0 &&
+        encryption_params.crypto_period_key_lookahead > 0) {
+      internal->prefetching_key_source = new media::PrefetchingKeySource(
+          std::move(internal->encryption_key_source),
+          encryption_params.crypto_period_key_lookahead);
+      internal->encryption_key_source.reset(internal->prefetching_key_source);
+    }
   }
 
   // Update MPD output and HLS output if needed.
@@ -875,6 +1085,12 @@ Status Packager::Initialize(
       LanguageToShortestForm(hls_params.default_text_language);
   hls_params.is_independent_segments =
       packaging_params.chunking_params.segment_sap_aligned;
+  // The built-in HTTP origin supports blocking reloads of the playlists it
+  // serves.
+  if (!packaging_params.origin_params.listen_address.empty() &&
+      absl::StartsWith(hls_params.master_playlist_output, kOriginFilePrefix)) {
+    hls_params.can_block_reload = true;
+  }
 
   if (!mpd_params.mpd_output.empty()) {
     const bool on_demand_dash_profile =
@@ -902,7 +1118,8 @@ Status Packager::Initialize(
     internal->job_manager.reset(
         new SingleThreadJobManager(std::move(sync_points)));
   } else {
-    internal->job_manager.reset(new JobManager(std::move(sync_points)));
+    internal->job_manager.reset(new JobManager(
+        std::move(sync_points), packaging_params.num_worker_threads));
   }
 
   std::vector<StreamDescriptor> streams_for_jobs;
@@ -953,6 +1170,14 @@ Status Packager::Initialize(
       internal->job_manager->sync_points(), &muxer_listener_factory,
       &muxer_factory, internal->job_manager.get()));
 
+  const StatsParams& stats_params = packaging_params.stats_params;
+  if (stats_params.collect_stats || !stats_params.stats_output.empty())
+    internal->job_manager->EnableStats();
+  if (!stats_params.stats_output.empty()) {
+    internal->stats_writer.reset(
+        new media::StatsWriter(stats_params, [this]() { return GetStats(); }));
+  }
+
   internal_ = std::move(internal);
   return Status::OK;
 }
@@ -961,7 +1186,16 @@ Status Packager::Run() {
   if (!internal_)
     return Status(error::INVALID_ARGUMENT, "Not yet initialized.");
 
-  RETURN_IF_ERROR(internal_->job_manager->RunJobs());
+  if (internal_->stats_writer)
+    internal_->stats_writer->Start();
+  Status status = internal_->job_manager->RunJobs();
+  // The statistics are written at the end even if packaging failed, to help
+  // finding out why.
+  if (internal_->stats_writer && !internal_->stats_writer->Stop() &&
+      status.ok()) {
+    status = Status(error::FILE_FAILURE, "Failed to write stats.");
+  }
+  RETURN_IF_ERROR(status);
 
   if (internal_->hls_notifier) {
     if (!internal_->hls_notifier->Flush())
@@ -982,6 +1216,28 @@ void Packager::Cancel() {
   internal_->job_manager->CancelJobs();
 }
 
+PackagerStats Packager::GetStats() const {
+  PackagerStats stats;
+  if (!internal_)
+    return stats;
+  internal_->job_manager->GetStats(&stats.handlers);
+
+  const media::BufferPoolStats buffer_pool_stats =
+      media::BufferPool::GetInstance()->GetStats();
+  stats.num_buffer_allocations = buffer_pool_stats.num_allocations;
+  stats.num_buffer_heap_allocations = buffer_pool_stats.num_heap_allocations;
+  stats.cached_buffer_bytes = buffer_pool_stats.cached_bytes;
+
+  if (internal_->prefetching_key_source) {
+    const media::KeyPrefetchStats key_prefetch_stats =
+        internal_->prefetching_key_source->GetStats();
+    stats.num_crypto_period_key_requests = key_prefetch_stats.num_requests;
+    stats.num_crypto_period_key_waits = key_prefetch_stats.num_waits;
+    stats.crypto_period_key_wait_time_ns = key_prefetch_stats.wait_time_ns;
+  }
+  return stats;
+}
+
 std::string Packager::GetLibraryVersion() {
   return GetPackagerVersion();
 }
@@ -0,0 +1,140 @@
+// Copyright 2024 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// End-to-end benchmarks of Packager::Run() on the test data, with the input
+// and the output in memory so that the numbers do not depend on the disk.
+
+#include <string>
+#include <vector>
+
+#include <absl/log/globals.h>
+#include <benchmark/benchmark.h>
+
+#include <packager/file.h>
+#include <packager/file/memory_file.h>
+#include <packager/media/test/test_data_util.h>
+#include <packager/packager.h>
+
+namespace shaka {
+namespace {
+
+const char kInput[] = "memory://input/bear-640x360.mp4";
+const char kOutputDirectory[] = "memory://output/";
+const double kSegmentDurationInSeconds = 1.0;
+// Avoids negative timestamps in TS output, as the packager app does.
+const int32_t kTransportStreamTimestampOffsetMs = 100;
+const uint8_t kKeyId[] = {
+    0xe5, 0x00, 0x7e, 0x6e, 0x9d, 0xcd, 0x5a, 0xc0,
+    0x95, 0x20, 0x2e, 0xd3, 0x75, 0x83, 0x82, 0xcd,
+};
+const uint8_t kKey[]{
+    0x6f, 0xc9, 0x6f, 0xe6, 0x28, 0xa2, 0x65, 0xb1,
+    0x3a, 0xed, 0xde, 0xc0, 0xbc, 0x42, 0x1f, 0x4d,
+};
+
+enum class Output { kDash, kEncryptedDash, kHlsTs };
+
+// Deletes the files of the previous run, and copies the input to memory.
+bool ResetFiles(const std::string& input_contents) {
+  MemoryFile::DeleteAll();
+  return File::WriteStringToFile(kInput, input_contents);
+}
+
+PackagingParams GetPackagingParams(Output output) {
+  PackagingParams packaging_params;
+  packaging_params.temp_dir = kOutputDirectory;
+  packaging_params.chunking_params.segment_duration_in_seconds =
+      kSegmentDurationInSeconds;
+  packaging_params.transport_stream_timestamp_offset_ms =
+      kTransportStreamTimestampOffsetMs;
+  if (output == Output::kHlsTs) {
+    packaging_params.hls_params.master_playlist_output =
+        std::string(kOutputDirectory) + "master.m3u8";
+  } else {
+    packaging_params.mpd_params.mpd_output =
+        std::string(kOutputDirectory) + "manifest.mpd";
+  }
+  if (output == Output::kEncryptedDash) {
+    packaging_params.encryption_params.key_provider = KeyProvider::kRawKey;
+    RawKeyParams::KeyInfo& key_info =
+        packaging_params.encryption_params.raw_key.key_map[""];
+    key_info.key_id.assign(std::begin(kKeyId), std::end(kKeyId));
+    key_info.key.assign(std::begin(kKey), std::end(kKey));
+  }
+  return packaging_params;
+}
+
+std::vector<StreamDescriptor> GetStreamDescriptors(Output output) {
+  const std::string extension = output == Output::kHlsTs ? "ts" : "m4s";
+  std::vector<StreamDescriptor> stream_descriptors;
+  for (const char* stream : {"audio", "video"}) {
+    StreamDescriptor stream_descriptor;
+    stream_descriptor.input = kInput;
+    stream_descriptor.stream_selector = stream;
+    if (output != Output::kHlsTs) {
+      stream_descriptor.output =
+          std::string(kOutputDirectory) + stream + "-init.mp4";
+    } else {
+      stream_descriptor.hls_playlist_name = std::string(stream) + ".m3u8";
+    }
+    stream_descriptor.segment_template = std::string(kOutputDirectory) +
+                                         stream + "-$Number$." + extension;
+    stream_descriptors.push_back(stream_descriptor);
+  }
+  return stream_descriptors;
+}
+
+void BM_PackagerRun(benchmark::State& state, Output output) {
+  std::string input_contents;
+  if (!File::ReadFileToString(
+          media::GetTestDataFilePath("bear-640x360.mp4").string().c_str(),
+          &input_contents)) {
+    state.SkipWithError("Failed to read the test data.");
+    return;
+  }
+
+  const PackagingParams packaging_params = GetPackagingParams(output);
+  const std::vector<StreamDescriptor> stream_descriptors =
+      GetStreamDescriptors(output);
+  // The packager logs every run.
+  const absl::LogSeverityAtLeast min_log_level = absl::MinLogLevel();
+  absl::SetMinLogLevel(absl::LogSeverityAtLeast::kError);
+  for (auto _ : state) {
+    state.PauseTiming();
+    if (!ResetFiles(input_contents)) {
+      state.SkipWithError("Failed to write the input to memory.");
+      break;
+    }
+    state.ResumeTiming();
+
+    Packager packager;
+    Status status = packager.Initialize(packaging_params, stream_descriptors);
+    if (status.ok())
+      status = packager.Run();
+    if (!status.ok()) {
+      state.SkipWithError(status.ToString().c_str());
+      break;
+    }
+  }
+  absl::SetMinLogLevel(min_log_level);
+  MemoryFile::DeleteAll();
+  state.SetBytesProcessed(state.iterations() * input_contents.size());
+}
+
+// The packager runs the jobs on other threads, so only the real time is
+// meaningful.
+BENCHMARK_CAPTURE(BM_PackagerRun, dash, Output::kDash)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_PackagerRun, encrypted_dash, Output::kEncryptedDash)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_PackagerRun, hls_ts, Output::kHlsTs)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace shaka
@@ -7,6 +7,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <packager/file.h>
 #include <packager/packager.h>
 
 using testing::_;
@@ -186,6 +187,18 @@ TEST_F(PackagerTest, DuplicatedSegmentTemplates) {
               HasSubstr("duplicated segment templates"));
 }
 
+TEST_F(PackagerTest, OriginOutputWithReservedHeader) {
+  auto packaging_params = SetupPackagingParams();
+  packaging_params.mp4_output_params.reserved_header_size = 4096;
+  auto stream_descriptors = SetupStreamDescriptors();
+  stream_descriptors[0].output = "origin://test/output_video.mp4";
+
+  Packager packager;
+  auto status = packager.Initialize(packaging_params, stream_descriptors);
+  ASSERT_EQ(error::UNIMPLEMENTED, status.error_code());
+  EXPECT_THAT(status.error_message(), HasSubstr("origin://"));
+}
+
 TEST_F(PackagerTest, SegmentAlignedAndSubsegmentNotAligned) {
   auto packaging_params = SetupPackagingParams();
   packaging_params.chunking_params.segment_sap_aligned = true;
@@ -205,6 +218,38 @@ TEST_F(PackagerTest, SegmentNotAlignedButSubsegmentAligned) {
   ASSERT_EQ(error::INVALID_ARGUMENT, status.error_code());
 }
 
+TEST_F(PackagerTest, ParallelSegmentsSameAsSerial) {
+  const uint8_t kIv[] = {0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef};
+  std::string serial_outputs[2];
+  for (bool parallel : {false, true}) {
+    auto packaging_params = SetupPackagingParams();
+    packaging_params.test_params.inject_fake_clock = true;
+    packaging_params.encryption_params.raw_key.key_map[""].iv.assign(
+        std::begin(kIv), std::end(kIv));
+    if (parallel) {
+      packaging_params.num_worker_threads = 4;
+      packaging_params.max_parallel_segments = 2;
+    }
+    Packager packager;
+    ASSERT_EQ(Status::OK,
+              packager.Initialize(packaging_params, SetupStreamDescriptors()));
+    ASSERT_EQ(Status::OK, packager.Run());
+
+    const std::string outputs[] = {GetFullPath(kOutputVideo),
+                                   GetFullPath(kOutputAudio)};
+    for (size_t i = 0; i < 2; ++i) {
+      std::string contents;
+      ASSERT_TRUE(File::ReadFileToString(outputs[i].c_str(), &contents));
+      ASSERT_FALSE(contents.empty());
+      if (parallel)
+        EXPECT_EQ(serial_outputs[i], contents) << outputs[i];
+      else
+        serial_outputs[i] = contents;
+      ASSERT_TRUE(File::Delete(outputs[i].c_str()));
+    }
+  }
+}
+
 TEST_F(PackagerTest, WriteOutputToBuffer) {
   auto packaging_params = SetupPackagingParams();
 
@@ -290,4 +335,85 @@ TEST_F(PackagerTest, LowLatencyDashEnabledAndUtcTimingNotSet) {
 }
 // TODO(kqyang): Add more tests.
 
+TEST_F(PackagerTest, GetStats) {
+  PackagingParams packaging_params = SetupPackagingParams();
+  packaging_params.stats_params.collect_stats = true;
+
+  Packager packager;
+  ASSERT_EQ(Status::OK, packager.Initialize(packaging_params,
+                                            SetupStreamDescriptors()));
+  ASSERT_EQ(Status::OK, packager.Run());
+
+  const PackagerStats stats = packager.GetStats();
+  int num_demuxers = 0;
+  int num_muxers = 0;
+  for (const MediaHandlerStats& handler : stats.handlers) {
+    if (handler.type == "Demuxer") {
+      ++num_demuxers;
+      EXPECT_GT(handler.processing_time_ns, 0u);
+    } else if (handler.type == "MP4Muxer") {
+      ++num_muxers;
+      EXPECT_THAT(handler.id, HasSubstr("/EncryptionHandler/"));
+      EXPECT_GT(handler.num_samples, 0u);
+      EXPECT_GT(handler.num_bytes, 0u);
+      EXPECT_GT(handler.p99_processing_time_ns, 0u);
+      EXPECT_GE(handler.p99_processing_time_ns,
+                handler.p50_processing_time_ns);
+    }
+  }
+  EXPECT_EQ(1, num_demuxers);
+  EXPECT_EQ(2, num_muxers);
+  EXPECT_GT(stats.num_buffer_allocations, 0u);
+}
+
+TEST_F(PackagerTest, GetStatsWithParallelOutputs) {
+  PackagingParams packaging_params = SetupPackagingParams();
+  packaging_params.parallel_outputs = true;
+  packaging_params.stats_params.collect_stats = true;
+
+  Packager packager;
+  ASSERT_EQ(Status::OK, packager.Initialize(packaging_params,
+                                            SetupStreamDescriptors()));
+  ASSERT_EQ(Status::OK, packager.Run());
+
+  // Every stream data goes through the queue of a branch.
+  int num_replicators = 0;
+  for (const MediaHandlerStats& handler : packager.GetStats().handlers) {
+    if (handler.type == "Replicator") {
+      ++num_replicators;
+      EXPECT_GT(handler.num_stream_data, 0u);
+      EXPECT_GT(handler.max_queue_depth, 0u);
+      EXPECT_EQ(0u, handler.queue_depth);
+    }
+  }
+  EXPECT_EQ(2, num_replicators);
+}
+
+TEST_F(PackagerTest, StatsNotCollectedByDefault) {
+  Packager packager;
+  ASSERT_EQ(Status::OK, packager.Initialize(SetupPackagingParams(),
+                                            SetupStreamDescriptors()));
+  ASSERT_EQ(Status::OK, packager.Run());
+  EXPECT_TRUE(packager.GetStats().handlers.empty());
+}
+
+TEST_F(PackagerTest, WriteStatsOutput) {
+  PackagingParams packaging_params = SetupPackagingParams();
+  packaging_params.stats_params.stats_output = GetFullPath("stats.prom");
+  packaging_params.stats_params.stats_format = StatsFormat::kPrometheus;
+
+  Packager packager;
+  ASSERT_EQ(Status::OK, packager.Initialize(packaging_params,
+                                            SetupStreamDescriptors()));
+  ASSERT_EQ(Status::OK, packager.Run());
+
+  std::string stats;
+  ASSERT_TRUE(File::ReadFileToString(
+      packaging_params.stats_params.stats_output.c_str(), &stats));
+  EXPECT_THAT(stats, HasSubstr("# TYPE shaka_packager_handler_samples_total "
+                               "counter\n"));
+  EXPECT_THAT(stats, HasSubstr("shaka_packager_handler_samples_total{id=\""
+                               "job0/Demuxer/"));
+}
+
 }  // namespace shaka